@@ -0,0 +1,375 @@
+/*======================================================================
+VulkanPBR_AcornForest : AppConfig.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "AppConfig.h"
+#include "ClusteredLights.h"
+#include "ShaderVariants.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void printUsage(const char* program)
+{
+	printf("Usage: %s [options]\n", program);
+	printf("  --threads <n>            worker threads, 0-64 (0 = auto)\n");
+	printf("  --mip-filter <mode>      none (GPU blit) | box | kaiser\n");
+	printf("  --texture-format <fmt>   rgba8 | bc1 | bc3 | bc5 | bc7\n");
+	printf("  --mipgen <mode>          compute | blit (GPU mips, used with --mip-filter none)\n");
+	printf("  --frames-in-flight <n>   frames the CPU may run ahead of the GPU (1-4)\n");
+	printf("  --low-latency            wait for the GPU before sampling input\n");
+	printf("  --present <policy>       default | low-latency | uncapped | vsync | power-saver\n");
+	printf("  --swapchain-images <n>   swapchain image count (0 = min + 1, clamped to the surface)\n");
+	printf("  --fps-limit <fps>        CPU frame limiter (0 = off)\n");
+	printf("  --startup-timeline       print the initialization steps with start/end times and threads\n");
+	printf("  --profile <file.json>    record CPU profiler zones, write a Chrome trace (Perfetto) at exit\n");
+	printf("  --shader-features <list> comma separated: alpha-test, vertex-color, uv-debug, uv-tiling, ibl,\n"
+		"                           clustered-lights, shadows, overdraw (none = base, default ibl,clustered-lights,shadows)\n");
+	printf("  --pipeline-cache <file>  pipeline cache loaded at startup, saved at exit (default pipeline_cache.bin, \"\" = off)\n");
+	printf("  --env-map <file.hdr>     equirectangular environment for image based lighting (default: procedural sky)\n");
+	printf("  --lights <n>             clustered point lights, 0-4096 (default 256)\n");
+	printf("  --shadow-size <n>        shadow map size per sun cascade, 256-8192 (default 2048)\n");
+	printf("  --no-spin                keep the model still (its shadow cascades stay cached)\n");
+	printf("  --depth-prepass          depth-only prepass, then shade only the visible fragments (no overdraw)\n");
+	printf("  --no-draw-sort           record draws unsorted with every bind (baseline for --bench-draws)\n");
+	printf("  --forest <n>             instance the model as a forest of n trees around it, 0-100000 (default 0)\n");
+	printf("  --no-impostors           draw every forest tree as a mesh\n");
+	printf("  --impostor-distance <d>  forest trees farther than d are impostor quads, 1-1000 (default 30)\n");
+	printf("  --memory-report <file>   device memory report written at exit (default memory_report.json, \"\" = off)\n");
+	printf("  --bench-textures         texture decode benchmark, no window\n");
+	printf("  --bench-bcn              block compression benchmark, no window\n");
+	printf("  --bench-mipgen           4K/8K GPU mip generation benchmark (blit vs compute)\n");
+	printf("  --bench-latency          input latency vs throughput for 1-4 frames in flight\n");
+	printf("  --bench-lights           clustered lighting cost for 1-4096 point lights\n");
+	printf("  --bench-prepass          scene GPU time without/with the depth prepass for 0-4096 point lights\n");
+	printf("  --bench-draws            bind counts and recording time of unsorted vs sorted draws\n");
+	printf("  --bench-impostors        forest frame time with impostors off and at several distances (10000 trees unless --forest)\n");
+	printf("  --bench-sort             draw key radix sort vs std::stable_sort, 1K-1M keys, no window\n");
+	printf("  --bench-scene            scene graph world matrices, 1M nodes with 1%% dirty per frame, no window\n");
+	printf("  --bench-simd             mat4 multiply, AABB transform and frustum culling per SIMD level, no window\n");
+	printf("  --bench-bvh              BVH build, refit, frustum and ray queries, 10K-1M instances, no window\n");
+	printf("  --bench-streaming        world cell streaming hitches along a camera path, no window\n");
+	printf("  --bench-jobs             job system microbenchmarks (1-64 threads), no window\n");
+	printf("  --bench-profiler         profiler zone overhead, no window\n");
+	printf("  --bench-limiter          frame limiter pacing accuracy, no window\n");
+	printf("  --validate-rendergraph   compile and validate the frame, sample and random render graphs, no GPU\n");
+	printf("  --validate-reflection    reflect a synthetic module and the compiled shaders, no GPU\n");
+	printf("  --validate-ibl           check the CPU IBL bake against known integrals and the cached bake, no GPU\n");
+	printf("  --validate-lights        check the light cluster mapping and culling, no GPU\n");
+	printf("  --validate-shadows       check the shadow cascade splits, snapping and caching, no GPU\n");
+	printf("  --validate-simd          check the SIMD math kernels against glm at every supported level, no GPU\n");
+	printf("  --validate-impostors     check the impostor octahedral mapping, frame blending and bake matrices, no GPU\n");
+	printf("  --help                   show this message\n");
+}
+
+bool parseCommandLine(int argc, char** argv, AppConfig& config, int& exitCode)
+{
+	exitCode = EXIT_FAILURE;
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+		if (strcmp(arg, "--threads") == 0 && value)
+		{
+			int threads = atoi(value);
+			if (threads < 0 || threads > 64)
+			{
+				printf("Worker threads must be 0-64: %s\n", value);
+				return false;
+			}
+			config.workerThreads = static_cast<uint32_t>(threads);
+			i++;
+		}
+		else if (strcmp(arg, "--mip-filter") == 0 && value)
+		{
+			if (strcmp(value, "none") == 0)        config.mipFilter = MipFilter::None;
+			else if (strcmp(value, "box") == 0)    config.mipFilter = MipFilter::Box;
+			else if (strcmp(value, "kaiser") == 0) config.mipFilter = MipFilter::Kaiser;
+			else
+			{
+				printf("Unknown mip filter: %s\n", value);
+				return false;
+			}
+			i++;
+		}
+		else if (strcmp(arg, "--texture-format") == 0 && value)
+		{
+			if (strcmp(value, "rgba8") == 0)    config.textureFormat = TextureFormat::RGBA8;
+			else if (strcmp(value, "bc1") == 0) config.textureFormat = TextureFormat::BC1;
+			else if (strcmp(value, "bc3") == 0) config.textureFormat = TextureFormat::BC3;
+			else if (strcmp(value, "bc5") == 0) config.textureFormat = TextureFormat::BC5;
+			else if (strcmp(value, "bc7") == 0) config.textureFormat = TextureFormat::BC7;
+			else
+			{
+				printf("Unknown texture format: %s\n", value);
+				return false;
+			}
+			i++;
+		}
+		else if (strcmp(arg, "--mipgen") == 0 && value)
+		{
+			if (strcmp(value, "compute") == 0)   config.computeMipmaps = true;
+			else if (strcmp(value, "blit") == 0) config.computeMipmaps = false;
+			else
+			{
+				printf("Unknown mipgen mode: %s\n", value);
+				return false;
+			}
+			i++;
+		}
+		else if (strcmp(arg, "--frames-in-flight") == 0 && value)
+		{
+			int frames = atoi(value);
+			if (frames < 1 || frames > 4)
+			{
+				printf("Frames in flight must be 1-4: %s\n", value);
+				return false;
+			}
+			config.framesInFlight = static_cast<uint32_t>(frames);
+			i++;
+		}
+		else if (strcmp(arg, "--low-latency") == 0)
+		{
+			config.lowLatency = true;
+		}
+		else if (strcmp(arg, "--present") == 0 && value)
+		{
+			if (parsePresentPolicy(value, config.presentPolicy) == false)
+			{
+				printf("Unknown present policy: %s\n", value);
+				return false;
+			}
+			i++;
+		}
+		else if (strcmp(arg, "--swapchain-images") == 0 && value)
+		{
+			int images = atoi(value);
+			if (images < 0 || images > 16)
+			{
+				printf("Swapchain images must be 0-16: %s\n", value);
+				return false;
+			}
+			config.swapchainImages = static_cast<uint32_t>(images);
+			i++;
+		}
+		else if (strcmp(arg, "--fps-limit") == 0 && value)
+		{
+			double fps = atof(value);
+			if (fps < 0.0 || fps > 1000.0)
+			{
+				printf("FPS limit must be 0-1000: %s\n", value);
+				return false;
+			}
+			config.fpsLimit = fps;
+			i++;
+		}
+		else if (strcmp(arg, "--startup-timeline") == 0)
+		{
+			config.startupTimeline = true;
+		}
+		else if (strcmp(arg, "--profile") == 0 && value)
+		{
+			config.profilePath = value;
+			i++;
+		}
+		else if (strcmp(arg, "--shader-features") == 0 && value)
+		{
+			if (parseShaderFeatures(value, config.shaderFeatures) == false)
+			{
+				printf("Unknown shader feature list: %s\n", value);
+				return false;
+			}
+			i++;
+		}
+		else if (strcmp(arg, "--pipeline-cache") == 0 && value)
+		{
+			config.pipelineCachePath = value;
+			i++;
+		}
+		else if (strcmp(arg, "--env-map") == 0 && value)
+		{
+			config.environmentMapPath = value;
+			i++;
+		}
+		else if (strcmp(arg, "--lights") == 0 && value)
+		{
+			int lights = atoi(value);
+			if (lights < 0 || lights > static_cast<int>(MAX_POINT_LIGHTS))
+			{
+				printf("Light count must be 0-%u: %s\n", MAX_POINT_LIGHTS, value);
+				return false;
+			}
+			config.lightCount = static_cast<uint32_t>(lights);
+			i++;
+		}
+		else if (strcmp(arg, "--shadow-size") == 0 && value)
+		{
+			int size = atoi(value);
+			if (size < 256 || size > 8192)
+			{
+				printf("Shadow map size must be 256-8192: %s\n", value);
+				return false;
+			}
+			config.shadowMapSize = static_cast<uint32_t>(size);
+			i++;
+		}
+		else if (strcmp(arg, "--no-spin") == 0)
+		{
+			config.spinModel = false;
+		}
+		else if (strcmp(arg, "--depth-prepass") == 0)
+		{
+			config.depthPrepass = true;
+		}
+		else if (strcmp(arg, "--no-draw-sort") == 0)
+		{
+			config.sortDraws = false;
+		}
+		else if (strcmp(arg, "--forest") == 0 && value)
+		{
+			int trees = atoi(value);
+			if (trees < 0 || trees > 100000)
+			{
+				printf("Forest tree count must be 0-100000: %s\n", value);
+				return false;
+			}
+			config.forestTrees = static_cast<uint32_t>(trees);
+			i++;
+		}
+		else if (strcmp(arg, "--no-impostors") == 0)
+		{
+			config.impostors = false;
+		}
+		else if (strcmp(arg, "--impostor-distance") == 0 && value)
+		{
+			float distance = static_cast<float>(atof(value));
+			if (distance < 1.0f || distance > 1000.0f)
+			{
+				printf("Impostor distance must be 1-1000: %s\n", value);
+				return false;
+			}
+			config.impostorDistance = distance;
+			i++;
+		}
+		else if (strcmp(arg, "--memory-report") == 0 && value)
+		{
+			config.memoryReportPath = value;
+			i++;
+		}
+		else if (strcmp(arg, "--bench-textures") == 0)
+		{
+			config.benchTextures = true;
+		}
+		else if (strcmp(arg, "--bench-bcn") == 0)
+		{
+			config.benchCompression = true;
+		}
+		else if (strcmp(arg, "--bench-mipgen") == 0)
+		{
+			config.benchMipGen = true;
+		}
+		else if (strcmp(arg, "--bench-latency") == 0)
+		{
+			config.benchLatency = true;
+		}
+		else if (strcmp(arg, "--bench-lights") == 0)
+		{
+			config.benchLights = true;
+		}
+		else if (strcmp(arg, "--bench-prepass") == 0)
+		{
+			config.benchPrepass = true;
+		}
+		else if (strcmp(arg, "--bench-draws") == 0)
+		{
+			config.benchDraws = true;
+		}
+		else if (strcmp(arg, "--bench-impostors") == 0)
+		{
+			config.benchImpostors = true;
+		}
+		else if (strcmp(arg, "--bench-sort") == 0)
+		{
+			config.benchSort = true;
+		}
+		else if (strcmp(arg, "--bench-scene") == 0)
+		{
+			config.benchScene = true;
+		}
+		else if (strcmp(arg, "--bench-simd") == 0)
+		{
+			config.benchSimd = true;
+		}
+		else if (strcmp(arg, "--bench-bvh") == 0)
+		{
+			config.benchBvh = true;
+		}
+		else if (strcmp(arg, "--bench-streaming") == 0)
+		{
+			config.benchStreaming = true;
+		}
+		else if (strcmp(arg, "--bench-jobs") == 0)
+		{
+			config.benchJobs = true;
+		}
+		else if (strcmp(arg, "--bench-profiler") == 0)
+		{
+			config.benchProfiler = true;
+		}
+		else if (strcmp(arg, "--bench-limiter") == 0)
+		{
+			config.benchLimiter = true;
+		}
+		else if (strcmp(arg, "--validate-rendergraph") == 0)
+		{
+			config.validateRenderGraph = true;
+		}
+		else if (strcmp(arg, "--validate-reflection") == 0)
+		{
+			config.validateReflection = true;
+		}
+		else if (strcmp(arg, "--validate-ibl") == 0)
+		{
+			config.validateIbl = true;
+		}
+		else if (strcmp(arg, "--validate-lights") == 0)
+		{
+			config.validateLights = true;
+		}
+		else if (strcmp(arg, "--validate-shadows") == 0)
+		{
+			config.validateShadows = true;
+		}
+		else if (strcmp(arg, "--validate-simd") == 0)
+		{
+			config.validateSimd = true;
+		}
+		else if (strcmp(arg, "--validate-impostors") == 0)
+		{
+			config.validateImpostors = true;
+		}
+		else
+		{
+			if (strcmp(arg, "--help") == 0)
+			{
+				exitCode = EXIT_SUCCESS;
+			}
+			else
+			{
+				printf("Unknown option: %s\n", arg);
+			}
+			printUsage(argv[0]);
+			return false;
+		}
+	}
+
+	// the impostor benchmark needs a forest
+	if (config.benchImpostors && config.forestTrees == 0)
+	{
+		config.forestTrees = 10000;
+	}
+	return true;
+}
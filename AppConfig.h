@@ -0,0 +1,70 @@
+/*======================================================================
+VulkanPBR_AcornForest : AppConfig.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Runtime settings, filled from the command line in main().
+Run with --help for the list of options.
+=======================================================================*/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "PresentPolicy.h"
+#include "ShaderVariants.h"
+#include "TextureLoader.h"
+
+struct AppConfig
+{
+	uint32_t    workerThreads = 0;                // 0: one per hardware thread (minus main), at most 64
+	MipFilter   mipFilter = MipFilter::Box;       // CPU mip filter, None = GPU blit chain
+	TextureFormat textureFormat = TextureFormat::BC7;    // falls back to RGBA8 if the GPU has no BCn support
+	bool        computeMipmaps = true;            // GPU mips (mip filter None): compute shader, false = blit chain
+	uint32_t    framesInFlight = 2;               // CPU frames ahead of the GPU (1..4)
+	bool        lowLatency = false;               // wait for the GPU before sampling input instead of after
+	PresentPolicy presentPolicy = PresentPolicy::Default;    // present mode preference, can be changed at runtime
+	uint32_t    swapchainImages = 0;              // 0: minImageCount + 1, clamped to the surface limits
+	double      fpsLimit = 0.0;                   // CPU frame limiter, 0 = off (power-saver defaults to 60)
+	bool        startupTimeline = false;          // print per-step start/end times of initialization
+	std::string profilePath;                      // --profile: Chrome Trace JSON written at exit (empty = profiler off)
+	std::string memoryReportPath = "memory_report.json";    // device memory per category/heap written at exit (empty = off)
+	uint32_t    shaderFeatures = SHADER_FEATURE_IBL | SHADER_FEATURE_CLUSTERED_LIGHTS | SHADER_FEATURE_SHADOWS;    // ShaderFeature bits of the pipeline variant, can be changed at runtime
+	std::string pipelineCachePath = "pipeline_cache.bin";    // VkPipelineCache saved at exit, loaded at startup (empty = off)
+	std::string environmentMapPath;               // equirectangular HDR for image based lighting (empty = procedural sky)
+	uint32_t    lightCount = 256;                 // clustered point lights (fireflies and lanterns), can be changed at runtime
+	uint32_t    shadowMapSize = 2048;             // per shadow cascade, 256-8192
+	bool        spinModel = true;                 // rotate the model (a dynamic shadow caster), can be changed at runtime
+	bool        depthPrepass = false;             // depth-only pass first, then shade with depth compare EQUAL; can be changed at runtime
+	bool        sortDraws = true;                 // sort draw packets and skip redundant binds (false = unsorted baseline), can be changed at runtime
+	uint32_t    forestTrees = 0;                  // instances of the model around it, 0 = the model alone
+	bool        impostors = true;                 // far forest trees as impostor quads, can be changed at runtime
+	float       impostorDistance = 30.0f;         // trees farther from the camera are impostors, can be changed at runtime
+
+	// headless benchmarks: run, print results and exit without opening a window
+	bool        benchTextures = false;
+	bool        benchCompression = false;
+	bool        benchMipGen = false;              // needs the GPU: runs after Vulkan init, then exits
+	bool        benchLatency = false;             // needs the GPU: frames in flight 1..4, latency vs throughput
+	bool        benchLights = false;              // needs the GPU: clustered lighting cost for 1..4096 point lights
+	bool        benchPrepass = false;             // needs the GPU: scene cost without/with the depth prepass
+	bool        benchDraws = false;               // needs the GPU: binds and recording time, unsorted vs sorted draws
+	bool        benchImpostors = false;           // needs the GPU: forest frame time with impostors off and on (10000 trees unless --forest)
+	bool        benchSort = false;                // CPU-only draw key radix sort vs std::stable_sort
+	bool        benchScene = false;               // CPU-only scene graph update, 1M nodes with 1% dirty
+	bool        benchSimd = false;                // CPU-only SIMD matrix/culling kernels, scalar vs SSE2 vs AVX2
+	bool        benchBvh = false;                 // CPU-only BVH build/refit/query at 10k-1M instances
+	bool        benchStreaming = false;           // CPU-only world cell streaming along a camera path, synchronous vs I/O threads
+	bool        benchJobs = false;                // CPU-only job system spawn/dependency/scaling microbenchmarks
+	bool        benchProfiler = false;            // CPU-only profiler zone overhead
+	bool        benchLimiter = false;             // CPU-only frame limiter accuracy
+	bool        validateRenderGraph = false;      // CPU-only render graph barrier/aliasing checks
+	bool        validateReflection = false;       // CPU-only SPIR-V reflection checks
+	bool        validateIbl = false;              // CPU-only IBL reference bake checks (and the cached bake, if any)
+	bool        validateLights = false;           // CPU-only light cluster mapping/culling checks
+	bool        validateShadows = false;          // CPU-only shadow cascade split/snapping/caching checks
+	bool        validateSimd = false;             // CPU-only SIMD kernels vs glm checks
+	bool        validateImpostors = false;        // CPU-only impostor atlas mapping/frame blending/bake matrix checks
+};
+
+// returns false if the program should exit (bad option or --help); exitCode is EXIT_SUCCESS only for --help
+bool parseCommandLine(int argc, char** argv, AppConfig& config, int& exitCode);
@@ -0,0 +1,41 @@
+/*======================================================================
+VulkanPBR_AcornForest : BenchUtil.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Helpers shared by the headless benchmarks and self-tests: a random
+sequence that is identical on every platform (so a generated test
+scene is the same everywhere, unlike std::uniform_*_distribution) and
+millisecond timing.
+=======================================================================*/
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// xorshift64*: same sequence on every platform; the state must not be 0
+inline uint64_t nextRandom(uint64_t& state)
+{
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * 0x2545F4914F6CDD1Dull;
+}
+
+// [0, 1) from the top 24 bits
+inline float randomUnit(uint64_t& state)
+{
+	return static_cast<float>(nextRandom(state) >> 40) / 16777216.0f;
+}
+
+inline float randomRange(uint64_t& state, float low, float high)
+{
+	return low + (high - low) * randomUnit(state);
+}
+
+// milliseconds since start, read from the clock start was taken from
+template <typename Clock, typename Duration>
+double elapsedMs(std::chrono::time_point<Clock, Duration> start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
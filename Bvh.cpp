@@ -0,0 +1,689 @@
+/*======================================================================
+VulkanPBR_AcornForest : Bvh.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE    // before the first glm include: the benchmark cameras use Vulkan depth like the renderer
+#include "Bvh.h"
+#include "BenchUtil.h"
+#include "JobSystem.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+	const uint32_t BIN_COUNT = 16;
+	const uint32_t MAX_LEAF_SIZE = 8;             // larger ranges always split when a split exists
+	const uint32_t MAX_DEPTH = 64;                // also the traversal stack size; deeper ranges become leaves
+	const uint32_t PARALLEL_BUILD_SIZE = 4096;    // the first half of a larger split builds as its own job
+	const uint32_t PARALLEL_BIN_SIZE = 65536;     // larger ranges bin on several threads
+	const uint32_t BIN_BLOCK_SIZE = 16384;
+	const uint32_t UNUSED_NODE = UINT32_MAX;
+
+	struct Bin
+	{
+		BvhBox   bounds;
+		BvhBox   centroids;
+		uint32_t count;
+	};
+
+	using AxisBins = Bin[3][BIN_COUNT];
+
+	struct BuildContext
+	{
+		std::vector<BvhNode>    nodes;        // pre-order with gaps: a range of n instances reserves 2n - 1 nodes
+		std::vector<uint32_t>   instances;    // partitioned in place, ranges of different jobs never overlap
+		std::vector<BvhBox>     bounds;       // per instance
+		std::vector<glm::vec3>  centroids;    // per instance
+		CJobSystem*             jobSystem = nullptr;
+		std::atomic<uint32_t>   depth{ 0 };
+	};
+
+	BvhBox emptyBox()
+	{
+		return { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+	}
+
+	void grow(BvhBox& box, const BvhBox& other)
+	{
+		box.min = glm::min(box.min, other.min);
+		box.max = glm::max(box.max, other.max);
+	}
+
+	void grow(BvhBox& box, const glm::vec3& point)
+	{
+		box.min = glm::min(box.min, point);
+		box.max = glm::max(box.max, point);
+	}
+
+	float halfArea(const BvhBox& box)
+	{
+		glm::vec3 size = box.max - box.min;
+		return (size.x < 0.0f) ? 0.0f : size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	uint32_t binOf(float value, float minimum, float scale)
+	{
+		return std::min(BIN_COUNT - 1, static_cast<uint32_t>((value - minimum) * scale));
+	}
+
+	void clearBins(AxisBins& bins)
+	{
+		for (auto& axisBins : bins)
+		{
+			for (Bin& bin : axisBins)
+			{
+				bin = { emptyBox(), emptyBox(), 0 };
+			}
+		}
+	}
+
+	void binInstances(const BuildContext& context, uint32_t begin, uint32_t end, const glm::vec3& minimum, const glm::vec3& scale, AxisBins& bins)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			uint32_t instance = context.instances[i];
+			const glm::vec3& centroid = context.centroids[instance];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				Bin& bin = bins[axis][binOf(centroid[axis], minimum[axis], scale[axis])];
+				grow(bin.bounds, context.bounds[instance]);
+				grow(bin.centroids, centroid);
+				bin.count++;
+			}
+		}
+	}
+
+	void binRange(const BuildContext& context, uint32_t begin, uint32_t end, const glm::vec3& minimum, const glm::vec3& scale, AxisBins& bins)
+	{
+		clearBins(bins);
+		uint32_t count = end - begin;
+		if (context.jobSystem == nullptr || count < PARALLEL_BIN_SIZE)
+		{
+			binInstances(context, begin, end, minimum, scale, bins);
+			return;
+		}
+
+		// one set of bins per block, merged afterwards
+		uint32_t blockCount = (count + BIN_BLOCK_SIZE - 1) / BIN_BLOCK_SIZE;
+		std::vector<AxisBins> blockBins(blockCount);
+		context.jobSystem->parallelFor(blockCount, 1, [&](uint32_t first, uint32_t last)
+		{
+			for (uint32_t block = first; block < last; block++)
+			{
+				clearBins(blockBins[block]);
+				uint32_t blockBegin = begin + block * BIN_BLOCK_SIZE;
+				binInstances(context, blockBegin, std::min(end, blockBegin + BIN_BLOCK_SIZE), minimum, scale, blockBins[block]);
+			}
+		});
+		for (const AxisBins& partial : blockBins)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				for (uint32_t bin = 0; bin < BIN_COUNT; bin++)
+				{
+					grow(bins[axis][bin].bounds, partial[axis][bin].bounds);
+					grow(bins[axis][bin].centroids, partial[axis][bin].centroids);
+					bins[axis][bin].count += partial[axis][bin].count;
+				}
+			}
+		}
+	}
+
+	void buildNode(BuildContext& context, uint32_t nodeIndex, uint32_t begin, uint32_t end, const BvhBox& bounds, const BvhBox& centroidBounds,
+		uint32_t depth)
+	{
+		BvhNode& node = context.nodes[nodeIndex];
+		node.min = bounds.min;
+		node.max = bounds.max;
+		node.leftFirst = begin;
+		node.count = end - begin;
+
+		uint32_t deepest = context.depth.load();
+		while (depth + 1 > deepest && context.depth.compare_exchange_weak(deepest, depth + 1) == false)
+		{
+		}
+
+		uint32_t count = end - begin;
+		if (count <= 2 || depth + 1 >= MAX_DEPTH)
+		{
+			return;
+		}
+
+		glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+		glm::vec3 scale(0.0f);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			scale[axis] = (extent[axis] > 0.0f) ? BIN_COUNT / extent[axis] : 0.0f;
+		}
+
+		// best split between two bins: sweep the bins from both sides
+		uint32_t bestAxis = 0;
+		uint32_t bestBin = 0;
+		float bestCost = FLT_MAX;
+		AxisBins bins;
+		if (extent.x > 0.0f || extent.y > 0.0f || extent.z > 0.0f)
+		{
+			binRange(context, begin, end, centroidBounds.min, scale, bins);
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				if (extent[axis] <= 0.0f)
+				{
+					continue;
+				}
+				float rightCost[BIN_COUNT];
+				BvhBox right = emptyBox();
+				uint32_t rightCount = 0;
+				for (uint32_t bin = BIN_COUNT - 1; bin > 0; bin--)
+				{
+					grow(right, bins[axis][bin].bounds);
+					rightCount += bins[axis][bin].count;
+					rightCost[bin] = halfArea(right) * rightCount;
+				}
+				BvhBox left = emptyBox();
+				uint32_t leftCount = 0;
+				for (uint32_t bin = 1; bin < BIN_COUNT; bin++)
+				{
+					grow(left, bins[axis][bin - 1].bounds);
+					leftCount += bins[axis][bin - 1].count;
+					float cost = halfArea(left) * leftCount + rightCost[bin];
+					if (leftCount > 0 && leftCount < count && cost < bestCost)
+					{
+						bestCost = cost;
+						bestAxis = axis;
+						bestBin = bin;
+					}
+				}
+			}
+		}
+
+		uint32_t middle = 0;
+		BvhBox leftBounds = emptyBox(), leftCentroids = emptyBox();
+		BvhBox rightBounds = emptyBox(), rightCentroids = emptyBox();
+		if (bestBin > 0)
+		{
+			// SAH: one node visit plus the instance tests weighted by the chance to hit each child
+			float splitCost = 1.0f + bestCost / std::max(halfArea(bounds), FLT_MIN);
+			if (count <= MAX_LEAF_SIZE && splitCost >= static_cast<float>(count))
+			{
+				return;
+			}
+			uint32_t* first = context.instances.data() + begin;
+			middle = static_cast<uint32_t>(std::partition(first, first + count, [&](uint32_t instance)
+			{
+				return binOf(context.centroids[instance][bestAxis], centroidBounds.min[bestAxis], scale[bestAxis]) < bestBin;
+			}) - context.instances.data());
+			for (uint32_t bin = 0; bin < BIN_COUNT; bin++)
+			{
+				BvhBox& childBounds = (bin < bestBin) ? leftBounds : rightBounds;
+				BvhBox& childCentroids = (bin < bestBin) ? leftCentroids : rightCentroids;
+				grow(childBounds, bins[bestAxis][bin].bounds);
+				grow(childCentroids, bins[bestAxis][bin].centroids);
+			}
+		}
+		else
+		{
+			// every centroid in one spot: halve the range, small ranges stay a leaf
+			if (count <= MAX_LEAF_SIZE)
+			{
+				return;
+			}
+			middle = begin + count / 2;
+			for (uint32_t i = begin; i < end; i++)
+			{
+				uint32_t instance = context.instances[i];
+				grow((i < middle) ? leftBounds : rightBounds, context.bounds[instance]);
+				grow((i < middle) ? leftCentroids : rightCentroids, context.centroids[instance]);
+			}
+		}
+
+		uint32_t leftCount = middle - begin;
+		uint32_t leftIndex = nodeIndex + 1;
+		uint32_t rightIndex = nodeIndex + 2 * leftCount;    // after the 2 * leftCount - 1 nodes reserved for the left range
+		node.leftFirst = rightIndex;
+		node.count = 0;
+
+		if (context.jobSystem != nullptr && count >= PARALLEL_BUILD_SIZE)
+		{
+			JobHandle leftJob = context.jobSystem->submit([&context, leftIndex, begin, middle, leftBounds, leftCentroids, depth]()
+			{
+				buildNode(context, leftIndex, begin, middle, leftBounds, leftCentroids, depth + 1);
+			});
+			buildNode(context, rightIndex, middle, end, rightBounds, rightCentroids, depth + 1);
+			context.jobSystem->wait(leftJob);
+		}
+		else
+		{
+			buildNode(context, leftIndex, begin, middle, leftBounds, leftCentroids, depth + 1);
+			buildNode(context, rightIndex, middle, end, rightBounds, rightCentroids, depth + 1);
+		}
+	}
+
+	// inward planes: outside when the corner furthest along a normal is behind it, fully inside when the nearest corner is in front
+	bool cullBox(const FrustumPlanes& frustum, const glm::vec3& minimum, const glm::vec3& maximum, uint32_t& planeMask)
+	{
+		for (uint32_t plane = 0; plane < 6; plane++)
+		{
+			if ((planeMask & (1u << plane)) == 0)
+			{
+				continue;
+			}
+			const glm::vec4& p = frustum.planes[plane];
+			glm::vec3 furthest(p.x >= 0.0f ? maximum.x : minimum.x, p.y >= 0.0f ? maximum.y : minimum.y, p.z >= 0.0f ? maximum.z : minimum.z);
+			glm::vec3 nearest(p.x >= 0.0f ? minimum.x : maximum.x, p.y >= 0.0f ? minimum.y : maximum.y, p.z >= 0.0f ? minimum.z : maximum.z);
+			if (glm::dot(glm::vec3(p), furthest) + p.w < 0.0f)
+			{
+				return true;
+			}
+			if (glm::dot(glm::vec3(p), nearest) + p.w >= 0.0f)
+			{
+				planeMask &= ~(1u << plane);
+			}
+		}
+		return false;
+	}
+
+	// slab test: entry distance, or FLT_MAX when the ray misses within [0, maxDistance]
+	float intersectBox(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, const glm::vec3& minimum,
+		const glm::vec3& maximum)
+	{
+		glm::vec3 t0 = (minimum - origin) * inverseDirection;
+		glm::vec3 t1 = (maximum - origin) * inverseDirection;
+		glm::vec3 tEnter = glm::min(t0, t1);
+		glm::vec3 tExit = glm::max(t0, t1);
+		float enter = std::max(std::max(tEnter.x, tEnter.y), std::max(tEnter.z, 0.0f));
+		float exit = std::min(std::min(tExit.x, tExit.y), std::min(tExit.z, maxDistance));
+		return (enter <= exit) ? enter : FLT_MAX;
+	}
+
+}
+
+void CBvh::build(const AabbArrays& bounds, CJobSystem* jobSystem)
+{
+	uint32_t count = static_cast<uint32_t>(bounds.size());
+	m_Nodes.clear();
+	m_Instances.clear();
+	m_Bounds.clear();
+	m_Depth = 0;
+	if (count == 0)
+	{
+		return;
+	}
+
+	BuildContext context;
+	context.jobSystem = jobSystem;
+	context.nodes.resize(2 * static_cast<size_t>(count) - 1);
+	context.instances.resize(count);
+	context.bounds.resize(count);
+	context.centroids.resize(count);
+	BvhBox rootBounds = emptyBox();
+	BvhBox rootCentroids = emptyBox();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		context.instances[i] = i;
+		context.bounds[i] = { glm::vec3(bounds.minX[i], bounds.minY[i], bounds.minZ[i]), glm::vec3(bounds.maxX[i], bounds.maxY[i], bounds.maxZ[i]) };
+		context.centroids[i] = (context.bounds[i].min + context.bounds[i].max) * 0.5f;
+		grow(rootBounds, context.bounds[i]);
+		grow(rootCentroids, context.centroids[i]);
+	}
+	for (BvhNode& node : context.nodes)
+	{
+		node.count = UNUSED_NODE;
+	}
+
+	buildNode(context, 0, 0, count, rootBounds, rootCentroids, 0);
+
+	// close the gaps: the used nodes are already in pre-order, only the second-child indices move
+	std::vector<uint32_t> compactIndex(context.nodes.size());
+	uint32_t used = 0;
+	for (size_t i = 0; i < context.nodes.size(); i++)
+	{
+		compactIndex[i] = used;
+		used += (context.nodes[i].count != UNUSED_NODE) ? 1 : 0;
+	}
+	m_Nodes.reserve(used);
+	for (const BvhNode& node : context.nodes)
+	{
+		if (node.count == UNUSED_NODE)
+		{
+			continue;
+		}
+		m_Nodes.push_back(node);
+		if (node.count == 0)
+		{
+			m_Nodes.back().leftFirst = compactIndex[node.leftFirst];
+		}
+	}
+
+	m_Instances.swap(context.instances);
+	m_Bounds.resize(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		m_Bounds[i] = context.bounds[m_Instances[i]];
+	}
+	m_Depth = context.depth.load();
+}
+
+void CBvh::refit(const AabbArrays& bounds)
+{
+	if (bounds.size() != m_Instances.size())
+	{
+		throw std::runtime_error("Failed to refit BVH: the instance count changed since the build!");
+	}
+
+	for (size_t i = 0; i < m_Instances.size(); i++)
+	{
+		uint32_t instance = m_Instances[i];
+		m_Bounds[i] = { glm::vec3(bounds.minX[instance], bounds.minY[instance], bounds.minZ[instance]),
+			glm::vec3(bounds.maxX[instance], bounds.maxY[instance], bounds.maxZ[instance]) };
+	}
+
+	// children always come after their parent
+	for (size_t i = m_Nodes.size(); i-- > 0;)
+	{
+		BvhNode& node = m_Nodes[i];
+		BvhBox box = emptyBox();
+		if (node.count > 0)
+		{
+			for (uint32_t entry = node.leftFirst; entry < node.leftFirst + node.count; entry++)
+			{
+				grow(box, m_Bounds[entry]);
+			}
+		}
+		else
+		{
+			grow(box, { m_Nodes[i + 1].min, m_Nodes[i + 1].max });
+			grow(box, { m_Nodes[node.leftFirst].min, m_Nodes[node.leftFirst].max });
+		}
+		node.min = box.min;
+		node.max = box.max;
+	}
+}
+
+uint32_t CBvh::queryFrustum(const FrustumPlanes& frustum, std::vector<uint32_t>& visible) const
+{
+	if (m_Nodes.empty())
+	{
+		return 0;
+	}
+
+	// planes the parent was fully inside of are not tested again
+	struct Entry
+	{
+		uint32_t node;
+		uint32_t planeMask;
+	};
+	Entry stack[MAX_DEPTH];
+	uint32_t stackSize = 0;
+	size_t firstVisible = visible.size();
+
+	Entry entry = { 0, 0x3F };
+	while (true)
+	{
+		const BvhNode& node = m_Nodes[entry.node];
+		uint32_t planeMask = entry.planeMask;
+		if (planeMask == 0 || cullBox(frustum, node.min, node.max, planeMask) == false)
+		{
+			if (node.count == 0)
+			{
+				stack[stackSize++] = { node.leftFirst, planeMask };
+				entry = { entry.node + 1, planeMask };
+				continue;
+			}
+			for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+			{
+				uint32_t instanceMask = planeMask;
+				if (instanceMask == 0 || cullBox(frustum, m_Bounds[i].min, m_Bounds[i].max, instanceMask) == false)
+				{
+					visible.push_back(m_Instances[i]);
+				}
+			}
+		}
+		if (stackSize == 0)
+		{
+			break;
+		}
+		entry = stack[--stackSize];
+	}
+	return static_cast<uint32_t>(visible.size() - firstVisible);
+}
+
+bool CBvh::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, BvhHit& hit) const
+{
+	hit = BvhHit();
+	if (m_Nodes.empty())
+	{
+		return false;
+	}
+
+	glm::vec3 inverseDirection;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		// a huge finite value instead of infinity: 0 * inf would be NaN for an origin on a slab
+		inverseDirection[axis] = (std::abs(direction[axis]) > 1e-30f) ? 1.0f / direction[axis] : std::copysign(1e30f, direction[axis]);
+	}
+
+	// nearer child first; entries farther than the best hit are skipped when popped
+	struct Entry
+	{
+		uint32_t node;
+		float    distance;
+	};
+	Entry stack[MAX_DEPTH];
+	uint32_t stackSize = 0;
+	float best = maxDistance;
+
+	Entry entry = { 0, intersectBox(origin, inverseDirection, maxDistance, m_Nodes[0].min, m_Nodes[0].max) };
+	while (true)
+	{
+		if (entry.distance <= best)
+		{
+			const BvhNode& node = m_Nodes[entry.node];
+			if (node.count > 0)
+			{
+				for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+				{
+					float distance = intersectBox(origin, inverseDirection, best, m_Bounds[i].min, m_Bounds[i].max);
+					if (distance <= best && (distance < hit.distance || hit.instance == BVH_NO_HIT))
+					{
+						best = distance;
+						hit.instance = m_Instances[i];
+						hit.distance = distance;
+					}
+				}
+			}
+			else
+			{
+				const BvhNode& first = m_Nodes[entry.node + 1];
+				const BvhNode& second = m_Nodes[node.leftFirst];
+				Entry nearChild = { entry.node + 1, intersectBox(origin, inverseDirection, best, first.min, first.max) };
+				Entry farChild = { node.leftFirst, intersectBox(origin, inverseDirection, best, second.min, second.max) };
+				if (farChild.distance < nearChild.distance)
+				{
+					std::swap(nearChild, farChild);
+				}
+				if (nearChild.distance != FLT_MAX)
+				{
+					if (farChild.distance != FLT_MAX)
+					{
+						stack[stackSize++] = farChild;
+					}
+					entry = nearChild;
+					continue;
+				}
+			}
+		}
+		if (stackSize == 0)
+		{
+			break;
+		}
+		entry = stack[--stackSize];
+	}
+	return hit.instance != BVH_NO_HIT;
+}
+
+float CBvh::getSahCost() const
+{
+	if (m_Nodes.empty())
+	{
+		return 0.0f;
+	}
+	double cost = 0.0;
+	for (const BvhNode& node : m_Nodes)
+	{
+		cost += halfArea({ node.min, node.max }) * ((node.count > 0) ? node.count : 1.0);
+	}
+	return static_cast<float>(cost / std::max(halfArea({ m_Nodes[0].min, m_Nodes[0].max }), FLT_MIN));
+}
+
+void CBvh::benchmark()
+{
+	const uint32_t counts[] = { 10000, 100000, 1000000 };
+	const uint32_t cameraCount = 64;
+	const uint32_t rayCount = 20000;
+	const uint32_t checkedRays = 200;
+
+	CJobSystem jobSystem;
+	printf("BVH over forest instances: binned SAH (%u bins), %u threads, SIMD culling for brute force: %s\n", BIN_COUNT,
+		jobSystem.getWorkerCount() + 1, toString(CSimdMath::getBestSimdLevel()));
+
+	for (uint32_t count : counts)
+	{
+		// trees at a constant density, the forest grows with the count
+		uint64_t state = 0x9E3779B97F4A7C15ull + count;
+		float halfSide = std::sqrt(static_cast<float>(count)) * 2.0f;
+		AabbArrays bounds;
+		bounds.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			float x = randomRange(state, -halfSide, halfSide);
+			float y = randomRange(state, -halfSide, halfSide);
+			float radius = randomRange(state, 0.5f, 3.0f);
+			bounds.minX[i] = x - radius; bounds.maxX[i] = x + radius;
+			bounds.minY[i] = y - radius; bounds.maxY[i] = y + radius;
+			bounds.minZ[i] = 0.0f;       bounds.maxZ[i] = randomRange(state, 2.0f, 12.0f);
+		}
+
+		CBvh bvh;
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		bvh.build(bounds, nullptr);
+		double singleMs = elapsedMs(start);
+		start = std::chrono::high_resolution_clock::now();
+		bvh.build(bounds, &jobSystem);
+		double parallelMs = elapsedMs(start);
+		printf("  %7u instances: build %8.2f ms (1 thread) %8.2f ms (jobs), %u nodes, depth %u, SAH cost %.1f\n", count, singleMs, parallelMs,
+			bvh.getNodeCount(), bvh.getDepth(), bvh.getSahCost());
+
+		// cameras walking through the forest, 150 m far plane
+		std::vector<FrustumPlanes> frustums(cameraCount);
+		std::vector<glm::vec3> eyes(cameraCount);
+		std::vector<glm::vec3> forwards(cameraCount);
+		glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+		proj[1][1] *= -1.0f;
+		for (uint32_t camera = 0; camera < cameraCount; camera++)
+		{
+			float angle = randomRange(state, 0.0f, 6.2831853f);
+			eyes[camera] = glm::vec3(randomRange(state, -halfSide, halfSide), randomRange(state, -halfSide, halfSide), randomRange(state, 1.7f, 20.0f));
+			forwards[camera] = glm::normalize(glm::vec3(std::cos(angle), std::sin(angle), -0.2f));
+			frustums[camera] = CSimdMath::extractFrustumPlanes(proj * glm::lookAt(eyes[camera], eyes[camera] + forwards[camera], glm::vec3(0.0f, 0.0f, 1.0f)));
+		}
+
+		auto checkFrustums = [&](const AabbArrays& current, double& bvhMs, double& bruteMs, uint64_t& visibleTotal)
+		{
+			bool matches = true;
+			std::vector<uint32_t> visible;
+			std::vector<uint8_t> flags(count);
+			bvhMs = bruteMs = 0.0;
+			visibleTotal = 0;
+			for (uint32_t camera = 0; camera < cameraCount; camera++)
+			{
+				visible.clear();
+				start = std::chrono::high_resolution_clock::now();
+				bvh.queryFrustum(frustums[camera], visible);
+				bvhMs += elapsedMs(start);
+
+				start = std::chrono::high_resolution_clock::now();
+				uint32_t bruteCount = CSimdMath::cullAabbs(CSimdMath::getBestSimdLevel(), frustums[camera], current, flags.data());
+				bruteMs += elapsedMs(start);
+
+				// same plane tests on the same boxes: the sets must be identical
+				matches = matches && visible.size() == bruteCount;
+				for (uint32_t instance : visible)
+				{
+					matches = matches && flags[instance] != 0;
+				}
+				visibleTotal += visible.size();
+			}
+			return matches;
+		};
+
+		double bvhMs = 0.0, bruteMs = 0.0;
+		uint64_t visibleTotal = 0;
+		bool frustumOk = checkFrustums(bounds, bvhMs, bruteMs, visibleTotal);
+		printf("    frustum: %8.1f queries/s BVH, %8.1f queries/s brute force, %llu visible per query   %s\n", cameraCount * 1000.0 / std::max(bvhMs, 1e-6),
+			cameraCount * 1000.0 / std::max(bruteMs, 1e-6), static_cast<unsigned long long>(visibleTotal / cameraCount), frustumOk ? "ok" : "MISMATCH");
+
+		// picking rays from the cameras, checked against testing every instance
+		bool raysOk = true;
+		uint32_t hits = 0;
+		std::vector<glm::vec3> rayOrigins(rayCount), rayDirections(rayCount);
+		for (uint32_t ray = 0; ray < rayCount; ray++)
+		{
+			uint32_t camera = ray % cameraCount;
+			rayOrigins[ray] = eyes[camera];
+			rayDirections[ray] = glm::normalize(forwards[camera] + glm::vec3(randomRange(state, -0.5f, 0.5f), randomRange(state, -0.5f, 0.5f),
+				randomRange(state, -0.3f, 0.3f)));
+		}
+		start = std::chrono::high_resolution_clock::now();
+		for (uint32_t ray = 0; ray < rayCount; ray++)
+		{
+			BvhHit hit;
+			hits += bvh.raycast(rayOrigins[ray], rayDirections[ray], 500.0f, hit) ? 1 : 0;
+		}
+		double rayMs = elapsedMs(start);
+		for (uint32_t ray = 0; ray < checkedRays; ray++)
+		{
+			BvhHit hit;
+			bvh.raycast(rayOrigins[ray], rayDirections[ray], 500.0f, hit);
+			glm::vec3 inverseDirection = 1.0f / rayDirections[ray];
+			float nearest = FLT_MAX;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				nearest = std::min(nearest, intersectBox(rayOrigins[ray], inverseDirection, 500.0f, glm::vec3(bounds.minX[i], bounds.minY[i], bounds.minZ[i]),
+					glm::vec3(bounds.maxX[i], bounds.maxY[i], bounds.maxZ[i])));
+			}
+			raysOk = raysOk && ((nearest == FLT_MAX) ? hit.instance == BVH_NO_HIT : (hit.instance != BVH_NO_HIT && std::abs(hit.distance - nearest) < 1e-3f));
+		}
+		printf("    rays:    %8.0f rays/ms, %u of %u hit   %s\n", rayCount / std::max(rayMs, 1e-6), hits, rayCount, raysOk ? "ok" : "MISMATCH");
+
+		// 10% of the instances move a few meters, then refit (tree kept) vs rebuild
+		for (uint32_t moved = 0; moved < count / 10; moved++)
+		{
+			uint32_t i = static_cast<uint32_t>(nextRandom(state) % count);
+			float dx = randomRange(state, -5.0f, 5.0f), dy = randomRange(state, -5.0f, 5.0f);
+			bounds.minX[i] += dx; bounds.maxX[i] += dx;
+			bounds.minY[i] += dy; bounds.maxY[i] += dy;
+		}
+		start = std::chrono::high_resolution_clock::now();
+		bvh.refit(bounds);
+		double refitMs = elapsedMs(start);
+		float refitSah = bvh.getSahCost();
+		bool refitOk = checkFrustums(bounds, bvhMs, bruteMs, visibleTotal);
+		double refitQueries = cameraCount * 1000.0 / std::max(bvhMs, 1e-6);
+		CBvh rebuilt;
+		start = std::chrono::high_resolution_clock::now();
+		rebuilt.build(bounds, &jobSystem);
+		double rebuildMs = elapsedMs(start);
+		printf("    10%% moved: refit %7.2f ms (SAH cost %.1f, %8.1f queries/s), rebuild %7.2f ms (SAH cost %.1f)   %s\n", refitMs, refitSah, refitQueries,
+			rebuildMs, rebuilt.getSahCost(), refitOk ? "ok" : "MISMATCH");
+	}
+}
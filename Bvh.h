@@ -0,0 +1,83 @@
+/*======================================================================
+VulkanPBR_AcornForest : Bvh.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Bounding volume hierarchy over instance bounds (trees of the forest,
+props), for frustum culling and mouse picking on the CPU.
+
+build() splits with a binned surface area heuristic (16 bins per axis).
+Ranges above a few thousand instances bin on several threads, and the
+two halves of a split build as separate jobs. The result is flattened
+depth-first into 32-byte nodes: the first child of an interior node is
+the next node, only the second child is stored. The instance bounds are
+copied in leaf order, so a query reads nodes and leaves front to back.
+
+refit() keeps the tree and recomputes the bounds after instances moved,
+children before parents (O(n), no allocation). The tree gets looser as
+things move; rebuild when getSahCost() has grown too much.
+=======================================================================*/
+#pragma once
+
+#include "SimdMath.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class CJobSystem;
+
+const uint32_t BVH_NO_HIT = UINT32_MAX;
+
+struct BvhBox
+{
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+struct BvhNode
+{
+	glm::vec3 min;
+	uint32_t  leftFirst;    // interior: index of the second child (the first is this node + 1); leaf: first entry of the leaf order
+	glm::vec3 max;
+	uint32_t  count;        // instances in the leaf, 0 for an interior node
+};
+
+struct BvhHit
+{
+	uint32_t instance = BVH_NO_HIT;
+	float    distance = 0.0f;    // along the ray to the instance bounds (0 when the origin is inside)
+};
+
+class CBvh
+{
+private:
+
+	std::vector<BvhNode>    m_Nodes;
+	std::vector<uint32_t>   m_Instances;    // instance index per leaf entry
+	std::vector<BvhBox>     m_Bounds;       // instance bounds per leaf entry
+	uint32_t                m_Depth = 0;
+
+public:
+
+	// jobSystem may be null (single-threaded)
+	void build(const AabbArrays& bounds, CJobSystem* jobSystem);
+	// same instances as the last build(), new bounds
+	void refit(const AabbArrays& bounds);
+
+	// instances whose bounds are at least partly inside, appended to visible; returns the count appended
+	uint32_t queryFrustum(const FrustumPlanes& frustum, std::vector<uint32_t>& visible) const;
+	// nearest instance bounds hit by origin + t * direction, 0 <= t <= maxDistance; the caller tests the mesh for exact picking
+	bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, BvhHit& hit) const;
+
+	uint32_t getNodeCount() const { return static_cast<uint32_t>(m_Nodes.size()); }
+	uint32_t getInstanceCount() const { return static_cast<uint32_t>(m_Instances.size()); }
+	uint32_t getDepth() const { return m_Depth; }
+	const std::vector<BvhNode>& getNodes() const { return m_Nodes; }
+	// expected cost of a random query relative to the root (node visits + instance tests), for rebuild decisions
+	float getSahCost() const;
+
+	// CPU-only: build, refit, frustum and ray throughput at 10k/100k/1M instances, checked against brute force
+	static void benchmark();
+};
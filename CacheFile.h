@@ -0,0 +1,151 @@
+/*======================================================================
+VulkanPBR_AcornForest : CacheFile.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Container helpers shared by the on-disk caches (TextureCache, IblCache,
+WorldStreaming). Every file starts with a KTX2-style identifier and a
+version, followed by the cache's own header fields and its payload.
+Files are written under a unique temporary name and renamed into place,
+so a crash never leaves a half-written entry behind.
+=======================================================================*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+const char* const CACHE_DIRECTORY = "Asset/Cache";
+const uint32_t    CACHE_IDENTIFIER_SIZE = 12;
+
+class CCacheFile
+{
+public:
+
+	// same idea as the KTX2 identifier: catches text-mode transfers and truncated files
+	struct Identifier
+	{
+		uint8_t bytes[CACHE_IDENTIFIER_SIZE];
+	};
+
+	// 0xAB, a six character tag, 0xBB, CR LF EOF LF
+	static constexpr Identifier makeIdentifier(const char (&tag)[7])
+	{
+		return { { 0xAB,
+			static_cast<uint8_t>(tag[0]), static_cast<uint8_t>(tag[1]), static_cast<uint8_t>(tag[2]),
+			static_cast<uint8_t>(tag[3]), static_cast<uint8_t>(tag[4]), static_cast<uint8_t>(tag[5]),
+			0xBB, '\r', '\n', 0x1A, '\n' } };
+	}
+
+	static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+	// FNV-1a; chain calls to hash several buffers
+	static uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// Header must start with uint8_t identifier[CACHE_IDENTIFIER_SIZE] followed by uint32_t version
+	template <typename Header>
+	static void initHeader(Header& header, const Identifier& identifier, uint32_t version)
+	{
+		memcpy(header.identifier, identifier.bytes, CACHE_IDENTIFIER_SIZE);
+		header.version = version;
+	}
+
+	// Opens path and reads its header. Returns false if the file is missing, shorter than the
+	// header, or has another identifier or version. fileSize is the size of the whole file,
+	// for checking the sizes the header announces before anything is allocated.
+	template <typename Header>
+	static bool readHeader(const std::string& path, const Identifier& identifier, uint32_t version,
+		std::ifstream& file, Header& header, uint64_t& fileSize)
+	{
+		std::error_code error;
+		fileSize = static_cast<uint64_t>(std::filesystem::file_size(path, error));
+		if (error || fileSize < sizeof(Header))
+		{
+			return false;
+		}
+
+		file.open(path, std::ios::binary);
+		if (file.is_open() == false)
+		{
+			return false;
+		}
+
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		return file.good() &&
+			memcmp(header.identifier, identifier.bytes, CACHE_IDENTIFIER_SIZE) == 0 &&
+			header.version == version;
+	}
+
+	// Writes the header and then writeBody(std::ofstream&) to a temporary file next to path and renames
+	// it over path. Each call gets its own temporary name, so workers storing the same key at once do not
+	// write into one file; the last rename wins. label names the cache in failure messages; nullptr fails silently.
+	template <typename Header, typename WriteBody>
+	static bool write(const std::string& path, const Header& header, WriteBody writeBody, const char* label)
+	{
+		std::error_code error;
+		std::filesystem::path parent = std::filesystem::path(path).parent_path();
+		if (parent.empty() == false)
+		{
+			std::filesystem::create_directories(parent, error);
+		}
+
+		std::string tempPath = path + "." + std::to_string(nextTempIndex()) + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (file.is_open() == false)
+			{
+				if (label)
+				{
+					printf("%s: cannot write %s\n", label, tempPath.c_str());
+				}
+				return false;
+			}
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			writeBody(file);
+			if (file.good() == false)
+			{
+				if (label)
+				{
+					printf("%s: write failed for %s\n", label, tempPath.c_str());
+				}
+				file.close();
+				std::filesystem::remove(tempPath, error);
+				return false;
+			}
+		}
+
+		std::filesystem::rename(tempPath, path, error);
+		if (error)
+		{
+			if (label)
+			{
+				printf("%s: cannot replace %s (%s)\n", label, path.c_str(), error.message().c_str());
+			}
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+		return true;
+	}
+
+private:
+
+	static uint32_t nextTempIndex()
+	{
+		static std::atomic<uint32_t> counter{ 0 };
+		return counter.fetch_add(1, std::memory_order_relaxed);
+	}
+};
@@ -0,0 +1,313 @@
+/*======================================================================
+VulkanPBR_AcornForest : ClusteredLights.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE    // before the first glm include: the self test builds ubo.proj like the renderer
+#include "ClusteredLights.h"
+#include "JobSystem.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	// integer hash -> [0, 1), identical on every platform (std distributions are not)
+	float hashToUnit(uint32_t value)
+	{
+		value ^= value >> 16;
+		value *= 0x7FEB352Du;
+		value ^= value >> 15;
+		value *= 0x846CA68Bu;
+		value ^= value >> 16;
+		return static_cast<float>(value >> 8) / 16777216.0f;
+	}
+
+	float random(uint32_t light, uint32_t channel)
+	{
+		return hashToUnit(light * 8u + channel);
+	}
+
+	glm::uvec3 getClusterCoordinates(uint32_t cluster)
+	{
+		return glm::uvec3(cluster % CLUSTER_GRID_X, (cluster / CLUSTER_GRID_X) % CLUSTER_GRID_Y, cluster / (CLUSTER_GRID_X * CLUSTER_GRID_Y));
+	}
+
+	// one light in 32 is a lantern: bigger, brighter and still
+	bool isLantern(uint32_t light)
+	{
+		return light % 32 == 31;
+	}
+}
+
+LightBufferHeader CClusteredLights::makeHeader(const glm::mat4& view, const glm::mat4& proj, uint32_t width, uint32_t height, uint32_t lightCount)
+{
+	// glm::perspective with depth 0..1: proj[2][2] = far / (near - far), proj[3][2] = near * far / (near - far)
+	float nearPlane = proj[3][2] / proj[2][2];
+	float farPlane = proj[3][2] / (proj[2][2] + 1.0f);
+	float logRatio = std::log(farPlane / nearPlane);
+
+	LightBufferHeader header{};
+	header.view = view;
+	header.projection = glm::vec4(1.0f / proj[0][0], 1.0f / std::abs(proj[1][1]), nearPlane, farPlane);
+	header.screen = glm::vec4(static_cast<float>(width), static_cast<float>(height),
+		CLUSTER_GRID_Z / logRatio, -(CLUSTER_GRID_Z * std::log(nearPlane)) / logRatio);
+	header.lightCount = std::min(lightCount, MAX_POINT_LIGHTS);
+	return header;
+}
+
+float CClusteredLights::getForestLightExtent(uint32_t count)
+{
+	return 1.5f * std::sqrt(static_cast<float>(std::max(std::min(count, MAX_POINT_LIGHTS), FOREST_LIGHT_BASE_COUNT)) / FOREST_LIGHT_BASE_COUNT);
+}
+
+std::vector<PointLight> CClusteredLights::createForestLights(uint32_t count)
+{
+	std::vector<PointLight> lights(std::min(count, MAX_POINT_LIGHTS));
+	float extent = getForestLightExtent(count);
+	for (uint32_t i = 0; i < lights.size(); i++)
+	{
+		glm::vec3 position((random(i, 0) * 2.0f - 1.0f) * extent, (random(i, 1) * 2.0f - 1.0f) * extent, random(i, 2) * 1.2f + 0.05f);
+		if (isLantern(i))
+		{
+			lights[i].positionRadius = glm::vec4(position.x, position.y, 0.1f, 0.6f + 0.3f * random(i, 3));
+			lights[i].colorIntensity = glm::vec4(1.0f, 0.55f + 0.15f * random(i, 4), 0.2f, 0.6f);
+		}
+		else
+		{
+			lights[i].positionRadius = glm::vec4(position, 0.15f + 0.15f * random(i, 3));
+			lights[i].colorIntensity = glm::vec4(0.7f + 0.3f * random(i, 4), 1.0f, 0.3f * random(i, 5), 0.15f);
+		}
+	}
+	return lights;
+}
+
+void CClusteredLights::animate(const std::vector<PointLight>& base, std::vector<PointLight>& lights, float time)
+{
+	lights.resize(base.size());
+	for (uint32_t i = 0; i < base.size(); i++)
+	{
+		lights[i] = base[i];
+		float phase = random(i, 6) * 6.2831853f;
+		float speed = 0.5f + random(i, 7);
+		if (isLantern(i))
+		{
+			lights[i].colorIntensity.a *= 0.9f + 0.1f * std::sin(time * 7.0f * speed + phase);    // flicker
+		}
+		else
+		{
+			// drift around the spawn point and blink
+			glm::vec3 offset(std::sin(time * speed + phase), std::cos(time * speed * 0.8f + phase), 0.5f * std::sin(time * speed * 1.3f + phase));
+			lights[i].positionRadius += glm::vec4(offset * 0.1f, 0.0f);
+			lights[i].colorIntensity.a *= std::max(std::sin(time * speed * 2.0f + phase), 0.0f);
+		}
+	}
+}
+
+uint32_t CClusteredLights::getClusterIndex(const LightBufferHeader& header, const glm::vec3& viewPosition)
+{
+	float depth = -viewPosition.z;
+	if (depth < header.projection.z || depth > header.projection.w)
+	{
+		return UINT32_MAX;
+	}
+
+	// framebuffer coordinates: x right, y down (Vulkan), 0..1
+	float u = 0.5f + 0.5f * viewPosition.x / (depth * header.projection.x);
+	float v = 0.5f - 0.5f * viewPosition.y / (depth * header.projection.y);
+	if (u < 0.0f || u > 1.0f || v < 0.0f || v > 1.0f)
+	{
+		return UINT32_MAX;
+	}
+
+	uint32_t x = std::min(static_cast<uint32_t>(u * CLUSTER_GRID_X), CLUSTER_GRID_X - 1);
+	uint32_t y = std::min(static_cast<uint32_t>(v * CLUSTER_GRID_Y), CLUSTER_GRID_Y - 1);
+	uint32_t z = static_cast<uint32_t>(std::clamp(std::log(depth) * header.screen.z + header.screen.w, 0.0f, CLUSTER_GRID_Z - 1.0f));
+	return x + CLUSTER_GRID_X * (y + CLUSTER_GRID_Y * z);
+}
+
+// Shaders/cluster_cull.comp has the same function
+void CClusteredLights::getClusterBounds(const LightBufferHeader& header, uint32_t cluster, glm::vec3& boundsMin, glm::vec3& boundsMax)
+{
+	glm::uvec3 coordinates = getClusterCoordinates(cluster);
+	float nearPlane = header.projection.z;
+	float farPlane = header.projection.w;
+	float sliceNear = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(coordinates.z) / CLUSTER_GRID_Z);
+	float sliceFar = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(coordinates.z + 1) / CLUSTER_GRID_Z);
+
+	// tile edges on a plane at depth 1 (framebuffer y down = view y up)
+	glm::vec2 tileMin(2.0f * coordinates.x / CLUSTER_GRID_X - 1.0f, 1.0f - 2.0f * (coordinates.y + 1) / CLUSTER_GRID_Y);
+	glm::vec2 tileMax(2.0f * (coordinates.x + 1) / CLUSTER_GRID_X - 1.0f, 1.0f - 2.0f * coordinates.y / CLUSTER_GRID_Y);
+	tileMin *= glm::vec2(header.projection.x, header.projection.y);
+	tileMax *= glm::vec2(header.projection.x, header.projection.y);
+
+	glm::vec2 xyMin = glm::min(tileMin * sliceNear, tileMin * sliceFar);
+	glm::vec2 xyMax = glm::max(tileMax * sliceNear, tileMax * sliceFar);
+	boundsMin = glm::vec3(xyMin, -sliceFar);
+	boundsMax = glm::vec3(xyMax, -sliceNear);
+}
+
+void CClusteredLights::cull(const LightBufferHeader& header, const PointLight* lights, ClusterData& clusters, CJobSystem& jobSystem)
+{
+	std::vector<glm::vec4> viewLights(header.lightCount);
+	for (uint32_t i = 0; i < header.lightCount; i++)
+	{
+		glm::vec4 center = header.view * glm::vec4(glm::vec3(lights[i].positionRadius), 1.0f);
+		viewLights[i] = glm::vec4(glm::vec3(center), lights[i].positionRadius.w);
+	}
+
+	clusters.lightCounts.assign(CLUSTER_COUNT, 0);
+	clusters.lightIndices.resize(static_cast<size_t>(CLUSTER_COUNT) * MAX_LIGHTS_PER_CLUSTER);
+	jobSystem.parallelFor(CLUSTER_COUNT, 64, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t cluster = begin; cluster < end; cluster++)
+		{
+			glm::vec3 boundsMin, boundsMax;
+			getClusterBounds(header, cluster, boundsMin, boundsMax);
+
+			uint32_t count = 0;
+			uint32_t* indices = &clusters.lightIndices[static_cast<size_t>(cluster) * MAX_LIGHTS_PER_CLUSTER];
+			for (uint32_t i = 0; i < header.lightCount; i++)
+			{
+				glm::vec3 center(viewLights[i]);
+				glm::vec3 closest = glm::clamp(center, boundsMin, boundsMax);
+				glm::vec3 offset = center - closest;
+				if (glm::dot(offset, offset) <= viewLights[i].w * viewLights[i].w)
+				{
+					if (count < MAX_LIGHTS_PER_CLUSTER)
+					{
+						indices[count] = i;
+					}
+					count++;
+				}
+			}
+			clusters.lightCounts[cluster] = count;
+		}
+	});
+}
+
+void CClusteredLights::writeClusterBuffer(const ClusterData& clusters, void* clusterBuffer)
+{
+	uint32_t* counts = static_cast<uint32_t*>(clusterBuffer);
+	for (uint32_t cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+	{
+		counts[cluster] = std::min(clusters.lightCounts[cluster], MAX_LIGHTS_PER_CLUSTER);
+	}
+	memcpy(counts + CLUSTER_COUNT, clusters.lightIndices.data(), clusters.lightIndices.size() * sizeof(uint32_t));
+}
+
+ClusterStats CClusteredLights::getStats(const ClusterData& clusters)
+{
+	ClusterStats stats;
+	uint64_t total = 0;
+	for (uint32_t count : clusters.lightCounts)
+	{
+		if (count > 0)
+		{
+			stats.occupiedClusters++;
+			total += std::min(count, MAX_LIGHTS_PER_CLUSTER);
+		}
+		stats.maxLights = std::max(stats.maxLights, count);
+		stats.overflowClusters += (count > MAX_LIGHTS_PER_CLUSTER) ? 1 : 0;
+	}
+	stats.averageLights = stats.occupiedClusters ? static_cast<double>(total) / stats.occupiedClusters : 0.0;
+	return stats;
+}
+
+bool CClusteredLights::selfTest()
+{
+	bool passed = true;
+	auto check = [&](bool condition, const char* what)
+	{
+		if (condition == false)
+		{
+			printf("  FAILED: %s\n", what);
+			passed = false;
+		}
+	};
+
+	CJobSystem jobSystem;
+
+	// same camera as the renderer, 16:9
+	glm::mat4 view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 10.0f);
+	proj[1][1] *= -1.0f;
+
+	// grid parameters recovered from the matrix
+	LightBufferHeader header = makeHeader(view, proj, 1920, 1080, 0);
+	check(std::abs(header.projection.z - 0.1f) < 1e-5f && std::abs(header.projection.w - 10.0f) < 1e-3f, "near/far from ubo.proj");
+	check(std::abs(header.projection.y - std::tan(glm::radians(22.5f))) < 1e-5f, "vertical field of view from ubo.proj");
+	check(std::abs(header.projection.x - header.projection.y * 16.0f / 9.0f) < 1e-5f, "horizontal field of view from ubo.proj");
+
+	// the center of every cluster's bounds maps back to that cluster
+	uint32_t mismatches = 0;
+	for (uint32_t cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+	{
+		glm::vec3 boundsMin, boundsMax;
+		getClusterBounds(header, cluster, boundsMin, boundsMax);
+		mismatches += (getClusterIndex(header, (boundsMin + boundsMax) * 0.5f) != cluster) ? 1 : 0;
+	}
+	printf("Cluster grid %ux%ux%u: %u of %u cluster centers map to another cluster\n",
+		CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z, mismatches, CLUSTER_COUNT);
+	check(mismatches == 0, "cluster bounds and cluster lookup agree");
+
+	// no lights: every cluster is empty
+	ClusterData clusters;
+	cull(header, nullptr, clusters, jobSystem);
+	check(getStats(clusters).occupiedClusters == 0, "no lights, no cluster entries");
+
+	// conservative culling: any light that reaches a visible point is in the point's cluster
+	for (uint32_t lightCount : { 16u, 1024u, MAX_POINT_LIGHTS })
+	{
+		std::vector<PointLight> lights = createForestLights(lightCount);
+		header = makeHeader(view, proj, 1920, 1080, lightCount);
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+		cull(header, lights.data(), clusters, jobSystem);
+		auto endTime = std::chrono::high_resolution_clock::now();
+
+		// an overflowing cluster drops lights, so its points count as missing below rather than being skipped
+		uint32_t missing = 0;
+		uint32_t tested = 0;
+		const uint32_t pointCount = 20000;
+		float extent = getForestLightExtent(lightCount) + 0.3f;
+		for (uint32_t p = 0; p < pointCount; p++)
+		{
+			// random world point in the light volume, tested if it is on screen
+			glm::vec3 world((hashToUnit(p * 3u + 1000001u) * 2.0f - 1.0f) * extent, (hashToUnit(p * 3u + 1000002u) * 2.0f - 1.0f) * extent,
+				hashToUnit(p * 3u + 1000003u) * 1.6f - 0.2f);
+			uint32_t cluster = getClusterIndex(header, glm::vec3(view * glm::vec4(world, 1.0f)));
+			if (cluster == UINT32_MAX)
+			{
+				continue;
+			}
+			const uint32_t* begin = &clusters.lightIndices[static_cast<size_t>(cluster) * MAX_LIGHTS_PER_CLUSTER];
+			const uint32_t* end = begin + std::min(clusters.lightCounts[cluster], MAX_LIGHTS_PER_CLUSTER);
+			for (uint32_t i = 0; i < lightCount; i++)
+			{
+				// strictly inside (0.1% margin): points on the sphere itself are at the mercy of rounding
+				if (glm::length(world - glm::vec3(lights[i].positionRadius)) < lights[i].positionRadius.w * 0.999f)
+				{
+					tested++;
+					missing += (std::find(begin, end, i) == end) ? 1 : 0;
+				}
+			}
+		}
+
+		ClusterStats stats = getStats(clusters);
+		printf("%5u lights: CPU cull %.2f ms, %u clusters occupied, %.1f avg / %u max lights per cluster, %u overflowing, %u of %u point-light pairs missing\n",
+			lightCount, std::chrono::duration<double, std::milli>(endTime - startTime).count(), stats.occupiedClusters,
+			stats.averageLights, stats.maxLights, stats.overflowClusters, missing, tested);
+		check(stats.overflowClusters == 0, "no cluster exceeds MAX_LIGHTS_PER_CLUSTER");
+		check(tested > 0 && missing == 0, "every light reaching a point is in the point's cluster");
+	}
+
+	printf(passed ? "Clustered lights: all checks passed\n" : "Clustered lights: FAILED\n");
+	return passed;
+}
@@ -0,0 +1,97 @@
+/*======================================================================
+VulkanPBR_AcornForest : ClusteredLights.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Clustered forward lighting: point lights binned into a 3D froxel grid.
+The view frustum is split into CLUSTER_GRID_X x CLUSTER_GRID_Y screen
+tiles and CLUSTER_GRID_Z depth slices, exponentially spaced between the
+near and far planes of ubo.proj. The culling pass (Shaders/cluster_cull.comp,
+CLightCuller) tests every light sphere against every cluster's view-space
+bounding box and writes a fixed-size list of light indices per cluster;
+the fragment shader only loops over the list of its own cluster, so its
+cost follows the lights near the pixel instead of the total light count.
+
+This file has the GPU buffer layouts, the grid parameters derived from
+the projection matrix, the firefly/lantern light set, and a CPU
+reference of the culling pass: used when the GPU culler is unavailable,
+for the --bench-lights occupancy statistics and by --validate-lights.
+=======================================================================*/
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class CJobSystem;
+
+// keep in sync with Shaders/cluster_cull.comp and the fragment shaders
+const uint32_t CLUSTER_GRID_X = 16;
+const uint32_t CLUSTER_GRID_Y = 9;
+const uint32_t CLUSTER_GRID_Z = 24;
+const uint32_t CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+const uint32_t MAX_LIGHTS_PER_CLUSTER = 256;    // further lights are dropped (counted as overflow)
+const uint32_t FOREST_LIGHT_BASE_COUNT = 256;   // createForestLights() fills a 3 x 3 square up to this count
+const uint32_t MAX_POINT_LIGHTS = 4096;
+
+// std430, world space
+struct PointLight
+{
+	glm::vec4 positionRadius;    // xyz = position, w = radius (zero contribution beyond it)
+	glm::vec4 colorIntensity;    // rgb = color, a = intensity
+};
+
+// std430 header of the light buffer, followed by lightCount PointLights
+struct LightBufferHeader
+{
+	glm::mat4 view;              // world -> view, for the culling pass
+	glm::vec4 projection;        // tan(fovX / 2), tan(fovY / 2), near, far
+	glm::vec4 screen;            // width, height, depth slice scale, depth slice bias
+	uint32_t  lightCount;
+	uint32_t  padding[3];
+};
+
+// std430 cluster buffer: light count of every cluster, then MAX_LIGHTS_PER_CLUSTER indices per cluster
+const size_t CLUSTER_BUFFER_SIZE = sizeof(uint32_t) * CLUSTER_COUNT * (1 + MAX_LIGHTS_PER_CLUSTER);
+
+struct ClusterData
+{
+	std::vector<uint32_t>   lightCounts;     // CLUSTER_COUNT, may exceed MAX_LIGHTS_PER_CLUSTER
+	std::vector<uint32_t>   lightIndices;    // CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER
+};
+
+struct ClusterStats
+{
+	uint32_t    occupiedClusters = 0;
+	double      averageLights = 0.0;         // per occupied cluster
+	uint32_t    maxLights = 0;
+	uint32_t    overflowClusters = 0;        // clusters that dropped lights
+};
+
+class CClusteredLights
+{
+public:
+
+	// near/far and field of view from a perspective matrix (glm::perspective, depth 0..1, Y flipped or not)
+	static LightBufferHeader makeHeader(const glm::mat4& view, const glm::mat4& proj, uint32_t width, uint32_t height, uint32_t lightCount);
+
+	// Fireflies and lanterns around the model, deterministic for a given count. Past FOREST_LIGHT_BASE_COUNT
+	// the square they spawn in grows with the count, so the density (and lights per cluster) stays the same.
+	static std::vector<PointLight> createForestLights(uint32_t count);
+	static float getForestLightExtent(uint32_t count);    // half width of that square
+	static void animate(const std::vector<PointLight>& base, std::vector<PointLight>& lights, float time);
+
+	// cluster of a view-space position, same mapping as the fragment shaders; UINT32_MAX outside the frustum
+	static uint32_t getClusterIndex(const LightBufferHeader& header, const glm::vec3& viewPosition);
+	static void getClusterBounds(const LightBufferHeader& header, uint32_t cluster, glm::vec3& boundsMin, glm::vec3& boundsMax);
+
+	// CPU reference of cluster_cull.comp (also the fallback without it); writeClusterBuffer() stores the
+	// result in the layout of the GPU cluster buffer (CLUSTER_BUFFER_SIZE bytes)
+	static void cull(const LightBufferHeader& header, const PointLight* lights, ClusterData& clusters, CJobSystem& jobSystem);
+	static void writeClusterBuffer(const ClusterData& clusters, void* clusterBuffer);
+	static ClusterStats getStats(const ClusterData& clusters);
+
+	// CPU-only checks of the grid mapping and the culling: no light that reaches a point is missing from its cluster
+	static bool selfTest();
+};
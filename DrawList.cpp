@@ -0,0 +1,301 @@
+/*======================================================================
+VulkanPBR_AcornForest : DrawList.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "DrawList.h"
+#include "BenchUtil.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+	const uint32_t RADIX_BITS = 8;
+	const uint32_t RADIX_BUCKETS = 1u << RADIX_BITS;
+	const uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+	const size_t RADIX_BLOCK_SIZE = 16384;    // keys per job; smaller lists sort on the calling thread
+	const uint32_t RADIX_MAX_BLOCKS = 64;
+
+	const uint32_t PIPELINE_SLOT_COUNT = 1u << 12;
+	const uint32_t MATERIAL_COUNT = 1u << 16;
+}
+
+uint64_t CDrawList::makeSortKey(uint32_t pass, uint32_t pipelineSlot, uint32_t materialIndex, float depth)
+{
+	// non-negative floats order like their bit patterns
+	uint32_t depthBits = 0;
+	float clampedDepth = std::max(depth, 0.0f);
+	memcpy(&depthBits, &clampedDepth, sizeof(depthBits));
+
+	return (static_cast<uint64_t>(pass & 0xF) << 60)
+		| (static_cast<uint64_t>(pipelineSlot & (PIPELINE_SLOT_COUNT - 1)) << 48)
+		| (static_cast<uint64_t>(materialIndex & (MATERIAL_COUNT - 1)) << 32)
+		| depthBits;
+}
+
+void CDrawList::clear()
+{
+	m_Packets.clear();
+	m_PipelineKeys.clear();
+	m_Sorted = false;
+}
+
+void CDrawList::add(uint32_t pass, uint32_t pipelineKey, uint32_t materialIndex, float depth, uint32_t firstIndex, uint32_t indexCount,
+	uint32_t firstInstance, uint32_t instanceCount)
+{
+	uint32_t slot = static_cast<uint32_t>(std::find(m_PipelineKeys.begin(), m_PipelineKeys.end(), pipelineKey) - m_PipelineKeys.begin());
+	if (slot == m_PipelineKeys.size())
+	{
+		m_PipelineKeys.push_back(pipelineKey);
+	}
+
+	DrawPacket packet;
+	packet.sortKey = makeSortKey(pass, slot, materialIndex, depth);
+	packet.pass = pass;
+	packet.pipelineKey = pipelineKey;
+	packet.materialIndex = materialIndex;
+	packet.firstIndex = firstIndex;
+	packet.indexCount = indexCount;
+	packet.firstInstance = firstInstance;
+	packet.instanceCount = instanceCount;
+	m_Packets.push_back(packet);
+	m_Sorted = false;
+}
+
+void CDrawList::sort(CJobSystem& jobSystem)
+{
+	size_t count = m_Packets.size();
+	m_Keys.resize(count);
+	m_Order.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		m_Keys[i] = m_Packets[i].sortKey;
+		m_Order[i] = static_cast<uint32_t>(i);
+	}
+	radixSort(m_Keys.data(), m_Order.data(), count, jobSystem);
+
+	m_SortedPackets.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		m_SortedPackets[i] = m_Packets[m_Order[i]];
+	}
+	m_Packets.swap(m_SortedPackets);
+	m_Sorted = true;
+}
+
+void CDrawList::radixSort(uint64_t* keys, uint32_t* values, size_t count, CJobSystem& jobSystem)
+{
+	if (count < 2)
+	{
+		return;
+	}
+
+	uint32_t blockCount = static_cast<uint32_t>(std::min<size_t>(std::max<size_t>(count / RADIX_BLOCK_SIZE, 1), RADIX_MAX_BLOCKS));
+	size_t blockSize = (count + blockCount - 1) / blockCount;
+
+	std::vector<uint64_t> keyScratch(count);
+	std::vector<uint32_t> valueScratch(count);
+	std::vector<size_t> offsets(static_cast<size_t>(blockCount) * RADIX_BUCKETS);    // per block: histogram, then write offsets
+
+	uint64_t* sourceKeys = keys;
+	uint32_t* sourceValues = values;
+	uint64_t* targetKeys = keyScratch.data();
+	uint32_t* targetValues = valueScratch.data();
+
+	for (uint32_t pass = 0; pass < RADIX_PASSES; pass++)
+	{
+		const uint32_t shift = pass * RADIX_BITS;
+
+		// 1. digit histogram of every block
+		jobSystem.parallelFor(blockCount, 1, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t block = begin; block < end; block++)
+			{
+				size_t* histogram = &offsets[static_cast<size_t>(block) * RADIX_BUCKETS];
+				std::fill(histogram, histogram + RADIX_BUCKETS, 0);
+				size_t last = std::min(count, (block + 1) * blockSize);
+				for (size_t i = block * blockSize; i < last; i++)
+				{
+					histogram[(sourceKeys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+				}
+			}
+		});
+
+		// every key has the same digit: the pass would not move anything
+		uint32_t digit = static_cast<uint32_t>((sourceKeys[0] >> shift) & (RADIX_BUCKETS - 1));
+		size_t sameDigit = 0;
+		for (uint32_t block = 0; block < blockCount; block++)
+		{
+			sameDigit += offsets[static_cast<size_t>(block) * RADIX_BUCKETS + digit];
+		}
+		if (sameDigit == count)
+		{
+			continue;
+		}
+
+		// 2. exclusive prefix sum, digit-major then block: block b writes its keys of a digit after blocks 0..b-1 (stable)
+		size_t sum = 0;
+		for (uint32_t bucket = 0; bucket < RADIX_BUCKETS; bucket++)
+		{
+			for (uint32_t block = 0; block < blockCount; block++)
+			{
+				size_t& offset = offsets[static_cast<size_t>(block) * RADIX_BUCKETS + bucket];
+				size_t blockCountOfDigit = offset;
+				offset = sum;
+				sum += blockCountOfDigit;
+			}
+		}
+
+		// 3. scatter
+		jobSystem.parallelFor(blockCount, 1, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t block = begin; block < end; block++)
+			{
+				size_t* blockOffsets = &offsets[static_cast<size_t>(block) * RADIX_BUCKETS];
+				size_t last = std::min(count, (block + 1) * blockSize);
+				for (size_t i = block * blockSize; i < last; i++)
+				{
+					size_t target = blockOffsets[(sourceKeys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+					targetKeys[target] = sourceKeys[i];
+					targetValues[target] = sourceValues[i];
+				}
+			}
+		});
+
+		std::swap(sourceKeys, targetKeys);
+		std::swap(sourceValues, targetValues);
+	}
+
+	if (sourceKeys != keys)
+	{
+		memcpy(keys, sourceKeys, count * sizeof(uint64_t));
+		memcpy(values, sourceValues, count * sizeof(uint32_t));
+	}
+}
+
+void CDrawList::benchmark()
+{
+	const size_t counts[] = { 1000, 10000, 100000, 1000000 };
+	const uint32_t iterations = 10;
+
+	CJobSystem jobSystem;
+	printf("Draw key radix sort (%u threads), %u runs per count\n", jobSystem.getWorkerCount() + 1, iterations);
+	printf("     keys   radix (ms)   std::stable_sort (ms)   speedup   result\n");
+
+	for (size_t count : counts)
+	{
+		// draw-like keys: few passes, pipelines and materials, random depth
+		uint64_t state = 0x9E3779B97F4A7C15ull + count;
+		std::vector<uint64_t> input(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			uint64_t random = nextRandom(state);
+			input[i] = makeSortKey(static_cast<uint32_t>(random & 1), static_cast<uint32_t>((random >> 1) & 7),
+				static_cast<uint32_t>((random >> 4) & 63), static_cast<float>((random >> 16) & 0xFFFFF) / 4096.0f);
+		}
+
+		std::vector<uint64_t> keys;
+		std::vector<uint32_t> values(count);
+		double radixMs = 0.0;
+		for (uint32_t run = 0; run < iterations; run++)
+		{
+			keys = input;
+			std::iota(values.begin(), values.end(), 0u);
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			radixSort(keys.data(), values.data(), count, jobSystem);
+			radixMs += elapsedMs(start) / iterations;
+		}
+
+		std::vector<uint32_t> reference(count);
+		double stableSortMs = 0.0;
+		for (uint32_t run = 0; run < iterations; run++)
+		{
+			std::iota(reference.begin(), reference.end(), 0u);
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			std::stable_sort(reference.begin(), reference.end(), [&](uint32_t a, uint32_t b) { return input[a] < input[b]; });
+			stableSortMs += elapsedMs(start) / iterations;
+		}
+
+		// stable: equal keys keep their input order, so the permutations must match exactly
+		bool matches = (values == reference);
+		printf("  %7zu   %10.3f   %21.3f   %6.2fx   %s\n", count, radixMs, stableSortMs, stableSortMs / std::max(radixMs, 1e-6),
+			matches ? "ok" : "MISMATCH");
+	}
+}
+
+void CDrawStateCache::bindPipeline(VkCommandBuffer commandBuffer, VkPipeline pipeline)
+{
+	if (m_Filter && pipeline == m_Pipeline)
+	{
+		m_Stats.skipped++;
+		return;
+	}
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	m_Pipeline = pipeline;
+	m_Stats.pipelineBinds++;
+}
+
+void CDrawStateCache::bindDescriptorSet(VkCommandBuffer commandBuffer, VkPipelineLayout layout, uint32_t setIndex, VkDescriptorSet set)
+{
+	// every pipeline variant shares one layout, so bound sets stay valid across pipeline binds
+	if (m_Filter && setIndex < MAX_SETS && set == m_Sets[setIndex])
+	{
+		m_Stats.skipped++;
+		return;
+	}
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, setIndex, 1, &set, 0, nullptr);
+	if (setIndex < MAX_SETS)
+	{
+		m_Sets[setIndex] = set;
+	}
+	m_Stats.descriptorBinds++;
+}
+
+void CDrawStateCache::bindGeometry(VkCommandBuffer commandBuffer, VkBuffer vertexBuffer, VkBuffer instanceBuffer, VkBuffer indexBuffer)
+{
+	if (m_Filter && vertexBuffer == m_VertexBuffer && instanceBuffer == m_InstanceBuffer && indexBuffer == m_IndexBuffer)
+	{
+		m_Stats.skipped++;
+		return;
+	}
+	VkBuffer buffers[2] = { vertexBuffer, instanceBuffer };
+	VkDeviceSize offsets[2] = { 0, 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 2, buffers, offsets);
+	vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	m_VertexBuffer = vertexBuffer;
+	m_InstanceBuffer = instanceBuffer;
+	m_IndexBuffer = indexBuffer;
+	m_Stats.vertexBinds++;
+}
+
+void CDrawStateCache::pushMaterial(VkCommandBuffer commandBuffer, VkPipelineLayout layout, const std::vector<VkPushConstantRange>& ranges,
+	uint32_t materialIndex)
+{
+	if (ranges.empty())
+	{
+		return;
+	}
+	if (m_Filter && materialIndex == m_MaterialIndex)
+	{
+		m_Stats.skipped++;
+		return;
+	}
+	for (const VkPushConstantRange& range : ranges)
+	{
+		vkCmdPushConstants(commandBuffer, layout, range.stageFlags, 0, sizeof(uint32_t), &materialIndex);
+	}
+	m_MaterialIndex = materialIndex;
+	m_Stats.pushConstants++;
+}
+
+void CDrawStateCache::drawIndexed(VkCommandBuffer commandBuffer, uint32_t firstIndex, uint32_t indexCount, uint32_t firstInstance,
+	uint32_t instanceCount)
+{
+	vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, 0, firstInstance);
+	m_Stats.draws++;
+}
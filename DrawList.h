@@ -0,0 +1,118 @@
+/*======================================================================
+VulkanPBR_AcornForest : DrawList.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Draw packets with 64-bit sort keys.
+Every draw of a frame is a packet in a CDrawList. Its key orders, from
+the most significant bits down:
+  pass (4 bits)        depth prepass before the opaque pass
+  pipeline (12 bits)   slot of the pipeline variant in this list
+  material (16 bits)   material index (push constant)
+  depth (32 bits)      distance to the camera, front to back
+so after sort() the draws of a pass are grouped by pipeline and material
+and each group runs nearest first (early depth test rejects more).
+Keys are sorted by a parallel LSD radix sort (8 passes of 8 bits on the
+job system, passes whose digit is the same for every key are skipped).
+
+CDrawStateCache records the binds of each packet and leaves out the ones
+that would bind what the command buffer already has bound; the unsorted
+baseline (--no-draw-sort) binds the full state of every draw.
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+class CJobSystem;
+
+enum DrawPass : uint32_t
+{
+	DRAW_PASS_DEPTH_PREPASS = 0,
+	DRAW_PASS_OPAQUE = 1,
+};
+
+struct DrawPacket
+{
+	uint64_t    sortKey = 0;
+	uint32_t    pass = DRAW_PASS_OPAQUE;
+	uint32_t    pipelineKey = 0;          // CPipelineVariants key
+	uint32_t    materialIndex = 0;
+	uint32_t    firstIndex = 0;           // range of the index buffer
+	uint32_t    indexCount = 0;
+	uint32_t    firstInstance = 0;        // range of the instance buffer
+	uint32_t    instanceCount = 1;
+};
+
+struct DrawRecordStats
+{
+	uint32_t    draws = 0;
+	uint32_t    pipelineBinds = 0;
+	uint32_t    descriptorBinds = 0;
+	uint32_t    vertexBinds = 0;          // vertex + instance + index buffer
+	uint32_t    pushConstants = 0;
+	uint32_t    skipped = 0;              // redundant binds and pushes left out
+};
+
+class CDrawList
+{
+private:
+
+	std::vector<DrawPacket> m_Packets;
+	std::vector<uint32_t>   m_PipelineKeys;    // pipeline slot of the sort key -> variant key
+	bool                    m_Sorted = false;
+
+	// sort scratch, kept between frames
+	std::vector<uint64_t>   m_Keys;
+	std::vector<uint32_t>   m_Order;
+	std::vector<DrawPacket> m_SortedPackets;
+
+public:
+
+	static uint64_t makeSortKey(uint32_t pass, uint32_t pipelineSlot, uint32_t materialIndex, float depth);
+
+	void clear();
+	void add(uint32_t pass, uint32_t pipelineKey, uint32_t materialIndex, float depth, uint32_t firstIndex, uint32_t indexCount,
+		uint32_t firstInstance = 0, uint32_t instanceCount = 1);
+	void sort(CJobSystem& jobSystem);    // packets in key order; without it they stay in add() order
+
+	const std::vector<DrawPacket>& getPackets() const { return m_Packets; }
+	bool isSorted() const { return m_Sorted; }
+
+	// Stable LSD radix sort of keys, values moved along (values[i] belongs to keys[i]).
+	static void radixSort(uint64_t* keys, uint32_t* values, size_t count, CJobSystem& jobSystem);
+
+	// CPU-only: radix sort against std::stable_sort (result and time) for 1K..1M keys
+	static void benchmark();
+};
+
+// Binds for a sequence of draws in one command buffer; with filtering on, a bind of the state already bound is skipped.
+class CDrawStateCache
+{
+private:
+
+	static const uint32_t MAX_SETS = 4;
+
+	bool                m_Filter = true;
+	VkPipeline          m_Pipeline = VK_NULL_HANDLE;
+	VkDescriptorSet     m_Sets[MAX_SETS] = {};
+	VkBuffer            m_VertexBuffer = VK_NULL_HANDLE;
+	VkBuffer            m_InstanceBuffer = VK_NULL_HANDLE;
+	VkBuffer            m_IndexBuffer = VK_NULL_HANDLE;
+	uint32_t            m_MaterialIndex = UINT32_MAX;
+	DrawRecordStats     m_Stats;
+
+public:
+
+	explicit CDrawStateCache(bool filterRedundant) : m_Filter(filterRedundant) {}
+
+	void bindPipeline(VkCommandBuffer commandBuffer, VkPipeline pipeline);
+	void bindDescriptorSet(VkCommandBuffer commandBuffer, VkPipelineLayout layout, uint32_t setIndex, VkDescriptorSet set);
+	void bindGeometry(VkCommandBuffer commandBuffer, VkBuffer vertexBuffer, VkBuffer instanceBuffer, VkBuffer indexBuffer);
+	void pushMaterial(VkCommandBuffer commandBuffer, VkPipelineLayout layout, const std::vector<VkPushConstantRange>& ranges, uint32_t materialIndex);
+	void drawIndexed(VkCommandBuffer commandBuffer, uint32_t firstIndex, uint32_t indexCount, uint32_t firstInstance, uint32_t instanceCount);
+
+	const DrawRecordStats& getStats() const { return m_Stats; }
+};
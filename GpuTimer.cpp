@@ -0,0 +1,94 @@
+/*======================================================================
+VulkanPBR_AcornForest : GpuTimer.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "GpuTimer.h"
+
+#include <stdexcept>
+
+bool CGpuTimer::isSupported(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex)
+{
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+	return queueFamilyIndex < queueFamilyCount && queueFamilies[queueFamilyIndex].timestampValidBits > 0;
+}
+
+void CGpuTimer::create(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t maxQueries)
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	m_Device = device;
+	m_MaxQueries = maxQueries;
+	m_TimestampPeriod = properties.limits.timestampPeriod;
+
+	VkQueryPoolCreateInfo queryPoolInfo{};
+	queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = maxQueries;
+
+	if (vkCreateQueryPool(m_Device, &queryPoolInfo, nullptr, &m_QueryPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create timestamp query pool!");
+	}
+}
+
+void CGpuTimer::destroy()
+{
+	if (m_QueryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(m_Device, m_QueryPool, nullptr);
+		m_QueryPool = VK_NULL_HANDLE;
+	}
+}
+
+void CGpuTimer::reset(VkCommandBuffer commandBuffer)
+{
+	vkCmdResetQueryPool(commandBuffer, m_QueryPool, 0, m_MaxQueries);
+	m_Labels.clear();
+}
+
+void CGpuTimer::timestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits stage, const std::string& label)
+{
+	if (m_Labels.size() >= m_MaxQueries)
+	{
+		throw std::runtime_error("Failed to write timestamp: query pool is full!");
+	}
+
+	vkCmdWriteTimestamp(commandBuffer, stage, m_QueryPool, static_cast<uint32_t>(m_Labels.size()));
+	m_Labels.push_back(label);
+}
+
+bool CGpuTimer::resolve(std::vector<std::pair<std::string, double>>& sections, bool wait)
+{
+	sections.clear();
+	if (m_Labels.size() < 2)
+	{
+		return true;
+	}
+
+	std::vector<uint64_t> ticks(m_Labels.size());
+	VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | (wait ? VK_QUERY_RESULT_WAIT_BIT : 0);
+	VkResult result = vkGetQueryPoolResults(m_Device, m_QueryPool, 0, static_cast<uint32_t>(ticks.size()),
+		ticks.size() * sizeof(uint64_t), ticks.data(), sizeof(uint64_t), flags);
+
+	if (result == VK_NOT_READY)
+	{
+		return false;
+	}
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to read timestamp queries!");
+	}
+
+	for (size_t i = 1; i < ticks.size(); i++)
+	{
+		double ms = double(ticks[i] - ticks[i - 1]) * m_TimestampPeriod / 1000000.0;
+		sections.push_back({ m_Labels[i], ms });
+	}
+	return true;
+}
@@ -0,0 +1,46 @@
+/*======================================================================
+VulkanPBR_AcornForest : GpuTimer.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+GPU timestamp queries.
+Record timestamp() between pieces of work in a command buffer, submit,
+and once the work has completed resolve() returns the time between each
+pair of consecutive timestamps, labelled by the later one.
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+class CGpuTimer
+{
+private:
+
+	VkDevice                    m_Device = VK_NULL_HANDLE;
+	VkQueryPool                 m_QueryPool = VK_NULL_HANDLE;
+	uint32_t                    m_MaxQueries = 0;
+	float                       m_TimestampPeriod = 1.0f;    // nanoseconds per tick
+	std::vector<std::string>    m_Labels;                    // one per recorded timestamp
+
+public:
+
+	// returns false if the queue family cannot write timestamps
+	static bool isSupported(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex);
+
+	void create(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t maxQueries);
+	void destroy();
+
+	// must be recorded before the first timestamp() of a command buffer
+	void reset(VkCommandBuffer commandBuffer);
+	void timestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits stage, const std::string& label);
+
+	// Fetches the results (waits if wait == true). Returns false if they are not available yet.
+	// sections[i] = { label of timestamp i + 1, milliseconds since timestamp i }
+	bool resolve(std::vector<std::pair<std::string, double>>& sections, bool wait = true);
+
+	uint32_t getTimestampCount() const { return static_cast<uint32_t>(m_Labels.size()); }
+};
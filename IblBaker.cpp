@@ -0,0 +1,308 @@
+/*======================================================================
+VulkanPBR_AcornForest : IblBaker.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "IblBaker.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+	struct IblPushConstants
+	{
+		uint32_t outputWidth;
+		uint32_t outputHeight;
+		float    roughness;
+		uint32_t sampleCount;
+	};
+
+	const uint32_t IBL_GROUP_SIZE = 8;    // local_size_x/y in ibl.comp
+}
+
+bool CIblBaker::isSupported(VkPhysicalDevice physicalDevice)
+{
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(physicalDevice, FORMAT, &formatProperties);
+	const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	return (formatProperties.optimalTilingFeatures & required) == required;
+}
+
+void CIblBaker::create(VkDevice device, const std::vector<char>& shaderCode, VkPipelineCache pipelineCache)
+{
+	m_Device = device;
+
+	// 0: environment, 1: output level
+	std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	bindings[1].descriptorCount = 1;
+	bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &m_DescriptorSetLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create IBL baker descriptor set layout!");
+	}
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(IblPushConstants);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &m_DescriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(m_Device, &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create IBL baker pipeline layout!");
+	}
+
+	VkShaderModuleCreateInfo moduleInfo{};
+	moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize = shaderCode.size();
+	moduleInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data());
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(m_Device, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create IBL baker shader module!");
+	}
+
+	// one pipeline per pass: IBL_PASS (constant_id 0) folds the other passes away
+	VkResult result = VK_SUCCESS;
+	for (uint32_t pass = 0; pass < IBL_PASS_COUNT && result == VK_SUCCESS; pass++)
+	{
+		VkSpecializationMapEntry mapEntry{};
+		mapEntry.constantID = 0;
+		mapEntry.offset = 0;
+		mapEntry.size = sizeof(uint32_t);
+
+		VkSpecializationInfo specializationInfo{};
+		specializationInfo.mapEntryCount = 1;
+		specializationInfo.pMapEntries = &mapEntry;
+		specializationInfo.dataSize = sizeof(uint32_t);
+		specializationInfo.pData = &pass;
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = shaderModule;
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.stage.pSpecializationInfo = &specializationInfo;
+		pipelineInfo.layout = m_PipelineLayout;
+
+		result = vkCreateComputePipelines(m_Device, pipelineCache, 1, &pipelineInfo, nullptr, &m_Pipelines[pass]);
+	}
+	vkDestroyShaderModule(m_Device, shaderModule, nullptr);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create IBL baker pipeline!");
+	}
+
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;           // azimuth wraps around
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;    // poles do not
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = 0.0f;
+
+	if (vkCreateSampler(m_Device, &samplerInfo, nullptr, &m_EnvironmentSampler) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create IBL baker sampler!");
+	}
+}
+
+void CIblBaker::destroy()
+{
+	releaseTransient();
+
+	if (m_Device == VK_NULL_HANDLE)
+	{
+		return;
+	}
+	vkDestroySampler(m_Device, m_EnvironmentSampler, nullptr);
+	for (VkPipeline& pipeline : m_Pipelines)
+	{
+		vkDestroyPipeline(m_Device, pipeline, nullptr);
+		pipeline = VK_NULL_HANDLE;
+	}
+	vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
+	vkDestroyDescriptorSetLayout(m_Device, m_DescriptorSetLayout, nullptr);
+
+	m_EnvironmentSampler = VK_NULL_HANDLE;
+	m_PipelineLayout = VK_NULL_HANDLE;
+	m_DescriptorSetLayout = VK_NULL_HANDLE;
+}
+
+VkImageView CIblBaker::createLevelView(VkImage image, uint32_t level)
+{
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = FORMAT;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.baseMipLevel = level;
+	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+
+	VkImageView view;
+	if (vkCreateImageView(m_Device, &viewInfo, nullptr, &view) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create IBL baker image view!");
+	}
+	m_TransientViews.push_back(view);
+	return view;
+}
+
+void CIblBaker::recordPass(VkCommandBuffer commandBuffer, VkDescriptorPool descriptorPool, IblPass pass, VkImageView environment,
+	VkImage target, uint32_t level, uint32_t width, uint32_t height, float roughness, uint32_t sampleCount)
+{
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &m_DescriptorSetLayout;
+
+	VkDescriptorSet descriptorSet;
+	if (vkAllocateDescriptorSets(m_Device, &allocInfo, &descriptorSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate IBL baker descriptor set!");
+	}
+
+	VkDescriptorImageInfo environmentInfo{};
+	environmentInfo.sampler = m_EnvironmentSampler;
+	environmentInfo.imageView = environment;
+	environmentInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkDescriptorImageInfo outputInfo{};
+	outputInfo.imageView = createLevelView(target, level);
+	outputInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	std::vector<VkWriteDescriptorSet> writes(2);
+	for (VkWriteDescriptorSet& write : writes)
+	{
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = descriptorSet;
+		write.dstArrayElement = 0;
+		write.descriptorCount = 1;
+	}
+	writes[0].dstBinding = 0;
+	writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	writes[0].pImageInfo = &environmentInfo;
+	writes[1].dstBinding = 1;
+	writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	writes[1].pImageInfo = &outputInfo;
+	vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipelines[static_cast<uint32_t>(pass)]);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+
+	IblPushConstants pushConstants{ width, height, roughness, sampleCount };
+	vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+	vkCmdDispatch(commandBuffer, (width + IBL_GROUP_SIZE - 1) / IBL_GROUP_SIZE, (height + IBL_GROUP_SIZE - 1) / IBL_GROUP_SIZE, 1);
+}
+
+void CIblBaker::record(VkCommandBuffer commandBuffer, VkImageView environment, VkImage irradiance, VkImage prefiltered, VkImage brdfLut)
+{
+	const VkImage targets[IBL_PASS_COUNT] = { irradiance, prefiltered, brdfLut };
+	const uint32_t levelCounts[IBL_PASS_COUNT] = { 1, IBL_PREFILTERED_LEVELS, 1 };
+
+	// every level UNDEFINED -> GENERAL; the passes write disjoint images, so no barriers in between
+	VkImageMemoryBarrier barriers[IBL_PASS_COUNT]{};
+	for (uint32_t i = 0; i < IBL_PASS_COUNT; i++)
+	{
+		barriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barriers[i].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barriers[i].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barriers[i].image = targets[i];
+		barriers[i].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barriers[i].subresourceRange.baseMipLevel = 0;
+		barriers[i].subresourceRange.levelCount = levelCounts[i];
+		barriers[i].subresourceRange.baseArrayLayer = 0;
+		barriers[i].subresourceRange.layerCount = 1;
+		barriers[i].srcAccessMask = 0;
+		barriers[i].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	}
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 0, nullptr, 0, nullptr, IBL_PASS_COUNT, barriers);
+
+	// one descriptor set per dispatch
+	uint32_t dispatchCount = 2 + IBL_PREFILTERED_LEVELS;
+
+	std::vector<VkDescriptorPoolSize> poolSizes(2);
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[0].descriptorCount = dispatchCount;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	poolSizes[1].descriptorCount = dispatchCount;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = dispatchCount;
+
+	VkDescriptorPool descriptorPool;
+	if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create IBL baker descriptor pool!");
+	}
+	m_TransientPools.push_back(descriptorPool);
+
+	recordPass(commandBuffer, descriptorPool, IblPass::Irradiance, environment, irradiance, 0,
+		IBL_IRRADIANCE_WIDTH, IBL_IRRADIANCE_HEIGHT, 0.0f, IBL_IRRADIANCE_SAMPLES);
+	for (uint32_t level = 0; level < IBL_PREFILTERED_LEVELS; level++)
+	{
+		float roughness = static_cast<float>(level) / static_cast<float>(IBL_PREFILTERED_LEVELS - 1);
+		recordPass(commandBuffer, descriptorPool, IblPass::Prefiltered, environment, prefiltered, level,
+			std::max(IBL_PREFILTERED_WIDTH >> level, 1u), std::max(IBL_PREFILTERED_HEIGHT >> level, 1u), roughness, IBL_PREFILTERED_SAMPLES);
+	}
+	recordPass(commandBuffer, descriptorPool, IblPass::BrdfLut, environment, brdfLut, 0,
+		IBL_BRDF_LUT_SIZE, IBL_BRDF_LUT_SIZE, 0.0f, IBL_BRDF_LUT_SAMPLES);
+
+	// GENERAL -> TRANSFER_SRC for the readback
+	for (VkImageMemoryBarrier& barrier : barriers)
+	{
+		barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	}
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, IBL_PASS_COUNT, barriers);
+}
+
+void CIblBaker::releaseTransient()
+{
+	for (VkImageView view : m_TransientViews)
+	{
+		vkDestroyImageView(m_Device, view, nullptr);
+	}
+	for (VkDescriptorPool pool : m_TransientPools)
+	{
+		vkDestroyDescriptorPool(m_Device, pool, nullptr);
+	}
+	m_TransientViews.clear();
+	m_TransientPools.clear();
+}
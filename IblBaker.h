@@ -0,0 +1,59 @@
+/*======================================================================
+VulkanPBR_AcornForest : IblBaker.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+GPU bake of the IBL images (Shaders/ibl.comp, see IblPrecompute.h for
+what each image holds). One compute pipeline per pass, selected with
+the IBL_PASS specialization constant; the prefiltered image takes one
+dispatch per mip level. Only runs when the disk cache (CIblCache) has
+no entry for the environment, so a warm start never creates a
+dispatch.
+
+The environment and the three target images are RGBA16F; the targets
+must be created with VK_IMAGE_USAGE_STORAGE_BIT.
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "IblPrecompute.h"
+
+#include <vector>
+
+class CIblBaker
+{
+private:
+
+	VkDevice                        m_Device = VK_NULL_HANDLE;
+	VkDescriptorSetLayout           m_DescriptorSetLayout = VK_NULL_HANDLE;
+	VkPipelineLayout                m_PipelineLayout = VK_NULL_HANDLE;
+	VkPipeline                      m_Pipelines[IBL_PASS_COUNT] = {};
+	VkSampler                       m_EnvironmentSampler = VK_NULL_HANDLE;    // U repeat, V clamp, linear
+
+	// views and descriptor pools used by recorded commands; freed by releaseTransient()
+	std::vector<VkImageView>        m_TransientViews;
+	std::vector<VkDescriptorPool>   m_TransientPools;
+
+	VkImageView createLevelView(VkImage image, uint32_t level);
+	void recordPass(VkCommandBuffer commandBuffer, VkDescriptorPool descriptorPool, IblPass pass, VkImageView environment,
+		VkImage target, uint32_t level, uint32_t width, uint32_t height, float roughness, uint32_t sampleCount);
+
+public:
+
+	static const VkFormat FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+	// storage writes and linear filtering of FORMAT
+	static bool isSupported(VkPhysicalDevice physicalDevice);
+
+	void create(VkDevice device, const std::vector<char>& shaderCode, VkPipelineCache pipelineCache);
+	void destroy();
+	bool isCreated() const { return m_PipelineLayout != VK_NULL_HANDLE; }
+
+	// environment: SHADER_READ_ONLY_OPTIMAL. Targets sized like IblData::allocate(), every level UNDEFINED on entry
+	// and TRANSFER_SRC_OPTIMAL on exit, ready to be copied into a readback buffer for the cache.
+	void record(VkCommandBuffer commandBuffer, VkImageView environment, VkImage irradiance, VkImage prefiltered, VkImage brdfLut);
+
+	// call once the command buffers passed to record() have finished executing
+	void releaseTransient();
+};
@@ -0,0 +1,126 @@
+/*======================================================================
+VulkanPBR_AcornForest : IblCache.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "IblCache.h"
+#include "CacheFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+	const uint32_t IBL_CACHE_VERSION = 1;
+	const uint32_t PROCEDURAL_SKY_VERSION = 1;    // bump when CIblPrecompute::createProceduralSky() changes
+	constexpr CCacheFile::Identifier IBL_CACHE_IDENTIFIER = CCacheFile::makeIdentifier("AFIBL1");
+
+	struct CacheImage
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t levels;
+		uint32_t reserved;
+	};
+
+	struct CacheHeader
+	{
+		uint8_t    identifier[12];
+		uint32_t   version;
+		uint64_t   sourceKey;
+		uint32_t   irradianceSamples;
+		uint32_t   prefilteredSamples;
+		uint32_t   brdfLutSamples;
+		uint32_t   reserved;
+		CacheImage images[IBL_PASS_COUNT];    // irradiance, prefiltered, BRDF LUT
+	};
+
+	CacheHeader makeHeader(uint64_t sourceKey)
+	{
+		CacheHeader header{};
+		CCacheFile::initHeader(header, IBL_CACHE_IDENTIFIER, IBL_CACHE_VERSION);
+		header.sourceKey = sourceKey;
+		header.irradianceSamples = IBL_IRRADIANCE_SAMPLES;
+		header.prefilteredSamples = IBL_PREFILTERED_SAMPLES;
+		header.brdfLutSamples = IBL_BRDF_LUT_SAMPLES;
+		header.images[0] = { IBL_IRRADIANCE_WIDTH, IBL_IRRADIANCE_HEIGHT, 1, 0 };
+		header.images[1] = { IBL_PREFILTERED_WIDTH, IBL_PREFILTERED_HEIGHT, IBL_PREFILTERED_LEVELS, 0 };
+		header.images[2] = { IBL_BRDF_LUT_SIZE, IBL_BRDF_LUT_SIZE, 1, 0 };
+		return header;
+	}
+}
+
+uint64_t CIblCache::getSourceKey(const std::string& environmentPath)
+{
+	uint64_t hash = CCacheFile::FNV_OFFSET_BASIS;
+	if (environmentPath.empty())
+	{
+		const uint32_t procedural[3] = { PROCEDURAL_SKY_VERSION, CIblPrecompute::PROCEDURAL_SKY_WIDTH, CIblPrecompute::PROCEDURAL_SKY_HEIGHT };
+		return CCacheFile::hashBytes(hash, procedural, sizeof(procedural));
+	}
+
+	std::ifstream file(environmentPath, std::ios::binary);
+	if (file.is_open() == false)
+	{
+		return 0;
+	}
+	std::vector<char> buffer(1 << 16);
+	while (file)
+	{
+		file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		hash = CCacheFile::hashBytes(hash, buffer.data(), static_cast<size_t>(file.gcount()));
+	}
+	return hash;
+}
+
+std::string CIblCache::getCachePath(uint64_t sourceKey)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "ibl_%016llx.afibl", static_cast<unsigned long long>(sourceKey));
+	return std::string(CACHE_DIRECTORY) + "/" + name;
+}
+
+bool CIblCache::load(uint64_t sourceKey, IblData& data)
+{
+	std::ifstream file;
+	CacheHeader expected = makeHeader(sourceKey);
+	CacheHeader header{};
+	uint64_t fileSize = 0;
+	if (CCacheFile::readHeader(getCachePath(sourceKey), IBL_CACHE_IDENTIFIER, IBL_CACHE_VERSION, file, header, fileSize) == false ||
+		memcmp(&header, &expected, sizeof(header)) != 0)
+	{
+		return false;
+	}
+
+	data.allocate();
+	uint64_t payloadSize = 0;
+	for (const IblImage* image : { &data.irradiance, &data.prefiltered, &data.brdfLut })
+	{
+		payloadSize += image->getSizeBytes();
+	}
+	if (fileSize != sizeof(header) + payloadSize)
+	{
+		return false;
+	}
+
+	for (IblImage* image : { &data.irradiance, &data.prefiltered, &data.brdfLut })
+	{
+		file.read(reinterpret_cast<char*>(image->texels.data()), static_cast<std::streamsize>(image->getSizeBytes()));
+	}
+	return file.good();
+}
+
+void CIblCache::store(uint64_t sourceKey, const IblData& data)
+{
+	CacheHeader header = makeHeader(sourceKey);
+
+	CCacheFile::write(getCachePath(sourceKey), header, [&](std::ofstream& file)
+	{
+		for (const IblImage* image : { &data.irradiance, &data.prefiltered, &data.brdfLut })
+		{
+			file.write(reinterpret_cast<const char*>(image->texels.data()), static_cast<std::streamsize>(image->getSizeBytes()));
+		}
+	}, "IBL cache");
+}
@@ -0,0 +1,33 @@
+/*======================================================================
+VulkanPBR_AcornForest : IblCache.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+On-disk cache of the precomputed IBL images (Asset/Cache, .afibl files).
+Entries are keyed by a hash of the environment map file contents (or of
+the procedural sky generator), so a warm start reads three small RGBA16F
+images instead of loading the environment map and baking. The header
+also records the image sizes and sample counts: changing any of the
+IBL_* constants invalidates old entries.
+=======================================================================*/
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "IblPrecompute.h"
+
+class CIblCache
+{
+public:
+
+	// FNV-1a of the file contents, or of the procedural sky version for an empty path; 0 if the file cannot be read
+	static uint64_t getSourceKey(const std::string& environmentPath);
+	static std::string getCachePath(uint64_t sourceKey);
+
+	// returns false if there is no entry or it was written with other settings
+	static bool load(uint64_t sourceKey, IblData& data);
+
+	// failures are reported but not fatal: the environment is simply baked again next run
+	static void store(uint64_t sourceKey, const IblData& data);
+};
@@ -0,0 +1,529 @@
+/*======================================================================
+VulkanPBR_AcornForest : IblPrecompute.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "IblPrecompute.h"
+#include "BenchUtil.h"
+#include "IblCache.h"
+#include "JobSystem.h"
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+// Every function in this namespace has a twin in Shaders/ibl.comp; keep the two in sync.
+namespace
+{
+	const float IBL_PI = 3.14159265358979f;
+
+	float roundToHalf(float value)
+	{
+		return glm::unpackHalf1x16(glm::packHalf1x16(std::min(value, 65504.0f)));
+	}
+
+	// u = azimuth around +Z, v = polar angle from +Z
+	glm::vec2 directionToUv(const glm::vec3& direction)
+	{
+		return glm::vec2(std::atan2(direction.y, direction.x) * (0.5f / IBL_PI) + 0.5f, std::acos(glm::clamp(direction.z, -1.0f, 1.0f)) / IBL_PI);
+	}
+
+	glm::vec3 uvToDirection(const glm::vec2& uv)
+	{
+		float phi = (uv.x - 0.5f) * 2.0f * IBL_PI;
+		float theta = uv.y * IBL_PI;
+		return glm::vec3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+	}
+
+	// texel center of an output image
+	glm::vec2 texelUv(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+	{
+		return glm::vec2((x + 0.5f) / width, (y + 0.5f) / height);
+	}
+
+	// bilinear, wrapping in u and clamping in v like the baker's sampler
+	glm::vec3 sampleEnvironment(const EnvironmentMap& environment, const glm::vec3& direction)
+	{
+		glm::vec2 uv = directionToUv(direction);
+		float x = uv.x * environment.width - 0.5f;
+		float y = uv.y * environment.height - 0.5f;
+		float x0 = std::floor(x);
+		float y0 = std::floor(y);
+		float tx = x - x0;
+		float ty = y - y0;
+
+		auto fetch = [&](int32_t px, int32_t py)
+		{
+			int32_t width = static_cast<int32_t>(environment.width);
+			px = ((px % width) + width) % width;
+			py = glm::clamp(py, 0, static_cast<int32_t>(environment.height) - 1);
+			const float* texel = &environment.texels[(static_cast<size_t>(py) * environment.width + px) * 4];
+			return glm::vec3(texel[0], texel[1], texel[2]);
+		};
+		int32_t ix = static_cast<int32_t>(x0);
+		int32_t iy = static_cast<int32_t>(y0);
+		glm::vec3 top = glm::mix(fetch(ix, iy), fetch(ix + 1, iy), tx);
+		glm::vec3 bottom = glm::mix(fetch(ix, iy + 1), fetch(ix + 1, iy + 1), tx);
+		return glm::mix(top, bottom, ty);
+	}
+
+	float radicalInverse(uint32_t bits)
+	{
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return static_cast<float>(bits) * 2.3283064365386963e-10f;
+	}
+
+	glm::vec2 hammersley(uint32_t i, uint32_t count)
+	{
+		return glm::vec2(static_cast<float>(i) / static_cast<float>(count), radicalInverse(i));
+	}
+
+	// tangent-space direction to world space around n
+	glm::vec3 toWorld(const glm::vec3& local, const glm::vec3& n)
+	{
+		glm::vec3 up = (std::abs(n.z) < 0.999f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+		glm::vec3 tangent = glm::normalize(glm::cross(up, n));
+		glm::vec3 bitangent = glm::cross(n, tangent);
+		return tangent * local.x + bitangent * local.y + n * local.z;
+	}
+
+	glm::vec3 sampleCosineHemisphere(const glm::vec2& xi)
+	{
+		float phi = 2.0f * IBL_PI * xi.x;
+		float cosTheta = std::sqrt(1.0f - xi.y);
+		float sinTheta = std::sqrt(xi.y);
+		return glm::vec3(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+	}
+
+	// GGX half vector in tangent space, alpha = roughness^2
+	glm::vec3 sampleGgx(const glm::vec2& xi, float roughness)
+	{
+		float alpha = roughness * roughness;
+		float phi = 2.0f * IBL_PI * xi.x;
+		float cosTheta = std::sqrt((1.0f - xi.y) / (1.0f + (alpha * alpha - 1.0f) * xi.y));
+		float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+		return glm::vec3(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+	}
+
+	glm::vec3 integrateIrradiance(const EnvironmentMap& environment, const glm::vec3& n)
+	{
+		glm::vec3 sum(0.0f);
+		for (uint32_t i = 0; i < IBL_IRRADIANCE_SAMPLES; i++)
+		{
+			sum += sampleEnvironment(environment, toWorld(sampleCosineHemisphere(hammersley(i, IBL_IRRADIANCE_SAMPLES)), n));
+		}
+		return sum / static_cast<float>(IBL_IRRADIANCE_SAMPLES);
+	}
+
+	glm::vec3 integratePrefiltered(const EnvironmentMap& environment, const glm::vec3& n, float roughness)
+	{
+		if (roughness == 0.0f)
+		{
+			return sampleEnvironment(environment, n);    // mirror: the GGX lobe is a single direction
+		}
+
+		glm::vec3 sum(0.0f);
+		float weight = 0.0f;
+		for (uint32_t i = 0; i < IBL_PREFILTERED_SAMPLES; i++)
+		{
+			glm::vec3 h = toWorld(sampleGgx(hammersley(i, IBL_PREFILTERED_SAMPLES), roughness), n);
+			glm::vec3 l = 2.0f * glm::dot(n, h) * h - n;
+			float nDotL = glm::dot(n, l);
+			if (nDotL > 0.0f)
+			{
+				sum += sampleEnvironment(environment, l) * nDotL;
+				weight += nDotL;
+			}
+		}
+		return sum / std::max(weight, 1e-4f);
+	}
+
+	glm::vec2 integrateBrdf(float nDotV, float roughness)
+	{
+		glm::vec3 v(std::sqrt(1.0f - nDotV * nDotV), 0.0f, nDotV);
+		float k = roughness * roughness * 0.5f;    // Smith-Schlick k for IBL
+		float scale = 0.0f;
+		float bias = 0.0f;
+		for (uint32_t i = 0; i < IBL_BRDF_LUT_SAMPLES; i++)
+		{
+			glm::vec3 h = sampleGgx(hammersley(i, IBL_BRDF_LUT_SAMPLES), roughness);
+			glm::vec3 l = 2.0f * glm::dot(v, h) * h - v;
+			float nDotL = l.z;
+			if (nDotL > 0.0f)
+			{
+				float nDotH = std::max(h.z, 0.0f);
+				float vDotH = std::max(glm::dot(v, h), 0.0f);
+				float g = (nDotV / (nDotV * (1.0f - k) + k)) * (nDotL / (nDotL * (1.0f - k) + k));
+				float gVis = g * vDotH / (nDotH * nDotV);
+				float fc = std::pow(1.0f - vDotH, 5.0f);
+				scale += (1.0f - fc) * gVis;
+				bias += fc * gVis;
+			}
+		}
+		return glm::vec2(scale, bias) / static_cast<float>(IBL_BRDF_LUT_SAMPLES);
+	}
+
+	void storeTexel(IblImage& image, size_t index, const glm::vec4& value)
+	{
+		image.texels[index * 4 + 0] = glm::packHalf1x16(value.r);
+		image.texels[index * 4 + 1] = glm::packHalf1x16(value.g);
+		image.texels[index * 4 + 2] = glm::packHalf1x16(value.b);
+		image.texels[index * 4 + 3] = glm::packHalf1x16(value.a);
+	}
+
+	glm::vec4 loadTexel(const IblImage& image, size_t index)
+	{
+		return glm::vec4(glm::unpackHalf1x16(image.texels[index * 4 + 0]), glm::unpackHalf1x16(image.texels[index * 4 + 1]),
+			glm::unpackHalf1x16(image.texels[index * 4 + 2]), glm::unpackHalf1x16(image.texels[index * 4 + 3]));
+	}
+
+	EnvironmentMap createConstantEnvironment(float upper, float lower)
+	{
+		EnvironmentMap environment;
+		environment.width = 64;
+		environment.height = 32;
+		environment.texels.resize(64 * 32 * 4);
+		for (uint32_t y = 0; y < 32; y++)
+		{
+			for (uint32_t x = 0; x < 64; x++)
+			{
+				float value = (y < 16) ? upper : lower;
+				float* texel = &environment.texels[(y * 64 + x) * 4];
+				texel[0] = texel[1] = texel[2] = value;
+				texel[3] = 1.0f;
+			}
+		}
+		return environment;
+	}
+}
+
+void IblImage::allocate(uint32_t imageWidth, uint32_t imageHeight, uint32_t levelCount)
+{
+	width = imageWidth;
+	height = imageHeight;
+	levels = levelCount;
+	texels.assign(getLevelOffset(levels), 0);
+}
+
+uint32_t IblImage::getLevelWidth(uint32_t level) const
+{
+	return std::max(width >> level, 1u);
+}
+
+uint32_t IblImage::getLevelHeight(uint32_t level) const
+{
+	return std::max(height >> level, 1u);
+}
+
+size_t IblImage::getLevelOffset(uint32_t level) const
+{
+	size_t offset = 0;
+	for (uint32_t i = 0; i < level; i++)
+	{
+		offset += static_cast<size_t>(getLevelWidth(i)) * getLevelHeight(i) * 4;
+	}
+	return offset;
+}
+
+void IblData::allocate()
+{
+	irradiance.allocate(IBL_IRRADIANCE_WIDTH, IBL_IRRADIANCE_HEIGHT, 1);
+	prefiltered.allocate(IBL_PREFILTERED_WIDTH, IBL_PREFILTERED_HEIGHT, IBL_PREFILTERED_LEVELS);
+	brdfLut.allocate(IBL_BRDF_LUT_SIZE, IBL_BRDF_LUT_SIZE, 1);
+}
+
+std::vector<uint16_t> EnvironmentMap::toHalf() const
+{
+	std::vector<uint16_t> halves(texels.size());
+	for (size_t i = 0; i < texels.size(); i++)
+	{
+		halves[i] = glm::packHalf1x16(texels[i]);
+	}
+	return halves;
+}
+
+EnvironmentMap CIblPrecompute::loadEnvironment(const std::string& path)
+{
+	if (path.empty())
+	{
+		return createProceduralSky(PROCEDURAL_SKY_WIDTH, PROCEDURAL_SKY_HEIGHT);
+	}
+
+	int width, height, channels;
+	float* pixels = stbi_loadf(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+	if (pixels == nullptr)
+	{
+		throw std::runtime_error("Failed to load environment map " + path + "!");
+	}
+
+	EnvironmentMap environment;
+	environment.width = static_cast<uint32_t>(width);
+	environment.height = static_cast<uint32_t>(height);
+	environment.texels.resize(static_cast<size_t>(width) * height * 4);
+	for (size_t i = 0; i < environment.texels.size(); i++)
+	{
+		environment.texels[i] = roundToHalf(std::max(pixels[i], 0.0f));
+	}
+	stbi_image_free(pixels);
+	return environment;
+}
+
+// Sky gradient, darker ground and a small bright sun, in linear HDR values. Deterministic, so the
+// cache key only needs the generator version and size (CIblCache::getSourceKey).
+EnvironmentMap CIblPrecompute::createProceduralSky(uint32_t width, uint32_t height)
+{
+	const glm::vec3 zenith(0.25f, 0.45f, 0.90f);
+	const glm::vec3 horizon(0.95f, 0.90f, 0.80f);
+	const glm::vec3 ground(0.20f, 0.17f, 0.13f);
+	const glm::vec3 sunDirection = glm::normalize(glm::vec3(0.4f, 0.3f, 0.6f));
+	const glm::vec3 sunRadiance(60.0f, 56.0f, 48.0f);
+	const float sunCosAngle = std::cos(1.5f * IBL_PI / 180.0f);
+
+	EnvironmentMap environment;
+	environment.width = width;
+	environment.height = height;
+	environment.texels.resize(static_cast<size_t>(width) * height * 4);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			glm::vec3 direction = uvToDirection(texelUv(x, y, width, height));
+			glm::vec3 color;
+			if (direction.z >= 0.0f)
+			{
+				color = glm::mix(horizon, zenith, std::sqrt(direction.z));
+			}
+			else
+			{
+				color = glm::mix(horizon * 0.5f, ground, std::min(-direction.z * 4.0f, 1.0f));
+			}
+			if (glm::dot(direction, sunDirection) > sunCosAngle)
+			{
+				color += sunRadiance;
+			}
+
+			float* texel = &environment.texels[(static_cast<size_t>(y) * width + x) * 4];
+			texel[0] = roundToHalf(color.r);
+			texel[1] = roundToHalf(color.g);
+			texel[2] = roundToHalf(color.b);
+			texel[3] = 1.0f;
+		}
+	}
+	return environment;
+}
+
+void CIblPrecompute::computeIrradiance(const EnvironmentMap& environment, IblImage& irradiance, CJobSystem& jobSystem)
+{
+	irradiance.allocate(IBL_IRRADIANCE_WIDTH, IBL_IRRADIANCE_HEIGHT, 1);
+	jobSystem.parallelFor(irradiance.height, 1, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t y = begin; y < end; y++)
+		{
+			for (uint32_t x = 0; x < irradiance.width; x++)
+			{
+				glm::vec3 n = uvToDirection(texelUv(x, y, irradiance.width, irradiance.height));
+				storeTexel(irradiance, static_cast<size_t>(y) * irradiance.width + x, glm::vec4(integrateIrradiance(environment, n), 1.0f));
+			}
+		}
+	});
+}
+
+void CIblPrecompute::computePrefiltered(const EnvironmentMap& environment, IblImage& prefiltered, CJobSystem& jobSystem)
+{
+	prefiltered.allocate(IBL_PREFILTERED_WIDTH, IBL_PREFILTERED_HEIGHT, IBL_PREFILTERED_LEVELS);
+	for (uint32_t level = 0; level < prefiltered.levels; level++)
+	{
+		uint32_t width = prefiltered.getLevelWidth(level);
+		uint32_t height = prefiltered.getLevelHeight(level);
+		size_t levelTexel = prefiltered.getLevelOffset(level) / 4;
+		float roughness = static_cast<float>(level) / static_cast<float>(prefiltered.levels - 1);
+
+		jobSystem.parallelFor(height, 1, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t y = begin; y < end; y++)
+			{
+				for (uint32_t x = 0; x < width; x++)
+				{
+					glm::vec3 n = uvToDirection(texelUv(x, y, width, height));
+					storeTexel(prefiltered, levelTexel + static_cast<size_t>(y) * width + x, glm::vec4(integratePrefiltered(environment, n, roughness), 1.0f));
+				}
+			}
+		});
+	}
+}
+
+void CIblPrecompute::computeBrdfLut(IblImage& brdfLut, CJobSystem& jobSystem)
+{
+	brdfLut.allocate(IBL_BRDF_LUT_SIZE, IBL_BRDF_LUT_SIZE, 1);
+	jobSystem.parallelFor(brdfLut.height, 1, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t y = begin; y < end; y++)
+		{
+			for (uint32_t x = 0; x < brdfLut.width; x++)
+			{
+				glm::vec2 uv = texelUv(x, y, brdfLut.width, brdfLut.height);
+				storeTexel(brdfLut, static_cast<size_t>(y) * brdfLut.width + x, glm::vec4(integrateBrdf(uv.x, uv.y), 0.0f, 1.0f));
+			}
+		}
+	});
+}
+
+void CIblPrecompute::compute(const EnvironmentMap& environment, IblData& data, CJobSystem& jobSystem)
+{
+	computeIrradiance(environment, data.irradiance, jobSystem);
+	computePrefiltered(environment, data.prefiltered, jobSystem);
+	computeBrdfLut(data.brdfLut, jobSystem);
+}
+
+IblError CIblPrecompute::compare(const IblImage& reference, const IblImage& result)
+{
+	IblError error;
+	if (reference.texels.size() != result.texels.size())
+	{
+		error.rms = error.max = HUGE_VAL;
+		return error;
+	}
+
+	double sum = 0.0;
+	size_t texelCount = reference.texels.size() / 4;
+	for (size_t i = 0; i < texelCount; i++)
+	{
+		glm::vec4 a = loadTexel(reference, i);
+		glm::vec4 b = loadTexel(result, i);
+		for (int c = 0; c < 3; c++)
+		{
+			double e = std::abs(a[c] - b[c]) / (1.0 + std::abs(a[c]));
+			sum += e * e;
+			error.max = std::max(error.max, e);
+		}
+	}
+	error.rms = std::sqrt(sum / static_cast<double>(texelCount * 3));
+	return error;
+}
+
+bool CIblPrecompute::selfTest(const std::string& environmentPath)
+{
+	bool passed = true;
+	auto check = [&](bool condition, const char* what)
+	{
+		if (condition == false)
+		{
+			printf("  FAILED: %s\n", what);
+			passed = false;
+		}
+	};
+
+	CJobSystem jobSystem;
+
+	// constant environment: every output equals the environment, whatever the lobe
+	{
+		EnvironmentMap environment = createConstantEnvironment(0.75f, 0.75f);
+		IblData data;
+		compute(environment, data, jobSystem);
+
+		IblImage expected;
+		expected.allocate(IBL_IRRADIANCE_WIDTH, IBL_IRRADIANCE_HEIGHT, 1);
+		for (size_t i = 0; i < expected.texels.size() / 4; i++)
+		{
+			storeTexel(expected, i, glm::vec4(0.75f, 0.75f, 0.75f, 1.0f));
+		}
+		IblError irradianceError = compare(expected, data.irradiance);
+
+		expected.allocate(IBL_PREFILTERED_WIDTH, IBL_PREFILTERED_HEIGHT, IBL_PREFILTERED_LEVELS);
+		for (size_t i = 0; i < expected.texels.size() / 4; i++)
+		{
+			storeTexel(expected, i, glm::vec4(0.75f, 0.75f, 0.75f, 1.0f));
+		}
+		IblError prefilteredError = compare(expected, data.prefiltered);
+
+		printf("Constant environment: irradiance max error %.5f, prefiltered max error %.5f\n", irradianceError.max, prefilteredError.max);
+		check(irradianceError.max < 1e-3, "constant environment irradiance");
+		check(prefilteredError.max < 1e-3, "constant environment prefiltered radiance");
+	}
+
+	// upper hemisphere 1, lower 0: irradiance is 1 facing up, 0 facing down and 1/2 facing the horizon
+	{
+		EnvironmentMap environment = createConstantEnvironment(1.0f, 0.0f);
+		IblImage irradiance;
+		computeIrradiance(environment, irradiance, jobSystem);
+
+		float top = loadTexel(irradiance, 0).r;
+		float bottom = loadTexel(irradiance, static_cast<size_t>(irradiance.height - 1) * irradiance.width).r;
+		float side = loadTexel(irradiance, static_cast<size_t>(irradiance.height / 2) * irradiance.width).r;
+		float sideAbove = loadTexel(irradiance, static_cast<size_t>(irradiance.height / 2 - 1) * irradiance.width).r;
+		float sideExpected = 0.5f + 0.5f * std::cos((irradiance.height / 2 - 0.5f) * IBL_PI / irradiance.height);    // (1 + cos(theta)) / 2
+
+		printf("Half-lit environment: irradiance top %.3f, bottom %.3f, horizon %.3f (expected %.3f)\n", top, bottom, sideAbove, sideExpected);
+		check(top > 0.97f && bottom < 0.03f, "half-lit irradiance at the poles");
+		check(std::abs(sideAbove - sideExpected) < 0.03f && std::abs((sideAbove + side) - 1.0f) < 0.03f, "half-lit irradiance at the horizon");
+	}
+
+	// BRDF LUT: scale + bias <= 1 (energy), a smooth surface seen head-on reflects F0 exactly
+	{
+		auto start = std::chrono::steady_clock::now();
+		IblImage brdfLut;
+		computeBrdfLut(brdfLut, jobSystem);
+		double brdfMs = elapsedMs(start);
+
+		float maxSum = 0.0f;
+		for (size_t i = 0; i < brdfLut.texels.size() / 4; i++)
+		{
+			glm::vec4 texel = loadTexel(brdfLut, i);
+			maxSum = std::max(maxSum, texel.r + texel.g);
+		}
+		glm::vec4 smooth = loadTexel(brdfLut, brdfLut.width - 1);    // NdotV ~ 1, roughness ~ 0
+
+		printf("BRDF LUT (%ums): max scale + bias %.4f, smooth head-on scale %.4f bias %.4f\n",
+			static_cast<uint32_t>(brdfMs), maxSum, smooth.r, smooth.g);
+		check(maxSum <= 1.01f, "BRDF LUT energy");
+		check(smooth.r > 0.97f && smooth.g < 0.01f, "BRDF LUT smooth head-on");
+	}
+
+	// cached GPU results against the reference for the same environment
+	uint64_t sourceKey = CIblCache::getSourceKey(environmentPath);
+	IblData cached;
+	if (sourceKey != 0 && CIblCache::load(sourceKey, cached))
+	{
+		auto start = std::chrono::steady_clock::now();
+		EnvironmentMap environment = loadEnvironment(environmentPath);
+		IblData reference;
+		compute(environment, reference, jobSystem);
+		printf("%s: CPU reference in %ums, compared with %s\n", environmentPath.empty() ? "Procedural sky" : environmentPath.c_str(),
+			static_cast<uint32_t>(elapsedMs(start)), CIblCache::getCachePath(sourceKey).c_str());
+
+		const char* names[IBL_PASS_COUNT] = { "irradiance", "prefiltered", "BRDF LUT" };
+		const IblImage* references[IBL_PASS_COUNT] = { &reference.irradiance, &reference.prefiltered, &reference.brdfLut };
+		const IblImage* results[IBL_PASS_COUNT] = { &cached.irradiance, &cached.prefiltered, &cached.brdfLut };
+		for (uint32_t i = 0; i < IBL_PASS_COUNT; i++)
+		{
+			IblError error = compare(*references[i], *results[i]);
+			printf("  %-12s rms %.5f  max %.5f\n", names[i], error.rms, error.max);
+
+			// GPU transcendentals and filter weights are less precise: the rms is the criterion, max is informative
+			check(error.rms < 0.02, names[i]);
+		}
+	}
+	else
+	{
+		printf("No cached IBL for %s yet: run the renderer once to bake it on the GPU\n",
+			environmentPath.empty() ? "the procedural sky" : environmentPath.c_str());
+	}
+
+	if (passed)
+	{
+		printf("IBL precompute: all checks passed\n");
+	}
+	return passed;
+}
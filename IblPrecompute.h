@@ -0,0 +1,112 @@
+/*======================================================================
+VulkanPBR_AcornForest : IblPrecompute.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Image based lighting data and its CPU reference implementation.
+Three images are precomputed from an equirectangular environment map
+(Z up, u = azimuth, v = polar angle from +Z):
+  irradiance    diffuse irradiance, cosine-weighted hemisphere average
+  prefiltered   GGX prefiltered radiance (N = V = R), one roughness per
+                mip level, roughness = level / (levels - 1)
+  BRDF LUT      split-sum scale (r) and bias (g) of F0, x = NdotV,
+                y = roughness
+All three are RGBA16F. The GPU bakes them with Shaders/ibl.comp
+(CIblBaker); this file has the same formulas on the CPU, used as the
+fallback when the GPU cannot bake and by --validate-ibl to check the
+GPU results stored in the cache. Both sides use the same Hammersley
+sample sets, so they only differ by float precision and filtering.
+=======================================================================*/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CJobSystem;
+
+// sizes and sample counts shared by Shaders/ibl.comp (through push constants) and the CPU reference
+const uint32_t IBL_IRRADIANCE_WIDTH = 64;
+const uint32_t IBL_IRRADIANCE_HEIGHT = 32;
+const uint32_t IBL_IRRADIANCE_SAMPLES = 1024;
+const uint32_t IBL_PREFILTERED_WIDTH = 256;
+const uint32_t IBL_PREFILTERED_HEIGHT = 128;
+const uint32_t IBL_PREFILTERED_LEVELS = 6;          // roughness 0.0, 0.2 .. 1.0
+const uint32_t IBL_PREFILTERED_SAMPLES = 512;
+const uint32_t IBL_BRDF_LUT_SIZE = 128;
+const uint32_t IBL_BRDF_LUT_SAMPLES = 1024;
+
+// value of the IBL_PASS specialization constant in ibl.comp
+enum class IblPass : uint32_t
+{
+	Irradiance = 0,
+	Prefiltered = 1,
+	BrdfLut = 2,
+};
+
+const uint32_t IBL_PASS_COUNT = 3;
+
+// RGBA16F image, levels tightly packed from level 0
+struct IblImage
+{
+	uint32_t                width = 0;
+	uint32_t                height = 0;
+	uint32_t                levels = 1;
+	std::vector<uint16_t>   texels;         // 4 halves per texel
+
+	void allocate(uint32_t imageWidth, uint32_t imageHeight, uint32_t levelCount);
+	uint32_t getLevelWidth(uint32_t level) const;
+	uint32_t getLevelHeight(uint32_t level) const;
+	size_t getLevelOffset(uint32_t level) const;    // in halves, multiply by 2 for bytes
+	size_t getSizeBytes() const { return texels.size() * sizeof(uint16_t); }
+};
+
+struct IblData
+{
+	IblImage    irradiance;
+	IblImage    prefiltered;
+	IblImage    brdfLut;
+
+	void allocate();    // sizes from the constants above
+};
+
+// equirectangular RGBA environment, values already rounded to half precision like the GPU copy
+struct EnvironmentMap
+{
+	uint32_t                width = 0;
+	uint32_t                height = 0;
+	std::vector<float>      texels;
+
+	std::vector<uint16_t> toHalf() const;    // RGBA16F upload data
+};
+
+// error of a result against the reference: |a - b| / (1 + |reference|) over every channel
+struct IblError
+{
+	double      rms = 0.0;
+	double      max = 0.0;
+};
+
+class CIblPrecompute
+{
+public:
+
+	static const uint32_t PROCEDURAL_SKY_WIDTH = 512;
+	static const uint32_t PROCEDURAL_SKY_HEIGHT = 256;
+
+	// .hdr (or any stb_image format) file; an empty path gives the built-in procedural sky. Throws if the file cannot be read.
+	static EnvironmentMap loadEnvironment(const std::string& path);
+	static EnvironmentMap createProceduralSky(uint32_t width, uint32_t height);
+
+	// CPU reference, rows spread over the job system
+	static void computeIrradiance(const EnvironmentMap& environment, IblImage& irradiance, CJobSystem& jobSystem);
+	static void computePrefiltered(const EnvironmentMap& environment, IblImage& prefiltered, CJobSystem& jobSystem);
+	static void computeBrdfLut(IblImage& brdfLut, CJobSystem& jobSystem);
+	static void compute(const EnvironmentMap& environment, IblData& data, CJobSystem& jobSystem);
+
+	static IblError compare(const IblImage& reference, const IblImage& result);
+
+	// CPU-only: analytic checks of the reference (constant and half-lit environments, BRDF LUT bounds),
+	// then compares the cached GPU results for the environment at path against the reference.
+	static bool selfTest(const std::string& environmentPath);
+};
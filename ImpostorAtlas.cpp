@@ -0,0 +1,337 @@
+/*======================================================================
+VulkanPBR_AcornForest : ImpostorAtlas.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE    // before the first glm include: the bake projections map depth to 0..1 like Vulkan
+#include "ImpostorAtlas.h"
+#include "BenchUtil.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	// camera basis of a frame, the same vectors glm::lookAt builds (Shaders/impostor.vert repeats this)
+	void getFrameBasis(const glm::vec3& direction, glm::vec3& side, glm::vec3& up)
+	{
+		glm::vec3 forward = -direction;
+		glm::vec3 worldUp = (std::abs(direction.z) > 0.999f) ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f);
+		side = glm::normalize(glm::cross(forward, worldUp));
+		up = glm::cross(side, forward);
+	}
+}
+
+void CImpostorAtlas::setup(const ImpostorSettings& settings, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	m_Settings = settings;
+	m_Settings.frames = std::min(std::max(m_Settings.frames, 2u), 32u);
+	m_Center = (boundsMin + boundsMax) * 0.5f;
+	m_Radius = std::max(glm::length(boundsMax - boundsMin) * 0.5f, 1e-4f);
+}
+
+glm::vec2 CImpostorAtlas::encodeHemiOctahedron(const glm::vec3& direction)
+{
+	glm::vec3 d(direction.x, direction.y, std::max(direction.z, 0.0f));
+	float sum = std::abs(d.x) + std::abs(d.y) + d.z;
+	if (sum <= 0.0f)
+	{
+		return glm::vec2(0.5f);
+	}
+	glm::vec2 p(d.x / sum, d.y / sum);
+
+	// the diamond |x| + |y| <= 1 turned 45 degrees onto the square
+	return glm::vec2(p.x + p.y, p.x - p.y) * 0.5f + 0.5f;
+}
+
+glm::vec3 CImpostorAtlas::decodeHemiOctahedron(const glm::vec2& uv)
+{
+	glm::vec2 square = uv * 2.0f - 1.0f;
+	glm::vec2 p((square.x + square.y) * 0.5f, (square.x - square.y) * 0.5f);
+	return glm::normalize(glm::vec3(p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y)));
+}
+
+glm::vec3 CImpostorAtlas::getFrameDirection(uint32_t x, uint32_t y) const
+{
+	return decodeHemiOctahedron(glm::vec2(static_cast<float>(x), static_cast<float>(y)) / static_cast<float>(m_Settings.frames - 1));
+}
+
+glm::mat4 CImpostorAtlas::getBakeViewProj(uint32_t x, uint32_t y) const
+{
+	glm::vec3 direction = getFrameDirection(x, y);
+	glm::vec3 side;
+	glm::vec3 up;
+	getFrameBasis(direction, side, up);
+
+	// the sphere fills the frame; depth 0..1 from its front to its back
+	glm::mat4 view = glm::lookAt(m_Center + direction * (2.0f * m_Radius), m_Center, up);
+	glm::mat4 proj = glm::ortho(-m_Radius, m_Radius, -m_Radius, m_Radius, m_Radius, 3.0f * m_Radius);
+	proj[1][1] *= -1;    // Vulkan: y down
+
+	// clip space of the whole atlas -> the frame's tile
+	float frames = static_cast<float>(m_Settings.frames);
+	glm::mat4 tile = glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f + (2.0f * x + 1.0f) / frames, -1.0f + (2.0f * y + 1.0f) / frames, 0.0f));
+	tile = glm::scale(tile, glm::vec3(1.0f / frames, 1.0f / frames, 1.0f));
+	return tile * proj * view;
+}
+
+glm::vec2 CImpostorAtlas::getFrameUv(uint32_t x, uint32_t y, const glm::vec3& position) const
+{
+	glm::vec3 side;
+	glm::vec3 up;
+	getFrameBasis(getFrameDirection(x, y), side, up);
+
+	glm::vec3 p = position - m_Center;
+	return glm::vec2(0.5f + glm::dot(p, side) / (2.0f * m_Radius), 0.5f - glm::dot(p, up) / (2.0f * m_Radius));
+}
+
+float CImpostorAtlas::getFrameDepth(uint32_t x, uint32_t y, const glm::vec3& position) const
+{
+	return glm::dot(position - m_Center, getFrameDirection(x, y)) / m_Radius;
+}
+
+glm::vec2 CImpostorAtlas::getAtlasUv(uint32_t x, uint32_t y, const glm::vec2& frameUv) const
+{
+	return (glm::vec2(static_cast<float>(x), static_cast<float>(y)) + frameUv) / static_cast<float>(m_Settings.frames);
+}
+
+ImpostorFrameBlend CImpostorAtlas::getFrameBlend(const glm::vec3& viewDirection) const
+{
+	uint32_t last = m_Settings.frames - 1;
+	glm::vec2 grid = encodeHemiOctahedron(glm::normalize(viewDirection)) * static_cast<float>(last);
+	glm::uvec2 base(std::min(static_cast<uint32_t>(grid.x), last - 1), std::min(static_cast<uint32_t>(grid.y), last - 1));
+	glm::vec2 f = glm::clamp(grid - glm::vec2(base), 0.0f, 1.0f);
+
+	// the grid cell is split along its anti-diagonal; the weights are the barycentric coordinates in its triangle
+	ImpostorFrameBlend blend;
+	if (f.x + f.y < 1.0f)
+	{
+		blend.frames[0] = base;
+		blend.frames[1] = base + glm::uvec2(1, 0);
+		blend.frames[2] = base + glm::uvec2(0, 1);
+		blend.weights[0] = 1.0f - f.x - f.y;
+		blend.weights[1] = f.x;
+		blend.weights[2] = f.y;
+	}
+	else
+	{
+		blend.frames[0] = base + glm::uvec2(1, 1);
+		blend.frames[1] = base + glm::uvec2(0, 1);
+		blend.frames[2] = base + glm::uvec2(1, 0);
+		blend.weights[0] = f.x + f.y - 1.0f;
+		blend.weights[1] = 1.0f - f.x;
+		blend.weights[2] = 1.0f - f.y;
+	}
+	return blend;
+}
+
+std::vector<glm::vec4> CImpostorAtlas::createForest(uint32_t count, float clearingRadius, float spacing)
+{
+	// a jittered grid over a disk a little larger than the count needs, nearest cells to the clearing kept
+	const float pi = 3.14159265f;
+	float radius = std::sqrt(clearingRadius * clearingRadius + count * spacing * spacing / pi) + 2.0f * spacing;
+	int32_t cells = static_cast<int32_t>(std::ceil(radius / spacing));
+
+	uint64_t state = 0x9E3779B97F4A7C15ull;
+	std::vector<glm::vec4> forest;
+	for (int32_t y = -cells; y < cells; y++)
+	{
+		for (int32_t x = -cells; x < cells; x++)
+		{
+			glm::vec2 position((x + randomRange(state, 0.1f, 0.9f)) * spacing, (y + randomRange(state, 0.1f, 0.9f)) * spacing);
+			float scale = randomRange(state, 0.6f, 1.2f);
+			float distance = glm::length(position);
+			if (distance >= clearingRadius && distance <= radius)
+			{
+				forest.push_back(glm::vec4(position, 0.0f, scale));
+			}
+		}
+	}
+
+	std::stable_sort(forest.begin(), forest.end(), [](const glm::vec4& a, const glm::vec4& b)
+	{
+		return a.x * a.x + a.y * a.y < b.x * b.x + b.y * b.y;
+	});
+	forest.resize(std::min(forest.size(), static_cast<size_t>(count)));
+	return forest;
+}
+
+void CImpostorAtlas::sortByDistance(std::vector<glm::vec4>& instances, const glm::vec3& eye)
+{
+	std::stable_sort(instances.begin(), instances.end(), [&](const glm::vec4& a, const glm::vec4& b)
+	{
+		glm::vec3 toA = glm::vec3(a) - eye;
+		glm::vec3 toB = glm::vec3(b) - eye;
+		return glm::dot(toA, toA) < glm::dot(toB, toB);
+	});
+}
+
+uint32_t CImpostorAtlas::countCloser(const std::vector<glm::vec4>& instances, const glm::vec3& eye, float distance)
+{
+	auto end = std::partition_point(instances.begin(), instances.end(), [&](const glm::vec4& instance)
+	{
+		glm::vec3 toInstance = glm::vec3(instance) - eye;
+		return glm::dot(toInstance, toInstance) < distance * distance;
+	});
+	return static_cast<uint32_t>(end - instances.begin());
+}
+
+bool CImpostorAtlas::selfTest()
+{
+	bool passed = true;
+	auto check = [&](bool condition, const char* what)
+	{
+		if (condition == false)
+		{
+			printf("  FAILED: %s\n", what);
+			passed = false;
+		}
+	};
+
+	uint64_t state = 12345;
+	auto randomDirection = [&]()
+	{
+		glm::vec3 d;
+		do
+		{
+			d = glm::vec3(randomRange(state, -1.0f, 1.0f), randomRange(state, -1.0f, 1.0f), randomRange(state, 0.0f, 1.0f));
+		} while (glm::length(d) < 0.1f || glm::length(d) > 1.0f);
+		return glm::normalize(d);
+	};
+
+	// octahedral mapping: the whole square decodes to the hemisphere, every direction round trips
+	float worstRoundTrip = 0.0f;
+	bool inSquare = true;
+	for (uint32_t i = 0; i < 10000; i++)
+	{
+		glm::vec3 d = randomDirection();
+		glm::vec2 uv = encodeHemiOctahedron(d);
+		inSquare = inSquare && uv.x >= 0.0f && uv.x <= 1.0f && uv.y >= 0.0f && uv.y <= 1.0f;
+		worstRoundTrip = std::max(worstRoundTrip, glm::length(decodeHemiOctahedron(uv) - d));
+	}
+	printf("Octahedral mapping: worst round trip error %.2e\n", worstRoundTrip);
+	check(inSquare, "encoded directions are inside the unit square");
+	check(worstRoundTrip < 1e-5f, "decode(encode(d)) == d");
+	check(glm::length(decodeHemiOctahedron(glm::vec2(0.5f)) - glm::vec3(0.0f, 0.0f, 1.0f)) < 1e-6f, "the center of the map looks from above");
+	check(std::abs(decodeHemiOctahedron(glm::vec2(0.0f, 0.3f)).z) < 1e-6f, "the border of the map is the horizon");
+
+	// a tree-like bounds off the origin, so the sphere center matters
+	CImpostorAtlas atlas;
+	ImpostorSettings settings;
+	atlas.setup(settings, glm::vec3(-0.8f, -0.6f, 0.0f), glm::vec3(1.0f, 0.9f, 2.4f));
+	uint32_t frames = settings.frames;
+
+	// frame selection: weights are barycentric, exact on the frame directions, frames within one grid cell
+	bool weightsValid = true;
+	bool exactOnFrames = true;
+	bool neighbours = true;
+	for (uint32_t y = 0; y < frames; y++)
+	{
+		for (uint32_t x = 0; x < frames; x++)
+		{
+			ImpostorFrameBlend blend = atlas.getFrameBlend(atlas.getFrameDirection(x, y));
+			float weight = 0.0f;
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				weight += (blend.frames[i] == glm::uvec2(x, y)) ? blend.weights[i] : 0.0f;
+			}
+			exactOnFrames = exactOnFrames && weight > 0.999f;
+		}
+	}
+	for (uint32_t i = 0; i < 10000; i++)
+	{
+		ImpostorFrameBlend blend = atlas.getFrameBlend(randomDirection());
+		float sum = blend.weights[0] + blend.weights[1] + blend.weights[2];
+		weightsValid = weightsValid && std::abs(sum - 1.0f) < 1e-5f && blend.weights[0] >= -1e-6f && blend.weights[1] >= -1e-6f &&
+			blend.weights[2] >= -1e-6f;
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			glm::ivec2 offset = glm::ivec2(blend.frames[j]) - glm::ivec2(blend.frames[0]);
+			neighbours = neighbours && blend.frames[j].x < frames && blend.frames[j].y < frames && std::abs(offset.x) <= 1 && std::abs(offset.y) <= 1;
+		}
+	}
+	check(weightsValid, "blend weights are non-negative and sum to 1");
+	check(exactOnFrames, "a frame's own direction selects only that frame");
+	check(neighbours, "blended frames are corners of one grid cell");
+
+	// blending is continuous: a tiny turn of the camera changes the weighted frame mix only a little
+	float worstJump = 0.0f;
+	for (uint32_t i = 0; i < 2000; i++)
+	{
+		glm::vec3 d = randomDirection();
+		glm::vec3 e = glm::normalize(d + glm::vec3(randomRange(state, -1e-4f, 1e-4f), randomRange(state, -1e-4f, 1e-4f), 0.0f));
+		ImpostorFrameBlend a = atlas.getFrameBlend(d);
+		ImpostorFrameBlend b = atlas.getFrameBlend(e);
+		glm::vec3 mixA(0.0f);
+		glm::vec3 mixB(0.0f);
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			mixA += a.weights[j] * atlas.getFrameDirection(a.frames[j].x, a.frames[j].y);
+			mixB += b.weights[j] * atlas.getFrameDirection(b.frames[j].x, b.frames[j].y);
+		}
+		worstJump = std::max(worstJump, glm::length(mixA - mixB));
+	}
+	printf("Frame blending: worst change of the blended direction for a 1e-4 turn %.2e\n", worstJump);
+	check(worstJump < 1e-2f, "frame weights change continuously with the view direction");
+
+	// bake matrices: the rasterized position of a point is where the runtime looks it up
+	float worstUv = 0.0f;
+	float worstDepth = 0.0f;
+	bool insideTile = true;
+	for (uint32_t i = 0; i < 10000; i++)
+	{
+		uint32_t x = static_cast<uint32_t>(nextRandom(state) % frames);
+		uint32_t y = static_cast<uint32_t>(nextRandom(state) % frames);
+		glm::vec3 p = atlas.getCenter() + randomDirection() * randomRange(state, 0.0f, atlas.getRadius()) *
+			glm::vec3(1.0f, 1.0f, (i % 2) ? 1.0f : -1.0f);
+
+		glm::vec4 clip = atlas.getBakeViewProj(x, y) * glm::vec4(p, 1.0f);
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		glm::vec2 rasterUv = glm::vec2(ndc) * 0.5f + 0.5f;
+		glm::vec2 frameUv = atlas.getFrameUv(x, y, p);
+		glm::vec2 atlasUv = atlas.getAtlasUv(x, y, frameUv);
+		worstUv = std::max(worstUv, glm::length(rasterUv - atlasUv));
+		// bake depth buffer: 0 at the front of the sphere, 0.5 at the center, 1 at the back
+		worstDepth = std::max(worstDepth, std::abs(ndc.z - (0.5f - 0.5f * atlas.getFrameDepth(x, y, p))));
+		insideTile = insideTile && frameUv.x >= -1e-4f && frameUv.x <= 1.0001f && frameUv.y >= -1e-4f && frameUv.y <= 1.0001f &&
+			ndc.z >= -1e-4f && ndc.z <= 1.0001f;
+	}
+	printf("Bake matrices: worst atlas uv error %.2e, worst depth error %.2e\n", worstUv, worstDepth);
+	check(worstUv < 1e-5f, "bake projection matches getFrameUv()/getAtlasUv()");
+	check(worstDepth < 1e-5f, "bake depth matches getFrameDepth()");
+	check(insideTile, "the bounding sphere stays inside its frame's tile and depth range");
+
+	// a frame looks along its direction: points on the line through the center land on the frame center
+	glm::vec2 centerUv = atlas.getFrameUv(2, 5, atlas.getCenter() + atlas.getFrameDirection(2, 5) * 0.7f);
+	check(glm::length(centerUv - glm::vec2(0.5f)) < 1e-5f, "frame cameras look at the sphere center along their direction");
+	glm::vec2 topUv = atlas.getFrameUv(0, 3, atlas.getCenter() + glm::vec3(0.0f, 0.0f, atlas.getRadius() * 0.5f));
+	check(topUv.y < 0.5f, "the top of the tree is at the top of a horizon frame");
+
+	// forest: count, clearing, and the distance split
+	std::vector<glm::vec4> forest = createForest(10000, 10.0f, 2.5f);
+	bool outsideClearing = true;
+	for (const glm::vec4& tree : forest)
+	{
+		outsideClearing = outsideClearing && glm::length(glm::vec2(tree)) >= 10.0f;
+	}
+	check(forest.size() == 10000, "createForest() returns the requested count");
+	check(outsideClearing, "no tree in the clearing");
+
+	glm::vec3 eye(6.0f, 6.0f, 3.0f);
+	sortByDistance(forest, eye);
+	uint32_t closer = countCloser(forest, eye, 30.0f);
+	uint32_t brute = 0;
+	for (const glm::vec4& tree : forest)
+	{
+		brute += (glm::length(glm::vec3(tree) - eye) < 30.0f) ? 1 : 0;
+	}
+	printf("Forest: %zu trees, %u within 30 units of the camera\n", forest.size(), closer);
+	check(closer == brute && closer > 0 && closer < forest.size(), "countCloser() matches brute force");
+
+	printf(passed ? "Impostor atlas: all checks passed\n" : "Impostor atlas: FAILED\n");
+	return passed;
+}
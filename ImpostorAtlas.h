@@ -0,0 +1,89 @@
+/*======================================================================
+VulkanPBR_AcornForest : ImpostorAtlas.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Octahedral impostors for distant trees: the frame layout of the atlas,
+the bake cameras and the frame selection at runtime.
+The tree is rendered from frames x frames view directions on the upper
+hemisphere (z up), laid out as a hemi-octahedral map: frame (x, y) looks
+from the direction that decodes from uv = (x, y) / (frames - 1), so the
+border frames see the tree from the horizon and the middle one from
+above. Each frame is an orthographic view of the tree's bounding sphere,
+frameSize texels square, in its own tile of the atlas.
+
+At runtime a tree beyond the impostor distance is one camera-facing
+quad. The direction to the camera, in the tree's model space, lands
+between four frames of the grid; the three corners of the grid triangle
+it is in are sampled and blended by barycentric weights, which changes
+smoothly as the camera moves. Shaders/impostor.vert does the same math
+as getFrameBlend() and getFrameUv().
+
+The atlas has two layers: albedo with coverage in alpha, and the model
+space normal with the depth in front of the sphere center (in units of
+the radius) in alpha, for lighting and depth-correct overlap.
+=======================================================================*/
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct ImpostorSettings
+{
+	uint32_t    frames = 8;                 // per atlas side, 2..32
+	uint32_t    frameSize = 256;            // texels per frame side
+	float       distance = 30.0f;           // trees farther from the camera are drawn as impostors
+};
+
+// three frames and their weights (summing to 1) for one view direction
+struct ImpostorFrameBlend
+{
+	glm::uvec2  frames[3];
+	float       weights[3];
+};
+
+class CImpostorAtlas
+{
+private:
+
+	ImpostorSettings    m_Settings;
+	glm::vec3           m_Center = glm::vec3(0.0f);    // bounding sphere of the tree, model space
+	float               m_Radius = 1.0f;
+
+public:
+
+	void setup(const ImpostorSettings& settings, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+	const ImpostorSettings& getSettings() const { return m_Settings; }
+	glm::vec3 getCenter() const { return m_Center; }
+	float getRadius() const { return m_Radius; }
+	uint32_t getAtlasSize() const { return m_Settings.frames * m_Settings.frameSize; }
+
+	// unit direction z >= 0 (below the horizon is clamped to it) <-> 0..1 square
+	static glm::vec2 encodeHemiOctahedron(const glm::vec3& direction);
+	static glm::vec3 decodeHemiOctahedron(const glm::vec2& uv);
+
+	// model space direction from the tree towards the camera of frame (x, y)
+	glm::vec3 getFrameDirection(uint32_t x, uint32_t y) const;
+	// model space -> clip space of the atlas: the frame's orthographic view, squeezed into its tile; Vulkan depth and y
+	glm::mat4 getBakeViewProj(uint32_t x, uint32_t y) const;
+	// where the bake of frame (x, y) puts a model space point: 0..1 inside the frame, and the depth in front of the center / radius
+	glm::vec2 getFrameUv(uint32_t x, uint32_t y, const glm::vec3& position) const;
+	float getFrameDepth(uint32_t x, uint32_t y, const glm::vec3& position) const;
+	glm::vec2 getAtlasUv(uint32_t x, uint32_t y, const glm::vec2& frameUv) const;
+
+	// viewDirection: model space, from the tree towards the camera
+	ImpostorFrameBlend getFrameBlend(const glm::vec3& viewDirection) const;
+
+	// Trees (xyz position on the ground, w scale) in a disk around a clearing of clearingRadius at the origin,
+	// one per spacing x spacing cell on average, jittered; the same count gives the same forest.
+	static std::vector<glm::vec4> createForest(uint32_t count, float clearingRadius, float spacing);
+	// nearest first, so the trees closer than a distance are a prefix
+	static void sortByDistance(std::vector<glm::vec4>& instances, const glm::vec3& eye);
+	// length of that prefix (binary search over instances sorted for eye)
+	static uint32_t countCloser(const std::vector<glm::vec4>& instances, const glm::vec3& eye, float distance);
+
+	// CPU-only checks: octahedral mapping, frame blending and the bake matrices against getFrameUv()
+	static bool selfTest();
+};
@@ -0,0 +1,771 @@
+/*======================================================================
+VulkanPBR_AcornForest : ImpostorPass.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "ImpostorPass.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace
+{
+	// same layout in impostor_bake.vert/.frag
+	struct BakePush
+	{
+		glm::mat4 viewProj;
+		glm::vec4 sphere;
+		glm::vec4 direction;
+	};
+
+	// same layout in impostor.vert/.frag
+	struct ImpostorPush
+	{
+		glm::vec4 sphere;
+		glm::vec4 atlas;
+	};
+
+	const uint32_t VERTICES_PER_IMPOSTOR = 6;
+}
+
+uint32_t CImpostorPass::getMipLevels(uint32_t frameSize)
+{
+	uint32_t levels = 1;
+	while ((frameSize >> levels) >= 8)
+	{
+		levels++;
+	}
+	return levels;
+}
+
+VkShaderModule CImpostorPass::createShaderModule(const std::vector<char>& code)
+{
+	VkShaderModuleCreateInfo moduleInfo{};
+	moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize = code.size();
+	moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(m_Device, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create impostor shader module!");
+	}
+	return shaderModule;
+}
+
+void CImpostorPass::create(VkDevice device, uint32_t atlasSize, uint32_t mipLevels, VkFormat depthFormat, const std::vector<char>& bakeVertCode,
+	const std::vector<char>& bakeFragCode, VkPipelineCache pipelineCache, const VkVertexInputBindingDescription& binding,
+	const VkVertexInputAttributeDescription& position, const VkVertexInputAttributeDescription& texCoord)
+{
+	m_Device = device;
+	m_AtlasSize = atlasSize;
+	m_MipLevels = mipLevels;
+	m_DepthFormat = depthFormat;
+
+	createBakeRenderPass();
+	createBakePipeline(bakeVertCode, bakeFragCode, pipelineCache, binding, position, texCoord);
+}
+
+void CImpostorPass::createBakeRenderPass()
+{
+	// 0: albedo, 1: normal-depth, 2: depth. Cleared to zero: alpha 0 is "no tree here" for the runtime.
+	std::array<VkAttachmentDescription, 3> attachments{};
+	const VkFormat formats[3] = { ALBEDO_FORMAT, NORMAL_DEPTH_FORMAT, m_DepthFormat };
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		attachments[i].format = formats[i];
+		attachments[i].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[i].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachments[i].storeOp = (i < 2) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[i].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		// mip 0 is the source of the first blit
+		attachments[i].finalLayout = (i < 2) ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	}
+
+	VkAttachmentReference colorReferences[2] = {};
+	colorReferences[0].attachment = 0;
+	colorReferences[0].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorReferences[1].attachment = 1;
+	colorReferences[1].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depthReference{};
+	depthReference.attachment = 2;
+	depthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 2;
+	subpass.pColorAttachments = colorReferences;
+	subpass.pDepthStencilAttachment = &depthReference;
+
+	// the blits of generateMips() read what the pass wrote
+	VkSubpassDependency dependency{};
+	dependency.srcSubpass = 0;
+	dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	renderPassInfo.pAttachments = attachments.data();
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = 1;
+	renderPassInfo.pDependencies = &dependency;
+
+	if (vkCreateRenderPass(m_Device, &renderPassInfo, nullptr, &m_BakeRenderPass) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create impostor bake render pass!");
+	}
+}
+
+void CImpostorPass::createBakePipeline(const std::vector<char>& vertCode, const std::vector<char>& fragCode, VkPipelineCache pipelineCache,
+	const VkVertexInputBindingDescription& binding, const VkVertexInputAttributeDescription& position,
+	const VkVertexInputAttributeDescription& texCoord)
+{
+	// set 0: the model's texture
+	VkDescriptorSetLayoutBinding textureBinding{};
+	textureBinding.binding = 0;
+	textureBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	textureBinding.descriptorCount = 1;
+	textureBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
+	setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	setLayoutInfo.bindingCount = 1;
+	setLayoutInfo.pBindings = &textureBinding;
+
+	if (vkCreateDescriptorSetLayout(m_Device, &setLayoutInfo, nullptr, &m_BakeSetLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create impostor bake descriptor set layout!");
+	}
+
+	VkDescriptorPoolSize poolSize{};
+	poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSize.descriptorCount = 1;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	poolInfo.maxSets = 1;
+
+	if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_BakePool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create impostor bake descriptor pool!");
+	}
+
+	VkPushConstantRange pushConstant{};
+	pushConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	pushConstant.offset = 0;
+	pushConstant.size = sizeof(BakePush);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &m_BakeSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstant;
+
+	if (vkCreatePipelineLayout(m_Device, &pipelineLayoutInfo, nullptr, &m_BakePipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create impostor bake pipeline layout!");
+	}
+
+	VkShaderModule vertModule = createShaderModule(vertCode);
+	VkShaderModule fragModule = createShaderModule(fragCode);
+
+	VkPipelineShaderStageCreateInfo shaderStages[2] = {};
+	shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStages[0].module = vertModule;
+	shaderStages[0].pName = "main";
+	shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shaderStages[1].module = fragModule;
+	shaderStages[1].pName = "main";
+
+	// position and texture coordinates; the vertex color is skipped through the stride
+	VkVertexInputAttributeDescription attributes[2] = { position, texCoord };
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	vertexInputInfo.pVertexBindingDescriptions = &binding;
+	vertexInputInfo.vertexAttributeDescriptionCount = 2;
+	vertexInputInfo.pVertexAttributeDescriptions = attributes;
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+	// the whole atlas: each frame's matrix places it in its tile
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(m_AtlasSize);
+	viewport.height = static_cast<float>(m_AtlasSize);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor{};
+	scissor.offset = { 0, 0 };
+	scissor.extent = { m_AtlasSize, m_AtlasSize };
+
+	VkPipelineViewportStateCreateInfo viewportState{};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.pViewports = &viewport;
+	viewportState.scissorCount = 1;
+	viewportState.pScissors = &scissor;
+
+	// no culling, like the main pipeline: the model is not closed
+	VkPipelineRasterizationStateCreateInfo rasterizer{};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizer.depthClampEnable = VK_FALSE;
+	rasterizer.rasterizerDiscardEnable = VK_FALSE;
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = VK_CULL_MODE_NONE;
+	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterizer.depthBiasEnable = VK_FALSE;
+
+	VkPipelineMultisampleStateCreateInfo multisampling{};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	multisampling.sampleShadingEnable = VK_FALSE;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencil{};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = VK_TRUE;
+	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+	depthStencil.depthBoundsTestEnable = VK_FALSE;
+	depthStencil.stencilTestEnable = VK_FALSE;
+
+	VkPipelineColorBlendAttachmentState blendAttachments[2] = {};
+	for (VkPipelineColorBlendAttachmentState& blendAttachment : blendAttachments)
+	{
+		blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		blendAttachment.blendEnable = VK_FALSE;
+	}
+
+	VkPipelineColorBlendStateCreateInfo colorBlending{};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlending.attachmentCount = 2;
+	colorBlending.pAttachments = blendAttachments;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = shaderStages;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pDepthStencilState = &depthStencil;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.layout = m_BakePipelineLayout;
+	pipelineInfo.renderPass = m_BakeRenderPass;
+	pipelineInfo.subpass = 0;
+
+	VkResult result = vkCreateGraphicsPipelines(m_Device, pipelineCache, 1, &pipelineInfo, nullptr, &m_BakePipeline);
+	vkDestroyShaderModule(m_Device, vertModule, nullptr);
+	vkDestroyShaderModule(m_Device, fragModule, nullptr);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create impostor bake pipeline!");
+	}
+}
+
+void CImpostorPass::setDrawShaders(const std::vector<char>& vertCode, const std::vector<char>& fragCode)
+{
+	m_VertModule = createShaderModule(vertCode);
+	m_FragModule = createShaderModule(fragCode);
+
+	// 0: uniform buffer (camera, model rotation, sun), 1: albedo atlas, 2: normal-depth atlas
+	VkDescriptorSetLayoutBinding bindings[3] = {};
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorCount = 1;
+		bindings[i].descriptorType = (i == 0) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		bindings[i].stageFlags = (i == 0) ? (VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT) : VK_SHADER_STAGE_FRAGMENT_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
+	setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	setLayoutInfo.bindingCount = 3;
+	setLayoutInfo.pBindings = bindings;
+
+	if (vkCreateDescriptorSetLayout(m_Device, &setLayoutInfo, nullptr, &m_SetLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create impostor descriptor set layout!");
+	}
+
+	VkPushConstantRange pushConstant{};
+	pushConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	pushConstant.offset = 0;
+	pushConstant.size = sizeof(ImpostorPush);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &m_SetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstant;
+
+	if (vkCreatePipelineLayout(m_Device, &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create impostor pipeline layout!");
+	}
+}
+
+VkImageView CImpostorPass::createView(VkImage image, VkFormat format, VkImageAspectFlags aspect, uint32_t mipLevels)
+{
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = format;
+	viewInfo.subresourceRange.aspectMask = aspect;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = mipLevels;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+
+	VkImageView view;
+	if (vkCreateImageView(m_Device, &viewInfo, nullptr, &view) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create impostor atlas image view!");
+	}
+	return view;
+}
+
+void CImpostorPass::setImages(VkImage albedo, VkImage normalDepth, VkImage depth)
+{
+	m_AlbedoImage = albedo;
+	m_NormalDepthImage = normalDepth;
+	m_AlbedoView = createView(albedo, ALBEDO_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT, m_MipLevels);
+	m_NormalDepthView = createView(normalDepth, NORMAL_DEPTH_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT, m_MipLevels);
+
+	m_BakeViews[0] = createView(albedo, ALBEDO_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+	m_BakeViews[1] = createView(normalDepth, NORMAL_DEPTH_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+	m_BakeViews[2] = createView(depth, m_DepthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
+
+	VkFramebufferCreateInfo framebufferInfo{};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = m_BakeRenderPass;
+	framebufferInfo.attachmentCount = 3;
+	framebufferInfo.pAttachments = m_BakeViews;
+	framebufferInfo.width = m_AtlasSize;
+	framebufferInfo.height = m_AtlasSize;
+	framebufferInfo.layers = 1;
+
+	if (vkCreateFramebuffer(m_Device, &framebufferInfo, nullptr, &m_BakeFramebuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create impostor bake framebuffer!");
+	}
+}
+
+void CImpostorPass::bake(VkCommandBuffer commandBuffer, const CImpostorAtlas& atlas, VkBuffer vertexBuffer, VkBuffer indexBuffer,
+	uint32_t indexCount, VkImageView texture, VkSampler textureSampler)
+{
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = m_BakePool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &m_BakeSetLayout;
+
+	VkDescriptorSet set;
+	if (vkAllocateDescriptorSets(m_Device, &allocInfo, &set) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate impostor bake descriptor set!");
+	}
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = texture;
+	imageInfo.sampler = textureSampler;
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = set;
+	write.dstBinding = 0;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.descriptorCount = 1;
+	write.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+
+	VkClearValue clearValues[3] = {};
+	clearValues[2].depthStencil = { 1.0f, 0 };
+
+	VkRenderPassBeginInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = m_BakeRenderPass;
+	renderPassInfo.framebuffer = m_BakeFramebuffer;
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = { m_AtlasSize, m_AtlasSize };
+	renderPassInfo.clearValueCount = 3;
+	renderPassInfo.pClearValues = clearValues;
+
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_BakePipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_BakePipelineLayout, 0, 1, &set, 0, nullptr);
+
+	VkDeviceSize offset = 0;
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+	vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+	// one draw of the whole model per frame; the frames do not overlap, so one depth buffer serves them all
+	uint32_t frames = atlas.getSettings().frames;
+	for (uint32_t y = 0; y < frames; y++)
+	{
+		for (uint32_t x = 0; x < frames; x++)
+		{
+			BakePush push;
+			push.viewProj = atlas.getBakeViewProj(x, y);
+			push.sphere = glm::vec4(atlas.getCenter(), atlas.getRadius());
+			push.direction = glm::vec4(atlas.getFrameDirection(x, y), 0.0f);
+			vkCmdPushConstants(commandBuffer, m_BakePipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push), &push);
+			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+		}
+	}
+	vkCmdEndRenderPass(commandBuffer);
+
+	generateMips(commandBuffer);
+}
+
+void CImpostorPass::generateMips(VkCommandBuffer commandBuffer)
+{
+	// level 0 is TRANSFER_SRC after the pass; every level is blitted from the one above, then becomes a source itself
+	for (VkImage image : { m_AlbedoImage, m_NormalDepthImage })
+	{
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.subresourceRange.levelCount = 1;
+
+		int32_t size = static_cast<int32_t>(m_AtlasSize);
+		for (uint32_t level = 1; level < m_MipLevels; level++)
+		{
+			barrier.subresourceRange.baseMipLevel = level;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			VkImageBlit blit{};
+			blit.srcOffsets[1] = { size, size, 1 };
+			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.srcSubresource.mipLevel = level - 1;
+			blit.srcSubresource.baseArrayLayer = 0;
+			blit.srcSubresource.layerCount = 1;
+			blit.dstOffsets[1] = { size / 2, size / 2, 1 };
+			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.dstSubresource.mipLevel = level;
+			blit.dstSubresource.baseArrayLayer = 0;
+			blit.dstSubresource.layerCount = 1;
+			vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
+				VK_FILTER_LINEAR);
+
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			size /= 2;
+		}
+
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = m_MipLevels;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+}
+
+void CImpostorPass::finishBake()
+{
+	vkDestroyFramebuffer(m_Device, m_BakeFramebuffer, nullptr);
+	for (VkImageView& view : m_BakeViews)
+	{
+		vkDestroyImageView(m_Device, view, nullptr);
+		view = VK_NULL_HANDLE;
+	}
+	vkDestroyPipeline(m_Device, m_BakePipeline, nullptr);
+	vkDestroyPipelineLayout(m_Device, m_BakePipelineLayout, nullptr);
+	vkDestroyDescriptorPool(m_Device, m_BakePool, nullptr);
+	vkDestroyDescriptorSetLayout(m_Device, m_BakeSetLayout, nullptr);
+	vkDestroyRenderPass(m_Device, m_BakeRenderPass, nullptr);
+
+	m_BakeFramebuffer = VK_NULL_HANDLE;
+	m_BakePipeline = VK_NULL_HANDLE;
+	m_BakePipelineLayout = VK_NULL_HANDLE;
+	m_BakePool = VK_NULL_HANDLE;
+	m_BakeSetLayout = VK_NULL_HANDLE;
+	m_BakeRenderPass = VK_NULL_HANDLE;
+}
+
+void CImpostorPass::createPipeline(VkRenderPass renderPass, VkSampleCountFlagBits samples, VkExtent2D extent, VkPipelineCache pipelineCache)
+{
+	if (m_VertModule == VK_NULL_HANDLE || m_AlbedoView == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	VkPipelineShaderStageCreateInfo shaderStages[2] = {};
+	shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStages[0].module = m_VertModule;
+	shaderStages[0].pName = "main";
+	shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shaderStages[1].module = m_FragModule;
+	shaderStages[1].pName = "main";
+
+	// no vertex buffer: the corners come from gl_VertexIndex, the tree from the instance buffer
+	VkVertexInputBindingDescription binding{};
+	binding.binding = 0;
+	binding.stride = sizeof(glm::vec4);
+	binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+	VkVertexInputAttributeDescription attribute{};
+	attribute.binding = 0;
+	attribute.location = 0;
+	attribute.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+	attribute.offset = 0;
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	vertexInputInfo.pVertexBindingDescriptions = &binding;
+	vertexInputInfo.vertexAttributeDescriptionCount = 1;
+	vertexInputInfo.pVertexAttributeDescriptions = &attribute;
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+	// static viewport like the main pipeline, hence the recreation with the swapchain
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(extent.width);
+	viewport.height = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor{};
+	scissor.offset = { 0, 0 };
+	scissor.extent = extent;
+
+	VkPipelineViewportStateCreateInfo viewportState{};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.pViewports = &viewport;
+	viewportState.scissorCount = 1;
+	viewportState.pScissors = &scissor;
+
+	VkPipelineRasterizationStateCreateInfo rasterizer{};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizer.depthClampEnable = VK_FALSE;
+	rasterizer.rasterizerDiscardEnable = VK_FALSE;
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = VK_CULL_MODE_NONE;
+	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterizer.depthBiasEnable = VK_FALSE;
+
+	// same sample count as the main pass; per pixel shading is enough for a distant cutout
+	VkPipelineMultisampleStateCreateInfo multisampling{};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.rasterizationSamples = samples;
+	multisampling.sampleShadingEnable = VK_FALSE;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencil{};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = VK_TRUE;
+	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+	depthStencil.depthBoundsTestEnable = VK_FALSE;
+	depthStencil.stencilTestEnable = VK_FALSE;
+
+	VkPipelineColorBlendAttachmentState blendAttachment{};
+	blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	blendAttachment.blendEnable = VK_FALSE;
+
+	VkPipelineColorBlendStateCreateInfo colorBlending{};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlending.attachmentCount = 1;
+	colorBlending.pAttachments = &blendAttachment;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = shaderStages;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pDepthStencilState = &depthStencil;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.layout = m_PipelineLayout;
+	pipelineInfo.renderPass = renderPass;
+	pipelineInfo.subpass = 0;
+
+	if (vkCreateGraphicsPipelines(m_Device, pipelineCache, 1, &pipelineInfo, nullptr, &m_Pipeline) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create impostor pipeline!");
+	}
+}
+
+void CImpostorPass::createDescriptorSets(const std::vector<VkBuffer>& uniformBuffers, VkDeviceSize uniformSize, VkSampler atlasSampler)
+{
+	if (m_Pipeline == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	uint32_t setCount = static_cast<uint32_t>(uniformBuffers.size());
+	VkDescriptorPoolSize poolSizes[2] = {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[0].descriptorCount = setCount;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[1].descriptorCount = 2 * setCount;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = 2;
+	poolInfo.pPoolSizes = poolSizes;
+	poolInfo.maxSets = setCount;
+
+	if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create impostor descriptor pool!");
+	}
+
+	std::vector<VkDescriptorSetLayout> layouts(setCount, m_SetLayout);
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = m_DescriptorPool;
+	allocInfo.descriptorSetCount = setCount;
+	allocInfo.pSetLayouts = layouts.data();
+
+	m_DescriptorSets.resize(setCount);
+	if (vkAllocateDescriptorSets(m_Device, &allocInfo, m_DescriptorSets.data()) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate impostor descriptor sets!");
+	}
+
+	for (uint32_t i = 0; i < setCount; i++)
+	{
+		VkDescriptorBufferInfo bufferInfo{};
+		bufferInfo.buffer = uniformBuffers[i];
+		bufferInfo.offset = 0;
+		bufferInfo.range = uniformSize;
+
+		VkDescriptorImageInfo imageInfos[2] = {};
+		imageInfos[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfos[0].imageView = m_AlbedoView;
+		imageInfos[0].sampler = atlasSampler;
+		imageInfos[1].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfos[1].imageView = m_NormalDepthView;
+		imageInfos[1].sampler = atlasSampler;
+
+		VkWriteDescriptorSet writes[2] = {};
+		writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet = m_DescriptorSets[i];
+		writes[0].dstBinding = 0;
+		writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		writes[0].descriptorCount = 1;
+		writes[0].pBufferInfo = &bufferInfo;
+		writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet = m_DescriptorSets[i];
+		writes[1].dstBinding = 1;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[1].descriptorCount = 2;    // bindings 1 and 2
+		writes[1].pImageInfo = imageInfos;
+		vkUpdateDescriptorSets(m_Device, 2, writes, 0, nullptr);
+	}
+}
+
+void CImpostorPass::destroyPipeline()
+{
+	if (m_Device == VK_NULL_HANDLE)
+	{
+		return;
+	}
+	vkDestroyDescriptorPool(m_Device, m_DescriptorPool, nullptr);    // frees the sets
+	vkDestroyPipeline(m_Device, m_Pipeline, nullptr);
+	m_DescriptorPool = VK_NULL_HANDLE;
+	m_DescriptorSets.clear();
+	m_Pipeline = VK_NULL_HANDLE;
+}
+
+void CImpostorPass::destroy()
+{
+	if (m_Device == VK_NULL_HANDLE)
+	{
+		return;
+	}
+	if (m_BakeRenderPass != VK_NULL_HANDLE)
+	{
+		finishBake();
+	}
+	destroyPipeline();
+	vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
+	vkDestroyDescriptorSetLayout(m_Device, m_SetLayout, nullptr);
+	vkDestroyShaderModule(m_Device, m_VertModule, nullptr);
+	vkDestroyShaderModule(m_Device, m_FragModule, nullptr);
+	vkDestroyImageView(m_Device, m_AlbedoView, nullptr);
+	vkDestroyImageView(m_Device, m_NormalDepthView, nullptr);
+
+	m_PipelineLayout = VK_NULL_HANDLE;
+	m_SetLayout = VK_NULL_HANDLE;
+	m_VertModule = VK_NULL_HANDLE;
+	m_FragModule = VK_NULL_HANDLE;
+	m_AlbedoView = VK_NULL_HANDLE;
+	m_NormalDepthView = VK_NULL_HANDLE;
+	m_Device = VK_NULL_HANDLE;
+}
+
+void CImpostorPass::record(VkCommandBuffer commandBuffer, uint32_t imageIndex, const CImpostorAtlas& atlas, VkBuffer instanceBuffer,
+	uint32_t firstInstance, uint32_t instanceCount)
+{
+	if (instanceCount == 0)
+	{
+		return;
+	}
+
+	ImpostorPush push;
+	push.sphere = glm::vec4(atlas.getCenter(), atlas.getRadius());
+	push.atlas = glm::vec4(static_cast<float>(atlas.getSettings().frames), 0.0f, 0.0f, 0.0f);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &m_DescriptorSets[imageIndex], 0, nullptr);
+	vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push), &push);
+
+	VkDeviceSize offset = 0;
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &instanceBuffer, &offset);
+	vkCmdDraw(commandBuffer, VERTICES_PER_IMPOSTOR, instanceCount, 0, firstInstance);
+}
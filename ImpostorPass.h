@@ -0,0 +1,108 @@
+/*======================================================================
+VulkanPBR_AcornForest : ImpostorPass.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Baking and drawing of the tree impostors (ImpostorAtlas.h).
+
+The bake is an offscreen render pass of its own, run once at startup:
+the atlas layers (albedo, normal-depth) and a depth buffer of the same
+size are the attachments, and the model is drawn once per frame with
+that frame's matrix (Shaders/impostor_bake.vert/.frag). The atlas then
+gets a mip chain by blits; the frames are power-of-two tiles, so every
+mip texel stays inside its frame. The renderer owns the images, as with
+the shadow map, and frees the depth buffer after finishBake().
+
+The draw pipeline (Shaders/impostor.vert/.frag) renders into the main
+render pass after the meshes: one quad per far tree, instanced from the
+renderer's instance buffer, with a descriptor set per swapchain image
+(uniform buffer and the two atlas layers). It depends on the render pass
+and the extent, so it is recreated with the swapchain.
+
+Without the bake shaders nothing is created and far trees stay meshes;
+without the draw shaders the atlas is baked but never drawn.
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "ImpostorAtlas.h"
+
+#include <vector>
+
+class CImpostorPass
+{
+private:
+
+	VkDevice                        m_Device = VK_NULL_HANDLE;
+	uint32_t                        m_AtlasSize = 0;
+	uint32_t                        m_MipLevels = 1;
+	VkFormat                        m_DepthFormat = VK_FORMAT_UNDEFINED;
+
+	// bake
+	VkRenderPass                    m_BakeRenderPass = VK_NULL_HANDLE;
+	VkDescriptorSetLayout           m_BakeSetLayout = VK_NULL_HANDLE;
+	VkPipelineLayout                m_BakePipelineLayout = VK_NULL_HANDLE;
+	VkPipeline                      m_BakePipeline = VK_NULL_HANDLE;
+	VkDescriptorPool                m_BakePool = VK_NULL_HANDLE;
+	VkImageView                     m_BakeViews[3] = {};           // mip 0 of albedo and normal-depth, depth
+	VkFramebuffer                   m_BakeFramebuffer = VK_NULL_HANDLE;
+
+	// atlas, all mips
+	VkImage                         m_AlbedoImage = VK_NULL_HANDLE;
+	VkImage                         m_NormalDepthImage = VK_NULL_HANDLE;
+	VkImageView                     m_AlbedoView = VK_NULL_HANDLE;
+	VkImageView                     m_NormalDepthView = VK_NULL_HANDLE;
+
+	// draw
+	VkShaderModule                  m_VertModule = VK_NULL_HANDLE;    // kept for swapchain recreation
+	VkShaderModule                  m_FragModule = VK_NULL_HANDLE;
+	VkDescriptorSetLayout           m_SetLayout = VK_NULL_HANDLE;
+	VkPipelineLayout                m_PipelineLayout = VK_NULL_HANDLE;
+	VkPipeline                      m_Pipeline = VK_NULL_HANDLE;
+	VkDescriptorPool                m_DescriptorPool = VK_NULL_HANDLE;
+	std::vector<VkDescriptorSet>    m_DescriptorSets;
+
+	VkShaderModule createShaderModule(const std::vector<char>& code);
+	VkImageView createView(VkImage image, VkFormat format, VkImageAspectFlags aspect, uint32_t mipLevels);
+	void createBakeRenderPass();
+	void createBakePipeline(const std::vector<char>& vertCode, const std::vector<char>& fragCode, VkPipelineCache pipelineCache,
+		const VkVertexInputBindingDescription& binding, const VkVertexInputAttributeDescription& position,
+		const VkVertexInputAttributeDescription& texCoord);
+	void generateMips(VkCommandBuffer commandBuffer);
+
+public:
+
+	static const VkFormat ALBEDO_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+	static const VkFormat NORMAL_DEPTH_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+	// mip levels of an atlas of frameSize frames: down to 8 x 8 texels per frame
+	static uint32_t getMipLevels(uint32_t frameSize);
+
+	// bake render pass and pipeline; position and texCoord are the model's vertex attributes (locations 0 and 2)
+	void create(VkDevice device, uint32_t atlasSize, uint32_t mipLevels, VkFormat depthFormat, const std::vector<char>& bakeVertCode,
+		const std::vector<char>& bakeFragCode, VkPipelineCache pipelineCache, const VkVertexInputBindingDescription& binding,
+		const VkVertexInputAttributeDescription& position, const VkVertexInputAttributeDescription& texCoord);
+	// draw shaders; createPipeline() builds from them
+	void setDrawShaders(const std::vector<char>& vertCode, const std::vector<char>& fragCode);
+	void destroy();
+	bool isBakeCreated() const { return m_BakePipeline != VK_NULL_HANDLE; }
+	bool isCreated() const { return m_Pipeline != VK_NULL_HANDLE; }    // impostors can be drawn
+
+	// atlas layers (atlasSize, mipLevels, ALBEDO_FORMAT / NORMAL_DEPTH_FORMAT) and the bake depth buffer (atlasSize, depthFormat)
+	void setImages(VkImage albedo, VkImage normalDepth, VkImage depth);
+	// draws every frame of the atlas and builds the mips; leaves the atlas ready for sampling
+	void bake(VkCommandBuffer commandBuffer, const CImpostorAtlas& atlas, VkBuffer vertexBuffer, VkBuffer indexBuffer, uint32_t indexCount,
+		VkImageView texture, VkSampler textureSampler);
+	// after the bake's command buffer completed: frees the bake-only objects, the depth buffer can go
+	void finishBake();
+
+	// with the swapchain: pipeline for renderPass, a set per uniform buffer
+	void createPipeline(VkRenderPass renderPass, VkSampleCountFlagBits samples, VkExtent2D extent, VkPipelineCache pipelineCache);
+	void createDescriptorSets(const std::vector<VkBuffer>& uniformBuffers, VkDeviceSize uniformSize, VkSampler atlasSampler);
+	void destroyPipeline();
+
+	// instanceCount quads from instanceBuffer (vec4 position + scale per instance), starting at firstInstance
+	void record(VkCommandBuffer commandBuffer, uint32_t imageIndex, const CImpostorAtlas& atlas, VkBuffer instanceBuffer,
+		uint32_t firstInstance, uint32_t instanceCount);
+};
@@ -0,0 +1,420 @@
+/*======================================================================
+VulkanPBR_AcornForest : JobSystem.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "JobSystem.h"
+#include "BenchUtil.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+struct JobNode
+{
+	std::function<void()>   func;
+	std::atomic<uint32_t>   pendingDependencies{ 1 };    // +1 while submit() is still registering dependencies
+	std::atomic<bool>       finished{ false };
+
+	std::mutex              mutex;                       // guards done and continuations
+	bool                    done = false;
+	std::vector<JobHandle>  continuations;               // jobs waiting on this one
+};
+
+namespace
+{
+	// lets push() find the calling worker's own deque
+	thread_local const CJobSystem*  t_JobSystem = nullptr;
+	thread_local uint32_t           t_QueueIndex = 0;
+
+	const uint32_t SPIN_BEFORE_SLEEP = 64;    // failed steal rounds before a worker sleeps
+}
+
+CJobSystem::CJobSystem(uint32_t threadCount)
+{
+	if (threadCount == 0)
+	{
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;    // main thread also works while waiting
+	}
+
+	m_Queues.reserve(threadCount + 1);
+	for (uint32_t i = 0; i < threadCount + 1; i++)
+	{
+		m_Queues.push_back(std::make_unique<WorkerQueue>());
+	}
+
+	m_Workers.reserve(threadCount);
+	for (uint32_t i = 0; i < threadCount; i++)
+	{
+		m_Workers.emplace_back(&CJobSystem::workerLoop, this, i + 1);
+	}
+}
+
+CJobSystem::~CJobSystem()
+{
+	waitIdle();
+
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		m_Quit = true;
+	}
+	m_WakeCondition.notify_all();
+
+	for (std::thread& worker : m_Workers)
+	{
+		worker.join();
+	}
+}
+
+JobHandle CJobSystem::submit(std::function<void()> job, const std::vector<JobHandle>& dependencies)
+{
+	JobHandle node = std::make_shared<JobNode>();
+	node->func = std::move(job);
+	m_PendingJobs.fetch_add(1);
+
+	for (const JobHandle& dependency : dependencies)
+	{
+		if (dependency == nullptr)
+		{
+			continue;
+		}
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+		if (dependency->done == false)
+		{
+			node->pendingDependencies.fetch_add(1);
+			dependency->continuations.push_back(node);
+		}
+	}
+
+	// drop the submit guard: queue now unless a dependency is still running (it will queue the job when it finishes)
+	if (node->pendingDependencies.fetch_sub(1) == 1)
+	{
+		push(node);
+	}
+	return node;
+}
+
+void CJobSystem::parallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t, uint32_t)>& func)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	batchSize = std::max(batchSize, 1u);
+
+	std::atomic<uint32_t> remaining{ (count + batchSize - 1) / batchSize };
+	for (uint32_t begin = 0; begin < count; begin += batchSize)
+	{
+		uint32_t end = std::min(begin + batchSize, count);
+		submit([&func, &remaining, begin, end]()
+		{
+			func(begin, end);
+			remaining.fetch_sub(1);
+		});
+	}
+
+	// the calling thread helps out instead of sleeping
+	while (remaining.load() > 0)
+	{
+		if (runOneJob() == false)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void CJobSystem::wait(const JobHandle& job)
+{
+	while (isDone(job) == false)
+	{
+		if (runOneJob() == false)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void CJobSystem::waitIdle()
+{
+	while (m_PendingJobs.load() > 0)
+	{
+		if (runOneJob() == false)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool CJobSystem::isDone(const JobHandle& job)
+{
+	return job == nullptr || job->finished.load();
+}
+
+uint32_t CJobSystem::getQueueIndex() const
+{
+	return (t_JobSystem == this) ? t_QueueIndex : 0;
+}
+
+void CJobSystem::push(JobHandle job)
+{
+	WorkerQueue& queue = *m_Queues[getQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+		m_QueuedJobs.fetch_add(1);
+	}
+
+	// Sleepers re-check m_QueuedJobs under m_SleepMutex, so taking it here means the wakeup cannot be lost.
+	if (m_SleepingWorkers.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		m_WakeCondition.notify_one();
+	}
+}
+
+JobHandle CJobSystem::pop(uint32_t queueIndex)
+{
+	if (m_QueuedJobs.load() == 0)
+	{
+		return nullptr;
+	}
+
+	// own deque, newest first
+	{
+		WorkerQueue& queue = *m_Queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty() == false)
+		{
+			JobHandle job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			m_QueuedJobs.fetch_sub(1);
+			return job;
+		}
+	}
+
+	// steal the oldest job of another deque, starting next to our own so thieves spread out
+	uint32_t queueCount = static_cast<uint32_t>(m_Queues.size());
+	for (uint32_t offset = 1; offset < queueCount; offset++)
+	{
+		WorkerQueue& queue = *m_Queues[(queueIndex + offset) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty() == false)
+		{
+			JobHandle job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			m_QueuedJobs.fetch_sub(1);
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+bool CJobSystem::runOneJob()
+{
+	JobHandle job = pop(getQueueIndex());
+	if (job == nullptr)
+	{
+		return false;
+	}
+	execute(job);
+	return true;
+}
+
+void CJobSystem::execute(const JobHandle& job)
+{
+	{
+		PROFILE_SCOPE("Job");
+		job->func();
+	}
+	job->func = nullptr;    // release captures now; handles may outlive the job
+
+	std::vector<JobHandle> continuations;
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		job->done = true;
+		continuations.swap(job->continuations);
+	}
+	job->finished.store(true);
+
+	for (JobHandle& continuation : continuations)
+	{
+		if (continuation->pendingDependencies.fetch_sub(1) == 1)
+		{
+			push(std::move(continuation));
+		}
+	}
+
+	m_PendingJobs.fetch_sub(1);
+}
+
+void CJobSystem::workerLoop(uint32_t queueIndex)
+{
+	t_JobSystem = this;
+	t_QueueIndex = queueIndex;
+	CProfiler::setThreadName("Worker " + std::to_string(queueIndex));
+
+	uint32_t idleRounds = 0;
+	while (true)
+	{
+		if (runOneJob())
+		{
+			idleRounds = 0;
+			continue;
+		}
+
+		if (++idleRounds < SPIN_BEFORE_SLEEP)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		idleRounds = 0;
+
+		std::unique_lock<std::mutex> lock(m_SleepMutex);
+		m_SleepingWorkers.fetch_add(1);
+		m_WakeCondition.wait(lock, [this]() { return m_Quit.load() || m_QueuedJobs.load() > 0; });
+		m_SleepingWorkers.fetch_sub(1);
+		if (m_Quit.load() && m_QueuedJobs.load() == 0)
+		{
+			return;
+		}
+	}
+}
+
+//====================================================================================
+// microbenchmarks (--bench-jobs)
+//====================================================================================
+
+namespace
+{
+	using BenchClock = std::chrono::steady_clock;
+
+	// ~1 us of ALU work that the optimizer cannot remove
+	float busyWork(uint32_t seed)
+	{
+		float value = static_cast<float>(seed);
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			value = std::sqrt(value * 1.0001f + 1.0f);
+		}
+		return value;
+	}
+
+	uint64_t fibonacci(CJobSystem& jobSystem, uint32_t n)
+	{
+		if (n < 18)    // serial cutoff: below this a job costs more than the work
+		{
+			return (n < 2) ? n : fibonacci(jobSystem, n - 1) + fibonacci(jobSystem, n - 2);
+		}
+		uint64_t left = 0;
+		JobHandle child = jobSystem.submit([&jobSystem, &left, n]() { left = fibonacci(jobSystem, n - 1); });
+		uint64_t right = fibonacci(jobSystem, n - 2);
+		jobSystem.wait(child);
+		return left + right;
+	}
+}
+
+void CJobSystem::benchmark(uint32_t maxThreads)
+{
+	const uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	printf("Job system benchmark (%u hardware threads)\n", hardwareThreads);
+
+	// 1. spawn overhead: empty jobs, from outside the pool and from inside a job (own deque)
+	{
+		const uint32_t jobCount = 200000;
+		CJobSystem jobSystem;
+
+		BenchClock::time_point start = BenchClock::now();
+		for (uint32_t i = 0; i < jobCount; i++)
+		{
+			jobSystem.submit([]() {});
+		}
+		jobSystem.waitIdle();
+		double externalMs = elapsedMs(start);
+
+		start = BenchClock::now();
+		jobSystem.submit([&jobSystem, jobCount]()
+		{
+			for (uint32_t i = 0; i < jobCount; i++)
+			{
+				jobSystem.submit([]() {});
+			}
+		});
+		jobSystem.waitIdle();
+		double nestedMs = elapsedMs(start);
+
+		printf("  spawn + run, %u empty jobs on %u threads:\n", jobCount, jobSystem.getWorkerCount() + 1);
+		printf("    from main thread   %7.1f ns/job\n", externalMs * 1e6 / jobCount);
+		printf("    from a worker      %7.1f ns/job\n", nestedMs * 1e6 / jobCount);
+	}
+
+	// 2. dependency chain: each job waits on the previous one (scheduling latency per link)
+	{
+		const uint32_t chainLength = 20000;
+		CJobSystem jobSystem;
+		uint32_t counter = 0;
+
+		BenchClock::time_point start = BenchClock::now();
+		JobHandle previous;
+		for (uint32_t i = 0; i < chainLength; i++)
+		{
+			previous = jobSystem.submit([&counter]() { counter++; }, { previous });
+		}
+		jobSystem.wait(previous);
+		double chainMs = elapsedMs(start);
+
+		printf("  dependency chain, %u jobs: %.1f ns/link (%s)\n", chainLength, chainMs * 1e6 / chainLength,
+			counter == chainLength ? "in order" : "ORDER BROKEN");
+	}
+
+	// 3. fork/join scaling: parallelFor (flat) and recursive fibonacci (nested waits, stealing)
+	{
+		const uint32_t itemCount = 1u << 16;
+		std::vector<float> results(itemCount);
+
+		std::vector<uint32_t> threadCounts;
+		for (uint32_t threads = 1; threads < maxThreads; threads *= 2)
+		{
+			threadCounts.push_back(threads);
+		}
+		threadCounts.push_back(maxThreads);
+
+		printf("  fork/join scaling (threads above %u are oversubscribed):\n", hardwareThreads);
+		printf("    threads   parallelFor      speedup   fibonacci(32)    speedup\n");
+		double baseFlatMs = 0.0;
+		double baseTreeMs = 0.0;
+		for (uint32_t threads : threadCounts)
+		{
+			CJobSystem jobSystem(threads - 1);    // the calling thread is the remaining worker
+			double flatMs = 1e30;
+			double treeMs = 1e30;
+			uint64_t fib = 0;
+			for (uint32_t run = 0; run < 3; run++)    // best of 3
+			{
+				BenchClock::time_point start = BenchClock::now();
+				jobSystem.parallelFor(itemCount, 256, [&results](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t i = begin; i < end; i++)
+					{
+						results[i] = busyWork(i);
+					}
+				});
+				flatMs = std::min(flatMs, elapsedMs(start));
+
+				start = BenchClock::now();
+				fib = fibonacci(jobSystem, 32);
+				treeMs = std::min(treeMs, elapsedMs(start));
+			}
+			if (threads == 1)
+			{
+				baseFlatMs = flatMs;
+				baseTreeMs = treeMs;
+			}
+			printf("    %7u   %8.2f ms   %6.2fx   %8.2f ms     %6.2fx%s\n", threads, flatMs, baseFlatMs / flatMs,
+				treeMs, baseTreeMs / treeMs, fib == 2178309 ? "" : "  WRONG RESULT");
+		}
+	}
+}
@@ -0,0 +1,85 @@
+/*======================================================================
+VulkanPBR_AcornForest : JobSystem.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+CPU worker pool (work stealing).
+Every worker owns a deque. Jobs a worker spawns go to the back of its
+own deque and it pops them back LIFO, which keeps the data cache-warm.
+Idle workers steal from the front of the other deques. Threads outside
+the pool (the main thread) share deque 0. A waiting thread keeps running
+jobs instead of blocking, so a pool with zero workers still completes
+every job (single-threaded), and nested parallelFor() cannot deadlock.
+
+Jobs can depend on other jobs: submit(job, { a, b }) runs job once both
+a and b have finished. Jobs must not throw. Catch inside the job and
+rethrow on the waiting thread (see CTextureLoader::decodeBatch).
+=======================================================================*/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct JobNode;
+using JobHandle = std::shared_ptr<JobNode>;    // keeps the job's completion state alive for waiters
+
+class CJobSystem
+{
+private:
+
+	struct WorkerQueue
+	{
+		std::mutex              mutex;
+		std::deque<JobHandle>   jobs;    // owner: push/pop back, thieves: pop front
+	};
+
+	std::vector<std::thread>                    m_Workers;          // worker threads
+	std::vector<std::unique_ptr<WorkerQueue>>   m_Queues;           // [0]: threads outside the pool, [i + 1]: worker i
+	std::atomic<uint32_t>                       m_QueuedJobs{ 0 };  // jobs sitting in a deque (ready to run)
+	std::atomic<uint32_t>                       m_PendingJobs{ 0 }; // submitted and not finished (includes jobs waiting on dependencies)
+
+	std::mutex                                  m_SleepMutex;
+	std::condition_variable                     m_WakeCondition;    // signalled when a job is queued or on shutdown
+	std::atomic<uint32_t>                       m_SleepingWorkers{ 0 };
+	std::atomic<bool>                           m_Quit{ false };
+
+	void workerLoop(uint32_t queueIndex);
+	uint32_t getQueueIndex() const;                         // deque of the calling thread
+	void push(JobHandle job);                               // job is ready: all dependencies finished
+	JobHandle pop(uint32_t queueIndex);                     // own deque first, then steal
+	bool runOneJob();                                       // pops and runs one job on the calling thread
+	void execute(const JobHandle& job);
+
+public:
+
+	// threadCount = 0 : one worker per hardware thread, minus the main thread
+	explicit CJobSystem(uint32_t threadCount = 0);
+	~CJobSystem();                                          // finishes every submitted job first
+
+	CJobSystem(const CJobSystem&) = delete;
+	CJobSystem& operator=(const CJobSystem&) = delete;
+
+	// Runs job after every job in dependencies has finished (finished or null handles are ignored).
+	JobHandle submit(std::function<void()> job, const std::vector<JobHandle>& dependencies = {});
+
+	// Splits [0, count) into batches of batchSize and runs func(begin, end) on the pool.
+	// Blocks until every batch has finished; the calling thread takes part in the work.
+	void parallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t, uint32_t)>& func);
+
+	void wait(const JobHandle& job);    // blocks (while helping) until job has finished
+	void waitIdle();                    // blocks (while helping) until every submitted job has finished
+
+	static bool isDone(const JobHandle& job);
+
+	uint32_t getWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+
+	// CPU-only microbenchmarks: spawn overhead, dependency chains and fork/join scaling up to maxThreads
+	static void benchmark(uint32_t maxThreads);
+};
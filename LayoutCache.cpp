@@ -0,0 +1,139 @@
+/*======================================================================
+VulkanPBR_AcornForest : LayoutCache.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "LayoutCache.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+size_t CLayoutCache::KeyHash::operator()(const std::vector<uint64_t>& key) const
+{
+	size_t seed = key.size();
+	for (uint64_t value : key)
+	{
+		seed ^= static_cast<size_t>(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+	return seed;
+}
+
+void CLayoutCache::create(VkDevice device)
+{
+	m_Device = device;
+}
+
+void CLayoutCache::destroy()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (auto& entry : m_PipelineLayouts)
+	{
+		vkDestroyPipelineLayout(m_Device, entry.second, nullptr);
+	}
+	for (auto& entry : m_SetLayouts)
+	{
+		vkDestroyDescriptorSetLayout(m_Device, entry.second, nullptr);
+	}
+	m_PipelineLayouts.clear();
+	m_SetLayouts.clear();
+}
+
+VkDescriptorSetLayout CLayoutCache::getSetLayout(const DescriptorSetLayoutDesc& desc)
+{
+	if (desc.bindingFlags.empty() == false && desc.bindingFlags.size() != desc.bindings.size())
+	{
+		throw std::runtime_error("Failed to create descriptor set layout: binding flag count mismatch!");
+	}
+
+	// sorted by binding number so declaration order does not split identical layouts
+	std::vector<size_t> order(desc.bindings.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return desc.bindings[a].binding < desc.bindings[b].binding; });
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	std::vector<VkDescriptorBindingFlags> bindingFlags;
+	std::vector<uint64_t> key = { desc.flags, desc.bindings.size() };
+	for (size_t index : order)
+	{
+		const VkDescriptorSetLayoutBinding& binding = desc.bindings[index];
+		if (binding.pImmutableSamplers != nullptr)
+		{
+			throw std::runtime_error("Failed to create descriptor set layout: immutable samplers are not cached!");
+		}
+		VkDescriptorBindingFlags flags = desc.bindingFlags.empty() ? 0 : desc.bindingFlags[index];
+		bindings.push_back(binding);
+		bindingFlags.push_back(flags);
+		key.push_back((static_cast<uint64_t>(binding.binding) << 32) | static_cast<uint32_t>(binding.descriptorType));
+		key.push_back((static_cast<uint64_t>(binding.descriptorCount) << 32) | binding.stageFlags);
+		key.push_back(flags);
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_RequestCount++;
+	auto found = m_SetLayouts.find(key);
+	if (found != m_SetLayouts.end())
+	{
+		return found->second;
+	}
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+	bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.flags = desc.flags;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	// binding flags need descriptor indexing; leave the chain out when none are set so 1.0 devices work
+	bool anyFlags = std::any_of(bindingFlags.begin(), bindingFlags.end(), [](VkDescriptorBindingFlags flags) { return flags != 0; });
+	layoutInfo.pNext = anyFlags ? &bindingFlagsInfo : nullptr;
+
+	VkDescriptorSetLayout setLayout;
+	if (vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor set layout!");
+	}
+	m_SetLayouts.emplace(std::move(key), setLayout);
+	return setLayout;
+}
+
+VkPipelineLayout CLayoutCache::getPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges)
+{
+	std::vector<uint64_t> key = { setLayouts.size(), pushConstantRanges.size() };
+	for (VkDescriptorSetLayout setLayout : setLayouts)
+	{
+		key.push_back(reinterpret_cast<uint64_t>(setLayout));
+	}
+	for (const VkPushConstantRange& range : pushConstantRanges)
+	{
+		key.push_back(range.stageFlags);
+		key.push_back((static_cast<uint64_t>(range.offset) << 32) | range.size);
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_RequestCount++;
+	auto found = m_PipelineLayouts.find(key);
+	if (found != m_PipelineLayouts.end())
+	{
+		return found->second;
+	}
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+	pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+	pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+
+	VkPipelineLayout pipelineLayout;
+	if (vkCreatePipelineLayout(m_Device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline layout!");
+	}
+	m_PipelineLayouts.emplace(std::move(key), pipelineLayout);
+	return pipelineLayout;
+}
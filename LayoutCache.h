@@ -0,0 +1,58 @@
+/*======================================================================
+VulkanPBR_AcornForest : LayoutCache.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Deduplicating descriptor set layout / pipeline layout cache.
+Layouts are keyed by their contents (bindings sorted by binding number,
+binding flags, create flags; set layouts and push-constant ranges for
+pipeline layouts), so pipelines whose shaders declare the same interface
+share one VkDescriptorSetLayout / VkPipelineLayout, and recreating a
+pipeline (swapchain resize, shader variants) creates no new layouts.
+The cache owns every layout it returns. Thread-safe.
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// VkDescriptorSetLayoutCreateInfo contents (immutable samplers are not supported)
+struct DescriptorSetLayoutDesc
+{
+	VkDescriptorSetLayoutCreateFlags            flags = 0;
+	std::vector<VkDescriptorSetLayoutBinding>   bindings;
+	std::vector<VkDescriptorBindingFlags>       bindingFlags;    // empty, or one per binding
+};
+
+class CLayoutCache
+{
+private:
+
+	struct KeyHash
+	{
+		size_t operator()(const std::vector<uint64_t>& key) const;
+	};
+
+	VkDevice                                                                m_Device = VK_NULL_HANDLE;
+	std::mutex                                                              m_Mutex;
+	std::unordered_map<std::vector<uint64_t>, VkDescriptorSetLayout, KeyHash>   m_SetLayouts;
+	std::unordered_map<std::vector<uint64_t>, VkPipelineLayout, KeyHash>        m_PipelineLayouts;
+	uint32_t                                                                m_RequestCount = 0;
+
+public:
+
+	void create(VkDevice device);
+	void destroy();
+
+	VkDescriptorSetLayout getSetLayout(const DescriptorSetLayoutDesc& desc);
+	VkPipelineLayout getPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges);
+
+	uint32_t getSetLayoutCount() const { return static_cast<uint32_t>(m_SetLayouts.size()); }
+	uint32_t getPipelineLayoutCount() const { return static_cast<uint32_t>(m_PipelineLayouts.size()); }
+	uint32_t getRequestCount() const { return m_RequestCount; }
+};
@@ -0,0 +1,44 @@
+/*======================================================================
+VulkanPBR_AcornForest : LightCuller.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+GPU light culling for clustered forward lighting (Shaders/cluster_cull.comp,
+see ClusteredLights.h for the grid and buffer layouts). Recorded at the
+start of every frame's command buffer: one dispatch bins the lights of
+that swapchain image's light buffer into its cluster buffer. The frame
+graph's light-cull pass (RenderGraph.h) orders it after the previous
+fragment reads and hands the cluster buffer to the fragment shaders.
+
+Both buffers are owned by the renderer, one pair per swapchain image;
+setBuffers() points the culler's descriptor sets at them.
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+class CLightCuller
+{
+private:
+
+	VkDevice                        m_Device = VK_NULL_HANDLE;
+	VkDescriptorSetLayout           m_DescriptorSetLayout = VK_NULL_HANDLE;
+	VkPipelineLayout                m_PipelineLayout = VK_NULL_HANDLE;
+	VkPipeline                      m_Pipeline = VK_NULL_HANDLE;
+	VkDescriptorPool                m_DescriptorPool = VK_NULL_HANDLE;
+	std::vector<VkDescriptorSet>    m_DescriptorSets;    // one per swapchain image
+
+public:
+
+	void create(VkDevice device, const std::vector<char>& shaderCode, VkPipelineCache pipelineCache);
+	void destroy();
+	bool isCreated() const { return m_Pipeline != VK_NULL_HANDLE; }
+
+	// one descriptor set per swapchain image (binding 0 = lights, 1 = clusters); call again when the buffers are recreated
+	void setBuffers(const std::vector<VkBuffer>& lightBuffers, const std::vector<VkBuffer>& clusterBuffers);
+
+	// the dispatch only: the frame graph records the barriers around it
+	void record(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+};
@@ -0,0 +1,198 @@
+/*======================================================================
+VulkanPBR_AcornForest : MemoryTracker.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "MemoryTracker.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+	const char* CATEGORY_NAMES[static_cast<size_t>(MemoryCategory::Count)] =
+	{
+		"vertex", "index", "uniform", "staging", "storage", "texture", "attachment"
+	};
+
+	void writeStats(std::ofstream& file, const MemoryStats& stats)
+	{
+		file << "\"current\": " << stats.current << ", \"peak\": " << stats.peak << ", \"allocations\": " << stats.allocations;
+	}
+}
+
+const char* toString(MemoryCategory category)
+{
+	return CATEGORY_NAMES[static_cast<size_t>(category)];
+}
+
+void CMemoryTracker::init(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceMemoryProperties& memoryProperties, bool budgetSupported)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_PhysicalDevice = physicalDevice;
+	m_MemoryProperties = memoryProperties;
+	m_BudgetSupported = budgetSupported;
+}
+
+void CMemoryTracker::add(MemoryStats& stats, VkDeviceSize size)
+{
+	stats.current += size;
+	stats.peak = std::max(stats.peak, stats.current);
+	stats.allocations++;
+}
+
+void CMemoryTracker::remove(MemoryStats& stats, VkDeviceSize size)
+{
+	stats.current -= size;
+	stats.allocations--;
+}
+
+VkResult CMemoryTracker::allocate(VkDevice device, const VkMemoryAllocateInfo& allocInfo, MemoryCategory category, VkDeviceMemory& memory)
+{
+	VkResult result = vkAllocateMemory(device, &allocInfo, nullptr, &memory);
+	if (result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	uint32_t heapIndex = m_MemoryProperties.memoryTypes[allocInfo.memoryTypeIndex].heapIndex;
+	m_Allocations[memory] = { category, allocInfo.allocationSize, heapIndex };
+	add(m_Categories[static_cast<size_t>(category)], allocInfo.allocationSize);
+	add(m_Heaps[heapIndex], allocInfo.allocationSize);
+	add(m_Total, allocInfo.allocationSize);
+	return result;
+}
+
+void CMemoryTracker::free(VkDevice device, VkDeviceMemory memory)
+{
+	if (memory == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto found = m_Allocations.find(memory);
+		if (found != m_Allocations.end())
+		{
+			const Allocation& allocation = found->second;
+			remove(m_Categories[static_cast<size_t>(allocation.category)], allocation.size);
+			remove(m_Heaps[allocation.heapIndex], allocation.size);
+			remove(m_Total, allocation.size);
+			m_Allocations.erase(found);
+		}
+	}
+	vkFreeMemory(device, memory, nullptr);
+}
+
+// host-visible transfer sources are staging buffers; otherwise the most specific usage wins
+MemoryCategory CMemoryTracker::categorizeBuffer(VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+{
+	if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+	{
+		return MemoryCategory::Vertex;
+	}
+	if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+	{
+		return MemoryCategory::Index;
+	}
+	if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+	{
+		return MemoryCategory::Uniform;
+	}
+	if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+	{
+		return MemoryCategory::Storage;
+	}
+	if ((usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) && (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+	{
+		return MemoryCategory::Staging;
+	}
+	return MemoryCategory::Storage;
+}
+
+MemoryCategory CMemoryTracker::categorizeImage(VkImageUsageFlags usage)
+{
+	const VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+		VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+	return ((usage & attachmentUsage) && (usage & VK_IMAGE_USAGE_SAMPLED_BIT) == 0) ? MemoryCategory::Attachment : MemoryCategory::Texture;
+}
+
+MemoryStats CMemoryTracker::getCategoryStats(MemoryCategory category) const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Categories[static_cast<size_t>(category)];
+}
+
+MemoryStats CMemoryTracker::getTotalStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Total;
+}
+
+std::vector<MemoryHeapReport> CMemoryTracker::queryHeaps() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+	budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+	if (m_BudgetSupported)
+	{
+		VkPhysicalDeviceMemoryProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		properties2.pNext = &budget;
+		vkGetPhysicalDeviceMemoryProperties2(m_PhysicalDevice, &properties2);
+	}
+
+	std::vector<MemoryHeapReport> heaps(m_MemoryProperties.memoryHeapCount);
+	for (uint32_t i = 0; i < m_MemoryProperties.memoryHeapCount; i++)
+	{
+		MemoryHeapReport& heap = heaps[i];
+		heap.deviceLocal = (m_MemoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+		heap.size = m_MemoryProperties.memoryHeaps[i].size;
+		heap.tracked = m_Heaps[i];
+		heap.budget = m_BudgetSupported ? budget.heapBudget[i] : heap.size;
+		heap.usage = m_BudgetSupported ? budget.heapUsage[i] : heap.tracked.current;
+	}
+	return heaps;
+}
+
+void CMemoryTracker::writeJson(const std::string& path, const std::string& deviceName) const
+{
+	std::ofstream file(path, std::ios::trunc);
+	if (file.is_open() == false)
+	{
+		throw std::runtime_error("Failed to open memory report file!");
+	}
+
+	std::vector<MemoryHeapReport> heaps = queryHeaps();
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	file << "{\n  \"device\": ";
+	CProfiler::writeJsonString(file, deviceName);
+	file << ",\n";
+	file << "  \"budgetSupported\": " << (m_BudgetSupported ? "true" : "false") << ",\n";
+	file << "  \"total\": { ";
+	writeStats(file, m_Total);
+	file << " },\n  \"categories\": {\n";
+	for (size_t i = 0; i < static_cast<size_t>(MemoryCategory::Count); i++)
+	{
+		file << "    \"" << CATEGORY_NAMES[i] << "\": { ";
+		writeStats(file, m_Categories[i]);
+		file << " }" << (i + 1 < static_cast<size_t>(MemoryCategory::Count) ? "," : "") << "\n";
+	}
+	file << "  },\n  \"heaps\": [\n";
+	for (size_t i = 0; i < heaps.size(); i++)
+	{
+		const MemoryHeapReport& heap = heaps[i];
+		file << "    { \"index\": " << i << ", \"deviceLocal\": " << (heap.deviceLocal ? "true" : "false")
+			<< ", \"size\": " << heap.size << ", \"budget\": " << heap.budget << ", \"usage\": " << heap.usage
+			<< ", \"untracked\": " << (heap.usage > heap.tracked.current ? heap.usage - heap.tracked.current : 0) << ", \"tracked\": { ";
+		writeStats(file, heap.tracked);
+		file << " } }" << (i + 1 < heaps.size() ? "," : "") << "\n";
+	}
+	file << "  ]\n}\n";
+}
@@ -0,0 +1,100 @@
+/*======================================================================
+VulkanPBR_AcornForest : MemoryTracker.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Device memory accounting.
+Every vkAllocateMemory/vkFreeMemory of the framework goes through
+allocate()/free(), tagged with a category. Current and peak bytes are
+kept per category and per heap. With VK_EXT_memory_budget the driver's
+heap budget and process usage are queried as well. Usage minus tracked
+bytes is memory this code does not allocate itself (ImGui backend,
+driver internals). Without the extension the budget falls back to the
+heap size and usage to the tracked total.
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class MemoryCategory
+{
+	Vertex,
+	Index,
+	Uniform,
+	Staging,
+	Storage,       // SSBOs (materials, compute)
+	Texture,
+	Attachment,    // color/depth render targets
+	Count
+};
+
+const char* toString(MemoryCategory category);
+
+struct MemoryStats
+{
+	VkDeviceSize    current = 0;
+	VkDeviceSize    peak = 0;
+	uint32_t        allocations = 0;    // live vkDeviceMemory objects
+};
+
+struct MemoryHeapReport
+{
+	bool            deviceLocal = false;
+	VkDeviceSize    size = 0;
+	VkDeviceSize    budget = 0;         // how much this process can use before the OS/driver starts evicting
+	VkDeviceSize    usage = 0;          // driver-reported usage of this process (= tracked without the extension)
+	MemoryStats     tracked;
+};
+
+class CMemoryTracker
+{
+private:
+
+	struct Allocation
+	{
+		MemoryCategory  category;
+		VkDeviceSize    size;
+		uint32_t        heapIndex;
+	};
+
+	mutable std::mutex                                      m_Mutex;    // allocations also happen on startup worker threads
+	VkPhysicalDevice                                        m_PhysicalDevice = VK_NULL_HANDLE;
+	VkPhysicalDeviceMemoryProperties                        m_MemoryProperties{};
+	bool                                                    m_BudgetSupported = false;
+
+	std::unordered_map<VkDeviceMemory, Allocation>          m_Allocations;
+	MemoryStats                                             m_Categories[static_cast<size_t>(MemoryCategory::Count)];
+	MemoryStats                                             m_Heaps[VK_MAX_MEMORY_HEAPS];
+	MemoryStats                                             m_Total;
+
+	static void add(MemoryStats& stats, VkDeviceSize size);
+	static void remove(MemoryStats& stats, VkDeviceSize size);
+
+public:
+
+	// budgetSupported: VK_EXT_memory_budget was enabled on the device
+	void init(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceMemoryProperties& memoryProperties, bool budgetSupported);
+
+	// vkAllocateMemory + bookkeeping. Returns the Vulkan result (memory is only tracked on success).
+	VkResult allocate(VkDevice device, const VkMemoryAllocateInfo& allocInfo, MemoryCategory category, VkDeviceMemory& memory);
+	void free(VkDevice device, VkDeviceMemory memory);    // VK_NULL_HANDLE is ignored
+
+	static MemoryCategory categorizeBuffer(VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+	static MemoryCategory categorizeImage(VkImageUsageFlags usage);
+
+	MemoryStats getCategoryStats(MemoryCategory category) const;
+	MemoryStats getTotalStats() const;
+	bool isBudgetSupported() const { return m_BudgetSupported; }
+
+	// queries the driver budget on every call when supported
+	std::vector<MemoryHeapReport> queryHeaps() const;
+
+	// categories, heaps and budgets as JSON; throws if the file cannot be opened
+	void writeJson(const std::string& path, const std::string& deviceName) const;
+};
@@ -0,0 +1,392 @@
+/*======================================================================
+VulkanPBR_AcornForest : MipGenerator.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+	struct MipGenPushConstants
+	{
+		uint32_t srcWidth;
+		uint32_t srcHeight;
+		uint32_t mipCount;
+		uint32_t workGroupCount;
+	};
+
+	const uint32_t MIP_TILE_SIZE = 64;              // source texels per workgroup side
+	const uint32_t MIP_SINGLE_PASS_MAX_SIZE = 4096; // level 6 of the source must fit in one tile
+
+	// the shader stores through an rgba8 (UNORM) view and does the sRGB conversion itself
+	VkFormat getStorageFormat(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_R8G8B8A8_UNORM:
+			return VK_FORMAT_R8G8B8A8_UNORM;
+		default:
+			return VK_FORMAT_UNDEFINED;
+		}
+	}
+
+	uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties)
+	{
+		VkPhysicalDeviceMemoryProperties memProperties;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+		{
+			if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				return i;
+			}
+		}
+		throw std::runtime_error("Failed to find suitable memory type for mip generator!");
+	}
+}
+
+bool CMipGenerator::isFormatSupported(VkPhysicalDevice physicalDevice, VkFormat format)
+{
+	VkFormat storageFormat = getStorageFormat(format);
+	if (storageFormat == VK_FORMAT_UNDEFINED)
+	{
+		return false;
+	}
+
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(physicalDevice, storageFormat, &formatProperties);
+	return (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) != 0;
+}
+
+void CMipGenerator::create(VkDevice device, VkPhysicalDevice physicalDevice, const std::vector<char>& shaderCode, CMemoryTracker& memoryTracker)
+{
+	m_Device = device;
+	m_PhysicalDevice = physicalDevice;
+	m_MemoryTracker = &memoryTracker;
+
+	// 0: source level, 1: destination levels, 2: global counter
+	std::vector<VkDescriptorSetLayoutBinding> bindings(3);
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	bindings[1].descriptorCount = MAX_LEVELS_PER_DISPATCH;
+	bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings[2].binding = 2;
+	bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[2].descriptorCount = 1;
+	bindings[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &m_DescriptorSetLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create mip generator descriptor set layout!");
+	}
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(MipGenPushConstants);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &m_DescriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(m_Device, &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create mip generator pipeline layout!");
+	}
+
+	VkShaderModuleCreateInfo moduleInfo{};
+	moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize = shaderCode.size();
+	moduleInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data());
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(m_Device, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create mip generator shader module!");
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = shaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = m_PipelineLayout;
+
+	VkResult result = vkCreateComputePipelines(m_Device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_Pipeline);
+	vkDestroyShaderModule(m_Device, shaderModule, nullptr);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create mip generator pipeline!");
+	}
+
+	// global atomic counter (4 bytes, cleared on first use)
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = sizeof(uint32_t);
+	bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateBuffer(m_Device, &bufferInfo, nullptr, &m_CounterBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create mip generator counter buffer!");
+	}
+
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(m_Device, m_CounterBuffer, &memRequirements);
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = findMemoryType(m_PhysicalDevice, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	if (m_MemoryTracker->allocate(m_Device, allocInfo, MemoryCategory::Storage, m_CounterMemory) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate mip generator counter memory!");
+	}
+	vkBindBufferMemory(m_Device, m_CounterBuffer, m_CounterMemory, 0);
+	m_CounterCleared = false;
+}
+
+void CMipGenerator::destroy()
+{
+	releaseTransient();
+
+	if (m_Device == VK_NULL_HANDLE)
+	{
+		return;
+	}
+	vkDestroyBuffer(m_Device, m_CounterBuffer, nullptr);
+	m_MemoryTracker->free(m_Device, m_CounterMemory);
+	vkDestroyPipeline(m_Device, m_Pipeline, nullptr);
+	vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
+	vkDestroyDescriptorSetLayout(m_Device, m_DescriptorSetLayout, nullptr);
+
+	m_CounterBuffer = VK_NULL_HANDLE;
+	m_CounterMemory = VK_NULL_HANDLE;
+	m_Pipeline = VK_NULL_HANDLE;
+	m_PipelineLayout = VK_NULL_HANDLE;
+	m_DescriptorSetLayout = VK_NULL_HANDLE;
+}
+
+VkImageView CMipGenerator::createLevelView(VkImage image, VkFormat format, uint32_t level)
+{
+	VkImageViewUsageCreateInfo usageInfo{};
+	usageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO;
+	usageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT;
+
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.pNext = &usageInfo;
+	viewInfo.image = image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = getStorageFormat(format);
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.baseMipLevel = level;
+	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+
+	VkImageView view;
+	if (vkCreateImageView(m_Device, &viewInfo, nullptr, &view) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create mip generator image view!");
+	}
+	m_TransientViews.push_back(view);
+	return view;
+}
+
+void CMipGenerator::record(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels)
+{
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mipLevels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	if (mipLevels > 1)
+	{
+		if (m_CounterCleared == false)
+		{
+			vkCmdFillBuffer(commandBuffer, m_CounterBuffer, 0, sizeof(uint32_t), 0);
+			m_CounterCleared = true;
+		}
+
+		// every level TRANSFER_DST -> GENERAL
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		// counter: the clear above, or the reset done by a previous record() in the same command buffer
+		VkMemoryBarrier memoryBarrier{};
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 1, &memoryBarrier, 0, nullptr, 1, &barrier);
+
+		std::vector<VkImageView> levelViews(mipLevels);
+		for (uint32_t level = 0; level < mipLevels; level++)
+		{
+			levelViews[level] = createLevelView(image, format, level);
+		}
+
+		// one descriptor set per dispatch; at least 6 levels are written per dispatch
+		uint32_t maxDispatches = (mipLevels - 1 + 5) / 6;
+
+		std::vector<VkDescriptorPoolSize> poolSizes(2);
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		poolSizes[0].descriptorCount = maxDispatches * (1 + MAX_LEVELS_PER_DISPATCH);
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSizes[1].descriptorCount = maxDispatches;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+		poolInfo.maxSets = maxDispatches;
+
+		VkDescriptorPool descriptorPool;
+		if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create mip generator descriptor pool!");
+		}
+		m_TransientPools.push_back(descriptorPool);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+
+		uint32_t sourceLevel = 0;
+		while (sourceLevel + 1 < mipLevels)
+		{
+			uint32_t srcWidth = std::max(width >> sourceLevel, 1u);
+			uint32_t srcHeight = std::max(height >> sourceLevel, 1u);
+
+			// beyond 4096 the single-pass tail does not fit in one workgroup: stop at 6 levels
+			uint32_t maxLevels = (std::max(srcWidth, srcHeight) <= MIP_SINGLE_PASS_MAX_SIZE) ? MAX_LEVELS_PER_DISPATCH : 6;
+			uint32_t mipCount = std::min(mipLevels - 1 - sourceLevel, maxLevels);
+
+			VkDescriptorSetAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocInfo.descriptorPool = descriptorPool;
+			allocInfo.descriptorSetCount = 1;
+			allocInfo.pSetLayouts = &m_DescriptorSetLayout;
+
+			VkDescriptorSet descriptorSet;
+			if (vkAllocateDescriptorSets(m_Device, &allocInfo, &descriptorSet) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate mip generator descriptor set!");
+			}
+
+			VkDescriptorImageInfo sourceInfo{};
+			sourceInfo.imageView = levelViews[sourceLevel];
+			sourceInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			// unused slots repeat the last written level; the shader never stores to them
+			std::vector<VkDescriptorImageInfo> destinationInfos(MAX_LEVELS_PER_DISPATCH);
+			for (uint32_t i = 0; i < MAX_LEVELS_PER_DISPATCH; i++)
+			{
+				destinationInfos[i].imageView = levelViews[sourceLevel + std::min(i + 1, mipCount)];
+				destinationInfos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			}
+
+			VkDescriptorBufferInfo counterInfo{};
+			counterInfo.buffer = m_CounterBuffer;
+			counterInfo.offset = 0;
+			counterInfo.range = sizeof(uint32_t);
+
+			std::vector<VkWriteDescriptorSet> writes(3);
+			for (VkWriteDescriptorSet& write : writes)
+			{
+				write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				write.dstSet = descriptorSet;
+				write.dstArrayElement = 0;
+				write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			}
+			writes[0].dstBinding = 0;
+			writes[0].descriptorCount = 1;
+			writes[0].pImageInfo = &sourceInfo;
+			writes[1].dstBinding = 1;
+			writes[1].descriptorCount = MAX_LEVELS_PER_DISPATCH;
+			writes[1].pImageInfo = destinationInfos.data();
+			writes[2].dstBinding = 2;
+			writes[2].descriptorCount = 1;
+			writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[2].pBufferInfo = &counterInfo;
+
+			vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+
+			uint32_t groupsX = (srcWidth + MIP_TILE_SIZE - 1) / MIP_TILE_SIZE;
+			uint32_t groupsY = (srcHeight + MIP_TILE_SIZE - 1) / MIP_TILE_SIZE;
+
+			MipGenPushConstants pushConstants{ srcWidth, srcHeight, mipCount, groupsX * groupsY };
+			vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+			vkCmdDispatch(commandBuffer, groupsX, groupsY, 1);
+
+			sourceLevel += mipCount;
+			if (sourceLevel + 1 < mipLevels)
+			{
+				// next dispatch reads what this one wrote
+				VkMemoryBarrier dispatchBarrier{};
+				dispatchBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+				dispatchBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+				dispatchBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					0, 1, &dispatchBarrier, 0, nullptr, 0, nullptr);
+			}
+		}
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	}
+	else
+	{
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	}
+
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void CMipGenerator::releaseTransient()
+{
+	for (VkImageView view : m_TransientViews)
+	{
+		vkDestroyImageView(m_Device, view, nullptr);
+	}
+	for (VkDescriptorPool pool : m_TransientPools)
+	{
+		vkDestroyDescriptorPool(m_Device, pool, nullptr);
+	}
+	m_TransientViews.clear();
+	m_TransientPools.clear();
+}
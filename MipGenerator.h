@@ -0,0 +1,65 @@
+/*======================================================================
+VulkanPBR_AcornForest : MipGenerator.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Compute-shader mip chain generation (Shaders/mipgen.comp).
+Writes up to 12 levels per dispatch through storage image views, so a
+texture up to 4096^2 needs a single dispatch and a handful of barriers
+instead of one blit and two barriers per level. Filtering is done in
+linear space, and the image format itself does not need linear-filter
+blit support.
+
+Textures must be created with getImageCreateFlags() and
+VK_IMAGE_USAGE_STORAGE_BIT. The storage views use the UNORM alias of
+the image's sRGB format.
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "MemoryTracker.h"
+
+#include <string>
+#include <vector>
+
+class CMipGenerator
+{
+private:
+
+	VkDevice                        m_Device = VK_NULL_HANDLE;
+	VkPhysicalDevice                m_PhysicalDevice = VK_NULL_HANDLE;
+	CMemoryTracker*                 m_MemoryTracker = nullptr;
+	VkDescriptorSetLayout           m_DescriptorSetLayout = VK_NULL_HANDLE;
+	VkPipelineLayout                m_PipelineLayout = VK_NULL_HANDLE;
+	VkPipeline                      m_Pipeline = VK_NULL_HANDLE;
+
+	VkBuffer                        m_CounterBuffer = VK_NULL_HANDLE;    // atomic counter used to pick the last workgroup
+	VkDeviceMemory                  m_CounterMemory = VK_NULL_HANDLE;
+	bool                            m_CounterCleared = false;
+
+	// views and descriptor pools used by recorded commands; freed by releaseTransient()
+	std::vector<VkImageView>        m_TransientViews;
+	std::vector<VkDescriptorPool>   m_TransientPools;
+
+	VkImageView createLevelView(VkImage image, VkFormat format, uint32_t level);
+
+public:
+
+	static const uint32_t MAX_LEVELS_PER_DISPATCH = 12;
+
+	// storage support for the UNORM alias of format
+	static bool isFormatSupported(VkPhysicalDevice physicalDevice, VkFormat format);
+	static VkImageCreateFlags getImageCreateFlags() { return VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT; }
+
+	void create(VkDevice device, VkPhysicalDevice physicalDevice, const std::vector<char>& shaderCode, CMemoryTracker& memoryTracker);
+	void destroy();
+	bool isCreated() const { return m_Pipeline != VK_NULL_HANDLE; }
+
+	// Same contract as CVulkanFramework::recordMipmapBlits(): level 0 filled, every level in
+	// TRANSFER_DST_OPTIMAL on entry, every level in SHADER_READ_ONLY_OPTIMAL on exit.
+	void record(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels);
+
+	// call once the command buffers passed to record() have finished executing
+	void releaseTransient();
+};
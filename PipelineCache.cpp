@@ -0,0 +1,94 @@
+/*======================================================================
+VulkanPBR_AcornForest : PipelineCache.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "PipelineCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	// VkPipelineCacheHeaderVersionOne: the driver rejects foreign data itself, but not every driver does it gracefully
+	bool isCompatible(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties)
+	{
+		const size_t headerSize = 16 + VK_UUID_SIZE;
+		if (data.size() < headerSize)
+		{
+			return false;
+		}
+		uint32_t header[4];
+		std::memcpy(header, data.data(), sizeof(header));
+		return header[0] >= headerSize &&
+			header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			header[2] == properties.vendorID &&
+			header[3] == properties.deviceID &&
+			std::memcmp(data.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+}
+
+void CPipelineCache::create(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& path)
+{
+	m_Device = device;
+	m_Path = path;
+
+	std::vector<char> data;
+	if (path.empty() == false)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (file.is_open())
+		{
+			data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+		if (data.empty() == false && isCompatible(data, properties) == false)
+		{
+			printf("Pipeline cache %s was written by another GPU or driver, starting empty\n", path.c_str());
+			data.clear();
+		}
+	}
+
+	VkPipelineCacheCreateInfo cacheInfo{};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheInfo.initialDataSize = data.size();
+	cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+	if (vkCreatePipelineCache(m_Device, &cacheInfo, nullptr, &m_Cache) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline cache!");
+	}
+	m_LoadedBytes = data.size();
+}
+
+void CPipelineCache::save() const
+{
+	if (m_Cache == VK_NULL_HANDLE || m_Path.empty())
+	{
+		return;
+	}
+
+	size_t size = 0;
+	vkGetPipelineCacheData(m_Device, m_Cache, &size, nullptr);
+	std::vector<char> data(size);
+	if (size == 0 || vkGetPipelineCacheData(m_Device, m_Cache, &size, data.data()) != VK_SUCCESS)
+	{
+		return;
+	}
+
+	// a failed write only costs recompiling next time
+	std::ofstream file(m_Path, std::ios::binary | std::ios::trunc);
+	file.write(data.data(), static_cast<std::streamsize>(size));
+}
+
+void CPipelineCache::destroy()
+{
+	if (m_Cache != VK_NULL_HANDLE)
+	{
+		vkDestroyPipelineCache(m_Device, m_Cache, nullptr);
+		m_Cache = VK_NULL_HANDLE;
+	}
+}
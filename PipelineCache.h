@@ -0,0 +1,38 @@
+/*======================================================================
+VulkanPBR_AcornForest : PipelineCache.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+VkPipelineCache persisted to disk.
+create() seeds the cache with the file written by the previous run when
+its header matches this GPU and driver (vendor, device, cache UUID), so
+pipelines and shader variants compiled before come back without running
+the driver's shader compiler. save() writes the cache back at exit.
+A missing, stale or unreadable file just starts an empty cache.
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <string>
+
+class CPipelineCache
+{
+private:
+
+	VkDevice            m_Device = VK_NULL_HANDLE;
+	VkPipelineCache     m_Cache = VK_NULL_HANDLE;
+	std::string         m_Path;
+	size_t              m_LoadedBytes = 0;       // 0: started empty
+
+public:
+
+	// path empty: in-memory cache only, nothing is read or written
+	void create(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& path);
+	void save() const;
+	void destroy();
+
+	VkPipelineCache get() const { return m_Cache; }
+	size_t getLoadedBytes() const { return m_LoadedBytes; }
+};
@@ -0,0 +1,231 @@
+/*======================================================================
+VulkanPBR_AcornForest : PresentPolicy.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "PresentPolicy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <timeapi.h>    // timeBeginPeriod, winmm.lib
+#endif
+
+namespace
+{
+	const char* POLICY_NAMES[PRESENT_POLICY_COUNT] = { "default", "low-latency", "uncapped", "vsync", "power-saver" };
+
+	const double POWER_SAVER_FPS = 60.0;
+
+	// spin-phase budget never drops below this, so a single fast sleep does not make the next one late
+	const std::chrono::microseconds MIN_SPIN(200);
+	// and never grows above this: with a coarse OS timer the learnt overshoot would otherwise turn most
+	// of the frame into spinning. Past it the limiter trades pacing accuracy for an idle core.
+	const std::chrono::microseconds MAX_SPIN(2000);
+
+	// Windows sleeps in whole ticks of the system timer, 15.6 ms by default; 1 ms while a limit is set
+	void setFineTimerResolution(bool fine)
+	{
+#ifdef _WIN32
+		if (fine)
+		{
+			timeBeginPeriod(1);
+		}
+		else
+		{
+			timeEndPeriod(1);
+		}
+#else
+		(void)fine;
+#endif
+	}
+}
+
+const char* toString(PresentPolicy policy)
+{
+	return POLICY_NAMES[static_cast<uint32_t>(policy)];
+}
+
+const char* toString(VkPresentModeKHR presentMode)
+{
+	switch (presentMode)
+	{
+	case VK_PRESENT_MODE_IMMEDIATE_KHR:     return "IMMEDIATE";
+	case VK_PRESENT_MODE_MAILBOX_KHR:       return "MAILBOX";
+	case VK_PRESENT_MODE_FIFO_KHR:          return "FIFO";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR:  return "FIFO_RELAXED";
+	default:                                return "other";
+	}
+}
+
+bool parsePresentPolicy(const char* name, PresentPolicy& policy)
+{
+	for (uint32_t i = 0; i < PRESENT_POLICY_COUNT; i++)
+	{
+		if (strcmp(name, POLICY_NAMES[i]) == 0)
+		{
+			policy = static_cast<PresentPolicy>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+VkPresentModeKHR selectPresentMode(PresentPolicy policy, const std::vector<VkPresentModeKHR>& availableModes)
+{
+	std::vector<VkPresentModeKHR> preference;
+	switch (policy)
+	{
+	case PresentPolicy::Default:    preference = { VK_PRESENT_MODE_MAILBOX_KHR }; break;
+	case PresentPolicy::LowLatency: preference = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR }; break;
+	case PresentPolicy::Uncapped:   preference = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR }; break;
+	case PresentPolicy::VSync:      break;
+	case PresentPolicy::PowerSaver: preference = { VK_PRESENT_MODE_FIFO_RELAXED_KHR }; break;
+	}
+
+	for (VkPresentModeKHR mode : preference)
+	{
+		if (std::find(availableModes.begin(), availableModes.end(), mode) != availableModes.end())
+		{
+			return mode;
+		}
+	}
+	return VK_PRESENT_MODE_FIFO_KHR;    // always supported
+}
+
+uint32_t selectImageCount(uint32_t requested, const VkSurfaceCapabilitiesKHR& capabilities)
+{
+	uint32_t imageCount = (requested == 0) ? capabilities.minImageCount + 1 : requested;
+	imageCount = std::max(imageCount, capabilities.minImageCount);
+	if (capabilities.maxImageCount > 0)    // zero means there is no maximum
+	{
+		imageCount = std::min(imageCount, capabilities.maxImageCount);
+	}
+	return imageCount;
+}
+
+double selectFrameLimit(PresentPolicy policy, double fpsLimit)
+{
+	if (fpsLimit > 0.0)
+	{
+		return fpsLimit;
+	}
+	return (policy == PresentPolicy::PowerSaver) ? POWER_SAVER_FPS : 0.0;
+}
+
+//====================================================================================
+// CFrameLimiter
+//====================================================================================
+
+CFrameLimiter::~CFrameLimiter()
+{
+	if (m_TargetFps > 0.0)
+	{
+		setFineTimerResolution(false);
+	}
+}
+
+void CFrameLimiter::setTargetFps(double fps)
+{
+	if (fps == m_TargetFps)
+	{
+		return;
+	}
+	if ((fps > 0.0) != (m_TargetFps > 0.0))
+	{
+		setFineTimerResolution(fps > 0.0);
+	}
+	m_TargetFps = fps;
+	m_Period = (fps > 0.0) ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps)) : Clock::duration::zero();
+	m_Deadline = Clock::now();
+}
+
+// Sleep in short steps while well ahead of the deadline, then spin with yield for the last part.
+// m_SleepOvershoot learns how late sleep_for() returns on this OS (about 1 ms on Windows with the
+// 1 ms timer period, tens of microseconds on Linux) and decays slowly so one spike does not stick.
+// The spin part is capped at MAX_SPIN however late the sleeps return.
+void CFrameLimiter::wait()
+{
+	if (m_TargetFps <= 0.0)
+	{
+		return;
+	}
+
+	m_Deadline += m_Period;
+	Clock::time_point now = Clock::now();
+	if (now > m_Deadline)
+	{
+		m_Deadline = now;    // late (stall, window drag): restart the cadence instead of rushing frames
+		return;
+	}
+
+	const std::chrono::microseconds step(1000);
+	for (;;)
+	{
+		Clock::duration remaining = m_Deadline - Clock::now();
+		Clock::duration budget = std::clamp<Clock::duration>(m_SleepOvershoot, MIN_SPIN, MAX_SPIN);
+		if (remaining <= budget + step)
+		{
+			break;
+		}
+
+		Clock::time_point before = Clock::now();
+		std::this_thread::sleep_for(step);
+		Clock::duration overshoot = (Clock::now() - before) - step;
+		m_SleepOvershoot = std::max(overshoot, m_SleepOvershoot - m_SleepOvershoot / 64);
+	}
+
+	while (Clock::now() < m_Deadline)
+	{
+		std::this_thread::yield();
+	}
+}
+
+void CFrameLimiter::benchmark(uint32_t frames)
+{
+	const double rates[] = { 30.0, 60.0, 144.0, 240.0 };
+
+	printf("Frame limiter: %u frames per rate\n", frames);
+	printf("  target FPS   mean interval   mean error   max error   within 0.1 ms\n");
+	for (double rate : rates)
+	{
+		CFrameLimiter limiter;
+		limiter.setTargetFps(rate);
+		limiter.wait();    // start the cadence
+
+		const double target = 1000.0 / rate;
+		double totalInterval = 0.0;
+		double totalError = 0.0;
+		double maxError = 0.0;
+		uint32_t within = 0;
+
+		Clock::time_point previous = Clock::now();
+		for (uint32_t i = 0; i < frames; i++)
+		{
+			limiter.wait();
+			Clock::time_point now = Clock::now();
+			double interval = std::chrono::duration<double, std::milli>(now - previous).count();
+			previous = now;
+
+			double error = std::fabs(interval - target);
+			totalInterval += interval;
+			totalError += error;
+			maxError = std::max(maxError, error);
+			within += (error <= 0.1) ? 1 : 0;
+		}
+
+		printf("  %10.0f   %10.3f ms   %7.3f ms   %6.3f ms   %10.1f%%\n", rate, totalInterval / frames,
+			totalError / frames, maxError, 100.0 * within / frames);
+	}
+}
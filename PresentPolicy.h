@@ -0,0 +1,72 @@
+/*======================================================================
+VulkanPBR_AcornForest : PresentPolicy.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Present mode policy, swapchain image count and CPU frame limiter.
+A policy lists present modes in order of preference. The first one the
+surface supports is used, and FIFO is always the last resort since every
+device must support it. The frame limiter sleeps for most of the frame
+and spins for the rest (at most 2 ms). While a limit is set it raises
+the Windows timer resolution to 1 ms, since at the default 15.6 ms tick
+the spin would take most of the frame.
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+enum class PresentPolicy
+{
+	Default,       // MAILBOX, else FIFO
+	LowLatency,    // MAILBOX, else IMMEDIATE, else FIFO
+	Uncapped,      // IMMEDIATE (benchmarking), else MAILBOX, else FIFO
+	VSync,         // FIFO
+	PowerSaver,    // FIFO_RELAXED, else FIFO; frame limiter on (60 FPS unless --fps-limit)
+};
+
+const uint32_t PRESENT_POLICY_COUNT = 5;
+
+const char* toString(PresentPolicy policy);
+const char* toString(VkPresentModeKHR presentMode);
+bool parsePresentPolicy(const char* name, PresentPolicy& policy);    // returns false for unknown names
+
+VkPresentModeKHR selectPresentMode(PresentPolicy policy, const std::vector<VkPresentModeKHR>& availableModes);
+
+// requested == 0: minImageCount + 1. Clamped to the surface limits either way.
+uint32_t selectImageCount(uint32_t requested, const VkSurfaceCapabilitiesKHR& capabilities);
+
+// frame limit for a policy: fpsLimit if set, otherwise the policy's default (0 = unlimited)
+double selectFrameLimit(PresentPolicy policy, double fpsLimit);
+
+class CFrameLimiter
+{
+private:
+
+	using Clock = std::chrono::steady_clock;
+
+	double              m_TargetFps = 0.0;
+	Clock::duration     m_Period{};
+	Clock::time_point   m_Deadline{};
+	Clock::duration     m_SleepOvershoot{};    // worst recent oversleep, sleeps stop this much early
+
+public:
+
+	CFrameLimiter() = default;
+	~CFrameLimiter();    // restores the timer resolution if a limit is still set
+
+	CFrameLimiter(const CFrameLimiter&) = delete;
+	CFrameLimiter& operator=(const CFrameLimiter&) = delete;
+
+	void setTargetFps(double fps);    // 0 = unlimited
+	double getTargetFps() const { return m_TargetFps; }
+
+	// Blocks until the next frame is due. Falls back to "now" after a stall instead of catching up.
+	void wait();
+
+	// runs the limiter at a few rates and prints the pacing error
+	static void benchmark(uint32_t frames);
+};
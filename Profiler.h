@@ -0,0 +1,90 @@
+/*======================================================================
+VulkanPBR_AcornForest : Profiler.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+CPU profiler zones exported as Chrome Trace Event JSON.
+PROFILE_SCOPE("name") times the enclosing block. Every thread writes its
+zones into its own ring buffer (single writer, no locks, no allocation),
+which keeps the last PROFILER_RING_SIZE zones per thread. Run with
+--profile <file.json> and open the file in ui.perfetto.dev or
+chrome://tracing.
+
+Recording is off until CProfiler::setEnabled(true); a disabled zone costs
+one relaxed load. Build with PROFILER_ENABLED=0 to compile every zone out.
+Zone names must be string literals (or otherwise outlive the export).
+=======================================================================*/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+const uint32_t PROFILER_RING_SIZE = 1u << 16;    // zones kept per thread (power of two)
+
+class CProfiler
+{
+private:
+
+	static std::atomic<bool> s_Enabled;
+
+public:
+
+	static int64_t now() { return std::chrono::steady_clock::now().time_since_epoch().count(); }
+
+	static void setEnabled(bool enabled) { s_Enabled.store(enabled, std::memory_order_relaxed); }
+	static bool isEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+
+	// appends one zone to the calling thread's ring buffer (registers the thread on first use)
+	static void record(const char* name, int64_t start, int64_t end);
+
+	// shown as the track name in the trace; call once at the top of a thread
+	static void setThreadName(const std::string& name);
+
+	// Stops recording and writes every buffered zone. Returns the number of zones written, throws if the file cannot be opened.
+	static uint32_t writeChromeTrace(const std::string& path);
+
+	// cost per zone: disabled, enabled, and the bare clock read
+	static void benchmark(uint32_t iterations);
+
+	// writes text as a quoted JSON string, escaping quotes, backslashes and control characters
+	static void writeJsonString(std::ostream& file, const std::string& text);
+};
+
+class CProfileScope
+{
+private:
+
+	const char* m_Name;
+	int64_t     m_Start;    // 0: profiler was off when the zone opened
+
+public:
+
+	explicit CProfileScope(const char* name) : m_Name(name), m_Start(CProfiler::isEnabled() ? CProfiler::now() : 0) {}
+	~CProfileScope()
+	{
+		if (m_Start != 0)
+		{
+			CProfiler::record(m_Name, m_Start, CProfiler::now());
+		}
+	}
+
+	CProfileScope(const CProfileScope&) = delete;
+	CProfileScope& operator=(const CProfileScope&) = delete;
+};
+
+#if PROFILER_ENABLED
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) CProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#endif
@@ -0,0 +1,1288 @@
+/*======================================================================
+VulkanPBR_AcornForest : RenderGraph.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "RenderGraph.h"
+#include "BenchUtil.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+	const VkAccessFlags WRITE_ACCESS =
+		VK_ACCESS_SHADER_WRITE_BIT |
+		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_TRANSFER_WRITE_BIT |
+		VK_ACCESS_HOST_WRITE_BIT |
+		VK_ACCESS_MEMORY_WRITE_BIT;
+
+	RGAccess makeAccess(VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout)
+	{
+		RGAccess result;
+		result.stages = stages;
+		result.access = access;
+		result.layout = layout;
+		return result;
+	}
+
+	const char* layoutName(VkImageLayout layout)
+	{
+		switch (layout)
+		{
+		case VK_IMAGE_LAYOUT_UNDEFINED:                         return "UNDEFINED";
+		case VK_IMAGE_LAYOUT_GENERAL:                           return "GENERAL";
+		case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:          return "COLOR_ATTACHMENT";
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:  return "DEPTH_ATTACHMENT";
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:   return "DEPTH_READ_ONLY";
+		case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:          return "SHADER_READ_ONLY";
+		case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:              return "TRANSFER_SRC";
+		case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:              return "TRANSFER_DST";
+		case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:                   return "PRESENT_SRC";
+		default:                                                return "?";
+		}
+	}
+
+	std::string stageNames(VkPipelineStageFlags stages)
+	{
+		static const std::pair<VkPipelineStageFlags, const char*> names[] =
+		{
+			{ VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, "TOP" },
+			{ VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, "INDIRECT" },
+			{ VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, "VERTEX_INPUT" },
+			{ VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, "VS" },
+			{ VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, "FS" },
+			{ VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT, "EARLY_Z" },
+			{ VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, "LATE_Z" },
+			{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, "COLOR_OUT" },
+			{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, "CS" },
+			{ VK_PIPELINE_STAGE_TRANSFER_BIT, "TRANSFER" },
+			{ VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, "BOTTOM" },
+		};
+
+		std::string result;
+		for (const auto& name : names)
+		{
+			if (stages & name.first)
+			{
+				result += result.empty() ? "" : "|";
+				result += name.second;
+			}
+		}
+		return result.empty() ? "NONE" : result;
+	}
+
+	bool covers(VkFlags mask, VkFlags required)
+	{
+		return (mask & required) == required;
+	}
+}
+
+//====================================================================================
+// RGAccess
+//====================================================================================
+
+bool RGAccess::isWrite() const
+{
+	return (access & WRITE_ACCESS) != 0;
+}
+
+RGAccess RGAccess::colorAttachmentWrite()
+{
+	return makeAccess(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+}
+
+RGAccess RGAccess::colorAttachmentReadWrite()
+{
+	return makeAccess(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+		VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+}
+
+RGAccess RGAccess::depthAttachmentWrite()
+{
+	return makeAccess(VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+}
+
+RGAccess RGAccess::depthAttachmentRead()
+{
+	return makeAccess(VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+}
+
+RGAccess RGAccess::sampledFragment()
+{
+	return makeAccess(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+RGAccess RGAccess::sampledCompute()
+{
+	return makeAccess(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+RGAccess RGAccess::storageImageWrite()
+{
+	return makeAccess(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL);
+}
+
+RGAccess RGAccess::storageBufferWrite()
+{
+	return makeAccess(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED);
+}
+
+RGAccess RGAccess::storageBufferRead()
+{
+	return makeAccess(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED);
+}
+
+RGAccess RGAccess::storageBufferReadFragment()
+{
+	return makeAccess(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED);
+}
+
+RGAccess RGAccess::transferSrc()
+{
+	return makeAccess(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+}
+
+RGAccess RGAccess::transferDst()
+{
+	return makeAccess(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+}
+
+RGAccess RGAccess::vertexBuffer()
+{
+	return makeAccess(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED);
+}
+
+RGAccess RGAccess::indirectBuffer()
+{
+	return makeAccess(VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED);
+}
+
+RGAccess RGAccess::present()
+{
+	return makeAccess(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+}
+
+RGAccess RGAccess::fromLayout(VkImageLayout layout)
+{
+	switch (layout)
+	{
+	case VK_IMAGE_LAYOUT_UNDEFINED:                         return makeAccess(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, layout);
+	case VK_IMAGE_LAYOUT_GENERAL:                           return storageImageWrite();
+	case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:          return colorAttachmentWrite();
+	case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:  return depthAttachmentWrite();
+	case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:   return depthAttachmentRead();
+	case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:          return sampledFragment();
+	case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:              return transferSrc();
+	case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:              return transferDst();
+	case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:                   return present();
+	default:
+		throw std::invalid_argument("Unsupported layout transition!");
+	}
+}
+
+RGAccess RGAccess::discarded(const RGAccess& lastUse)
+{
+	return makeAccess(lastUse.stages, lastUse.access, VK_IMAGE_LAYOUT_UNDEFINED);
+}
+
+RGAccess RGAccess::untouched(VkImageLayout layout)
+{
+	return makeAccess(0, 0, layout);
+}
+
+//====================================================================================
+// Graph setup
+//====================================================================================
+
+RGHandle CRenderGraph::addResource(const Resource& resource)
+{
+	m_Compiled = false;
+	m_Resources.push_back(resource);
+	return static_cast<RGHandle>(m_Resources.size() - 1);
+}
+
+RGHandle CRenderGraph::createImage(const std::string& name, VkDeviceSize size)
+{
+	Resource resource;
+	resource.name = name;
+	resource.size = size;
+	return addResource(resource);
+}
+
+RGHandle CRenderGraph::createBuffer(const std::string& name, VkDeviceSize size)
+{
+	Resource resource;
+	resource.name = name;
+	resource.image = false;
+	resource.size = size;
+	return addResource(resource);
+}
+
+RGHandle CRenderGraph::importImage(const std::string& name, const RGAccess& initial, const RGAccess& final)
+{
+	Resource resource;
+	resource.name = name;
+	resource.imported = true;
+	resource.initial = initial;
+	resource.final = final;
+	return addResource(resource);
+}
+
+RGHandle CRenderGraph::importBuffer(const std::string& name, const RGAccess& initial, const RGAccess& final)
+{
+	Resource resource;
+	resource.name = name;
+	resource.image = false;
+	resource.imported = true;
+	resource.initial = initial;
+	resource.final = final;
+	return addResource(resource);
+}
+
+uint32_t CRenderGraph::addPass(const std::string& name, std::function<void(VkCommandBuffer)> record)
+{
+	m_Compiled = false;
+	Pass pass;
+	pass.name = name;
+	pass.record = record;
+	m_Passes.push_back(pass);
+	return static_cast<uint32_t>(m_Passes.size() - 1);
+}
+
+void CRenderGraph::addUse(uint32_t pass, RGHandle resource, const RGAccess& access, bool read, bool write)
+{
+	if (pass >= m_Passes.size() || resource >= m_Resources.size())
+	{
+		throw std::runtime_error("Failed to add resource use: invalid pass or resource handle!");
+	}
+	m_Compiled = false;
+
+	// one merged use per resource and pass
+	for (Use& use : m_Passes[pass].uses)
+	{
+		if (use.resource != resource)
+		{
+			continue;
+		}
+		if (m_Resources[resource].image && use.access.layout != access.layout)
+		{
+			throw std::runtime_error("Failed to add resource use: " + m_Passes[pass].name + " uses " +
+				m_Resources[resource].name + " in two layouts!");
+		}
+		use.access.stages |= access.stages;
+		use.access.access |= access.access;
+		use.read = use.read || read;
+		use.write = use.write || write;
+		return;
+	}
+
+	Use use;
+	use.resource = resource;
+	use.access = access;
+	use.read = read;
+	use.write = write;
+	m_Passes[pass].uses.push_back(use);
+}
+
+void CRenderGraph::read(uint32_t pass, RGHandle resource, const RGAccess& access)
+{
+	addUse(pass, resource, access, true, false);
+}
+
+void CRenderGraph::write(uint32_t pass, RGHandle resource, const RGAccess& access)
+{
+	addUse(pass, resource, access, false, true);
+}
+
+void CRenderGraph::setSideEffect(uint32_t pass)
+{
+	m_Passes.at(pass).sideEffect = true;
+}
+
+void CRenderGraph::reset()
+{
+	m_Resources.clear();
+	m_Passes.clear();
+	m_Compiled = false;
+	m_Order.clear();
+	m_PassBarriers.clear();
+	m_FinalBarriers.clear();
+	m_MemorySlots.clear();
+	m_ResourceSlot.clear();
+}
+
+//====================================================================================
+// Compilation
+//====================================================================================
+
+void CRenderGraph::compile()
+{
+	cullPasses();
+	assignMemorySlots();
+	buildBarriers();
+	m_Compiled = true;
+}
+
+// walk backwards: a pass is live if something live (or outside the frame) reads what it writes
+void CRenderGraph::cullPasses()
+{
+	std::vector<bool> needed(m_Resources.size());
+	for (size_t r = 0; r < m_Resources.size(); r++)
+	{
+		needed[r] = m_Resources[r].imported;
+	}
+
+	std::vector<bool> live(m_Passes.size(), false);
+	for (size_t p = m_Passes.size(); p-- > 0;)
+	{
+		const Pass& pass = m_Passes[p];
+		bool isLive = pass.sideEffect;
+		for (const Use& use : pass.uses)
+		{
+			isLive = isLive || (use.write && needed[use.resource]);
+		}
+		if (isLive == false)
+		{
+			continue;
+		}
+
+		live[p] = true;
+		for (const Use& use : pass.uses)
+		{
+			if (use.write)
+			{
+				needed[use.resource] = false;    // this pass produces the content read later
+			}
+		}
+		for (const Use& use : pass.uses)
+		{
+			if (use.read)
+			{
+				needed[use.resource] = true;
+			}
+		}
+	}
+
+	m_Order.clear();
+	for (uint32_t p = 0; p < m_Passes.size(); p++)
+	{
+		if (live[p])
+		{
+			m_Order.push_back(p);
+		}
+	}
+}
+
+// first fit, largest first: transient resources whose lifetimes do not overlap share a slot
+void CRenderGraph::assignMemorySlots()
+{
+	std::vector<int> first(m_Resources.size(), -1);
+	std::vector<int> last(m_Resources.size(), -1);
+	for (size_t i = 0; i < m_Order.size(); i++)
+	{
+		for (const Use& use : m_Passes[m_Order[i]].uses)
+		{
+			if (first[use.resource] < 0)
+			{
+				first[use.resource] = static_cast<int>(i);
+			}
+			last[use.resource] = static_cast<int>(i);
+		}
+	}
+
+	std::vector<RGHandle> transients;
+	for (RGHandle r = 0; r < m_Resources.size(); r++)
+	{
+		if (m_Resources[r].imported == false && first[r] >= 0)
+		{
+			transients.push_back(r);
+		}
+	}
+	std::stable_sort(transients.begin(), transients.end(), [&](RGHandle a, RGHandle b)
+	{
+		return m_Resources[a].size > m_Resources[b].size;
+	});
+
+	m_MemorySlots.clear();
+	m_ResourceSlot.assign(m_Resources.size(), -1);
+	for (RGHandle r : transients)
+	{
+		size_t slot = 0;
+		for (; slot < m_MemorySlots.size(); slot++)
+		{
+			bool overlaps = false;
+			for (RGHandle other : m_MemorySlots[slot].resources)
+			{
+				overlaps = overlaps || (first[r] <= last[other] && first[other] <= last[r]);
+			}
+			if (overlaps == false)
+			{
+				break;
+			}
+		}
+		if (slot == m_MemorySlots.size())
+		{
+			m_MemorySlots.push_back({});
+		}
+		m_MemorySlots[slot].resources.push_back(r);
+		m_MemorySlots[slot].size = std::max(m_MemorySlots[slot].size, m_Resources[r].size);
+		m_ResourceSlot[r] = static_cast<int>(slot);
+	}
+
+	for (RGMemorySlot& slot : m_MemorySlots)
+	{
+		std::sort(slot.resources.begin(), slot.resources.end(), [&](RGHandle a, RGHandle b) { return first[a] < first[b]; });
+	}
+}
+
+uint32_t CRenderGraph::memoryKey(RGHandle resource) const
+{
+	int slot = m_ResourceSlot.empty() ? -1 : m_ResourceSlot[resource];
+	return slot < 0 ? resource : static_cast<uint32_t>(m_Resources.size() + slot);
+}
+
+// track the last accesses of every resource and emit a barrier only when a hazard or layout change needs one
+void CRenderGraph::buildBarriers()
+{
+	struct State
+	{
+		VkImageLayout           layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		bool                    hasWrite = false;     // written or transitioned since the frame started
+		VkPipelineStageFlags    writeStages = 0;
+		VkAccessFlags           writeAccess = 0;
+		VkPipelineStageFlags    readStages = 0;       // reads since the last write
+		VkPipelineStageFlags    syncedStages = 0;     // stages that already wait for the last write
+		VkAccessFlags           visibleAccess = 0;    // accesses the last write is visible to
+		bool                    used = false;
+	};
+
+	std::vector<State> states(m_Resources.size());
+	for (size_t r = 0; r < m_Resources.size(); r++)
+	{
+		const Resource& resource = m_Resources[r];
+		if (resource.imported)
+		{
+			states[r].layout = resource.initial.layout;
+			states[r].used = true;
+			if (resource.initial.isWrite())
+			{
+				states[r].hasWrite = true;
+				states[r].writeStages = resource.initial.stages;
+				states[r].writeAccess = resource.initial.access & WRITE_ACCESS;
+			}
+			else
+			{
+				states[r].readStages = resource.initial.stages;
+			}
+		}
+	}
+
+	auto apply = [&](RGHandle r, const RGAccess& access, bool read, bool write, const std::string& passName, std::vector<RGBarrier>& barriers)
+	{
+		const Resource& resource = m_Resources[r];
+		State& state = states[r];
+
+		if (state.used == false)
+		{
+			if (read)
+			{
+				throw std::runtime_error("Failed to compile render graph: " + passName + " reads " + resource.name + " before it is written!");
+			}
+
+			// aliased memory: wait for the previous user of the slot
+			int slot = m_ResourceSlot[r];
+			const std::vector<RGHandle>& slotResources = m_MemorySlots[slot].resources;
+			auto position = std::find(slotResources.begin(), slotResources.end(), r);
+			if (position != slotResources.begin())
+			{
+				const State& previous = states[*(position - 1)];
+				state.readStages = previous.writeStages | previous.readStages | previous.syncedStages;
+				state.writeAccess = previous.writeAccess;
+			}
+			state.used = true;
+		}
+
+		bool layoutChange = resource.image && access.layout != state.layout;
+		bool needed;
+		if (write || layoutChange)
+		{
+			needed = layoutChange || (state.writeStages | state.readStages | state.syncedStages) != 0;
+		}
+		else
+		{
+			needed = state.hasWrite && ((access.stages & ~state.syncedStages) != 0 || (access.access & ~state.visibleAccess) != 0);
+		}
+
+		if (needed)
+		{
+			RGBarrier barrier;
+			barrier.resource = r;
+			barrier.srcStages = state.writeStages | state.readStages | state.syncedStages;
+			barrier.srcStages = (barrier.srcStages != 0) ? barrier.srcStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+			barrier.srcAccess = state.writeAccess;
+			barrier.dstStages = access.stages;
+			barrier.dstAccess = access.access;
+			barrier.oldLayout = resource.image ? state.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = resource.image ? access.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+			barriers.push_back(barrier);
+		}
+
+		if (write)
+		{
+			state.hasWrite = true;
+			state.writeStages = access.stages;
+			state.writeAccess = access.access & WRITE_ACCESS;
+			state.readStages = 0;
+			state.syncedStages = 0;
+			state.visibleAccess = 0;
+		}
+		else if (layoutChange)
+		{
+			// the transition is a write: later readers must wait for it
+			state.hasWrite = true;
+			state.readStages = access.stages;
+			state.syncedStages = access.stages;
+			state.visibleAccess = access.access;
+		}
+		else
+		{
+			if (needed)
+			{
+				state.syncedStages |= access.stages;
+				state.visibleAccess |= access.access;
+			}
+			state.readStages |= access.stages;
+		}
+		if (resource.image)
+		{
+			state.layout = access.layout;
+		}
+	};
+
+	m_PassBarriers.assign(m_Order.size(), {});
+	for (size_t i = 0; i < m_Order.size(); i++)
+	{
+		const Pass& pass = m_Passes[m_Order[i]];
+		for (const Use& use : pass.uses)
+		{
+			apply(use.resource, use.access, use.read, use.write, pass.name, m_PassBarriers[i]);
+		}
+	}
+
+	m_FinalBarriers.clear();
+	for (RGHandle r = 0; r < m_Resources.size(); r++)
+	{
+		const Resource& resource = m_Resources[r];
+		if (resource.imported)
+		{
+			bool write = resource.final.isWrite();
+			apply(r, resource.final, !write, write, "end of frame", m_FinalBarriers);
+		}
+	}
+}
+
+//====================================================================================
+// Validation
+//====================================================================================
+
+// Replays the schedule event by event and checks every hazard independently of compile():
+//  RAW: a barrier after the write whose source covers the writer and whose destination covers the reader
+//  WAR/WAW: a barrier after each earlier access whose source covers it and whose destination covers the writer
+//  layouts: every access sees the layout it declared
+// Hazards are tracked per memory slot, so aliased resources are checked against each other.
+std::vector<std::string> CRenderGraph::validate() const
+{
+	std::vector<std::string> errors;
+	if (m_Compiled == false)
+	{
+		errors.push_back("graph is not compiled");
+		return errors;
+	}
+
+	struct Event
+	{
+		uint32_t                index = 0;
+		VkPipelineStageFlags    stages = 0;
+		VkAccessFlags           access = 0;
+		bool                    isBarrier = false;    // layout transition
+	};
+	struct Hazard
+	{
+		bool                    hasWrite = false;
+		Event                   write;                // last write or layout transition
+		bool                    hasDataWrite = false;
+		Event                   dataWrite;            // last write through a shader / attachment / transfer
+		std::vector<Event>      reads;                // since the last write
+	};
+	struct Recorded
+	{
+		uint32_t                index;
+		uint32_t                key;
+		RGBarrier               barrier;
+	};
+
+	const size_t keyCount = m_Resources.size() + m_MemorySlots.size();
+	std::vector<Hazard> hazards(keyCount);
+	std::vector<VkImageLayout> layouts(m_Resources.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+	std::vector<Recorded> recorded;
+	uint32_t index = 0;
+
+	for (RGHandle r = 0; r < m_Resources.size(); r++)
+	{
+		const Resource& resource = m_Resources[r];
+		if (resource.imported)
+		{
+			layouts[r] = resource.initial.layout;
+			Event initial{ index, resource.initial.stages, resource.initial.access & WRITE_ACCESS, false };
+			if (resource.initial.isWrite())
+			{
+				hazards[r].hasWrite = hazards[r].hasDataWrite = true;
+				hazards[r].write = hazards[r].dataWrite = initial;
+			}
+			else
+			{
+				hazards[r].reads.push_back(initial);
+			}
+		}
+	}
+	index++;
+
+	// execution dependency: a barrier after event whose source covers it and whose destination covers stages
+	auto executionCovered = [&](uint32_t key, const Event& event, VkPipelineStageFlags stages, uint32_t before) -> bool
+	{
+		for (VkPipelineStageFlags bit = 1; bit != 0 && bit <= stages; bit <<= 1)
+		{
+			if ((stages & bit) == 0)
+			{
+				continue;
+			}
+			bool found = false;
+			for (const Recorded& rec : recorded)
+			{
+				if (rec.key != key || rec.index >= before || (rec.barrier.dstStages & bit) == 0)
+				{
+					continue;
+				}
+				// a layout transition is covered by its own barrier or by a later one chained to its destination stages
+				bool afterEvent = (event.isBarrier && rec.index == event.index) ||
+					(rec.index > event.index && covers(rec.barrier.srcStages, event.stages));
+				found = found || afterEvent;
+			}
+			if (found == false)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	// memory dependency: the write is made visible to every stage/access pair
+	auto memoryCovered = [&](uint32_t key, const Event& write, VkPipelineStageFlags stages, VkAccessFlags access, uint32_t before) -> bool
+	{
+		for (VkPipelineStageFlags stage = 1; stage != 0 && stage <= stages; stage <<= 1)
+		{
+			for (VkAccessFlags bit = 1; bit != 0 && bit <= access; bit <<= 1)
+			{
+				if ((stages & stage) == 0 || (access & bit) == 0)
+				{
+					continue;
+				}
+				bool found = false;
+				for (const Recorded& rec : recorded)
+				{
+					found = found || (rec.key == key && rec.index > write.index && rec.index < before &&
+						covers(rec.barrier.srcAccess, write.access) && (rec.barrier.dstStages & stage) && (rec.barrier.dstAccess & bit));
+				}
+				if (found == false)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	};
+
+	// every earlier access must have finished before a write (or layout transition)
+	auto checkWrite = [&](uint32_t key, VkPipelineStageFlags stages, VkAccessFlags access, uint32_t at, const std::string& what)
+	{
+		const Hazard& hazard = hazards[key];
+		if (hazard.hasWrite && executionCovered(key, hazard.write, stages, at) == false)
+		{
+			errors.push_back(what + ": write-after-write hazard");
+		}
+		if (hazard.hasDataWrite && hazard.dataWrite.access != 0 && access != 0 && memoryCovered(key, hazard.dataWrite, stages, access, at) == false)
+		{
+			errors.push_back(what + ": write-after-write without memory dependency");
+		}
+		for (const Event& readEvent : hazard.reads)
+		{
+			if (executionCovered(key, readEvent, stages, at) == false)
+			{
+				errors.push_back(what + ": write-after-read hazard");
+				break;
+			}
+		}
+	};
+
+	auto recordBarriers = [&](const std::vector<RGBarrier>& barriers, const std::string& where)
+	{
+		for (const RGBarrier& barrier : barriers)
+		{
+			uint32_t key = memoryKey(barrier.resource);
+			const Resource& resource = m_Resources[barrier.resource];
+			std::string what = where + " / barrier " + resource.name;
+
+			if (resource.image && barrier.oldLayout != barrier.newLayout)
+			{
+				if (barrier.oldLayout != VK_IMAGE_LAYOUT_UNDEFINED && barrier.oldLayout != layouts[barrier.resource])
+				{
+					errors.push_back(what + ": old layout " + layoutName(barrier.oldLayout) + " but image is " + layoutName(layouts[barrier.resource]));
+				}
+
+				// the transition itself must come after every earlier access
+				Recorded self{ index, key, barrier };
+				recorded.push_back(self);
+				Hazard& hazard = hazards[key];
+				if (hazard.hasWrite && (hazard.write.isBarrier == false) && covers(barrier.srcStages, hazard.write.stages) == false &&
+					executionCovered(key, hazard.write, barrier.srcStages, index) == false)
+				{
+					errors.push_back(what + ": layout transition before the last write finished");
+				}
+				for (const Event& readEvent : hazard.reads)
+				{
+					if (covers(barrier.srcStages, readEvent.stages) == false && executionCovered(key, readEvent, barrier.srcStages, index) == false)
+					{
+						errors.push_back(what + ": layout transition while the image is still read");
+						break;
+					}
+				}
+
+				layouts[barrier.resource] = barrier.newLayout;
+				hazard.hasWrite = true;
+				hazard.write = Event{ index, barrier.dstStages, 0, true };
+				hazard.reads.clear();
+			}
+			else
+			{
+				recorded.push_back({ index, key, barrier });
+			}
+			index++;
+		}
+	};
+
+	auto checkUse = [&](RGHandle r, const RGAccess& access, bool read, bool write, const std::string& what)
+	{
+		uint32_t key = memoryKey(r);
+		Hazard& hazard = hazards[key];
+
+		if (m_Resources[r].image && layouts[r] != access.layout)
+		{
+			errors.push_back(what + ": expects " + layoutName(access.layout) + " but image is " + layoutName(layouts[r]));
+		}
+		if (read)
+		{
+			if (hazard.hasWrite && executionCovered(key, hazard.write, access.stages, index) == false)
+			{
+				errors.push_back(what + ": read-after-write hazard");
+			}
+			if (hazard.hasDataWrite && hazard.dataWrite.access != 0 && memoryCovered(key, hazard.dataWrite, access.stages, access.access, index) == false)
+			{
+				errors.push_back(what + ": write is not visible to the reader");
+			}
+		}
+		if (write)
+		{
+			checkWrite(key, access.stages, access.access & WRITE_ACCESS, index, what);
+			hazard.hasWrite = hazard.hasDataWrite = true;
+			hazard.write = hazard.dataWrite = Event{ index, access.stages, access.access & WRITE_ACCESS, false };
+			hazard.reads.clear();
+		}
+		else
+		{
+			hazard.reads.push_back(Event{ index, access.stages, access.access, false });
+		}
+		index++;
+	};
+
+	for (size_t i = 0; i < m_Order.size(); i++)
+	{
+		const Pass& pass = m_Passes[m_Order[i]];
+		recordBarriers(m_PassBarriers[i], pass.name);
+		for (const Use& use : pass.uses)
+		{
+			checkUse(use.resource, use.access, use.read, use.write, pass.name + " / " + m_Resources[use.resource].name);
+		}
+	}
+
+	recordBarriers(m_FinalBarriers, "end of frame");
+	for (RGHandle r = 0; r < m_Resources.size(); r++)
+	{
+		const Resource& resource = m_Resources[r];
+		if (resource.imported)
+		{
+			bool write = resource.final.isWrite();
+			checkUse(r, resource.final, !write, write, "end of frame / " + resource.name);
+		}
+	}
+	return errors;
+}
+
+//====================================================================================
+// Execution
+//====================================================================================
+
+void CRenderGraph::bindImage(RGHandle resource, VkImage image, const VkImageSubresourceRange& range)
+{
+	m_Resources.at(resource).vkImage = image;
+	m_Resources.at(resource).range = range;
+}
+
+void CRenderGraph::bindBuffer(RGHandle resource, VkBuffer buffer)
+{
+	m_Resources.at(resource).vkBuffer = buffer;
+}
+
+// one vkCmdPipelineBarrier per pass; buffer barriers are folded into a single global memory barrier
+void CRenderGraph::recordBatch(VkCommandBuffer commandBuffer, const std::vector<RGBarrier>& barriers) const
+{
+	if (barriers.empty())
+	{
+		return;
+	}
+
+	VkPipelineStageFlags srcStages = 0;
+	VkPipelineStageFlags dstStages = 0;
+	VkMemoryBarrier memoryBarrier{};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	std::vector<VkImageMemoryBarrier> imageBarriers;
+
+	for (const RGBarrier& barrier : barriers)
+	{
+		const Resource& resource = m_Resources[barrier.resource];
+		srcStages |= barrier.srcStages;
+		dstStages |= barrier.dstStages;
+
+		if (resource.image == false)
+		{
+			memoryBarrier.srcAccessMask |= barrier.srcAccess;
+			memoryBarrier.dstAccessMask |= barrier.dstAccess;
+			continue;
+		}
+		if (resource.vkImage == VK_NULL_HANDLE)
+		{
+			throw std::runtime_error("Failed to execute render graph: " + resource.name + " has no image bound!");
+		}
+
+		VkImageMemoryBarrier imageBarrier{};
+		imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageBarrier.srcAccessMask = barrier.srcAccess;
+		imageBarrier.dstAccessMask = barrier.dstAccess;
+		imageBarrier.oldLayout = barrier.oldLayout;
+		imageBarrier.newLayout = barrier.newLayout;
+		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.image = resource.vkImage;
+		imageBarrier.subresourceRange = resource.range;
+		imageBarriers.push_back(imageBarrier);
+	}
+
+	bool hasMemoryBarrier = (memoryBarrier.srcAccessMask | memoryBarrier.dstAccessMask) != 0;
+	vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0,
+		hasMemoryBarrier ? 1 : 0, hasMemoryBarrier ? &memoryBarrier : nullptr,
+		0, nullptr,
+		static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+}
+
+void CRenderGraph::execute(VkCommandBuffer commandBuffer) const
+{
+	if (m_Compiled == false)
+	{
+		throw std::runtime_error("Failed to execute render graph: not compiled!");
+	}
+
+	for (size_t i = 0; i < m_Order.size(); i++)
+	{
+		recordBatch(commandBuffer, m_PassBarriers[i]);
+		const Pass& pass = m_Passes[m_Order[i]];
+		if (pass.record)
+		{
+			pass.record(commandBuffer);
+		}
+	}
+	recordBatch(commandBuffer, m_FinalBarriers);
+}
+
+void CRenderGraph::recordBarriers(VkCommandBuffer commandBuffer, uint32_t pass) const
+{
+	if (m_Compiled == false)
+	{
+		throw std::runtime_error("Failed to record render graph barriers: not compiled!");
+	}
+
+	auto position = std::find(m_Order.begin(), m_Order.end(), pass);
+	if (position != m_Order.end())
+	{
+		recordBatch(commandBuffer, m_PassBarriers[position - m_Order.begin()]);
+	}
+}
+
+void CRenderGraph::recordFinalBarriers(VkCommandBuffer commandBuffer) const
+{
+	if (m_Compiled == false)
+	{
+		throw std::runtime_error("Failed to record render graph barriers: not compiled!");
+	}
+	recordBatch(commandBuffer, m_FinalBarriers);
+}
+
+//====================================================================================
+// Reporting
+//====================================================================================
+
+uint32_t CRenderGraph::getBarrierCount() const
+{
+	size_t count = m_FinalBarriers.size();
+	for (const std::vector<RGBarrier>& barriers : m_PassBarriers)
+	{
+		count += barriers.size();
+	}
+	return static_cast<uint32_t>(count);
+}
+
+uint32_t CRenderGraph::getBatchCount() const
+{
+	uint32_t count = m_FinalBarriers.empty() ? 0 : 1;
+	for (const std::vector<RGBarrier>& barriers : m_PassBarriers)
+	{
+		count += barriers.empty() ? 0 : 1;
+	}
+	return count;
+}
+
+VkDeviceSize CRenderGraph::getTransientSize(bool aliased) const
+{
+	VkDeviceSize size = 0;
+	for (const RGMemorySlot& slot : m_MemorySlots)
+	{
+		if (aliased)
+		{
+			size += slot.size;
+			continue;
+		}
+		for (RGHandle r : slot.resources)
+		{
+			size += m_Resources[r].size;
+		}
+	}
+	return size;
+}
+
+void CRenderGraph::printSchedule() const
+{
+	printf("Render graph: %u of %zu passes live, %u barriers in %u batches\n",
+		getLivePassCount(), m_Passes.size(), getBarrierCount(), getBatchCount());
+
+	auto printBarriers = [&](const std::vector<RGBarrier>& barriers)
+	{
+		for (const RGBarrier& barrier : barriers)
+		{
+			printf("    barrier %-12s %s -> %s", m_Resources[barrier.resource].name.c_str(),
+				stageNames(barrier.srcStages).c_str(), stageNames(barrier.dstStages).c_str());
+			if (barrier.oldLayout != barrier.newLayout)
+			{
+				printf("  [%s -> %s]", layoutName(barrier.oldLayout), layoutName(barrier.newLayout));
+			}
+			printf("\n");
+		}
+	};
+
+	for (size_t i = 0; i < m_Order.size(); i++)
+	{
+		printBarriers(m_PassBarriers[i]);
+		printf("  %s\n", m_Passes[m_Order[i]].name.c_str());
+	}
+	printBarriers(m_FinalBarriers);
+
+	for (uint32_t p = 0; p < m_Passes.size(); p++)
+	{
+		if (std::find(m_Order.begin(), m_Order.end(), p) == m_Order.end())
+		{
+			printf("  culled: %s\n", m_Passes[p].name.c_str());
+		}
+	}
+
+	printf("Transient memory: %.1f MB in %zu slots (%.1f MB without aliasing)\n",
+		getTransientSize(true) / (1024.0 * 1024.0), m_MemorySlots.size(), getTransientSize(false) / (1024.0 * 1024.0));
+	for (size_t s = 0; s < m_MemorySlots.size(); s++)
+	{
+		printf("  slot %zu:", s);
+		for (RGHandle r : m_MemorySlots[s].resources)
+		{
+			printf(" %s", m_Resources[r].name.c_str());
+		}
+		printf("\n");
+	}
+}
+
+//====================================================================================
+// Renderer frame
+//====================================================================================
+
+RGForestFrame declareForestFrame(CRenderGraph& graph, bool shadows, bool lightCulling)
+{
+	RGForestFrame frame;
+
+	// acquired with the semaphore waited at COLOR_ATTACHMENT_OUTPUT, drawn by the scene and ImGui, then presented
+	frame.swapchain = graph.importImage("swapchain", RGAccess::discarded(RGAccess::colorAttachmentWrite()), RGAccess::present());
+	frame.color = graph.importImage("msaaColor", RGAccess::discarded(RGAccess::colorAttachmentWrite()),
+		RGAccess::untouched(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+	frame.depth = graph.importImage("depth", RGAccess::discarded(RGAccess::depthAttachmentWrite()),
+		RGAccess::untouched(VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL));
+
+	// shared by every frame: the previous frames' fragment shaders may still sample it, and cached cascades
+	// are not re-rendered, so the transitions keep the contents (never from UNDEFINED)
+	if (shadows)
+	{
+		frame.shadowMap = graph.importImage("shadowMap", RGAccess::sampledFragment(), RGAccess::sampledFragment());
+		frame.shadowPass = graph.addPass("Shadow");
+		graph.write(frame.shadowPass, frame.shadowMap, RGAccess::depthAttachmentWrite());
+	}
+
+	// one cluster buffer per swapchain image, last read by the fragment shaders of the image's previous frame;
+	// the light buffers are written by the host before the submit, which makes them visible without a barrier
+	if (lightCulling)
+	{
+		frame.clusters = graph.importBuffer("clusters", RGAccess::storageBufferReadFragment(), RGAccess::storageBufferReadFragment());
+		frame.lightCullPass = graph.addPass("LightCull");
+		graph.write(frame.lightCullPass, frame.clusters, RGAccess::storageBufferWrite());
+	}
+
+	// prepass, PBR and impostors in one render pass, resolved into the swapchain image
+	frame.scenePass = graph.addPass("Scene");
+	if (shadows)
+	{
+		graph.read(frame.scenePass, frame.shadowMap, RGAccess::sampledFragment());
+	}
+	if (lightCulling)
+	{
+		graph.read(frame.scenePass, frame.clusters, RGAccess::storageBufferReadFragment());
+	}
+	graph.write(frame.scenePass, frame.color, RGAccess::colorAttachmentWrite());
+	graph.write(frame.scenePass, frame.depth, RGAccess::depthAttachmentWrite());
+	graph.write(frame.scenePass, frame.swapchain, RGAccess::colorAttachmentWrite());
+
+	frame.imguiPass = graph.addPass("ImGui");
+	graph.read(frame.imguiPass, frame.swapchain, RGAccess::colorAttachmentReadWrite());
+	graph.write(frame.imguiPass, frame.swapchain, RGAccess::colorAttachmentReadWrite());
+
+	return frame;
+}
+
+//====================================================================================
+// Self test (CPU only)
+//====================================================================================
+
+bool CRenderGraph::verify(const char* name) const
+{
+	std::vector<std::string> errors = validate();
+	for (const std::string& error : errors)
+	{
+		printf("  error: %s\n", error.c_str());
+	}
+
+	// check the validator: removing any single barrier must be reported
+	uint32_t barrierCount = 0;
+	uint32_t detected = 0;
+	for (size_t i = 0; i <= m_PassBarriers.size(); i++)
+	{
+		size_t count = (i < m_PassBarriers.size()) ? m_PassBarriers[i].size() : m_FinalBarriers.size();
+		for (size_t b = 0; b < count; b++)
+		{
+			CRenderGraph broken = *this;
+			std::vector<RGBarrier>& barriers = (i < broken.m_PassBarriers.size()) ? broken.m_PassBarriers[i] : broken.m_FinalBarriers;
+			barriers.erase(barriers.begin() + b);
+			barrierCount++;
+			detected += broken.validate().empty() ? 0 : 1;
+		}
+	}
+	printf("%s: %s, %u / %u removed barriers detected\n", name, errors.empty() ? "valid" : "INVALID", detected, barrierCount);
+	return errors.empty() && (detected == barrierCount);
+}
+
+bool CRenderGraph::selfTest(uint32_t randomGraphs)
+{
+	bool success = true;
+
+	// sample frame: MSAA scene, bloom, composite, ImGui, present, plus an unused debug view
+	{
+		const VkDeviceSize pixels = 1920ull * 1080ull;
+		CRenderGraph graph;
+		RGHandle swapchain = graph.importImage("swapchain",
+			makeAccess(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED), RGAccess::present());
+		RGHandle albedo = graph.importImage("albedo", RGAccess::sampledFragment(), RGAccess::sampledFragment());
+		RGHandle vertices = graph.importBuffer("vertices", RGAccess::vertexBuffer(), RGAccess::vertexBuffer());
+		RGHandle msaaColor = graph.createImage("msaaColor", pixels * 8 * 8);
+		RGHandle depth = graph.createImage("depth", pixels * 4 * 8);
+		RGHandle hdr = graph.createImage("hdr", pixels * 8);
+		RGHandle bloomA = graph.createImage("bloomA", pixels * 2);
+		RGHandle bloomB = graph.createImage("bloomB", pixels * 2);
+		RGHandle bloomC = graph.createImage("bloomC", pixels * 2);
+		RGHandle overdraw = graph.createImage("overdraw", pixels * 4);
+
+		uint32_t scene = graph.addPass("Scene");
+		graph.read(scene, vertices, RGAccess::vertexBuffer());
+		graph.read(scene, albedo, RGAccess::sampledFragment());
+		graph.write(scene, msaaColor, RGAccess::colorAttachmentWrite());
+		graph.write(scene, depth, RGAccess::depthAttachmentWrite());
+		graph.write(scene, hdr, RGAccess::colorAttachmentWrite());    // MSAA resolve target
+
+		uint32_t debugView = graph.addPass("OverdrawDebug");
+		graph.read(debugView, vertices, RGAccess::vertexBuffer());
+		graph.write(debugView, overdraw, RGAccess::colorAttachmentWrite());
+
+		uint32_t bright = graph.addPass("BloomBright");
+		graph.read(bright, hdr, RGAccess::sampledCompute());
+		graph.write(bright, bloomA, RGAccess::storageImageWrite());
+
+		uint32_t blurX = graph.addPass("BloomBlurX");
+		graph.read(blurX, bloomA, RGAccess::sampledCompute());
+		graph.write(blurX, bloomB, RGAccess::storageImageWrite());
+
+		uint32_t blurY = graph.addPass("BloomBlurY");
+		graph.read(blurY, bloomB, RGAccess::sampledCompute());
+		graph.write(blurY, bloomC, RGAccess::storageImageWrite());
+
+		uint32_t composite = graph.addPass("Composite");
+		graph.read(composite, hdr, RGAccess::sampledFragment());
+		graph.read(composite, bloomC, RGAccess::sampledFragment());
+		graph.write(composite, swapchain, RGAccess::colorAttachmentWrite());
+
+		uint32_t imgui = graph.addPass("ImGui");
+		graph.read(imgui, swapchain, RGAccess::colorAttachmentReadWrite());
+		graph.write(imgui, swapchain, RGAccess::colorAttachmentReadWrite());
+
+		graph.compile();
+		graph.printSchedule();
+		success = graph.verify("Sample frame") && success;
+	}
+
+	// the renderer's frame, with and without the optional passes
+	for (uint32_t features = 0; features < 4; features++)
+	{
+		bool shadows = (features & 1) != 0;
+		bool lightCulling = (features & 2) != 0;
+		CRenderGraph graph;
+		declareForestFrame(graph, shadows, lightCulling);
+		graph.compile();
+		if (shadows && lightCulling)
+		{
+			graph.printSchedule();
+		}
+
+		char name[64];
+		snprintf(name, sizeof(name), "Forest frame (shadows %s, light culling %s)", shadows ? "on" : "off", lightCulling ? "on" : "off");
+		success = graph.verify(name) && success;
+	}
+
+	// random graphs
+	uint64_t state = 0x2545F4914F6CDD1Dull;
+	const RGAccess imageWrites[] = { RGAccess::colorAttachmentWrite(), RGAccess::depthAttachmentWrite(), RGAccess::storageImageWrite(), RGAccess::transferDst() };
+	const RGAccess imageReads[] = { RGAccess::sampledFragment(), RGAccess::sampledCompute(), RGAccess::depthAttachmentRead(), RGAccess::transferSrc() };
+	const RGAccess bufferWrites[] = { RGAccess::storageBufferWrite(), makeAccess(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED) };
+	const RGAccess bufferReads[] = { RGAccess::storageBufferRead(), RGAccess::vertexBuffer(), RGAccess::indirectBuffer(),
+		makeAccess(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED) };
+
+	uint32_t failed = 0;
+	uint64_t totalBarriers = 0;
+	uint64_t totalPasses = 0;
+	uint64_t livePasses = 0;
+	for (uint32_t g = 0; g < randomGraphs; g++)
+	{
+		CRenderGraph graph;
+		uint32_t resourceCount = 2 + nextRandom(state) % 7;
+		std::vector<bool> written(resourceCount, false);
+		for (uint32_t r = 0; r < resourceCount; r++)
+		{
+			bool image = (nextRandom(state) % 3) != 0;
+			bool imported = (nextRandom(state) % 4) == 0;
+			std::string name = (image ? "image" : "buffer") + std::to_string(r);
+			if (imported)
+			{
+				const RGAccess& initial = image ? imageReads[nextRandom(state) % 4] : bufferReads[nextRandom(state) % 4];
+				const RGAccess& final = image ? imageReads[nextRandom(state) % 4] : bufferReads[nextRandom(state) % 4];
+				image ? graph.importImage(name, initial, final) : graph.importBuffer(name, initial, final);
+				written[r] = true;
+			}
+			else
+			{
+				VkDeviceSize size = (1 + nextRandom(state) % 16) * 65536;
+				image ? graph.createImage(name, size) : graph.createBuffer(name, size);
+			}
+		}
+
+		uint32_t passCount = 2 + nextRandom(state) % 11;
+		for (uint32_t p = 0; p < passCount; p++)
+		{
+			uint32_t pass = graph.addPass("pass" + std::to_string(p));
+			uint32_t useCount = 1 + nextRandom(state) % 4;
+			std::vector<bool> usedInPass(resourceCount, false);
+			for (uint32_t u = 0; u < useCount; u++)
+			{
+				RGHandle r = nextRandom(state) % resourceCount;
+				if (usedInPass[r])
+				{
+					continue;
+				}
+				usedInPass[r] = true;
+
+				bool image = graph.m_Resources[r].image;
+				bool doWrite = (written[r] == false) || (nextRandom(state) % 2 == 0);
+				if (doWrite)
+				{
+					graph.write(pass, r, image ? imageWrites[nextRandom(state) % 4] : bufferWrites[nextRandom(state) % 2]);
+					written[r] = true;
+				}
+				else
+				{
+					graph.read(pass, r, image ? imageReads[nextRandom(state) % 4] : bufferReads[nextRandom(state) % 4]);
+				}
+			}
+			if (nextRandom(state) % 4 == 0)
+			{
+				graph.setSideEffect(pass);
+			}
+		}
+
+		graph.compile();
+		std::vector<std::string> errors = graph.validate();
+		totalBarriers += graph.getBarrierCount();
+		totalPasses += passCount;
+		livePasses += graph.getLivePassCount();
+		if (errors.empty() == false)
+		{
+			if (failed < 3)
+			{
+				printf("Random graph %u failed: %s\n", g, errors[0].c_str());
+			}
+			failed++;
+		}
+	}
+
+	if (randomGraphs > 0)
+	{
+		printf("Random graphs: %u / %u valid, %.1f%% passes culled, %.2f barriers per live pass\n",
+			randomGraphs - failed, randomGraphs,
+			100.0 * double(totalPasses - livePasses) / double(totalPasses),
+			livePasses ? double(totalBarriers) / double(livePasses) : 0.0);
+	}
+	success = success && (failed == 0);
+
+	printf("Render graph self test %s\n", success ? "passed" : "FAILED");
+	return success;
+}
@@ -0,0 +1,209 @@
+/*======================================================================
+VulkanPBR_AcornForest : RenderGraph.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Frame graph with automatic synchronization.
+Passes declare which resources they read and write (stage, access and
+image layout). compile() then:
+  - drops passes whose results are never used,
+  - computes the barriers each pass needs (RAW, WAR, WAW and layout
+    changes) and merges them into one vkCmdPipelineBarrier per pass,
+  - assigns transient resources with disjoint lifetimes to shared
+    memory slots (aliasing).
+validate() re-checks the compiled schedule with an independent hazard
+simulation, so the graph can be tested on the CPU without a device
+(selfTest(), --validate-rendergraph).
+
+The renderer's own frame is declared by declareForestFrame(), so the
+self test validates the schedule the GPU actually runs. That frame is
+split over several command buffers submitted in pass order; each one
+records its passes' barriers with recordBarriers().
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using RGHandle = uint32_t;
+
+const uint32_t RG_NONE = UINT32_MAX;    // no such pass / resource
+
+// how a pass touches a resource
+struct RGAccess
+{
+	VkPipelineStageFlags    stages = 0;
+	VkAccessFlags           access = 0;
+	VkImageLayout           layout = VK_IMAGE_LAYOUT_UNDEFINED;    // ignored for buffers
+
+	bool isWrite() const;
+
+	static RGAccess colorAttachmentWrite();
+	static RGAccess colorAttachmentReadWrite();    // loadOp LOAD or blending
+	static RGAccess depthAttachmentWrite();
+	static RGAccess depthAttachmentRead();
+	static RGAccess sampledFragment();
+	static RGAccess sampledCompute();
+	static RGAccess storageImageWrite();
+	static RGAccess storageBufferWrite();
+	static RGAccess storageBufferRead();
+	static RGAccess storageBufferReadFragment();
+	static RGAccess transferSrc();
+	static RGAccess transferDst();
+	static RGAccess vertexBuffer();
+	static RGAccess indirectBuffer();
+	static RGAccess present();
+
+	// typical use of an image in the given layout (used for one-off layout transitions)
+	static RGAccess fromLayout(VkImageLayout layout);
+
+	// imported resources rewritten every frame: the initial state waits for the previous frame's lastUse and drops
+	// the contents; the final state needs no barrier, as the next frame's initial state does the waiting
+	static RGAccess discarded(const RGAccess& lastUse);
+	static RGAccess untouched(VkImageLayout layout);
+};
+
+struct RGBarrier
+{
+	RGHandle                resource;
+	VkPipelineStageFlags    srcStages;
+	VkAccessFlags           srcAccess;
+	VkPipelineStageFlags    dstStages;
+	VkAccessFlags           dstAccess;
+	VkImageLayout           oldLayout;
+	VkImageLayout           newLayout;
+};
+
+// transient resources sharing one memory allocation
+struct RGMemorySlot
+{
+	VkDeviceSize            size = 0;
+	std::vector<RGHandle>   resources;    // sorted by first use
+};
+
+class CRenderGraph
+{
+private:
+
+	struct Resource
+	{
+		std::string             name;
+		bool                    image = true;
+		bool                    imported = false;       // lives outside the frame: content kept, not aliased
+		VkDeviceSize            size = 0;               // transient resources only
+		RGAccess                initial;                // imported: state before the first pass
+		RGAccess                final;                  // imported: state after the last pass
+		VkImage                 vkImage = VK_NULL_HANDLE;
+		VkImageSubresourceRange range{};
+		VkBuffer                vkBuffer = VK_NULL_HANDLE;
+	};
+
+	struct Use
+	{
+		RGHandle                resource;
+		RGAccess                access;
+		bool                    read = false;
+		bool                    write = false;
+	};
+
+	struct Pass
+	{
+		std::string                             name;
+		std::vector<Use>                        uses;
+		bool                                    sideEffect = false;    // never culled (present, readback...)
+		std::function<void(VkCommandBuffer)>    record;
+	};
+
+	std::vector<Resource>               m_Resources;
+	std::vector<Pass>                   m_Passes;
+
+	// compile() results
+	bool                                m_Compiled = false;
+	std::vector<uint32_t>               m_Order;            // live passes in submission order
+	std::vector<std::vector<RGBarrier>> m_PassBarriers;     // recorded before m_Order[i]
+	std::vector<RGBarrier>              m_FinalBarriers;    // recorded after the last pass
+	std::vector<RGMemorySlot>           m_MemorySlots;
+	std::vector<int>                    m_ResourceSlot;     // -1: not aliased
+
+	RGHandle addResource(const Resource& resource);
+	void addUse(uint32_t pass, RGHandle resource, const RGAccess& access, bool read, bool write);
+
+	void cullPasses();
+	void assignMemorySlots();
+	void buildBarriers();
+
+	// resource or memory slot: the unit hazards are tracked on
+	uint32_t memoryKey(RGHandle resource) const;
+
+	void recordBatch(VkCommandBuffer commandBuffer, const std::vector<RGBarrier>& barriers) const;
+
+	// prints the validation errors and checks that removing any single barrier is reported
+	bool verify(const char* name) const;
+
+public:
+
+	// transient resources: undefined at the start of the frame, may share memory
+	RGHandle createImage(const std::string& name, VkDeviceSize size);
+	RGHandle createBuffer(const std::string& name, VkDeviceSize size);
+
+	// external resources (swapchain, textures, persistent buffers)
+	RGHandle importImage(const std::string& name, const RGAccess& initial, const RGAccess& final);
+	RGHandle importBuffer(const std::string& name, const RGAccess& initial, const RGAccess& final);
+
+	uint32_t addPass(const std::string& name, std::function<void(VkCommandBuffer)> record = nullptr);
+	void read(uint32_t pass, RGHandle resource, const RGAccess& access);
+	void write(uint32_t pass, RGHandle resource, const RGAccess& access);
+	void setSideEffect(uint32_t pass);
+
+	void compile();
+	void reset();
+
+	// Returns a description of every hazard left by the compiled schedule (empty = valid).
+	std::vector<std::string> validate() const;
+
+	// GPU execution: every live resource needs its Vulkan object bound first
+	void bindImage(RGHandle resource, VkImage image, const VkImageSubresourceRange& range);
+	void bindBuffer(RGHandle resource, VkBuffer buffer);
+	void execute(VkCommandBuffer commandBuffer) const;
+
+	// frames split over several command buffers (submitted in pass order) record the passes themselves:
+	// the barriers in front of pass (none if it was culled), and after the last pass the final ones
+	void recordBarriers(VkCommandBuffer commandBuffer, uint32_t pass) const;
+	void recordFinalBarriers(VkCommandBuffer commandBuffer) const;
+
+	void printSchedule() const;
+
+	uint32_t getLivePassCount() const { return static_cast<uint32_t>(m_Order.size()); }
+	uint32_t getBarrierCount() const;
+	uint32_t getBatchCount() const;    // vkCmdPipelineBarrier calls
+	const std::vector<RGMemorySlot>& getMemorySlots() const { return m_MemorySlots; }
+	VkDeviceSize getTransientSize(bool aliased) const;
+
+	// CPU-only checks: a sample frame, the renderer's frame plus randomGraphs random graphs, all compiled and validated
+	static bool selfTest(uint32_t randomGraphs);
+};
+
+// The renderer's frame (CVulkanFramework), submitted as three command buffers: shadow (shadowPass), scene
+// (lightCullPass, scenePass) and ImGui (imguiPass and the final barriers). Passes and resources of disabled
+// features are RG_NONE. The MSAA color and depth attachments are reused by the next frame in flight, so they
+// are imported as discarded() rather than created as transients; both belong to the scene pass, so there is
+// nothing to alias between them.
+struct RGForestFrame
+{
+	RGHandle    swapchain = RG_NONE;
+	RGHandle    color = RG_NONE;
+	RGHandle    depth = RG_NONE;
+	RGHandle    shadowMap = RG_NONE;
+	RGHandle    clusters = RG_NONE;
+
+	uint32_t    shadowPass = RG_NONE;
+	uint32_t    lightCullPass = RG_NONE;
+	uint32_t    scenePass = RG_NONE;
+	uint32_t    imguiPass = RG_NONE;
+};
+
+// declares the frame into an empty graph; the caller binds the Vulkan objects, compiles and records the pass bodies
+RGForestFrame declareForestFrame(CRenderGraph& graph, bool shadows, bool lightCulling);
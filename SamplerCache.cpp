@@ -0,0 +1,231 @@
+/*======================================================================
+VulkanPBR_AcornForest : SamplerCache.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "SamplerCache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	// glTF sampler values (OpenGL enums, same as TINYGLTF_TEXTURE_FILTER_* / TINYGLTF_TEXTURE_WRAP_*)
+	const int GLTF_FILTER_NEAREST = 9728;
+	const int GLTF_FILTER_LINEAR = 9729;
+	const int GLTF_FILTER_NEAREST_MIPMAP_NEAREST = 9984;
+	const int GLTF_FILTER_LINEAR_MIPMAP_NEAREST = 9985;
+	const int GLTF_FILTER_NEAREST_MIPMAP_LINEAR = 9986;
+	const int GLTF_FILTER_LINEAR_MIPMAP_LINEAR = 9987;
+	const int GLTF_WRAP_REPEAT = 10497;
+	const int GLTF_WRAP_CLAMP_TO_EDGE = 33071;
+	const int GLTF_WRAP_MIRRORED_REPEAT = 33648;
+
+	VkSamplerAddressMode toAddressMode(int wrap, VkSamplerAddressMode fallback)
+	{
+		switch (wrap)
+		{
+		case GLTF_WRAP_REPEAT:          return VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		case GLTF_WRAP_CLAMP_TO_EDGE:   return VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		case GLTF_WRAP_MIRRORED_REPEAT: return VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
+		default:                        return fallback;
+		}
+	}
+
+	void hashCombine(size_t& seed, uint32_t value)
+	{
+		seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+
+	uint32_t floatBits(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+}
+
+bool CSamplerCache::Key::operator==(const Key& other) const
+{
+	return flags == other.flags &&
+		magFilter == other.magFilter &&
+		minFilter == other.minFilter &&
+		mipmapMode == other.mipmapMode &&
+		addressModeU == other.addressModeU &&
+		addressModeV == other.addressModeV &&
+		addressModeW == other.addressModeW &&
+		mipLodBias == other.mipLodBias &&
+		anisotropyEnable == other.anisotropyEnable &&
+		maxAnisotropy == other.maxAnisotropy &&
+		compareEnable == other.compareEnable &&
+		compareOp == other.compareOp &&
+		minLod == other.minLod &&
+		maxLod == other.maxLod &&
+		borderColor == other.borderColor &&
+		unnormalizedCoordinates == other.unnormalizedCoordinates;
+}
+
+size_t CSamplerCache::KeyHash::operator()(const Key& key) const
+{
+	size_t seed = 0;
+	hashCombine(seed, key.flags);
+	hashCombine(seed, key.magFilter);
+	hashCombine(seed, key.minFilter);
+	hashCombine(seed, key.mipmapMode);
+	hashCombine(seed, key.addressModeU);
+	hashCombine(seed, key.addressModeV);
+	hashCombine(seed, key.addressModeW);
+	hashCombine(seed, floatBits(key.mipLodBias));
+	hashCombine(seed, key.anisotropyEnable);
+	hashCombine(seed, floatBits(key.maxAnisotropy));
+	hashCombine(seed, key.compareEnable);
+	hashCombine(seed, key.compareOp);
+	hashCombine(seed, floatBits(key.minLod));
+	hashCombine(seed, floatBits(key.maxLod));
+	hashCombine(seed, key.borderColor);
+	hashCombine(seed, key.unnormalizedCoordinates);
+	return seed;
+}
+
+void CSamplerCache::create(VkDevice device, const VkPhysicalDeviceLimits& limits, bool anisotropyEnabled)
+{
+	m_Device = device;
+	m_Limits = limits;
+	m_AnisotropyEnabled = anisotropyEnabled;
+}
+
+void CSamplerCache::destroy()
+{
+	for (auto& entry : m_Samplers)
+	{
+		vkDestroySampler(m_Device, entry.second, nullptr);
+	}
+	m_Samplers.clear();
+	m_RequestCount = 0;
+}
+
+CSamplerCache::Key CSamplerCache::makeKey(const VkSamplerCreateInfo& createInfo) const
+{
+	Key key{};
+	key.flags = createInfo.flags;
+	key.magFilter = createInfo.magFilter;
+	key.minFilter = createInfo.minFilter;
+	key.mipmapMode = createInfo.mipmapMode;
+	key.addressModeU = createInfo.addressModeU;
+	key.addressModeV = createInfo.addressModeV;
+	key.addressModeW = createInfo.addressModeW;
+	key.mipLodBias = std::clamp(createInfo.mipLodBias, -m_Limits.maxSamplerLodBias, m_Limits.maxSamplerLodBias);
+	key.compareEnable = createInfo.compareEnable;
+	key.compareOp = createInfo.compareEnable ? createInfo.compareOp : VK_COMPARE_OP_NEVER;
+	key.minLod = createInfo.minLod;
+	key.maxLod = std::max(createInfo.minLod, createInfo.maxLod);
+	key.unnormalizedCoordinates = createInfo.unnormalizedCoordinates;
+
+	key.anisotropyEnable = (createInfo.anisotropyEnable && m_AnisotropyEnabled) ? VK_TRUE : VK_FALSE;
+	key.maxAnisotropy = key.anisotropyEnable ? std::clamp(createInfo.maxAnisotropy, 1.0f, m_Limits.maxSamplerAnisotropy) : 1.0f;
+
+	// the border color is only read with CLAMP_TO_BORDER
+	bool usesBorder = createInfo.addressModeU == VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER ||
+		createInfo.addressModeV == VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER ||
+		createInfo.addressModeW == VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	key.borderColor = usesBorder ? createInfo.borderColor : VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+	return key;
+}
+
+VkSampler CSamplerCache::getSampler(const VkSamplerCreateInfo& createInfo)
+{
+	if (createInfo.pNext != nullptr)
+	{
+		throw std::runtime_error("Failed to get sampler: pNext chains cannot be cached!");
+	}
+
+	m_RequestCount++;
+	Key key = makeKey(createInfo);
+	auto found = m_Samplers.find(key);
+	if (found != m_Samplers.end())
+	{
+		return found->second;
+	}
+
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.flags = key.flags;
+	samplerInfo.magFilter = key.magFilter;
+	samplerInfo.minFilter = key.minFilter;
+	samplerInfo.mipmapMode = key.mipmapMode;
+	samplerInfo.addressModeU = key.addressModeU;
+	samplerInfo.addressModeV = key.addressModeV;
+	samplerInfo.addressModeW = key.addressModeW;
+	samplerInfo.mipLodBias = key.mipLodBias;
+	samplerInfo.anisotropyEnable = key.anisotropyEnable;
+	samplerInfo.maxAnisotropy = key.maxAnisotropy;
+	samplerInfo.compareEnable = key.compareEnable;
+	samplerInfo.compareOp = key.compareOp;
+	samplerInfo.minLod = key.minLod;
+	samplerInfo.maxLod = key.maxLod;
+	samplerInfo.borderColor = key.borderColor;
+	samplerInfo.unnormalizedCoordinates = key.unnormalizedCoordinates;
+
+	if (m_Samplers.size() >= m_Limits.maxSamplerAllocationCount)
+	{
+		throw std::runtime_error("Failed to create sampler: maxSamplerAllocationCount reached!");
+	}
+
+	VkSampler sampler;
+	if (vkCreateSampler(m_Device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create texture sampler!");
+	}
+	m_Samplers.emplace(key, sampler);
+	return sampler;
+}
+
+VkSamplerCreateInfo CSamplerCache::fromGltf(const VkSamplerCreateInfo& base, int minFilter, int magFilter, int wrapS, int wrapT)
+{
+	VkSamplerCreateInfo samplerInfo = base;
+
+	if (magFilter == GLTF_FILTER_NEAREST)
+	{
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+	}
+	else if (magFilter == GLTF_FILTER_LINEAR)
+	{
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+	}
+
+	switch (minFilter)
+	{
+	case GLTF_FILTER_NEAREST:
+	case GLTF_FILTER_NEAREST_MIPMAP_NEAREST:
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		break;
+	case GLTF_FILTER_LINEAR:
+	case GLTF_FILTER_LINEAR_MIPMAP_NEAREST:
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		break;
+	case GLTF_FILTER_NEAREST_MIPMAP_LINEAR:
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		break;
+	case GLTF_FILTER_LINEAR_MIPMAP_LINEAR:
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		break;
+	default:
+		break;
+	}
+
+	// GL_NEAREST / GL_LINEAR minification samples the base level only
+	if (minFilter == GLTF_FILTER_NEAREST || minFilter == GLTF_FILTER_LINEAR)
+	{
+		samplerInfo.maxLod = samplerInfo.minLod;
+	}
+
+	samplerInfo.addressModeU = toAddressMode(wrapS, base.addressModeU);
+	samplerInfo.addressModeV = toAddressMode(wrapT, base.addressModeV);
+	return samplerInfo;
+}
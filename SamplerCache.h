@@ -0,0 +1,75 @@
+/*======================================================================
+VulkanPBR_AcornForest : SamplerCache.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Deduplicating sampler cache.
+getSampler() hashes the contents of a VkSamplerCreateInfo and returns the
+existing VkSampler when an identical one was requested before, so
+thousands of materials with the usual handful of wrap/filter
+combinations share a few sampler objects. Requests are clamped to the
+device limits given to create(), which are queried once at startup.
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <unordered_map>
+
+class CSamplerCache
+{
+private:
+
+	// VkSamplerCreateInfo without sType/pNext, normalized so that fields the
+	// driver ignores do not produce separate samplers
+	struct Key
+	{
+		VkSamplerCreateFlags    flags;
+		VkFilter                magFilter;
+		VkFilter                minFilter;
+		VkSamplerMipmapMode     mipmapMode;
+		VkSamplerAddressMode    addressModeU;
+		VkSamplerAddressMode    addressModeV;
+		VkSamplerAddressMode    addressModeW;
+		float                   mipLodBias;
+		VkBool32                anisotropyEnable;
+		float                   maxAnisotropy;
+		VkBool32                compareEnable;
+		VkCompareOp             compareOp;
+		float                   minLod;
+		float                   maxLod;
+		VkBorderColor           borderColor;
+		VkBool32                unnormalizedCoordinates;
+
+		bool operator==(const Key& other) const;
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+
+	VkDevice                                    m_Device = VK_NULL_HANDLE;
+	VkPhysicalDeviceLimits                      m_Limits{};
+	bool                                        m_AnisotropyEnabled = false;    // samplerAnisotropy device feature
+	std::unordered_map<Key, VkSampler, KeyHash> m_Samplers;
+	uint32_t                                    m_RequestCount = 0;
+
+	Key makeKey(const VkSamplerCreateInfo& createInfo) const;
+
+public:
+
+	void create(VkDevice device, const VkPhysicalDeviceLimits& limits, bool anisotropyEnabled);
+	void destroy();
+
+	// Returns a sampler matching createInfo. pNext chains are not supported.
+	// The cache owns the sampler; do not destroy it.
+	VkSampler getSampler(const VkSamplerCreateInfo& createInfo);
+
+	// base with the filter/wrap modes of a glTF sampler applied (-1 = not specified in the file)
+	static VkSamplerCreateInfo fromGltf(const VkSamplerCreateInfo& base, int minFilter, int magFilter, int wrapS, int wrapT);
+
+	uint32_t getSamplerCount() const { return static_cast<uint32_t>(m_Samplers.size()); }
+	uint32_t getRequestCount() const { return m_RequestCount; }
+};
@@ -0,0 +1,378 @@
+/*======================================================================
+VulkanPBR_AcornForest : SceneGraph.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#define GLM_FORCE_RADIANS
+#include "SceneGraph.h"
+#include "BenchUtil.h"
+#include "JobSystem.h"
+#include "SimdMath.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	const uint32_t UPDATE_BATCH_SIZE = 4096;    // nodes per job; smaller levels update on the calling thread
+
+	const uint32_t MULTIPLY_BATCH_SIZE = 64;     // parent matrices gathered per CSimdMath::multiplyMat4() call
+
+	glm::mat4 randomLocal(uint64_t& state)
+	{
+		glm::vec3 translation(randomUnit(state) - 0.5f, randomUnit(state) - 0.5f, randomUnit(state));
+		glm::quat rotation = glm::angleAxis(randomUnit(state) * 6.2831853f, glm::normalize(glm::vec3(randomUnit(state) - 0.5f, randomUnit(state) - 0.5f, 1.0f)));
+		glm::vec3 scale(0.9f + 0.2f * randomUnit(state));
+		return CSceneGraph::composeTRS(translation, rotation, scale);
+	}
+}
+
+uint32_t CSceneGraph::addNode(uint32_t parent, const glm::mat4& local)
+{
+	uint32_t node = static_cast<uint32_t>(m_IndexOfNode.size());
+	uint32_t index = static_cast<uint32_t>(m_Local.size());
+	uint32_t parentIndex = (parent == SCENE_NO_PARENT) ? SCENE_NO_PARENT : m_IndexOfNode[parent];
+	uint32_t depth = (parentIndex == SCENE_NO_PARENT) ? 0 : m_Depth[parentIndex] + 1;
+
+	// appending keeps breadth-first order only behind the last node's level and parent
+	if (m_Sorted && index > 0)
+	{
+		m_Sorted = depth > m_Depth.back() || (depth == m_Depth.back() && (depth == 0 || parentIndex >= m_Parent.back()));
+	}
+	if (m_Sorted)
+	{
+		if (m_LevelStart.empty())
+		{
+			m_LevelStart = { 0, 1 };
+		}
+		else if (depth == getDepthCount())
+		{
+			m_LevelStart.push_back(index + 1);    // the old end is the start of the new level
+		}
+		else
+		{
+			m_LevelStart.back() = index + 1;
+		}
+	}
+
+	m_Parent.push_back(parentIndex);
+	m_Depth.push_back(depth);
+	m_Local.push_back(local);
+	m_World.push_back(parentIndex == SCENE_NO_PARENT ? local : m_World[parentIndex] * local);
+	m_Dirty.push_back(0);
+	m_UpdatePass.push_back(0);
+	m_NodeOfIndex.push_back(node);
+	m_IndexOfNode.push_back(index);
+	m_ChildrenValid = false;
+	return node;
+}
+
+void CSceneGraph::setLocal(uint32_t node, const glm::mat4& local)
+{
+	uint32_t index = m_IndexOfNode[node];
+	m_Local[index] = local;
+	if (m_Dirty[index] == 0)
+	{
+		m_Dirty[index] = 1;
+		m_DirtyNodes.push_back(node);
+	}
+}
+
+uint32_t CSceneGraph::getParent(uint32_t node) const
+{
+	uint32_t parentIndex = m_Parent[m_IndexOfNode[node]];
+	return (parentIndex == SCENE_NO_PARENT) ? SCENE_NO_PARENT : m_NodeOfIndex[parentIndex];
+}
+
+void CSceneGraph::sortBreadthFirst()
+{
+	const uint32_t count = getNodeCount();
+
+	// children of every index, in index order (CSR)
+	std::vector<uint32_t> childStart(count + 1, 0);
+	std::vector<uint32_t> order;
+	order.reserve(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (m_Parent[i] == SCENE_NO_PARENT)
+		{
+			order.push_back(i);
+		}
+		else
+		{
+			childStart[m_Parent[i] + 1]++;
+		}
+	}
+	for (uint32_t i = 0; i < count; i++)
+	{
+		childStart[i + 1] += childStart[i];
+	}
+	std::vector<uint32_t> children(count);
+	std::vector<uint32_t> cursor(childStart.begin(), childStart.end() - 1);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (m_Parent[i] != SCENE_NO_PARENT)
+		{
+			children[cursor[m_Parent[i]]++] = i;
+		}
+	}
+
+	// breadth-first: roots, then the children of each node in the order the nodes were visited
+	for (size_t visit = 0; visit < order.size(); visit++)
+	{
+		uint32_t index = order[visit];
+		order.insert(order.end(), children.begin() + childStart[index], children.begin() + childStart[index + 1]);
+	}
+
+	std::vector<uint32_t> newIndex(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		newIndex[order[i]] = i;
+	}
+
+	std::vector<uint32_t> parent(count), depth(count), nodeOfIndex(count);
+	std::vector<glm::mat4> local(count), world(count);
+	std::vector<uint8_t> dirty(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t source = order[i];
+		parent[i] = (m_Parent[source] == SCENE_NO_PARENT) ? SCENE_NO_PARENT : newIndex[m_Parent[source]];
+		depth[i] = m_Depth[source];
+		local[i] = m_Local[source];
+		world[i] = m_World[source];
+		dirty[i] = m_Dirty[source];
+		nodeOfIndex[i] = m_NodeOfIndex[source];
+		m_IndexOfNode[nodeOfIndex[i]] = i;
+	}
+	m_Parent.swap(parent);
+	m_Depth.swap(depth);
+	m_Local.swap(local);
+	m_World.swap(world);
+	m_Dirty.swap(dirty);
+	m_NodeOfIndex.swap(nodeOfIndex);
+
+	m_LevelStart.clear();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (i == 0 || m_Depth[i] != m_Depth[i - 1])
+		{
+			m_LevelStart.push_back(i);
+		}
+	}
+	m_LevelStart.push_back(count);
+	m_Sorted = true;
+	m_ChildrenValid = false;
+}
+
+void CSceneGraph::buildChildRanges()
+{
+	// breadth-first order sorts every level by parent, so the children of consecutive indices are consecutive
+	const uint32_t count = getNodeCount();
+	m_FirstChild.assign(count + 1, 0);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (m_Parent[i] != SCENE_NO_PARENT)
+		{
+			m_FirstChild[m_Parent[i] + 1]++;
+		}
+	}
+
+	// roots have no parent: the children of index 0 start right after them
+	uint32_t rootCount = m_LevelStart.size() > 1 ? m_LevelStart[1] : count;
+	m_FirstChild[0] = rootCount;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		m_FirstChild[i + 1] += m_FirstChild[i];
+	}
+	m_ChildrenValid = true;
+}
+
+void CSceneGraph::updateRange(uint32_t begin, uint32_t end)
+{
+	// the kernel multiplies arrays pairwise, so the parents are gathered next to each other;
+	// a root's parent is the identity. Parents are on an earlier level and never alias m_World[begin, end).
+	const SimdLevel level = CSimdMath::getBestSimdLevel();
+	glm::mat4 parents[MULTIPLY_BATCH_SIZE];
+	for (uint32_t first = begin; first < end; first += MULTIPLY_BATCH_SIZE)
+	{
+		uint32_t last = std::min(end, first + MULTIPLY_BATCH_SIZE);
+		for (uint32_t i = first; i < last; i++)
+		{
+			uint32_t parent = m_Parent[i];
+			parents[i - first] = parent == SCENE_NO_PARENT ? glm::mat4(1.0f) : m_World[parent];
+			m_Dirty[i] = 0;
+			m_UpdatePass[i] = m_UpdatePassCount;
+		}
+		CSimdMath::multiplyMat4(level, parents, &m_Local[first], &m_World[first], last - first);
+	}
+}
+
+void CSceneGraph::updateLevelRange(uint32_t begin, uint32_t end, CJobSystem* jobSystem)
+{
+	uint32_t count = end - begin;
+	if (jobSystem && count >= 2 * UPDATE_BATCH_SIZE)
+	{
+		jobSystem->parallelFor(count, UPDATE_BATCH_SIZE, [&](uint32_t first, uint32_t last) { updateRange(begin + first, begin + last); });
+	}
+	else
+	{
+		updateRange(begin, end);
+	}
+}
+
+void CSceneGraph::update(CJobSystem* jobSystem)
+{
+	m_LastUpdatedCount = 0;
+	if (m_DirtyNodes.empty())
+	{
+		return;
+	}
+	if (m_Sorted == false)
+	{
+		sortBreadthFirst();
+	}
+	if (m_ChildrenValid == false)
+	{
+		buildChildRanges();
+	}
+	m_UpdatePassCount++;
+
+	// ascending index = ancestors first: a dirty node inside a subtree that was already recomputed is skipped
+	std::vector<uint32_t> roots(m_DirtyNodes.size());
+	for (size_t i = 0; i < m_DirtyNodes.size(); i++)
+	{
+		roots[i] = m_IndexOfNode[m_DirtyNodes[i]];
+	}
+	std::sort(roots.begin(), roots.end());
+
+	uint32_t total = 0;
+	for (uint32_t root : roots)
+	{
+		if (m_UpdatePass[root] == m_UpdatePassCount)
+		{
+			continue;
+		}
+
+		// one contiguous range per level: the range, then everything between its first child and the next range's first child
+		uint32_t begin = root;
+		uint32_t end = root + 1;
+		while (begin < end)
+		{
+			updateLevelRange(begin, end, jobSystem);
+			total += end - begin;
+			begin = m_FirstChild[begin];
+			end = m_FirstChild[end];
+		}
+	}
+	m_DirtyNodes.clear();
+	m_LastUpdatedCount = total;
+}
+
+void CSceneGraph::updateAll(CJobSystem* jobSystem)
+{
+	if (m_Sorted == false)
+	{
+		sortBreadthFirst();
+	}
+	m_UpdatePassCount++;
+	for (uint32_t level = 0; level < getDepthCount(); level++)
+	{
+		updateLevelRange(m_LevelStart[level], m_LevelStart[level + 1], jobSystem);
+	}
+	m_LastUpdatedCount = getNodeCount();
+	m_DirtyNodes.clear();
+}
+
+glm::mat4 CSceneGraph::composeTRS(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale)
+{
+	glm::mat4 matrix = glm::mat4_cast(rotation);
+	matrix[0] *= scale.x;
+	matrix[1] *= scale.y;
+	matrix[2] *= scale.z;
+	matrix[3] = glm::vec4(translation, 1.0f);
+	return matrix;
+}
+
+void CSceneGraph::benchmark(uint32_t nodeCount, float dirtyFraction)
+{
+	const uint32_t frames = 20;
+	const uint32_t dirtyCount = std::max(1u, static_cast<uint32_t>(nodeCount * dirtyFraction));
+	uint64_t state = 0x2545F4914F6CDD1Dull;
+
+	// a forest of ~1000-node trees: every node hangs below a random earlier node of a random tree,
+	// so nodes arrive out of breadth-first order like glTF node lists
+	CSceneGraph graph;
+	uint32_t treeCount = std::max(1u, nodeCount / 1000);
+	std::vector<std::vector<uint32_t>> trees(treeCount);
+	for (uint32_t i = 0; i < nodeCount; i++)
+	{
+		if (i < treeCount)
+		{
+			trees[i].push_back(graph.addNode(SCENE_NO_PARENT, randomLocal(state)));
+			continue;
+		}
+		std::vector<uint32_t>& tree = trees[nextRandom(state) % treeCount];
+		uint32_t parent = tree[nextRandom(state) % tree.size()];
+		tree.push_back(graph.addNode(parent, randomLocal(state)));
+	}
+
+	CJobSystem jobSystem;
+	printf("Scene graph: %u nodes, %u dirty per frame (%.1f%%), %s multiplies, %u threads\n", nodeCount, dirtyCount, dirtyFraction * 100.0f,
+		toString(CSimdMath::getBestSimdLevel()), jobSystem.getWorkerCount() + 1);
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	graph.updateAll(nullptr);    // includes the breadth-first sort
+	printf("  sort + first update  %9.3f ms, %u levels\n", elapsedMs(start), graph.getDepthCount());
+
+	CJobSystem* jobSystems[] = { nullptr, &jobSystem };
+	for (CJobSystem* jobs : jobSystems)
+	{
+		double fullMs = 0.0;
+		double incrementalMs = 0.0;
+		uint64_t recomputed = 0;
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			start = std::chrono::high_resolution_clock::now();
+			graph.updateAll(jobs);
+			fullMs += elapsedMs(start) / frames;
+
+			for (uint32_t i = 0; i < dirtyCount; i++)
+			{
+				graph.setLocal(static_cast<uint32_t>(nextRandom(state) % nodeCount), randomLocal(state));
+			}
+			start = std::chrono::high_resolution_clock::now();
+			graph.update(jobs);
+			incrementalMs += elapsedMs(start) / frames;
+			recomputed += graph.getLastUpdatedCount();
+		}
+		printf("  %-8s  full %9.3f ms   dirty subtrees %9.3f ms (%llu nodes recomputed per frame)   %6.1fx\n", jobs ? "jobs" : "1 thread",
+			fullMs, incrementalMs, static_cast<unsigned long long>(recomputed / frames), fullMs / std::max(incrementalMs, 1e-6));
+	}
+
+	// the incremental result must match a full recompute
+	std::vector<glm::mat4> incremental(nodeCount);
+	for (uint32_t i = 0; i < dirtyCount; i++)
+	{
+		graph.setLocal(static_cast<uint32_t>(nextRandom(state) % nodeCount), randomLocal(state));
+	}
+	graph.update(&jobSystem);
+	for (uint32_t node = 0; node < nodeCount; node++)
+	{
+		incremental[node] = graph.getWorld(node);
+	}
+	graph.updateAll(nullptr);
+	float maxError = 0.0f;
+	for (uint32_t node = 0; node < nodeCount; node++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			glm::vec4 difference = glm::abs(incremental[node][column] - graph.getWorld(node)[column]);
+			maxError = std::max(maxError, std::max(std::max(difference.x, difference.y), std::max(difference.z, difference.w)));
+		}
+	}
+	printf("  incremental vs full: max difference %g (%s)\n", maxError, maxError == 0.0f ? "ok" : "MISMATCH");
+}
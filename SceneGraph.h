@@ -0,0 +1,88 @@
+/*======================================================================
+VulkanPBR_AcornForest : SceneGraph.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Transform hierarchy stored as structure of arrays.
+Nodes (glTF nodes, trees of the forest, the model) have a local matrix
+relative to their parent; update() turns them into world matrices.
+The arrays are kept in breadth-first order: sorted by depth, and within
+a depth by parent, so every parent comes before its children, a level
+is one contiguous range and its parents are read front to back.
+
+setLocal() flags the node and remembers it as a dirty root. update()
+only visits the subtrees below those roots: in breadth-first order the
+descendants of a node on each level are one contiguous range (the
+children of a range are the range between its first child and the
+first child after it), so a subtree is walked a level range at a time
+and untouched nodes are never read. Matrix multiplies go through
+CSimdMath::multiplyMat4() at the best level the CPU supports. A large
+level range is split into jobs; nodes of one level never depend on each
+other.
+
+Node ids returned by addNode() stay valid when the arrays are re-sorted.
+=======================================================================*/
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class CJobSystem;
+
+const uint32_t SCENE_NO_PARENT = UINT32_MAX;
+
+class CSceneGraph
+{
+private:
+
+	// per index, breadth-first order (index != node id)
+	std::vector<uint32_t>   m_Parent;          // index of the parent, SCENE_NO_PARENT for a root
+	std::vector<uint32_t>   m_Depth;
+	std::vector<glm::mat4>  m_Local;
+	std::vector<glm::mat4>  m_World;
+	std::vector<uint8_t>    m_Dirty;           // local changed since the last update()
+	std::vector<uint32_t>   m_UpdatePass;      // m_UpdatePassCount of the update() that last recomputed the world matrix
+	std::vector<uint32_t>   m_FirstChild;      // children of index i are [m_FirstChild[i], m_FirstChild[i + 1]); count + 1 entries
+	std::vector<uint32_t>   m_NodeOfIndex;
+
+	std::vector<uint32_t>   m_IndexOfNode;     // per node id
+	std::vector<uint32_t>   m_LevelStart;      // first index of every depth, then the node count
+	std::vector<uint32_t>   m_DirtyNodes;      // node ids flagged by setLocal() since the last update()
+	bool                    m_Sorted = true;
+	bool                    m_ChildrenValid = true;
+	uint32_t                m_UpdatePassCount = 0;
+	uint32_t                m_LastUpdatedCount = 0;
+
+	void sortBreadthFirst();
+	void buildChildRanges();
+	void updateRange(uint32_t begin, uint32_t end);
+	void updateLevelRange(uint32_t begin, uint32_t end, CJobSystem* jobSystem);
+
+public:
+
+	// parent: node id or SCENE_NO_PARENT; the world matrix is valid right away
+	uint32_t addNode(uint32_t parent, const glm::mat4& local);
+	void setLocal(uint32_t node, const glm::mat4& local);
+
+	const glm::mat4& getLocal(uint32_t node) const { return m_Local[m_IndexOfNode[node]]; }
+	const glm::mat4& getWorld(uint32_t node) const { return m_World[m_IndexOfNode[node]]; }    // as of the last update()
+	uint32_t getParent(uint32_t node) const;
+
+	// dirty subtrees only; jobSystem may be null (single-threaded)
+	void update(CJobSystem* jobSystem);
+	// every node, the reference for update()
+	void updateAll(CJobSystem* jobSystem);
+
+	uint32_t getNodeCount() const { return static_cast<uint32_t>(m_Local.size()); }
+	uint32_t getDepthCount() const { return m_LevelStart.empty() ? 0 : static_cast<uint32_t>(m_LevelStart.size() - 1); }
+	uint32_t getLastUpdatedCount() const { return m_LastUpdatedCount; }
+
+	// local matrix of a glTF node: translation * rotation * scale
+	static glm::mat4 composeTRS(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+
+	// CPU-only: full vs incremental update of nodeCount nodes with dirtyFraction of them changed per frame
+	static void benchmark(uint32_t nodeCount, float dirtyFraction);
+};
@@ -0,0 +1,815 @@
+/*======================================================================
+VulkanPBR_AcornForest : ShaderReflection.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "ShaderReflection.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <stdexcept>
+
+namespace
+{
+	const uint32_t SPIRV_MAGIC = 0x07230203;
+	const uint32_t UNDECORATED = UINT32_MAX;
+
+	// the parts of the SPIR-V grammar (spirv.h) that describe resources
+	enum SpirvOp : uint32_t
+	{
+		OpName = 5,
+		OpEntryPoint = 15,
+		OpTypeBool = 20,
+		OpTypeInt = 21,
+		OpTypeFloat = 22,
+		OpTypeVector = 23,
+		OpTypeMatrix = 24,
+		OpTypeImage = 25,
+		OpTypeSampler = 26,
+		OpTypeSampledImage = 27,
+		OpTypeArray = 28,
+		OpTypeRuntimeArray = 29,
+		OpTypeStruct = 30,
+		OpTypePointer = 32,
+		OpConstant = 43,
+		OpSpecConstantTrue = 48,
+		OpSpecConstantFalse = 49,
+		OpSpecConstant = 50,
+		OpVariable = 59,
+		OpDecorate = 71,
+		OpMemberDecorate = 72,
+		OpTypeAccelerationStructureKHR = 5341
+	};
+
+	enum SpirvDecoration : uint32_t
+	{
+		DecorationSpecId = 1,
+		DecorationBlock = 2,
+		DecorationBufferBlock = 3,
+		DecorationArrayStride = 6,
+		DecorationMatrixStride = 7,
+		DecorationBinding = 33,
+		DecorationDescriptorSet = 34,
+		DecorationOffset = 35
+	};
+
+	enum SpirvStorageClass : uint32_t
+	{
+		StorageClassUniformConstant = 0,
+		StorageClassUniform = 2,
+		StorageClassPushConstant = 9,
+		StorageClassStorageBuffer = 12
+	};
+
+	const uint32_t DIM_BUFFER = 5;
+	const uint32_t DIM_SUBPASS_DATA = 6;
+	const uint32_t IMAGE_STORAGE = 2;    // OpTypeImage "sampled" operand: 1 = sampled, 2 = storage
+
+	// one result id: its defining instruction and the decorations that target it
+	struct SpirvId
+	{
+		uint32_t                opcode = 0;
+		uint32_t                typeId = 0;          // result type of OpVariable / OpConstant
+		std::vector<uint32_t>   operands;            // words after the result id
+		std::string             name;
+		uint32_t                set = UNDECORATED;
+		uint32_t                binding = UNDECORATED;
+		uint32_t                arrayStride = 0;
+		uint32_t                specId = UNDECORATED;
+		bool                    bufferBlock = false;
+		std::vector<uint32_t>   memberOffsets;       // struct members
+		std::vector<uint32_t>   memberMatrixStrides;
+	};
+
+	VkShaderStageFlagBits toShaderStage(uint32_t executionModel)
+	{
+		switch (executionModel)
+		{
+		case 0:     return VK_SHADER_STAGE_VERTEX_BIT;
+		case 1:     return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+		case 2:     return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+		case 3:     return VK_SHADER_STAGE_GEOMETRY_BIT;
+		case 4:     return VK_SHADER_STAGE_FRAGMENT_BIT;
+		case 5:     return VK_SHADER_STAGE_COMPUTE_BIT;
+		default:    throw std::runtime_error("Failed to reflect shader: unsupported execution model!");
+		}
+	}
+
+	// smallest valid word count (opcode word included) of the instructions parsed below; 0 for the rest
+	uint32_t getMinWordCount(uint32_t opcode)
+	{
+		switch (opcode)
+		{
+		case OpName:                          return 3;    // target, name
+		case OpEntryPoint:                    return 4;    // execution model, function, name
+		case OpTypeBool:                      return 2;
+		case OpTypeInt:                       return 4;    // width, signedness
+		case OpTypeFloat:                     return 3;    // width
+		case OpTypeVector:                    return 4;    // component type, count
+		case OpTypeMatrix:                    return 4;    // column type, count
+		case OpTypeImage:                     return 9;    // sampled type, dim, depth, arrayed, ms, sampled, format
+		case OpTypeSampler:                   return 2;
+		case OpTypeSampledImage:              return 3;    // image type
+		case OpTypeArray:                     return 4;    // element type, length
+		case OpTypeRuntimeArray:              return 3;    // element type
+		case OpTypeStruct:                    return 2;
+		case OpTypePointer:                   return 4;    // storage class, type
+		case OpConstant:                      return 4;    // result type, result, value
+		case OpSpecConstantTrue:              return 3;
+		case OpSpecConstantFalse:             return 3;
+		case OpSpecConstant:                  return 4;
+		case OpVariable:                      return 4;    // result type, result, storage class
+		case OpDecorate:                      return 3;    // target, decoration
+		case OpMemberDecorate:                return 4;    // structure type, member, decoration
+		case OpTypeAccelerationStructureKHR:  return 2;
+		default:                              return 0;
+		}
+	}
+
+	std::string readString(const uint32_t* words, uint32_t wordCount)
+	{
+		const char* text = reinterpret_cast<const char*>(words);
+		return std::string(text, strnlen(text, wordCount * sizeof(uint32_t)));
+	}
+
+	void setMember(std::vector<uint32_t>& values, uint32_t member, uint32_t value)
+	{
+		if (values.size() <= member)
+		{
+			values.resize(member + 1, 0);
+		}
+		values[member] = value;
+	}
+
+	class SpirvModule
+	{
+	private:
+
+		std::vector<SpirvId>    m_Ids;
+
+		const SpirvId& get(uint32_t id) const
+		{
+			if (id >= m_Ids.size())
+			{
+				throw std::runtime_error("Failed to reflect shader: id out of bounds!");
+			}
+			return m_Ids[id];
+		}
+
+		SpirvId& get(uint32_t id)
+		{
+			return const_cast<SpirvId&>(static_cast<const SpirvModule*>(this)->get(id));
+		}
+
+	public:
+
+		VkShaderStageFlags      stages = 0;
+
+		explicit SpirvModule(const std::vector<char>& spirv)
+		{
+			if (spirv.size() % sizeof(uint32_t) != 0 || spirv.size() < 5 * sizeof(uint32_t))
+			{
+				throw std::runtime_error("Failed to reflect shader: not a SPIR-V module!");
+			}
+			std::vector<uint32_t> words(spirv.size() / sizeof(uint32_t));
+			std::memcpy(words.data(), spirv.data(), spirv.size());
+			if (words[0] != SPIRV_MAGIC)
+			{
+				throw std::runtime_error("Failed to reflect shader: bad SPIR-V magic number!");
+			}
+			m_Ids.resize(words[3]);    // id bound
+
+			for (size_t i = 5; i < words.size();)
+			{
+				uint32_t wordCount = words[i] >> 16;
+				uint32_t opcode = words[i] & 0xFFFF;
+				if (wordCount == 0 || i + wordCount > words.size())
+				{
+					throw std::runtime_error("Failed to reflect shader: truncated instruction!");
+				}
+				parseInstruction(opcode, &words[i], wordCount);
+				i += wordCount;
+			}
+		}
+
+		void parseInstruction(uint32_t opcode, const uint32_t* inst, uint32_t wordCount)
+		{
+			if (wordCount < getMinWordCount(opcode))
+			{
+				throw std::runtime_error("Failed to reflect shader: instruction " + std::to_string(opcode) + " has too few operands!");
+			}
+
+			switch (opcode)
+			{
+			case OpName:
+				get(inst[1]).name = readString(inst + 2, wordCount - 2);
+				break;
+			case OpEntryPoint:
+				stages |= toShaderStage(inst[1]);
+				break;
+			case OpDecorate:
+			{
+				SpirvId& target = get(inst[1]);
+				uint32_t value = (wordCount > 3) ? inst[3] : 0;
+				switch (inst[2])
+				{
+				case DecorationSpecId:         target.specId = value; break;
+				case DecorationBufferBlock:    target.bufferBlock = true; break;
+				case DecorationArrayStride:    target.arrayStride = value; break;
+				case DecorationBinding:        target.binding = value; break;
+				case DecorationDescriptorSet:  target.set = value; break;
+				default: break;
+				}
+				break;
+			}
+			case OpMemberDecorate:
+			{
+				SpirvId& target = get(inst[1]);
+				uint32_t value = (wordCount > 4) ? inst[4] : 0;
+				if (inst[3] == DecorationOffset)
+				{
+					setMember(target.memberOffsets, inst[2], value);
+				}
+				else if (inst[3] == DecorationMatrixStride)
+				{
+					setMember(target.memberMatrixStrides, inst[2], value);
+				}
+				break;
+			}
+			case OpTypeBool: case OpTypeInt: case OpTypeFloat: case OpTypeVector: case OpTypeMatrix:
+			case OpTypeImage: case OpTypeSampler: case OpTypeSampledImage: case OpTypeArray:
+			case OpTypeRuntimeArray: case OpTypeStruct: case OpTypePointer: case OpTypeAccelerationStructureKHR:
+			{
+				SpirvId& type = get(inst[1]);
+				type.opcode = opcode;
+				type.operands.assign(inst + 2, inst + wordCount);
+				break;
+			}
+			case OpConstant: case OpSpecConstantTrue: case OpSpecConstantFalse: case OpSpecConstant: case OpVariable:
+			{
+				SpirvId& value = get(inst[2]);
+				value.opcode = opcode;
+				value.typeId = inst[1];
+				value.operands.assign(inst + 3, inst + wordCount);    // constant value / storage class
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		// array length constants (spec constants use their default value)
+		uint32_t getConstant(uint32_t id) const
+		{
+			const SpirvId& constant = get(id);
+			if ((constant.opcode != OpConstant && constant.opcode != OpSpecConstant) || constant.operands.empty())
+			{
+				throw std::runtime_error("Failed to reflect shader: array length is not a constant!");
+			}
+			return constant.operands[0];
+		}
+
+		// std140/std430 size as laid out by the Offset/ArrayStride/MatrixStride decorations
+		uint32_t getTypeSize(uint32_t typeId, uint32_t matrixStride) const
+		{
+			const SpirvId& type = get(typeId);
+			switch (type.opcode)
+			{
+			case OpTypeBool:
+				return 4;
+			case OpTypeInt:
+			case OpTypeFloat:
+				return type.operands[0] / 8;
+			case OpTypeVector:
+				return type.operands[1] * getTypeSize(type.operands[0], 0);
+			case OpTypeMatrix:
+				return type.operands[1] * (matrixStride != 0 ? matrixStride : getTypeSize(type.operands[0], 0));
+			case OpTypeArray:
+			{
+				uint32_t length = getConstant(type.operands[1]);
+				return length * (type.arrayStride != 0 ? type.arrayStride : getTypeSize(type.operands[0], matrixStride));
+			}
+			case OpTypeStruct:
+			{
+				uint32_t size = 0;
+				for (size_t member = 0; member < type.operands.size(); member++)
+				{
+					uint32_t offset = member < type.memberOffsets.size() ? type.memberOffsets[member] : size;
+					uint32_t stride = member < type.memberMatrixStrides.size() ? type.memberMatrixStrides[member] : 0;
+					size = std::max(size, offset + getTypeSize(type.operands[member], stride));
+				}
+				return size;
+			}
+			default:
+				return 0;    // runtime arrays have no static size
+			}
+		}
+
+		VkDescriptorType getDescriptorType(const SpirvId& type, uint32_t storageClass) const
+		{
+			if (storageClass == StorageClassStorageBuffer || (storageClass == StorageClassUniform && type.bufferBlock))
+			{
+				return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			}
+			if (storageClass == StorageClassUniform)
+			{
+				return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			}
+
+			switch (type.opcode)
+			{
+			case OpTypeSampler:
+				return VK_DESCRIPTOR_TYPE_SAMPLER;
+			case OpTypeSampledImage:
+				return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			case OpTypeImage:
+			{
+				uint32_t dim = type.operands[1];
+				bool storage = type.operands[5] == IMAGE_STORAGE;
+				if (dim == DIM_BUFFER)
+				{
+					return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+				}
+				if (dim == DIM_SUBPASS_DATA)
+				{
+					return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+				}
+				return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			}
+			default:
+				throw std::runtime_error("Failed to reflect shader: unsupported resource type!");
+			}
+		}
+
+		void collect(std::vector<ReflectedBinding>& bindings, std::vector<VkPushConstantRange>& pushConstants,
+			std::vector<ReflectedSpecConstant>& specConstants) const
+		{
+			for (const SpirvId& variable : m_Ids)
+			{
+				bool isSpecConstant = variable.opcode == OpSpecConstantTrue || variable.opcode == OpSpecConstantFalse || variable.opcode == OpSpecConstant;
+				if (isSpecConstant && variable.specId != UNDECORATED)
+				{
+					ReflectedSpecConstant constant;
+					constant.id = variable.specId;
+					constant.isBool = get(variable.typeId).opcode == OpTypeBool;
+					constant.stages = stages;
+					constant.name = variable.name;
+					specConstants.push_back(constant);
+					continue;
+				}
+				if (variable.opcode != OpVariable)
+				{
+					continue;
+				}
+				const SpirvId& pointer = get(variable.typeId);
+				if (pointer.opcode != OpTypePointer)
+				{
+					throw std::runtime_error("Failed to reflect shader: variable type is not a pointer!");
+				}
+				uint32_t storageClass = variable.operands[0];
+				uint32_t typeId = pointer.operands[1];
+
+				if (storageClass == StorageClassPushConstant)
+				{
+					const SpirvId& block = get(typeId);
+					uint32_t offset = block.memberOffsets.empty() ? 0 : *std::min_element(block.memberOffsets.begin(), block.memberOffsets.end());
+					VkPushConstantRange range{};
+					range.stageFlags = stages;
+					range.offset = offset;
+					range.size = getTypeSize(typeId, 0) - offset;
+					pushConstants.push_back(range);
+					continue;
+				}
+				if (storageClass != StorageClassUniformConstant && storageClass != StorageClassUniform && storageClass != StorageClassStorageBuffer)
+				{
+					continue;    // inputs, outputs, workgroup memory...
+				}
+				if (variable.binding == UNDECORATED)
+				{
+					continue;    // not a descriptor (Vulkan GLSL requires a binding on every resource)
+				}
+
+				ReflectedBinding binding;
+				binding.set = (variable.set == UNDECORATED) ? 0 : variable.set;
+				binding.binding = variable.binding;
+				binding.stages = stages;
+
+				// peel arrays: sampler2D textures[4][2] is one binding of 8 descriptors
+				const SpirvId* type = &get(typeId);
+				while (type->opcode == OpTypeArray || type->opcode == OpTypeRuntimeArray)
+				{
+					binding.count = (type->opcode == OpTypeRuntimeArray) ? 0 : binding.count * getConstant(type->operands[1]);
+					type = &get(type->operands[0]);
+				}
+				binding.type = getDescriptorType(*type, storageClass);
+				binding.name = type->name.empty() ? variable.name : type->name;
+				bindings.push_back(binding);
+			}
+		}
+	};
+
+	// minimal SPIR-V writer for selfTest()
+	struct SpirvBuilder
+	{
+		std::vector<uint32_t> words = { SPIRV_MAGIC, 0x00010000, 0, 64, 0 };
+
+		void op(uint32_t opcode, std::initializer_list<uint32_t> operands)
+		{
+			words.push_back((static_cast<uint32_t>(operands.size() + 1) << 16) | opcode);
+			words.insert(words.end(), operands.begin(), operands.end());
+		}
+
+		void opWithString(uint32_t opcode, std::initializer_list<uint32_t> operands, const char* text)
+		{
+			std::vector<uint32_t> packed((strlen(text) + sizeof(uint32_t)) / sizeof(uint32_t), 0);
+			std::memcpy(packed.data(), text, strlen(text));
+			words.push_back((static_cast<uint32_t>(operands.size() + packed.size() + 1) << 16) | opcode);
+			words.insert(words.end(), operands.begin(), operands.end());
+			words.insert(words.end(), packed.begin(), packed.end());
+		}
+
+		std::vector<char> bytes() const
+		{
+			std::vector<char> result(words.size() * sizeof(uint32_t));
+			std::memcpy(result.data(), words.data(), result.size());
+			return result;
+		}
+	};
+
+	bool readSpirv(const char* path, std::vector<char>& code)
+	{
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (file.is_open() == false)
+		{
+			return false;
+		}
+		code.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(code.data(), code.size());
+		return true;
+	}
+}
+
+void CShaderReflection::addStage(const std::vector<char>& spirv)
+{
+	SpirvModule module(spirv);
+	if (module.stages == 0)
+	{
+		throw std::runtime_error("Failed to reflect shader: no entry point!");
+	}
+
+	std::vector<ReflectedBinding> bindings;
+	std::vector<VkPushConstantRange> pushConstants;
+	std::vector<ReflectedSpecConstant> specConstants;
+	module.collect(bindings, pushConstants, specConstants);
+
+	for (const ReflectedBinding& binding : bindings)
+	{
+		auto found = m_Bindings.find({ binding.set, binding.binding });
+		if (found == m_Bindings.end())
+		{
+			m_Bindings.emplace(std::make_pair(binding.set, binding.binding), binding);
+			continue;
+		}
+		ReflectedBinding& existing = found->second;
+		if (existing.type != binding.type || existing.count != binding.count)
+		{
+			throw std::runtime_error("Failed to reflect shaders: set " + std::to_string(binding.set) + " binding " +
+				std::to_string(binding.binding) + " is declared differently in two stages!");
+		}
+		existing.stages |= binding.stages;
+	}
+
+	for (const ReflectedSpecConstant& constant : specConstants)
+	{
+		auto found = m_SpecConstants.find(constant.id);
+		if (found == m_SpecConstants.end())
+		{
+			m_SpecConstants.emplace(constant.id, constant);
+			continue;
+		}
+		if (found->second.isBool != constant.isBool)
+		{
+			throw std::runtime_error("Failed to reflect shaders: constant_id " + std::to_string(constant.id) + " has different types in two stages!");
+		}
+		found->second.stages |= constant.stages;
+	}
+
+	m_PushConstants.insert(m_PushConstants.end(), pushConstants.begin(), pushConstants.end());
+	m_Stages |= module.stages;
+}
+
+void CShaderReflection::clear()
+{
+	m_Bindings.clear();
+	m_PushConstants.clear();
+	m_SpecConstants.clear();
+	m_Stages = 0;
+}
+
+uint32_t CShaderReflection::getSetCount() const
+{
+	return m_Bindings.empty() ? 0 : m_Bindings.rbegin()->first.first + 1;
+}
+
+DescriptorSetLayoutDesc CShaderReflection::getSetLayoutDesc(uint32_t set, uint32_t unboundedCount) const
+{
+	DescriptorSetLayoutDesc desc;
+	bool unbounded = false;
+	for (const auto& entry : m_Bindings)
+	{
+		const ReflectedBinding& reflected = entry.second;
+		if (reflected.set != set)
+		{
+			continue;
+		}
+		if (unbounded)
+		{
+			throw std::runtime_error("Failed to build descriptor set layout: an unsized array must be the last binding of set " + std::to_string(set) + "!");
+		}
+
+		VkDescriptorSetLayoutBinding binding{};
+		binding.binding = reflected.binding;
+		binding.descriptorType = reflected.type;
+		binding.descriptorCount = reflected.count;
+		binding.stageFlags = reflected.stages;
+		VkDescriptorBindingFlags flags = 0;
+
+		if (reflected.count == 0)
+		{
+			// bindless array: sized by the caller, filled while in use
+			binding.descriptorCount = unboundedCount;
+			flags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+			desc.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+			unbounded = true;
+		}
+		desc.bindings.push_back(binding);
+		desc.bindingFlags.push_back(flags);
+	}
+	return desc;
+}
+
+std::vector<VkDescriptorPoolSize> CShaderReflection::getPoolSizes(uint32_t set, uint32_t setCount, uint32_t unboundedCount) const
+{
+	std::vector<VkDescriptorPoolSize> poolSizes;
+	for (const auto& entry : m_Bindings)
+	{
+		const ReflectedBinding& reflected = entry.second;
+		if (reflected.set != set)
+		{
+			continue;
+		}
+		uint32_t count = (reflected.count == 0 ? unboundedCount : reflected.count) * setCount;
+		auto found = std::find_if(poolSizes.begin(), poolSizes.end(), [&](const VkDescriptorPoolSize& size) { return size.type == reflected.type; });
+		if (found != poolSizes.end())
+		{
+			found->descriptorCount += count;
+		}
+		else
+		{
+			poolSizes.push_back({ reflected.type, count });
+		}
+	}
+	return poolSizes;
+}
+
+const char* CShaderReflection::toString(VkDescriptorType type)
+{
+	switch (type)
+	{
+	case VK_DESCRIPTOR_TYPE_SAMPLER:                   return "sampler";
+	case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:    return "combined image sampler";
+	case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:             return "sampled image";
+	case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:             return "storage image";
+	case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:      return "uniform texel buffer";
+	case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:      return "storage texel buffer";
+	case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:            return "uniform buffer";
+	case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:            return "storage buffer";
+	case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:          return "input attachment";
+	default:                                           return "unknown";
+	}
+}
+
+void CShaderReflection::print() const
+{
+	for (const auto& entry : m_Bindings)
+	{
+		const ReflectedBinding& binding = entry.second;
+		char count[16];
+		snprintf(count, sizeof(count), binding.count == 0 ? "[]" : "[%u]", binding.count);
+		printf("  set %u binding %u: %-22s %-5s stages 0x%02x  %s\n", binding.set, binding.binding, toString(binding.type),
+			binding.count == 1 ? "" : count, binding.stages, binding.name.c_str());
+	}
+	for (const VkPushConstantRange& range : m_PushConstants)
+	{
+		printf("  push constants: offset %u, %u bytes, stages 0x%02x\n", range.offset, range.size, range.stageFlags);
+	}
+	for (const auto& entry : m_SpecConstants)
+	{
+		const ReflectedSpecConstant& constant = entry.second;
+		printf("  constant_id %u: %-5s stages 0x%02x  %s\n", constant.id, constant.isBool ? "bool" : "", constant.stages, constant.name.c_str());
+	}
+}
+
+bool CShaderReflection::selfTest()
+{
+	bool passed = true;
+	auto check = [&](bool condition, const char* what)
+	{
+		if (condition == false)
+		{
+			printf("  FAILED: %s\n", what);
+			passed = false;
+		}
+	};
+
+	// fragment stage with every resource kind the renderer uses:
+	//   set 0: 0 = UBO { mat4 }, 2 = sampler2D[4], 3 = storage image
+	//   set 1: 0 = SSBO { vec4[] }, 1 = sampler2D[] (bindless)
+	//   push constants { uint; mat4 (offset 16) } = 80 bytes
+	//   layout(constant_id = 0) const bool ALPHA_TEST
+	enum : uint32_t
+	{
+		Main = 1, Uint, Float, Vec4, Mat4, Four, Image2D, Sampled, SampledArray4, SampledRuntime, StorageImage,
+		Vec4Runtime, Materials, Ubo, Push, PtrSampledArray4, PtrSampledRuntime, PtrStorageImage, PtrMaterials, PtrUbo, PtrPush,
+		VarUbo, VarShadow, VarStorage, VarMaterials, VarTextures, VarPush, Sampler, PtrSampler, VarSampler, Bool, AlphaTest
+	};
+	SpirvBuilder fragment;
+	fragment.opWithString(OpEntryPoint, { 4, Main }, "main");
+	fragment.opWithString(OpName, { Materials }, "Materials");
+	fragment.opWithString(OpName, { VarTextures }, "textures");
+	fragment.opWithString(OpName, { AlphaTest }, "ALPHA_TEST");
+	fragment.op(OpDecorate, { AlphaTest, DecorationSpecId, 0 });
+	fragment.op(OpDecorate, { Vec4Runtime, DecorationArrayStride, 16 });
+	fragment.op(OpDecorate, { Materials, DecorationBlock });
+	fragment.op(OpMemberDecorate, { Materials, 0, DecorationOffset, 0 });
+	fragment.op(OpDecorate, { Ubo, DecorationBlock });
+	fragment.op(OpMemberDecorate, { Ubo, 0, DecorationOffset, 0 });
+	fragment.op(OpMemberDecorate, { Ubo, 0, DecorationMatrixStride, 16 });
+	fragment.op(OpDecorate, { Push, DecorationBlock });
+	fragment.op(OpMemberDecorate, { Push, 0, DecorationOffset, 0 });
+	fragment.op(OpMemberDecorate, { Push, 1, DecorationOffset, 16 });
+	fragment.op(OpMemberDecorate, { Push, 1, DecorationMatrixStride, 16 });
+	const uint32_t decorations[][3] = { { VarUbo, 0, 0 }, { VarShadow, 0, 2 }, { VarStorage, 0, 3 }, { VarMaterials, 1, 0 }, { VarTextures, 1, 1 } };
+	for (const uint32_t* decoration : decorations)
+	{
+		fragment.op(OpDecorate, { decoration[0], DecorationDescriptorSet, decoration[1] });
+		fragment.op(OpDecorate, { decoration[0], DecorationBinding, decoration[2] });
+	}
+	fragment.op(OpTypeBool, { Bool });
+	fragment.op(OpSpecConstantFalse, { Bool, AlphaTest });
+	fragment.op(OpTypeInt, { Uint, 32, 0 });
+	fragment.op(OpTypeFloat, { Float, 32 });
+	fragment.op(OpTypeVector, { Vec4, Float, 4 });
+	fragment.op(OpTypeMatrix, { Mat4, Vec4, 4 });
+	fragment.op(OpConstant, { Uint, Four, 4 });
+	fragment.op(OpTypeImage, { Image2D, Float, 1, 0, 0, 0, 1, 0 });
+	fragment.op(OpTypeSampledImage, { Sampled, Image2D });
+	fragment.op(OpTypeArray, { SampledArray4, Sampled, Four });
+	fragment.op(OpTypeRuntimeArray, { SampledRuntime, Sampled });
+	fragment.op(OpTypeImage, { StorageImage, Float, 1, 0, 0, 0, IMAGE_STORAGE, 4 });
+	fragment.op(OpTypeRuntimeArray, { Vec4Runtime, Vec4 });
+	fragment.op(OpTypeStruct, { Materials, Vec4Runtime });
+	fragment.op(OpTypeStruct, { Ubo, Mat4 });
+	fragment.op(OpTypeStruct, { Push, Uint, Mat4 });
+	fragment.op(OpTypePointer, { PtrSampledArray4, StorageClassUniformConstant, SampledArray4 });
+	fragment.op(OpTypePointer, { PtrSampledRuntime, StorageClassUniformConstant, SampledRuntime });
+	fragment.op(OpTypePointer, { PtrStorageImage, StorageClassUniformConstant, StorageImage });
+	fragment.op(OpTypePointer, { PtrMaterials, StorageClassStorageBuffer, Materials });
+	fragment.op(OpTypePointer, { PtrUbo, StorageClassUniform, Ubo });
+	fragment.op(OpTypePointer, { PtrPush, StorageClassPushConstant, Push });
+	fragment.op(OpVariable, { PtrUbo, VarUbo, StorageClassUniform });
+	fragment.op(OpVariable, { PtrSampledArray4, VarShadow, StorageClassUniformConstant });
+	fragment.op(OpVariable, { PtrStorageImage, VarStorage, StorageClassUniformConstant });
+	fragment.op(OpVariable, { PtrMaterials, VarMaterials, StorageClassStorageBuffer });
+	fragment.op(OpVariable, { PtrSampledRuntime, VarTextures, StorageClassUniformConstant });
+	fragment.op(OpVariable, { PtrPush, VarPush, StorageClassPushConstant });
+
+	// vertex stage sharing the UBO
+	SpirvBuilder vertex;
+	vertex.opWithString(OpEntryPoint, { 0, Main }, "main");
+	vertex.op(OpDecorate, { Ubo, DecorationBlock });
+	vertex.op(OpDecorate, { VarUbo, DecorationDescriptorSet, 0 });
+	vertex.op(OpDecorate, { VarUbo, DecorationBinding, 0 });
+	vertex.op(OpTypeFloat, { Float, 32 });
+	vertex.op(OpTypeVector, { Vec4, Float, 4 });
+	vertex.op(OpTypeMatrix, { Mat4, Vec4, 4 });
+	vertex.op(OpTypeStruct, { Ubo, Mat4 });
+	vertex.op(OpTypePointer, { PtrUbo, StorageClassUniform, Ubo });
+	vertex.op(OpVariable, { PtrUbo, VarUbo, StorageClassUniform });
+
+	// vertex stage that declares set 0 binding 0 as a sampler instead
+	SpirvBuilder conflicting;
+	conflicting.opWithString(OpEntryPoint, { 0, Main }, "main");
+	conflicting.op(OpDecorate, { VarSampler, DecorationDescriptorSet, 0 });
+	conflicting.op(OpDecorate, { VarSampler, DecorationBinding, 0 });
+	conflicting.op(OpTypeSampler, { Sampler });
+	conflicting.op(OpTypePointer, { PtrSampler, StorageClassUniformConstant, Sampler });
+	conflicting.op(OpVariable, { PtrSampler, VarSampler, StorageClassUniformConstant });
+
+	printf("Synthetic vertex + fragment module:\n");
+	CShaderReflection reflection;
+	reflection.addStage(fragment.bytes());
+	reflection.addStage(vertex.bytes());
+	reflection.print();
+
+	const auto& bindings = reflection.getBindings();
+	auto find = [&](uint32_t set, uint32_t binding) -> const ReflectedBinding*
+	{
+		auto found = bindings.find({ set, binding });
+		return found != bindings.end() ? &found->second : nullptr;
+	};
+	const ReflectedBinding* ubo = find(0, 0);
+	const ReflectedBinding* shadow = find(0, 2);
+	const ReflectedBinding* storage = find(0, 3);
+	const ReflectedBinding* materials = find(1, 0);
+	const ReflectedBinding* textures = find(1, 1);
+	check(bindings.size() == 5, "five bindings");
+	check(ubo && ubo->type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER && ubo->stages == (VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT), "UBO merged across stages");
+	check(shadow && shadow->type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER && shadow->count == 4, "sampler2D[4]");
+	check(storage && storage->type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, "storage image");
+	check(materials && materials->type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER && materials->name == "Materials", "SSBO");
+	check(textures && textures->count == 0 && textures->name == "textures", "unsized sampler2D[]");
+	check(reflection.getSetCount() == 2, "two sets");
+
+	const std::vector<VkPushConstantRange>& pushConstants = reflection.getPushConstantRanges();
+	check(pushConstants.size() == 1 && pushConstants[0].offset == 0 && pushConstants[0].size == 80 &&
+		pushConstants[0].stageFlags == VK_SHADER_STAGE_FRAGMENT_BIT, "push constants: fragment, 80 bytes");
+
+	const auto& specConstants = reflection.getSpecConstants();
+	check(specConstants.size() == 1 && specConstants.begin()->second.isBool && specConstants.begin()->second.name == "ALPHA_TEST" &&
+		specConstants.begin()->second.stages == VK_SHADER_STAGE_FRAGMENT_BIT, "bool specialization constant");
+
+	DescriptorSetLayoutDesc bindless = reflection.getSetLayoutDesc(1, 1000);
+	check(bindless.bindings.size() == 2 && bindless.bindings[1].descriptorCount == 1000 &&
+		(bindless.bindingFlags[1] & VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT) && bindless.bindingFlags[0] == 0 &&
+		(bindless.flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT), "bindless set layout");
+	DescriptorSetLayoutDesc set0 = reflection.getSetLayoutDesc(0, 1000);
+	check(set0.flags == 0 && set0.bindings.size() == 3, "set 0 layout");
+
+	std::vector<VkDescriptorPoolSize> poolSizes = reflection.getPoolSizes(0, 3, 0);
+	uint32_t samplerDescriptors = 0;
+	for (const VkDescriptorPoolSize& size : poolSizes)
+	{
+		samplerDescriptors += (size.type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) ? size.descriptorCount : 0;
+	}
+	check(poolSizes.size() == 3 && samplerDescriptors == 12, "pool sizes for 3 sets");
+
+	bool threw = false;
+	try
+	{
+		reflection.addStage(conflicting.bytes());
+	}
+	catch (const std::exception& e)
+	{
+		printf("  conflict detected: %s\n", e.what());
+		threw = true;
+	}
+	check(threw, "conflicting binding rejected");
+
+	// an OpTypeVector without its component count must be rejected, not read past
+	SpirvBuilder truncated;
+	truncated.opWithString(OpEntryPoint, { 4, Main }, "main");
+	truncated.op(OpTypeFloat, { Float, 32 });
+	truncated.op(OpTypeVector, { Vec4, Float });
+	threw = false;
+	try
+	{
+		CShaderReflection malformed;
+		malformed.addStage(truncated.bytes());
+	}
+	catch (const std::exception& e)
+	{
+		printf("  malformed module rejected: %s\n", e.what());
+		threw = true;
+	}
+	check(threw, "short instruction rejected");
+
+	// the renderer's shaders, if compiled
+	const char* fragmentShaders[] = { "shaders/frag.spv", "shaders/frag_bindless.spv" };
+	std::vector<char> vertexCode;
+	if (readSpirv("shaders/vert.spv", vertexCode))
+	{
+		for (const char* path : fragmentShaders)
+		{
+			std::vector<char> fragmentCode;
+			if (readSpirv(path, fragmentCode) == false)
+			{
+				continue;
+			}
+			CShaderReflection shaders;
+			shaders.addStage(vertexCode);
+			shaders.addStage(fragmentCode);
+			printf("shaders/vert.spv + %s:\n", path);
+			shaders.print();
+			check(shaders.getBindings().count({ 0, 0 }) == 1 && shaders.getBindings().at({ 0, 0 }).type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				"set 0 binding 0 is the transform UBO");
+		}
+	}
+
+	printf(passed ? "Shader reflection: all checks passed\n" : "Shader reflection: FAILED\n");
+	return passed;
+}
@@ -0,0 +1,86 @@
+/*======================================================================
+VulkanPBR_AcornForest : ShaderReflection.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+SPIR-V reflection.
+addStage() parses a SPIR-V module and collects its descriptor bindings
+(set, binding, type, array size) and push-constant block. Adding the
+stages of one pipeline merges them: a binding used by several stages
+gets all their stage flags, and conflicting declarations of the same
+(set, binding) throw. The result describes the descriptor set layouts,
+push-constant ranges and pool sizes of the pipeline, so the C++ side no
+longer repeats what the shaders declare. Specialization constants are
+collected too, so variants only specialize the ids a stage declares.
+
+Only the subset of SPIR-V that GLSL compilers emit for resource
+declarations is interpreted; everything else is skipped. Unsized arrays
+(textures[]) are reported with count 0 and become variable-count,
+update-after-bind bindings with the capacity passed by the caller.
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "LayoutCache.h"
+
+struct ReflectedBinding
+{
+	uint32_t            set = 0;
+	uint32_t            binding = 0;
+	VkDescriptorType    type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+	uint32_t            count = 1;          // array size, 0 = unsized (runtime) array
+	VkShaderStageFlags  stages = 0;
+	std::string         name;               // variable or block name, for logs
+};
+
+struct ReflectedSpecConstant
+{
+	uint32_t            id = 0;             // layout(constant_id = N)
+	bool                isBool = false;
+	VkShaderStageFlags  stages = 0;
+	std::string         name;
+};
+
+class CShaderReflection
+{
+private:
+
+	std::map<std::pair<uint32_t, uint32_t>, ReflectedBinding>   m_Bindings;         // keyed by (set, binding)
+	std::map<uint32_t, ReflectedSpecConstant>                   m_SpecConstants;    // keyed by constant id
+	std::vector<VkPushConstantRange>                            m_PushConstants;    // one range per stage that has a push-constant block
+	VkShaderStageFlags                                          m_Stages = 0;
+
+public:
+
+	// Parses one stage and merges it into the reflection. Throws on malformed SPIR-V or conflicting bindings.
+	void addStage(const std::vector<char>& spirv);
+	void clear();
+
+	const std::map<std::pair<uint32_t, uint32_t>, ReflectedBinding>& getBindings() const { return m_Bindings; }
+	const std::vector<VkPushConstantRange>& getPushConstantRanges() const { return m_PushConstants; }
+	const std::map<uint32_t, ReflectedSpecConstant>& getSpecConstants() const { return m_SpecConstants; }
+	VkShaderStageFlags getStages() const { return m_Stages; }
+	uint32_t getSetCount() const;    // highest set index + 1
+
+	// Layout of one set; unsized arrays get unboundedCount descriptors and the bindless flags
+	// (must then be the last binding of the set). Sets the shaders do not use come back empty.
+	DescriptorSetLayoutDesc getSetLayoutDesc(uint32_t set, uint32_t unboundedCount) const;
+
+	// pool sizes for setCount allocations of one set
+	std::vector<VkDescriptorPoolSize> getPoolSizes(uint32_t set, uint32_t setCount, uint32_t unboundedCount) const;
+
+	void print() const;
+
+	static const char* toString(VkDescriptorType type);
+
+	// CPU-only: reflects a synthetic module with every supported declaration plus the shader files
+	// that exist, prints them and checks the results. Returns false on the first mismatch.
+	static bool selfTest();
+};
@@ -0,0 +1,136 @@
+/*======================================================================
+VulkanPBR_AcornForest : ShaderVariants.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "ShaderVariants.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+	const char* FEATURE_NAMES[SHADER_FEATURE_COUNT] = { "alpha-test", "vertex-color", "uv-debug", "uv-tiling", "ibl", "clustered-lights", "shadows", "overdraw" };
+}
+
+const char* toString(ShaderFeature feature)
+{
+	for (uint32_t bit = 0; bit < SHADER_FEATURE_COUNT; bit++)
+	{
+		if (feature == (1u << bit))
+		{
+			return FEATURE_NAMES[bit];
+		}
+	}
+	return "unknown";
+}
+
+std::string describeShaderVariant(uint32_t key)
+{
+	std::string description;
+	for (uint32_t bit = 0; bit < SHADER_FEATURE_COUNT; bit++)
+	{
+		if (key & (1u << bit))
+		{
+			description += (description.empty() ? "" : "+") + std::string(FEATURE_NAMES[bit]);
+		}
+	}
+	return description.empty() ? "base" : description;
+}
+
+bool parseShaderFeatures(const char* text, uint32_t& key)
+{
+	key = 0;
+	if (strcmp(text, "none") == 0)
+	{
+		return true;
+	}
+
+	std::string list = text;
+	size_t begin = 0;
+	while (begin <= list.size())
+	{
+		size_t end = list.find(',', begin);
+		std::string name = list.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+		uint32_t bit = 0;
+		while (bit < SHADER_FEATURE_COUNT && name != FEATURE_NAMES[bit])
+		{
+			bit++;
+		}
+		if (bit == SHADER_FEATURE_COUNT)
+		{
+			return false;
+		}
+		key |= 1u << bit;
+		if (end == std::string::npos)
+		{
+			break;
+		}
+		begin = end + 1;
+	}
+	return true;
+}
+
+CShaderSpecialization::CShaderSpecialization(uint32_t key, const CShaderReflection& reflection, VkShaderStageFlagBits stage)
+{
+	for (const auto& entry : reflection.getSpecConstants())
+	{
+		const ReflectedSpecConstant& constant = entry.second;
+		if ((constant.stages & stage) == 0 || constant.isBool == false || constant.id >= SHADER_FEATURE_COUNT)
+		{
+			continue;
+		}
+		VkSpecializationMapEntry mapEntry{};
+		mapEntry.constantID = constant.id;
+		mapEntry.offset = static_cast<uint32_t>(m_Values.size() * sizeof(VkBool32));
+		mapEntry.size = sizeof(VkBool32);
+		m_Entries.push_back(mapEntry);
+		m_Values.push_back((key & (1u << constant.id)) ? VK_TRUE : VK_FALSE);
+	}
+
+	m_Info.mapEntryCount = static_cast<uint32_t>(m_Entries.size());
+	m_Info.pMapEntries = m_Entries.data();
+	m_Info.dataSize = m_Values.size() * sizeof(VkBool32);
+	m_Info.pData = m_Values.data();
+}
+
+void CPipelineVariants::create(VkDevice device, CreateFunction createPipeline)
+{
+	m_Device = device;
+	m_CreatePipeline = std::move(createPipeline);
+}
+
+VkPipeline CPipelineVariants::get(uint32_t key)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto found = m_Pipelines.find(key);
+	if (found != m_Pipelines.end())
+	{
+		return found->second;
+	}
+
+	// compiled under the lock: threads asking for the same variant wait for this compile instead of duplicating it
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	VkPipeline pipeline = m_CreatePipeline(key);
+	m_LastCompileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	m_CompileCount++;
+
+	m_Pipelines.emplace(key, pipeline);
+	return pipeline;
+}
+
+void CPipelineVariants::clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (auto& entry : m_Pipelines)
+	{
+		vkDestroyPipeline(m_Device, entry.second, nullptr);
+	}
+	m_Pipelines.clear();
+}
+
+uint32_t CPipelineVariants::getVariantCount()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return static_cast<uint32_t>(m_Pipelines.size());
+}
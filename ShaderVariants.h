@@ -0,0 +1,111 @@
+/*======================================================================
+VulkanPBR_AcornForest : ShaderVariants.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Shader variants through specialization constants.
+Every optional shader feature is one bit of a permutation key and one
+boolean specialization constant, layout(constant_id = <bit index>), in
+the GLSL. The driver compiles each variant with the disabled branches
+folded away, so a feature that is off costs no ALU and no registers,
+without keeping one SPIR-V file per permutation.
+
+CPipelineVariants compiles the pipeline of a key the first time get()
+asks for it and keeps it until clear() (render pass / swapchain change).
+Compiles go through the persisted pipeline cache (CPipelineCache), so a
+variant seen in an earlier run is cheap even on first use.
+
+A key can also carry PipelineStateFlag bits for the depth prepass;
+they change the fixed-function state only and are never specialization
+constants.
+
+Normal mapping and instancing will be further bits once the vertex
+format carries tangents and the renderer has an instance buffer.
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ShaderReflection.h"
+
+// bit index = constant_id in the shaders
+enum ShaderFeature : uint32_t
+{
+	SHADER_FEATURE_ALPHA_TEST = 1u << 0,      // discard texels below the alpha cutoff
+	SHADER_FEATURE_VERTEX_COLOR = 1u << 1,    // modulate by the vertex color
+	SHADER_FEATURE_UV_DEBUG = 1u << 2,        // output the texture coordinates
+	SHADER_FEATURE_UV_TILING = 1u << 3,       // sample with UV * 2
+	SHADER_FEATURE_IBL = 1u << 4,             // image based ambient lighting (IblPrecompute.h)
+	SHADER_FEATURE_CLUSTERED_LIGHTS = 1u << 5,    // point lights from the light clusters (ClusteredLights.h)
+	SHADER_FEATURE_SHADOWS = 1u << 6,         // sun light with cascaded shadow maps (ShadowCascades.h)
+	SHADER_FEATURE_OVERDRAW = 1u << 7,        // constant heat step, blended additively: how often each pixel was shaded
+};
+
+const uint32_t SHADER_FEATURE_COUNT = 8;
+
+// fixed-function state of a variant, in key bits above the shader features (no specialization constant)
+enum PipelineStateFlag : uint32_t
+{
+	PIPELINE_DEPTH_PREPASS = 1u << 24,        // depth only: no color writes, fragment stage only for the alpha test
+	PIPELINE_DEPTH_EQUAL = 1u << 25,          // after a depth prepass: depth compare EQUAL, no depth writes
+};
+
+const char* toString(ShaderFeature feature);
+std::string describeShaderVariant(uint32_t key);    // "alpha-test+uv-debug", "base"
+bool parseShaderFeatures(const char* text, uint32_t& key);    // comma separated names, "none"
+
+// VkSpecializationInfo for one stage plus the storage it points into; not copyable
+class CShaderSpecialization
+{
+private:
+
+	std::vector<VkSpecializationMapEntry>   m_Entries;
+	std::vector<VkBool32>                   m_Values;
+	VkSpecializationInfo                    m_Info{};
+
+public:
+
+	// Sets the boolean constants the stage declares (reflection) from the key bits.
+	// Constants the shader does not have are left out, so old SPIR-V still works.
+	CShaderSpecialization(uint32_t key, const CShaderReflection& reflection, VkShaderStageFlagBits stage);
+	CShaderSpecialization(const CShaderSpecialization&) = delete;
+	CShaderSpecialization& operator=(const CShaderSpecialization&) = delete;
+
+	const VkSpecializationInfo* get() const { return m_Entries.empty() ? nullptr : &m_Info; }
+};
+
+class CPipelineVariants
+{
+public:
+
+	using CreateFunction = std::function<VkPipeline(uint32_t key)>;
+
+private:
+
+	VkDevice                                    m_Device = VK_NULL_HANDLE;
+	CreateFunction                              m_CreatePipeline;
+	std::mutex                                  m_Mutex;         // command buffers are recorded on worker threads
+	std::unordered_map<uint32_t, VkPipeline>    m_Pipelines;
+	uint32_t                                    m_CompileCount = 0;
+	double                                      m_LastCompileMs = 0.0;
+
+public:
+
+	void create(VkDevice device, CreateFunction createPipeline);
+
+	// cached pipeline of the key, compiled now if this is its first use (throws if compiling fails)
+	VkPipeline get(uint32_t key);
+
+	void clear();    // destroys every variant (the create function's state changed)
+
+	uint32_t getVariantCount();
+	uint32_t getCompileCount() const { return m_CompileCount; }     // including recompiles after clear()
+	double getLastCompileMs() const { return m_LastCompileMs; }
+};
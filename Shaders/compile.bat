@@ -0,0 +1,36 @@
+@echo off
+rem Compiles the GLSL sources in this folder to SPIR-V.
+rem Needs the Vulkan SDK (VULKAN_SDK is set by the SDK installer).
+rem The project runs this as its pre-build step ("compile.bat nopause"),
+rem so the .spv files are rebuilt whenever the program is built.
+
+cd /d "%~dp0"
+if not defined VULKAN_SDK (
+	echo compile.bat: VULKAN_SDK is not set, cannot compile shaders
+	exit /b 1
+)
+set GLSLC="%VULKAN_SDK%\Bin\glslc.exe"
+set FAILED=0
+
+call :compile shaders.vert vert.spv
+call :compile shaders.frag frag.spv
+call :compile shaders_bindless.frag frag_bindless.spv
+call :compile mipgen.comp mipgen.spv
+call :compile ibl.comp ibl.spv
+call :compile cluster_cull.comp cluster_cull.spv
+call :compile shadow.vert shadow.spv
+call :compile impostor_bake.vert impostor_bake_vert.spv
+call :compile impostor_bake.frag impostor_bake_frag.spv
+call :compile impostor.vert impostor_vert.spv
+call :compile impostor.frag impostor_frag.spv
+
+if not "%1"=="nopause" pause
+exit /b %FAILED%
+
+:compile
+%GLSLC% %1 -o %2
+if errorlevel 1 (
+	echo compile.bat: %1 failed
+	set FAILED=1
+)
+exit /b 0
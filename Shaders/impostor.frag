@@ -0,0 +1,72 @@
+#version 450
+
+// Distant trees from the impostor atlas: three frames blended by weight,
+// cut out at the baked coverage. The baked depth pushes the fragment back
+// from the quad to the tree's surface, so neighbouring impostors and meshes
+// intersect where the trees would. Lighting is a simplified version of
+// shaders.frag (constant ambient, unshadowed sun), tone mapped the same way.
+
+layout(binding = 0) uniform UniformBufferObject
+{
+	mat4 model;
+	mat4 view;
+	mat4 proj;
+	vec3 camPos;
+	mat4 cascadeViewProj[4];
+	vec4 cascadeSplits;
+	vec4 sun;               // xyz = direction towards the sun, w = intensity
+}ubo;
+
+layout(binding = 1) uniform sampler2D albedoAtlas;          // rgb albedo, a coverage
+layout(binding = 2) uniform sampler2D normalDepthAtlas;     // xyz model space normal, w depth in front of the center / radius
+
+layout(push_constant) uniform ImpostorPush
+{
+	vec4 sphere;
+	vec4 atlas;
+};
+
+layout(location = 0) in vec2 fragFrameUv[3];
+layout(location = 3) flat in uvec3 fragFrames;
+layout(location = 4) flat in vec3 fragWeights;
+layout(location = 5) in vec3 fragWorldPos;
+layout(location = 6) flat in vec4 fragCenterRadius;
+
+layout(location = 0) out vec4 outColor;
+
+const float PI = 3.14159265359;
+const float ALPHA_CUTOFF = 0.5;
+const vec3 SUN_COLOR = vec3(1.0, 0.95, 0.85);
+const float AMBIENT = 0.35;
+
+void main()
+{
+	uint frames = uint(atlas.x);
+	vec4 albedo = vec4(0.0);
+	vec4 normalDepth = vec4(0.0);
+	for (int i = 0; i < 3; i++)
+	{
+		// outside its frame a corner of the quad sees nothing (and must not read the neighbouring frame)
+		vec2 uv = fragFrameUv[i];
+		float inside = (all(greaterThanEqual(uv, vec2(0.0))) && all(lessThanEqual(uv, vec2(1.0)))) ? fragWeights[i] : 0.0;
+		vec2 atlasUv = (vec2(fragFrames[i] % frames, fragFrames[i] / frames) + clamp(uv, 0.0, 1.0)) / float(frames);
+		albedo += texture(albedoAtlas, atlasUv) * inside;
+		normalDepth += texture(normalDepthAtlas, atlasUv) * inside;
+	}
+	if (albedo.a < ALPHA_CUTOFF)
+	{
+		discard;
+	}
+
+	// uncovered texels are zero: divide by the coverage to get the average of the covered ones
+	vec3 color = albedo.rgb / albedo.a;
+	vec3 n = normalize(mat3(ubo.model) * (normalDepth.xyz / albedo.a + vec3(0.0, 0.0, 1e-4)));
+	float depth = normalDepth.w / albedo.a;
+
+	vec3 lit = color * AMBIENT + SUN_COLOR * ubo.sun.w * max(dot(n, ubo.sun.xyz), 0.0) * color / PI;
+	outColor = vec4(lit / (lit + 1.0), 1.0);    // Reinhard
+
+	vec3 toCamera = normalize(ubo.camPos - fragCenterRadius.xyz);
+	vec4 clip = ubo.proj * ubo.view * vec4(fragWorldPos + toCamera * depth * fragCenterRadius.w, 1.0);
+	gl_FragDepth = clip.z / clip.w;
+}
@@ -0,0 +1,112 @@
+#version 450
+
+// Distant trees as camera-facing quads (ImpostorPass.cpp): six vertices per
+// tree instance, no vertex buffer. The quad covers the tree's bounding sphere.
+// The direction to the camera in the tree's model space picks three atlas
+// frames and their weights, and every corner is projected into each frame,
+// exactly as CImpostorAtlas::getFrameBlend() and getFrameUv() do on the CPU.
+
+layout(binding = 0) uniform UniformBufferObject
+{
+	mat4 model;
+	mat4 view;
+	mat4 proj;
+	vec3 camPos;
+	mat4 cascadeViewProj[4];
+	vec4 cascadeSplits;
+	vec4 sun;
+}ubo;
+
+layout(push_constant) uniform ImpostorPush
+{
+	vec4 sphere;    // bounding sphere of the tree mesh, model space: xyz center, w radius
+	vec4 atlas;     // x = frames per atlas side
+};
+
+layout(location = 0) in vec4 inInstance;    // xyz position, w scale
+
+layout(location = 0) out vec2 fragFrameUv[3];             // 0..1 inside each blended frame
+layout(location = 3) flat out uvec3 fragFrames;           // frame x + y * frames
+layout(location = 4) flat out vec3 fragWeights;
+layout(location = 5) out vec3 fragWorldPos;               // on the quad
+layout(location = 6) flat out vec4 fragCenterRadius;      // world space sphere of this tree
+
+const vec2 CORNERS[6] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+vec2 encodeHemiOctahedron(vec3 d)
+{
+	d.z = max(d.z, 0.0);
+	vec2 p = d.xy / max(abs(d.x) + abs(d.y) + d.z, 1e-6);
+	return vec2(p.x + p.y, p.x - p.y) * 0.5 + 0.5;
+}
+
+vec3 decodeHemiOctahedron(vec2 uv)
+{
+	vec2 square = uv * 2.0 - 1.0;
+	vec2 p = vec2(square.x + square.y, square.x - square.y) * 0.5;
+	return normalize(vec3(p, 1.0 - abs(p.x) - abs(p.y)));
+}
+
+// the basis glm::lookAt builds for a camera at direction, looking back at the center
+void frameBasis(vec3 direction, out vec3 side, out vec3 up)
+{
+	vec3 forward = -direction;
+	vec3 worldUp = (abs(direction.z) > 0.999) ? vec3(0.0, 1.0, 0.0) : vec3(0.0, 0.0, 1.0);
+	side = normalize(cross(forward, worldUp));
+	up = cross(side, forward);
+}
+
+void main()
+{
+	mat3 rotation = mat3(ubo.model);    // the trees turn with the model
+	float scale = inInstance.w;
+	vec3 center = inInstance.xyz + rotation * (sphere.xyz * scale);
+	float radius = sphere.w * scale;
+
+	// quad facing the camera, upright
+	vec3 toCamera = normalize(ubo.camPos - center);
+	vec3 side;
+	vec3 up;
+	frameBasis(toCamera, side, up);
+	vec2 corner = CORNERS[gl_VertexIndex];
+	vec3 worldPos = center + (side * corner.x + up * corner.y) * radius;
+
+	// frame selection: the grid triangle of the view direction, barycentric weights
+	float frames = atlas.x;
+	float last = frames - 1.0;
+	vec3 viewDirection = transpose(rotation) * toCamera;
+	vec2 grid = encodeHemiOctahedron(viewDirection) * last;
+	vec2 base = min(floor(grid), vec2(last - 1.0));
+	vec2 f = clamp(grid - base, 0.0, 1.0);
+
+	vec2 cells[3];
+	if (f.x + f.y < 1.0)
+	{
+		cells[0] = base;
+		cells[1] = base + vec2(1.0, 0.0);
+		cells[2] = base + vec2(0.0, 1.0);
+		fragWeights = vec3(1.0 - f.x - f.y, f.x, f.y);
+	}
+	else
+	{
+		cells[0] = base + vec2(1.0, 1.0);
+		cells[1] = base + vec2(0.0, 1.0);
+		cells[2] = base + vec2(1.0, 0.0);
+		fragWeights = vec3(f.x + f.y - 1.0, 1.0 - f.x, 1.0 - f.y);
+	}
+
+	// the corner relative to the sphere center, in unscaled model space, seen by each frame's camera
+	vec3 local = transpose(rotation) * (worldPos - center) / scale;
+	for (int i = 0; i < 3; i++)
+	{
+		vec3 frameSide;
+		vec3 frameUp;
+		frameBasis(decodeHemiOctahedron(cells[i] / last), frameSide, frameUp);
+		fragFrameUv[i] = vec2(0.5 + dot(local, frameSide) / (2.0 * sphere.w), 0.5 - dot(local, frameUp) / (2.0 * sphere.w));
+	}
+	fragFrames = uvec3(uint(cells[0].x + cells[0].y * frames), uint(cells[1].x + cells[1].y * frames), uint(cells[2].x + cells[2].y * frames));
+
+	fragWorldPos = worldPos;
+	fragCenterRadius = vec4(center, radius);
+	gl_Position = ubo.proj * ubo.view * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,39 @@
+#version 450
+
+// Bake of the impostor atlas: albedo with coverage, and the model space
+// face normal with the depth in front of the sphere center (in radii).
+// Cleared texels keep alpha 0, which is what the runtime tests against.
+
+layout(binding = 0) uniform sampler2D texSampler;
+
+layout(push_constant) uniform BakePush
+{
+	mat4 viewProj;
+	vec4 sphere;
+	vec4 direction;
+};
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) in vec3 fragPosition;
+
+layout(location = 0) out vec4 outAlbedo;
+layout(location = 1) out vec4 outNormalDepth;
+
+const float ALPHA_CUTOFF = 0.5;
+
+void main()
+{
+	// no vertex normals: face normal from derivatives, towards the frame's camera like faceNormal() in shaders.frag.
+	// Taken before the discard: derivatives are undefined once neighbouring invocations may have stopped.
+	vec3 n = normalize(cross(dFdx(fragPosition), dFdy(fragPosition)));
+	n = (dot(n, direction.xyz) < 0.0) ? -n : n;
+
+	vec4 albedo = texture(texSampler, fragTexCoord);
+	if (albedo.a < ALPHA_CUTOFF)
+	{
+		discard;
+	}
+
+	outAlbedo = vec4(albedo.rgb, 1.0);
+	outNormalDepth = vec4(n, dot(fragPosition - sphere.xyz, direction.xyz) / sphere.w);
+}
@@ -0,0 +1,25 @@
+#version 450
+
+// Bake of the impostor atlas (ImpostorPass.cpp): the whole model once per
+// frame, each frame's orthographic view squeezed into its tile of the atlas
+// (CImpostorAtlas::getBakeViewProj()). Positions stay in model space.
+
+layout(push_constant) uniform BakePush
+{
+	mat4 viewProj;
+	vec4 sphere;       // bounding sphere of the model: xyz center, w radius
+	vec4 direction;    // xyz: from the model towards the frame's camera
+};
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) out vec3 fragPosition;
+
+void main()
+{
+	gl_Position = viewProj * vec4(inPosition, 1.0);
+	fragTexCoord = inTexCoord;
+	fragPosition = inPosition;
+}
@@ -3,17 +3,221 @@
 
 layout(binding = 1) uniform sampler2D texSampler;
 
+// Image based lighting (IblPrecompute.h): equirectangular, Z up
+layout(set = 0, binding = 2) uniform sampler2D irradianceMap;
+layout(set = 0, binding = 3) uniform sampler2D prefilteredMap;    // mip = roughness * (levels - 1)
+layout(set = 0, binding = 4) uniform sampler2D brdfLut;           // x = NdotV, y = roughness
+
+// Clustered point lights (ClusteredLights.h): lights + froxel grid parameters,
+// and the per-cluster light lists written by cluster_cull.comp
+const uint CLUSTER_GRID_X = 16;
+const uint CLUSTER_GRID_Y = 9;
+const uint CLUSTER_GRID_Z = 24;
+const uint CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+const uint MAX_LIGHTS_PER_CLUSTER = 256;
+
+struct PointLight
+{
+	vec4 positionRadius;    // world space
+	vec4 colorIntensity;
+};
+
+layout(std430, set = 0, binding = 5) readonly buffer LightBuffer
+{
+	mat4  view;
+	vec4  projection;       // tan(fovX / 2), tan(fovY / 2), near, far
+	vec4  screen;           // width, height, depth slice scale, depth slice bias
+	uvec4 lightCount;
+	PointLight lights[];
+};
+
+layout(std430, set = 0, binding = 6) readonly buffer ClusterBuffer
+{
+	uint lightCounts[CLUSTER_COUNT];
+	uint lightIndices[];    // MAX_LIGHTS_PER_CLUSTER per cluster
+};
+
+// Sun shadow cascades (ShadowCascades.h): one depth layer per cascade, same UBO as shaders.vert
+const uint SHADOW_CASCADE_COUNT = 4;
+
+layout(set = 0, binding = 0) uniform UniformBufferObject
+{
+	mat4 model;
+	mat4 view;
+	mat4 proj;
+	vec3 camPos;
+	mat4 cascadeViewProj[SHADOW_CASCADE_COUNT];
+	vec4 cascadeSplits;
+	vec4 sun;
+}ubo;
+
+layout(set = 0, binding = 7) uniform sampler2DArrayShadow shadowMap;
+
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec3 fragWorldPos;
+layout(location = 3) in vec3 fragViewDir;
 
 layout(location = 0) out vec4 outColor;
 
+// Shader variants: specialization constants, constant_id = ShaderFeature bit (ShaderVariants.h).
+// The pipeline is compiled per feature set with the disabled branches folded away.
+layout(constant_id = 0) const bool ALPHA_TEST = false;
+layout(constant_id = 1) const bool VERTEX_COLOR = false;
+layout(constant_id = 2) const bool UV_DEBUG = false;
+layout(constant_id = 3) const bool UV_TILING = false;
+layout(constant_id = 4) const bool IBL = false;
+layout(constant_id = 5) const bool CLUSTERED_LIGHTS = false;
+layout(constant_id = 6) const bool SHADOWS = false;
+layout(constant_id = 7) const bool OVERDRAW = false;
+
+const float ALPHA_CUTOFF = 0.5;
+
+// no material maps yet: one roughness/metallic for the whole model
+const float ROUGHNESS = 0.6;
+const float METALLIC = 0.0;
+const float PI = 3.14159265358979;
+const vec3 SUN_COLOR = vec3(1.0, 0.95, 0.85);
+
+vec2 directionToUv(vec3 direction)
+{
+	return vec2(atan(direction.y, direction.x) * (0.5 / PI) + 0.5, acos(clamp(direction.z, -1.0, 1.0)) / PI);
+}
+
+// The vertex format has no normals, so the face normal comes from
+// screen-space derivatives of the world position (flipped towards the viewer).
+vec3 faceNormal(vec3 v)
+{
+	vec3 n = normalize(cross(dFdx(fragWorldPos), dFdy(fragWorldPos)));
+	return (dot(n, v) < 0.0) ? -n : n;
+}
+
+// split-sum ambient term
+vec3 ambientLighting(vec3 albedo)
+{
+	vec3 v = normalize(fragViewDir);
+	vec3 n = faceNormal(v);
+	float nDotV = max(dot(n, v), 1e-4);
+
+	vec3 f0 = mix(vec3(0.04), albedo, METALLIC);
+	vec3 fresnel = f0 + (max(vec3(1.0 - ROUGHNESS), f0) - f0) * pow(1.0 - nDotV, 5.0);    // Schlick with roughness
+
+	vec3 diffuse = texture(irradianceMap, directionToUv(n)).rgb * albedo * (1.0 - fresnel) * (1.0 - METALLIC);
+
+	float lod = ROUGHNESS * float(textureQueryLevels(prefilteredMap) - 1);
+	vec3 prefiltered = textureLod(prefilteredMap, directionToUv(reflect(-v, n)), lod).rgb;
+	vec2 brdf = texture(brdfLut, vec2(nDotV, ROUGHNESS)).rg;
+	vec3 specular = prefiltered * (fresnel * brdf.x + brdf.y);
+
+	return diffuse + specular;
+}
+
+// diffuse light of the point lights binned into this fragment's cluster;
+// same slice mapping as CClusteredLights::getClusterIndex()
+vec3 pointLighting(vec3 albedo)
+{
+	float viewDepth = -(view * vec4(fragWorldPos, 1.0)).z;
+	uvec2 tile = min(uvec2(gl_FragCoord.xy / screen.xy * vec2(CLUSTER_GRID_X, CLUSTER_GRID_Y)), uvec2(CLUSTER_GRID_X - 1u, CLUSTER_GRID_Y - 1u));
+	uint slice = uint(clamp(log(viewDepth) * screen.z + screen.w, 0.0, float(CLUSTER_GRID_Z - 1u)));
+	uint cluster = tile.x + CLUSTER_GRID_X * (tile.y + CLUSTER_GRID_Y * slice);
+
+	vec3 n = faceNormal(normalize(fragViewDir));
+	vec3 color = vec3(0.0);
+	uint count = lightCounts[cluster];
+	for (uint i = 0u; i < count; i++)
+	{
+		PointLight light = lights[lightIndices[cluster * MAX_LIGHTS_PER_CLUSTER + i]];
+		vec3 toLight = light.positionRadius.xyz - fragWorldPos;
+		float lightDistance = length(toLight);
+		float falloff = clamp(1.0 - pow(lightDistance / light.positionRadius.w, 4.0), 0.0, 1.0);    // windowed inverse square, zero at the radius
+		float attenuation = falloff * falloff / (lightDistance * lightDistance + 0.01);
+		color += light.colorIntensity.rgb * light.colorIntensity.a * attenuation * max(dot(n, toLight / lightDistance), 0.0);
+	}
+	return color * albedo * (1.0 - METALLIC) / PI;
+}
+
+// Lit fraction of the sun: first cascade whose slice holds the view depth (falls through to the
+// next one at a cascade's outer edge), 3x3 PCF of hardware depth comparisons. The depth bias is
+// applied when the map is rendered. textureGrad: the lookup is in non-uniform control flow.
+float sunShadow(float viewDepth)
+{
+	uint cascade = 0u;
+	while (cascade < SHADOW_CASCADE_COUNT - 1u && viewDepth > ubo.cascadeSplits[cascade])
+	{
+		cascade++;
+	}
+
+	for (; cascade < SHADOW_CASCADE_COUNT; cascade++)
+	{
+		vec4 shadowPos = ubo.cascadeViewProj[cascade] * vec4(fragWorldPos, 1.0);
+		vec3 coordinates = vec3(shadowPos.xy * 0.5 + 0.5, shadowPos.z);
+		if (any(lessThan(coordinates, vec3(0.0))) || any(greaterThan(coordinates, vec3(1.0))))
+		{
+			continue;
+		}
+
+		vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+		float lit = 0.0;
+		for (int y = -1; y <= 1; y++)
+		{
+			for (int x = -1; x <= 1; x++)
+			{
+				vec4 lookup = vec4(coordinates.xy + vec2(x, y) * texel, float(cascade), coordinates.z);
+				lit += textureGrad(shadowMap, lookup, vec2(0.0), vec2(0.0));
+			}
+		}
+		return lit / 9.0;
+	}
+	return 1.0;    // beyond the last cascade
+}
+
+// direct sun light, Lambert
+vec3 sunLighting(vec3 albedo)
+{
+	vec3 n = faceNormal(normalize(fragViewDir));
+	float nDotL = max(dot(n, ubo.sun.xyz), 0.0);
+	if (nDotL <= 0.0)
+	{
+		return vec3(0.0);
+	}
+	float viewDepth = -(ubo.view * vec4(fragWorldPos, 1.0)).z;
+	return SUN_COLOR * ubo.sun.w * nDotL * sunShadow(viewDepth) * albedo * (1.0 - METALLIC) / PI;
+}
+
 // main shader code
 void main() {	
 
-	outColor = texture(texSampler, fragTexCoord);
+	vec2 uv = UV_TILING ? fragTexCoord * 2.0 : fragTexCoord;    // Tiling
+	outColor = texture(texSampler, uv);
 
-	// outColor = vec4(fragTexCoord, 0.0, 1.0);               // Green: Horizontal,  Red: Vertical
-    // outColor = texture(texSampler, fragTexCoord * 2.0);    // Tiling
+	if (VERTEX_COLOR)
+	{
+		outColor.rgb *= fragColor;
+	}
+	if (IBL || CLUSTERED_LIGHTS || SHADOWS)
+	{
+		vec3 color = IBL ? ambientLighting(outColor.rgb) : vec3(0.0);
+		if (CLUSTERED_LIGHTS)
+		{
+			color += pointLighting(outColor.rgb);
+		}
+		if (SHADOWS)
+		{
+			color += sunLighting(outColor.rgb);
+		}
+		outColor.rgb = color / (color + 1.0);    // Reinhard
+	}
+	if (ALPHA_TEST && outColor.a < ALPHA_CUTOFF)
+	{
+		discard;
+	}
+	if (UV_DEBUG)
+	{
+		outColor = vec4(fragTexCoord, 0.0, 1.0);                // Green: Horizontal,  Red: Vertical
+	}
+	if (OVERDRAW)
+	{
+		outColor = vec4(0.1, 0.05, 0.025, 1.0);    // added per shaded fragment (additive blending): red, orange, then white
+	}
 }
 
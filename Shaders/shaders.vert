@@ -6,17 +6,30 @@ layout(binding = 0) uniform UniformBufferObject
 	mat4 model;
 	mat4 view;
 	mat4 proj;
+	vec3 camPos;
+	mat4 cascadeViewProj[4];    // sun shadow cascades (ShadowCascades.h): world -> shadow clip space
+	vec4 cascadeSplits;         // far view depth of every cascade
+	vec4 sun;                   // xyz = direction towards the sun, w = intensity
 }ubo;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec4 inInstance;    // per instance (binding 1): xyz position, w scale; (0, 0, 0, 1) for the model itself
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragWorldPos;    // IBL: flat normal from derivatives
+layout(location = 3) out vec3 fragViewDir;     // IBL: surface to camera, world space
+
+// the depth prepass and the main pass (depth compare EQUAL) are separate pipelines: both must compute the same depth
+invariant gl_Position;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+	vec4 worldPos = ubo.model * vec4(inPosition * inInstance.w, 1.0) + vec4(inInstance.xyz, 0.0);
+    gl_Position = ubo.proj * ubo.view * worldPos;
     fragColor = inColor;
 	fragTexCoord = inTexCoord;
+	fragWorldPos = worldPos.xyz;
+	fragViewDir = ubo.camPos - worldPos.xyz;
 }
@@ -0,0 +1,17 @@
+#version 450
+
+// Depth-only pass of the sun's shadow cascades (ShadowPass.cpp): one
+// render pass per re-rendered cascade, the cascade's light viewProj
+// times the model matrix in a push constant.
+
+layout(push_constant) uniform ShadowPush
+{
+	mat4 lightModelViewProj;
+};
+
+layout(location = 0) in vec3 inPosition;
+
+void main()
+{
+	gl_Position = lightModelViewProj * vec4(inPosition, 1.0);
+}
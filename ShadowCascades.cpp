@@ -0,0 +1,361 @@
+/*======================================================================
+VulkanPBR_AcornForest : ShadowCascades.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE    // before the first glm include: light projections map depth to 0..1 like Vulkan
+#include "ShadowCascades.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	// rotation only, so snapping in light space does not depend on where the camera is
+	glm::mat4 makeLightView(const glm::vec3& sunDirection)
+	{
+		glm::vec3 up = (std::abs(sunDirection.z) > 0.99f) ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f);
+		return glm::lookAt(glm::vec3(0.0f), -sunDirection, up);
+	}
+
+	// bounding sphere of a view-space frustum slice: on the view axis, so it does not change when the camera turns
+	void getSliceSphere(float tanX, float tanY, float sliceNear, float sliceFar, float& depth, float& radius)
+	{
+		// center depth minimizing the larger distance to the near and far corner rings
+		float nearSq = (tanX * tanX + tanY * tanY) * sliceNear * sliceNear;
+		float farSq = (tanX * tanX + tanY * tanY) * sliceFar * sliceFar;
+		depth = 0.5f * (sliceNear + sliceFar) + 0.5f * (farSq - nearSq) / (sliceFar - sliceNear);
+		depth = std::min(depth, sliceFar);
+		radius = std::sqrt(std::max((sliceFar - depth) * (sliceFar - depth) + farSq, (depth - sliceNear) * (depth - sliceNear) + nearSq));
+	}
+}
+
+void CShadowCascades::update(const glm::mat4& view, const glm::mat4& proj, const glm::vec3& sunDirection, const glm::mat4& model,
+	const std::vector<ShadowCaster>& casters)
+{
+	// near/far and field of view from the perspective matrix (depth 0..1)
+	float nearPlane = proj[3][2] / proj[2][2];
+	float farPlane = proj[3][2] / (proj[2][2] + 1.0f);
+	float tanX = 1.0f / std::abs(proj[0][0]);
+	float tanY = 1.0f / std::abs(proj[1][1]);
+	glm::mat4 inverseView = glm::inverse(view);
+	glm::vec3 sun = glm::normalize(sunDirection);
+	float cosThreshold = std::cos(glm::radians(m_Settings.sunThresholdDegrees));
+
+	float sliceNear = nearPlane;
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		ShadowCascade& cascade = m_Cascades[i];
+
+		float t = static_cast<float>(i + 1) / SHADOW_CASCADE_COUNT;
+		float uniformSplit = nearPlane + (farPlane - nearPlane) * t;
+		float logSplit = nearPlane * std::pow(farPlane / nearPlane, t);
+		cascade.splitNear = sliceNear;
+		cascade.splitFar = (i + 1 == SHADOW_CASCADE_COUNT) ? farPlane : uniformSplit + (logSplit - uniformSplit) * m_Settings.splitLambda;
+		sliceNear = cascade.splitFar;
+
+		float depth, radius;
+		getSliceSphere(tanX, tanY, cascade.splitNear, cascade.splitFar, depth, radius);
+		glm::vec3 worldCenter = glm::vec3(inverseView * glm::vec4(0.0f, 0.0f, -depth, 1.0f));
+		float texel = 2.0f * radius / m_Settings.mapSize;
+
+		// keep the cached layer unless the sun, the bounds or a dynamic caster says otherwise
+		bool render = (m_Valid == false) || cascade.hasDynamic || std::abs(radius - cascade.radius) > 0.5f * texel
+			|| glm::dot(sun, cascade.sunDirection) < cosThreshold;
+		if (render == false)
+		{
+			glm::vec2 center = glm::vec2(makeLightView(cascade.sunDirection) * glm::vec4(worldCenter, 1.0f));
+			render = glm::length(center - cascade.center) > m_Settings.boundsThresholdTexels * texel;
+		}
+		if (render == false)
+		{
+			bool hasDynamic = false;
+			cullCasters(cascade, model, casters, cascade.casters, hasDynamic);
+			render = hasDynamic;
+		}
+
+		if (render == false)
+		{
+			cascade.render = false;
+			cascade.casters.clear();
+			cascade.framesCached++;
+			continue;
+		}
+
+		// new light projection: snapped to whole texels, depth range from the sun side of the scene to the far side of the slice
+		glm::mat4 lightView = makeLightView(sun);
+		glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(worldCenter, 1.0f));
+		glm::vec3 sceneCenter = glm::vec3(lightView * glm::vec4(m_SceneCenter, 1.0f));
+		glm::vec2 center = glm::floor(glm::vec2(lightCenter) / texel) * texel;
+		float maxZ = std::max(lightCenter.z + radius, sceneCenter.z + m_SceneRadius);
+		float minZ = lightCenter.z - radius;
+		glm::mat4 lightProj = glm::ortho(center.x - radius, center.x + radius, center.y - radius, center.y + radius, -maxZ, -minZ);
+
+		cascade.viewProj = lightProj * lightView;
+		cascade.sunDirection = sun;
+		cascade.center = center;
+		cascade.radius = radius;
+		cascade.render = true;
+		cascade.framesCached = 0;
+		cullCasters(cascade, model, casters, cascade.casters, cascade.hasDynamic);
+		cascade.lastDrawCount = static_cast<uint32_t>(cascade.casters.size());
+	}
+	m_Valid = true;
+}
+
+void CShadowCascades::cullCasters(const ShadowCascade& cascade, const glm::mat4& model, const std::vector<ShadowCaster>& casters,
+	std::vector<uint32_t>& visible, bool& hasDynamic) const
+{
+	visible.clear();
+	hasDynamic = false;
+	glm::mat4 toClip = cascade.viewProj * model;    // orthographic: w stays 1
+	for (uint32_t i = 0; i < casters.size(); i++)
+	{
+		const ShadowCaster& caster = casters[i];
+		glm::vec3 clipMin(1e30f), clipMax(-1e30f);
+		for (uint32_t corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 position((corner & 1) ? caster.boundsMax.x : caster.boundsMin.x, (corner & 2) ? caster.boundsMax.y : caster.boundsMin.y,
+				(corner & 4) ? caster.boundsMax.z : caster.boundsMin.z);
+			glm::vec3 clip = glm::vec3(toClip * glm::vec4(position, 1.0f));
+			clipMin = glm::min(clipMin, clip);
+			clipMax = glm::max(clipMax, clip);
+		}
+		if (clipMax.x < -1.0f || clipMin.x > 1.0f || clipMax.y < -1.0f || clipMin.y > 1.0f || clipMax.z < 0.0f || clipMin.z > 1.0f)
+		{
+			continue;
+		}
+		visible.push_back(i);
+		hasDynamic = hasDynamic || caster.dynamic;
+	}
+}
+
+uint32_t CShadowCascades::getRenderedCount() const
+{
+	uint32_t count = 0;
+	for (const ShadowCascade& cascade : m_Cascades)
+	{
+		count += cascade.render ? 1 : 0;
+	}
+	return count;
+}
+
+std::vector<ShadowCaster> CShadowCascades::buildCasters(const float* positions, size_t stride, std::vector<uint32_t>& indices, uint32_t grid)
+{
+	auto position = [&](uint32_t vertex)
+	{
+		const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + stride * vertex);
+		return glm::vec3(p[0], p[1], p[2]);
+	};
+
+	glm::vec3 modelMin(1e30f), modelMax(-1e30f);
+	for (uint32_t index : indices)
+	{
+		modelMin = glm::min(modelMin, position(index));
+		modelMax = glm::max(modelMax, position(index));
+	}
+	glm::vec2 cellSize = glm::max(glm::vec2(modelMax - modelMin) / static_cast<float>(grid), glm::vec2(1e-6f));
+
+	// chunk of every triangle by its centroid, then a counting sort of the triangles by chunk
+	uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	std::vector<uint32_t> triangleChunks(triangleCount);
+	std::vector<uint32_t> chunkOffsets(grid * grid + 1, 0);
+	for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+	{
+		glm::vec3 centroid = (position(indices[3 * triangle]) + position(indices[3 * triangle + 1]) + position(indices[3 * triangle + 2])) / 3.0f;
+		glm::uvec2 cell = glm::min(glm::uvec2((glm::vec2(centroid) - glm::vec2(modelMin)) / cellSize), glm::uvec2(grid - 1));
+		triangleChunks[triangle] = cell.x + grid * cell.y;
+		chunkOffsets[triangleChunks[triangle] + 1]++;
+	}
+	for (uint32_t chunk = 0; chunk < grid * grid; chunk++)
+	{
+		chunkOffsets[chunk + 1] += chunkOffsets[chunk];
+	}
+
+	std::vector<uint32_t> sorted(triangleCount * 3);
+	std::vector<uint32_t> cursors(chunkOffsets.begin(), chunkOffsets.end() - 1);
+	for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+	{
+		uint32_t target = cursors[triangleChunks[triangle]]++;
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			sorted[3 * target + corner] = indices[3 * triangle + corner];
+		}
+	}
+	indices.swap(sorted);
+
+	std::vector<ShadowCaster> casters;
+	for (uint32_t chunk = 0; chunk < grid * grid; chunk++)
+	{
+		if (chunkOffsets[chunk] == chunkOffsets[chunk + 1])
+		{
+			continue;
+		}
+		ShadowCaster caster;
+		caster.firstIndex = 3 * chunkOffsets[chunk];
+		caster.indexCount = 3 * (chunkOffsets[chunk + 1] - chunkOffsets[chunk]);
+		caster.boundsMin = glm::vec3(1e30f);
+		caster.boundsMax = glm::vec3(-1e30f);
+		for (uint32_t i = caster.firstIndex; i < caster.firstIndex + caster.indexCount; i++)
+		{
+			caster.boundsMin = glm::min(caster.boundsMin, position(indices[i]));
+			caster.boundsMax = glm::max(caster.boundsMax, position(indices[i]));
+		}
+		casters.push_back(caster);
+	}
+	return casters;
+}
+
+bool CShadowCascades::selfTest()
+{
+	bool passed = true;
+	auto check = [&](bool condition, const char* what)
+	{
+		if (condition == false)
+		{
+			printf("  FAILED: %s\n", what);
+			passed = false;
+		}
+	};
+
+	// a 32 x 32 quad ground with a few raised quads, 2 x 2 units around the origin like the model
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> indices;
+	const uint32_t quads = 32;
+	for (uint32_t y = 0; y <= quads; y++)
+	{
+		for (uint32_t x = 0; x <= quads; x++)
+		{
+			float height = ((x / 4 + y / 4) % 5 == 0) ? 0.5f : 0.0f;
+			positions.push_back(glm::vec3(2.0f * x / quads - 1.0f, 2.0f * y / quads - 1.0f, height));
+		}
+	}
+	for (uint32_t y = 0; y < quads; y++)
+	{
+		for (uint32_t x = 0; x < quads; x++)
+		{
+			uint32_t corner = x + (quads + 1) * y;
+			for (uint32_t index : { corner, corner + 1, corner + quads + 2, corner, corner + quads + 2, corner + quads + 1 })
+			{
+				indices.push_back(index);
+			}
+		}
+	}
+
+	// chunking keeps every triangle and bounds it
+	auto sortedTriangles = [](const std::vector<uint32_t>& list)
+	{
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (size_t i = 0; i < list.size(); i += 3)
+		{
+			triangles.push_back({ list[i], list[i + 1], list[i + 2] });
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	};
+	std::vector<uint32_t> chunked = indices;
+	std::vector<ShadowCaster> casters = buildCasters(&positions[0].x, sizeof(glm::vec3), chunked, 4);
+	check(casters.size() == 16, "4 x 4 chunks over a full grid");
+	check(sortedTriangles(chunked) == sortedTriangles(indices), "chunking reorders triangles without changing them");
+	uint32_t coveredIndices = 0;
+	bool bounded = true;
+	for (const ShadowCaster& caster : casters)
+	{
+		coveredIndices += caster.indexCount;
+		for (uint32_t i = caster.firstIndex; i < caster.firstIndex + caster.indexCount; i++)
+		{
+			glm::vec3 p = positions[chunked[i]];
+			bounded = bounded && glm::all(glm::greaterThanEqual(p, caster.boundsMin)) && glm::all(glm::lessThanEqual(p, caster.boundsMax));
+		}
+	}
+	check(coveredIndices == chunked.size() && bounded, "chunks cover the index buffer and bound their triangles");
+
+	// same camera as the renderer, 16:9
+	glm::vec3 eye(2.0f, 2.0f, 2.0f);
+	glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 10.0f);
+	proj[1][1] *= -1.0f;
+	glm::vec3 sun = glm::normalize(glm::vec3(0.4f, 0.3f, 0.85f));
+	glm::mat4 model(1.0f);
+
+	CShadowCascades cascades;
+	cascades.setSceneBounds(glm::vec3(0.0f), std::sqrt(2.0f) + 0.5f);
+	cascades.update(view, proj, sun, model, casters);
+	check(cascades.getRenderedCount() == SHADOW_CASCADE_COUNT, "first update renders every cascade");
+	check(std::abs(cascades.getCascade(0).splitNear - 0.1f) < 1e-4f && std::abs(cascades.getCascade(SHADOW_CASCADE_COUNT - 1).splitFar - 10.0f) < 1e-3f,
+		"cascades span near to far");
+
+	// every point of every slice lands inside its cascade's map and depth range
+	uint32_t outside = 0;
+	glm::mat4 inverseView = glm::inverse(view);
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		const ShadowCascade& cascade = cascades.getCascade(i);
+		printf("Cascade %u: %6.3f - %6.3f, radius %6.3f, %2u casters\n", i, cascade.splitNear, cascade.splitFar, cascade.radius,
+			static_cast<uint32_t>(cascade.casters.size()));
+		for (uint32_t s = 0; s < 1000; s++)
+		{
+			float u = (s % 10) / 9.0f * 2.0f - 1.0f;
+			float v = ((s / 10) % 10) / 9.0f * 2.0f - 1.0f;
+			float depth = cascade.splitNear + (cascade.splitFar - cascade.splitNear) * ((s / 100) / 9.0f);
+			glm::vec4 viewPoint(u * depth / proj[0][0], v * depth / std::abs(proj[1][1]), -depth, 1.0f);
+			glm::vec3 clip = glm::vec3(cascade.viewProj * inverseView * viewPoint);
+			outside += (std::abs(clip.x) > 1.0f || std::abs(clip.y) > 1.0f || clip.z < 0.0f || clip.z > 1.0f) ? 1 : 0;
+		}
+	}
+	check(outside == 0, "cascade maps cover their slices");
+
+	// a static scene stays cached, also when the camera moves by less than the threshold
+	cascades.update(view, proj, sun, model, casters);
+	check(cascades.getRenderedCount() == 0, "static scene: every cascade cached");
+	glm::mat4 cachedViewProj = cascades.getCascade(1).viewProj;
+	glm::mat4 nudged = glm::lookAt(eye + glm::vec3(0.0005f, 0.0f, 0.0f), glm::vec3(0.0005f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	cascades.update(nudged, proj, sun, model, casters);
+	check(cascades.getRenderedCount() == 0 && cascades.getCascade(1).viewProj == cachedViewProj, "sub-threshold camera move keeps the cache");
+
+	glm::mat4 moved = glm::lookAt(eye + glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	cascades.update(moved, proj, sun, model, casters);
+	check(cascades.getRenderedCount() == SHADOW_CASCADE_COUNT, "camera move past the threshold re-renders");
+	cascades.update(moved, proj, sun, model, casters);
+
+	// sun: below the threshold cached, beyond it re-rendered
+	glm::vec3 sunSmall = glm::vec3(glm::rotate(glm::mat4(1.0f), glm::radians(0.2f), glm::vec3(0.0f, 0.0f, 1.0f)) * glm::vec4(sun, 0.0f));
+	cascades.update(moved, proj, sunSmall, model, casters);
+	check(cascades.getRenderedCount() == 0, "sun turn below the threshold keeps the cache");
+	glm::vec3 sunLarge = glm::vec3(glm::rotate(glm::mat4(1.0f), glm::radians(1.0f), glm::vec3(0.0f, 0.0f, 1.0f)) * glm::vec4(sun, 0.0f));
+	cascades.update(moved, proj, sunLarge, model, casters);
+	check(cascades.getRenderedCount() == SHADOW_CASCADE_COUNT, "sun turn past the threshold re-renders");
+
+	// dynamic casters: cascades that see them render every frame, the others stay cached
+	cascades.update(view, proj, sun, model, casters);
+	std::vector<ShadowCaster> dynamicCasters = casters;
+	for (ShadowCaster& caster : dynamicCasters)
+	{
+		caster.dynamic = true;
+	}
+	cascades.update(view, proj, sun, model, dynamicCasters);
+	bool consistent = true;
+	uint32_t seeing = 0;
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		const ShadowCascade& cascade = cascades.getCascade(i);
+		consistent = consistent && (cascade.render == (cascade.casters.empty() == false));
+		seeing += cascade.render ? 1 : 0;
+	}
+	printf("Dynamic casters: %u of %u cascades re-render\n", seeing, SHADOW_CASCADE_COUNT);
+	check(seeing > 0 && consistent, "exactly the cascades with dynamic casters re-render");
+	cascades.update(view, proj, sun, model, dynamicCasters);
+	check(cascades.getRenderedCount() == seeing, "dynamic casters re-render every frame");
+	cascades.update(view, proj, sun, model, casters);
+	check(cascades.getRenderedCount() == seeing, "casters that stopped moving are rendered once more");
+	cascades.update(view, proj, sun, model, casters);
+	check(cascades.getRenderedCount() == 0, "then cached again");
+
+	printf(passed ? "Shadow cascades: all checks passed\n" : "Shadow cascades: FAILED\n");
+	return passed;
+}
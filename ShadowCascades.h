@@ -0,0 +1,102 @@
+/*======================================================================
+VulkanPBR_AcornForest : ShadowCascades.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Cascaded shadow maps for the sun: split placement, light matrices and
+the cascade cache. The camera frustum of ubo.view/proj is cut into
+SHADOW_CASCADE_COUNT depth slices (practical split, a blend of uniform
+and logarithmic); each slice gets an orthographic light projection
+around its bounding sphere, snapped to whole shadow map texels so a
+camera that moves a little does not make the map shimmer or change.
+
+Cascades are cached: a cascade's layer is only re-rendered when
+  - the sun turned further than sunThresholdDegrees since its last render,
+  - its snapped bounds moved more than boundsThresholdTexels,
+  - it contains (or contained at its last render) a dynamic caster.
+A cached cascade keeps the matrix it was rendered with, and that matrix
+is what the fragment shaders sample with, so map and lookup always match.
+Far cascades that only see static geometry are rendered once.
+
+Shadow casters are ranges of the model's index buffer (buildCasters()
+splits the model into a grid of chunks), culled per cascade against the
+light-space box.
+=======================================================================*/
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// keep in sync with the fragment shaders
+const uint32_t SHADOW_CASCADE_COUNT = 4;
+
+struct ShadowCaster
+{
+	uint32_t    firstIndex = 0;
+	uint32_t    indexCount = 0;
+	glm::vec3   boundsMin = glm::vec3(0.0f);    // model space
+	glm::vec3   boundsMax = glm::vec3(0.0f);
+	bool        dynamic = false;                // moves between frames: cascades that see it are never cached
+};
+
+struct ShadowSettings
+{
+	uint32_t    mapSize = 2048;                 // per cascade
+	float       splitLambda = 0.75f;            // 0 = uniform splits, 1 = logarithmic
+	float       sunThresholdDegrees = 0.5f;
+	float       boundsThresholdTexels = 4.0f;
+};
+
+struct ShadowCascade
+{
+	glm::mat4               viewProj = glm::mat4(1.0f);    // world -> shadow clip space, as last rendered
+	float                   splitNear = 0.0f;              // view depth range of the slice
+	float                   splitFar = 0.0f;
+	bool                    render = false;                // re-rendered this frame
+	bool                    hasDynamic = false;            // the map holds dynamic casters
+	std::vector<uint32_t>   casters;                       // caster indices drawn this frame (empty when cached)
+	uint32_t                lastDrawCount = 0;             // draws of the last render
+	uint32_t                framesCached = 0;              // frames since the last render
+
+	// light space parameters of the last render
+	glm::vec3               sunDirection = glm::vec3(0.0f);
+	glm::vec2               center = glm::vec2(0.0f);
+	float                   radius = 0.0f;
+};
+
+class CShadowCascades
+{
+private:
+
+	ShadowSettings  m_Settings;
+	ShadowCascade   m_Cascades[SHADOW_CASCADE_COUNT];
+	bool            m_Valid = false;               // false: every cascade renders on the next update()
+	glm::vec3       m_SceneCenter = glm::vec3(0.0f);
+	float           m_SceneRadius = 1.0f;          // bounds every caster in every frame (light-space depth range)
+
+	void cullCasters(const ShadowCascade& cascade, const glm::mat4& model, const std::vector<ShadowCaster>& casters,
+		std::vector<uint32_t>& visible, bool& hasDynamic) const;
+
+public:
+
+	void setSettings(const ShadowSettings& settings) { m_Settings = settings; m_Valid = false; }
+	const ShadowSettings& getSettings() const { return m_Settings; }
+	void setSceneBounds(const glm::vec3& center, float radius) { m_SceneCenter = center; m_SceneRadius = radius; m_Valid = false; }
+	void invalidate() { m_Valid = false; }    // the maps were lost (recreated) or the settings changed
+
+	// sunDirection points towards the sun. Decides which cascades render this frame and their casters.
+	void update(const glm::mat4& view, const glm::mat4& proj, const glm::vec3& sunDirection, const glm::mat4& model,
+		const std::vector<ShadowCaster>& casters);
+
+	const ShadowCascade& getCascade(uint32_t index) const { return m_Cascades[index]; }
+	uint32_t getRenderedCount() const;
+
+	// Reorders indices (triangle lists) into grid x grid chunks over the model's XY bounds and returns one caster per
+	// non-empty chunk. Every triangle keeps its vertices, so a single draw of all indices still renders the model.
+	static std::vector<ShadowCaster> buildCasters(const float* positions, size_t stride, std::vector<uint32_t>& indices, uint32_t grid);
+
+	// CPU-only checks: slice coverage, texel snapping, cache invalidation and chunking
+	static bool selfTest();
+};
@@ -0,0 +1,74 @@
+/*======================================================================
+VulkanPBR_AcornForest : ShadowPass.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Depth-only rendering of the sun's shadow cascades (Shaders/shadow.vert).
+The shadow map is one depth image with SHADOW_CASCADE_COUNT layers,
+owned by the renderer; each layer has its own framebuffer so a cached
+cascade is simply not recorded and keeps its contents. Every recorded
+layer is cleared and drawn in DEPTH_STENCIL_ATTACHMENT_OPTIMAL; the
+frame graph (RenderGraph.h) moves the whole map into that layout after
+earlier frames' fragment shader reads and back to SHADER_READ_ONLY_OPTIMAL
+before this frame's.
+
+Casters are drawn one index range each (ShadowCaster), with a constant
+and slope-scaled depth bias against shadow acne. The render pass and the
+views exist without the pipeline (no shadow.spv): the map is then only
+cleared once, so the fragment shaders still have a valid, fully lit map.
+=======================================================================*/
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "ShadowCascades.h"
+
+#include <vector>
+
+class CShadowPass
+{
+private:
+
+	VkDevice            m_Device = VK_NULL_HANDLE;
+	VkFormat            m_Format = VK_FORMAT_UNDEFINED;
+	uint32_t            m_Size = 0;
+	VkRenderPass        m_RenderPass = VK_NULL_HANDLE;
+	VkPipelineLayout    m_PipelineLayout = VK_NULL_HANDLE;
+	VkPipeline          m_Pipeline = VK_NULL_HANDLE;
+	VkImageView         m_ArrayView = VK_NULL_HANDLE;                       // all cascades, for sampling
+	VkImageView         m_LayerViews[SHADOW_CASCADE_COUNT] = {};
+	VkFramebuffer       m_Framebuffers[SHADOW_CASCADE_COUNT] = {};
+	VkImage             m_Image = VK_NULL_HANDLE;
+
+	void createRenderPass();
+	void beginPass(VkCommandBuffer commandBuffer, uint32_t cascade);
+	VkImageView createView(VkImage image, VkImageViewType viewType, uint32_t baseLayer, uint32_t layerCount);
+
+public:
+
+	// depth format usable as attachment and sampled image (D32, else D16); VK_FORMAT_UNDEFINED if neither
+	static VkFormat findFormat(VkPhysicalDevice physicalDevice);
+
+	// render pass only; size x size per cascade
+	void create(VkDevice device, VkFormat format, uint32_t size);
+	// position: the vertex attribute with the model space position (location 0 in shadow.vert)
+	void createPipeline(const std::vector<char>& shaderCode, VkPipelineCache pipelineCache,
+		const VkVertexInputBindingDescription& binding, const VkVertexInputAttributeDescription& position);
+	void destroy();
+	bool isCreated() const { return m_Pipeline != VK_NULL_HANDLE; }    // casters can be recorded
+
+	// views and framebuffers of the shadow map: size x size, format, SHADOW_CASCADE_COUNT layers
+	void setImage(VkImage image);
+	VkImageView getView() const { return m_ArrayView; }
+	VkImageSubresourceRange getRange() const;    // every layer
+	VkFormat getFormat() const { return m_Format; }
+	uint32_t getSize() const { return m_Size; }
+
+	// clears every layer to the far plane and leaves it ready for sampling (once, after setImage())
+	void clear(VkCommandBuffer commandBuffer);
+
+	// clears cascade's layer and draws the visible casters; lightModelViewProj = cascade viewProj * model.
+	// The map must be in the attachment layout (declareForestFrame()'s shadow pass)
+	void record(VkCommandBuffer commandBuffer, uint32_t cascade, const glm::mat4& lightModelViewProj, VkBuffer vertexBuffer, VkBuffer indexBuffer,
+		const std::vector<ShadowCaster>& casters, const std::vector<uint32_t>& visible);
+};
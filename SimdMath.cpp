@@ -0,0 +1,684 @@
+/*======================================================================
+VulkanPBR_AcornForest : SimdMath.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE    // before the first glm include: the self test builds projections like the renderer
+#include "SimdMath.h"
+#include "BenchUtil.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_MATH_SSE2 1
+#endif
+
+// AVX2 kernels are compiled for that target only (the rest of the program stays SSE2) and picked at runtime
+#if defined(_M_X64) || defined(__x86_64__)
+#include <immintrin.h>
+#define SIMD_MATH_AVX2 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SIMD_TARGET_AVX2
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace
+{
+	const char* LEVEL_NAMES[static_cast<uint32_t>(SimdLevel::Count)] = { "scalar", "SSE2", "AVX2" };
+
+	SimdLevel detectSimdLevel()
+	{
+#ifdef SIMD_MATH_AVX2
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		bool fma = (info[2] & (1 << 12)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		__cpuidex(info, 7, 0);
+		bool avx2 = (info[1] & (1 << 5)) != 0;
+		bool osSavesYmm = osxsave && (_xgetbv(0) & 6) == 6;    // the OS saves the AVX registers on context switches
+		if (avx2 && fma && osSavesYmm)
+		{
+			return SimdLevel::AVX2;
+		}
+#else
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			return SimdLevel::AVX2;
+		}
+#endif
+#endif
+#ifdef SIMD_MATH_SSE2
+		return SimdLevel::SSE2;
+#else
+		return SimdLevel::Scalar;
+#endif
+	}
+
+	// ---- scalar kernels: [begin, end), also the tails of the SIMD kernels ----
+
+	void multiplyMat4Scalar(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			out[i] = a[i] * b[i];
+		}
+	}
+
+	void transformAabbsScalar(const glm::mat4& m, const AabbArrays& in, AabbArrays& out, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			float cx = (in.minX[i] + in.maxX[i]) * 0.5f, ex = (in.maxX[i] - in.minX[i]) * 0.5f;
+			float cy = (in.minY[i] + in.maxY[i]) * 0.5f, ey = (in.maxY[i] - in.minY[i]) * 0.5f;
+			float cz = (in.minZ[i] + in.maxZ[i]) * 0.5f, ez = (in.maxZ[i] - in.minZ[i]) * 0.5f;
+			float center[3], extent[3];
+			for (int row = 0; row < 3; row++)
+			{
+				center[row] = m[0][row] * cx + m[1][row] * cy + m[2][row] * cz + m[3][row];
+				extent[row] = std::abs(m[0][row]) * ex + std::abs(m[1][row]) * ey + std::abs(m[2][row]) * ez;
+			}
+			out.minX[i] = center[0] - extent[0]; out.maxX[i] = center[0] + extent[0];
+			out.minY[i] = center[1] - extent[1]; out.maxY[i] = center[1] + extent[1];
+			out.minZ[i] = center[2] - extent[2]; out.maxZ[i] = center[2] + extent[2];
+		}
+	}
+
+	uint32_t cullSpheresScalar(const FrustumPlanes& frustum, const SphereArrays& spheres, uint8_t* visible, size_t begin, size_t end)
+	{
+		uint32_t count = 0;
+		for (size_t i = begin; i < end; i++)
+		{
+			bool inside = true;
+			for (const glm::vec4& plane : frustum.planes)
+			{
+				float distance = plane.x * spheres.x[i] + plane.y * spheres.y[i] + plane.z * spheres.z[i] + plane.w;
+				inside = inside && distance >= -spheres.radius[i];
+			}
+			visible[i] = inside ? 1 : 0;
+			count += inside ? 1 : 0;
+		}
+		return count;
+	}
+
+	uint32_t cullAabbsScalar(const FrustumPlanes& frustum, const AabbArrays& boxes, uint8_t* visible, size_t begin, size_t end)
+	{
+		uint32_t count = 0;
+		for (size_t i = begin; i < end; i++)
+		{
+			bool inside = true;
+			for (const glm::vec4& plane : frustum.planes)
+			{
+				// corner furthest along the normal
+				float x = plane.x >= 0.0f ? boxes.maxX[i] : boxes.minX[i];
+				float y = plane.y >= 0.0f ? boxes.maxY[i] : boxes.minY[i];
+				float z = plane.z >= 0.0f ? boxes.maxZ[i] : boxes.minZ[i];
+				inside = inside && plane.x * x + plane.y * y + plane.z * z + plane.w >= 0.0f;
+			}
+			visible[i] = inside ? 1 : 0;
+			count += inside ? 1 : 0;
+		}
+		return count;
+	}
+
+	// ---- SSE2: 4 objects per register ----
+#ifdef SIMD_MATH_SSE2
+	inline __m128 abs4(__m128 value) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), value); }
+
+	uint32_t storeMask4(int mask, uint8_t* visible)
+	{
+		uint32_t count = 0;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			visible[lane] = static_cast<uint8_t>((mask >> lane) & 1);
+			count += visible[lane];
+		}
+		return count;
+	}
+
+	size_t multiplyMat4Sse2(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const __m128 a0 = _mm_loadu_ps(&a[i][0][0]);
+			const __m128 a1 = _mm_loadu_ps(&a[i][1][0]);
+			const __m128 a2 = _mm_loadu_ps(&a[i][2][0]);
+			const __m128 a3 = _mm_loadu_ps(&a[i][3][0]);
+			for (int column = 0; column < 4; column++)
+			{
+				const float* weights = &b[i][column][0];
+				__m128 result = _mm_mul_ps(a0, _mm_set1_ps(weights[0]));
+				result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(weights[1])));
+				result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(weights[2])));
+				result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(weights[3])));
+				_mm_storeu_ps(&out[i][column][0], result);
+			}
+		}
+		return count;
+	}
+
+	size_t transformAabbsSse2(const glm::mat4& m, const AabbArrays& in, AabbArrays& out, size_t count)
+	{
+		const __m128 half = _mm_set1_ps(0.5f);
+		size_t simdCount = count & ~size_t(3);
+		for (size_t i = 0; i < simdCount; i += 4)
+		{
+			__m128 minX = _mm_loadu_ps(&in.minX[i]), maxX = _mm_loadu_ps(&in.maxX[i]);
+			__m128 minY = _mm_loadu_ps(&in.minY[i]), maxY = _mm_loadu_ps(&in.maxY[i]);
+			__m128 minZ = _mm_loadu_ps(&in.minZ[i]), maxZ = _mm_loadu_ps(&in.maxZ[i]);
+			__m128 cx = _mm_mul_ps(_mm_add_ps(minX, maxX), half), ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+			__m128 cy = _mm_mul_ps(_mm_add_ps(minY, maxY), half), ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+			__m128 cz = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half), ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+
+			float* outMin[3] = { &out.minX[i], &out.minY[i], &out.minZ[i] };
+			float* outMax[3] = { &out.maxX[i], &out.maxY[i], &out.maxZ[i] };
+			for (int row = 0; row < 3; row++)
+			{
+				__m128 center = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[0][row]), cx), _mm_mul_ps(_mm_set1_ps(m[1][row]), cy)),
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[2][row]), cz), _mm_set1_ps(m[3][row])));
+				__m128 extent = _mm_add_ps(_mm_add_ps(_mm_mul_ps(abs4(_mm_set1_ps(m[0][row])), ex), _mm_mul_ps(abs4(_mm_set1_ps(m[1][row])), ey)),
+					_mm_mul_ps(abs4(_mm_set1_ps(m[2][row])), ez));
+				_mm_storeu_ps(outMin[row], _mm_sub_ps(center, extent));
+				_mm_storeu_ps(outMax[row], _mm_add_ps(center, extent));
+			}
+		}
+		return simdCount;
+	}
+
+	size_t cullSpheresSse2(const FrustumPlanes& frustum, const SphereArrays& spheres, uint8_t* visible, size_t count, uint32_t& visibleCount)
+	{
+		size_t simdCount = count & ~size_t(3);
+		for (size_t i = 0; i < simdCount; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(&spheres.x[i]);
+			__m128 y = _mm_loadu_ps(&spheres.y[i]);
+			__m128 z = _mm_loadu_ps(&spheres.z[i]);
+			__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (const glm::vec4& plane : frustum.planes)
+			{
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_mul_ps(_mm_set1_ps(plane.y), y)),
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), z), _mm_set1_ps(plane.w)));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+			}
+			visibleCount += storeMask4(_mm_movemask_ps(inside), &visible[i]);
+		}
+		return simdCount;
+	}
+
+	size_t cullAabbsSse2(const FrustumPlanes& frustum, const AabbArrays& boxes, uint8_t* visible, size_t count, uint32_t& visibleCount)
+	{
+		size_t simdCount = count & ~size_t(3);
+		for (size_t i = 0; i < simdCount; i += 4)
+		{
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (const glm::vec4& plane : frustum.planes)
+			{
+				// corner furthest along the normal: the choice is per plane, the same for every lane
+				__m128 x = _mm_loadu_ps(plane.x >= 0.0f ? &boxes.maxX[i] : &boxes.minX[i]);
+				__m128 y = _mm_loadu_ps(plane.y >= 0.0f ? &boxes.maxY[i] : &boxes.minY[i]);
+				__m128 z = _mm_loadu_ps(plane.z >= 0.0f ? &boxes.maxZ[i] : &boxes.minZ[i]);
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_mul_ps(_mm_set1_ps(plane.y), y)),
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), z), _mm_set1_ps(plane.w)));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+			}
+			visibleCount += storeMask4(_mm_movemask_ps(inside), &visible[i]);
+		}
+		return simdCount;
+	}
+#endif
+
+	// ---- AVX2 + FMA: 8 objects per register ----
+#ifdef SIMD_MATH_AVX2
+	SIMD_TARGET_AVX2 inline __m256 abs8(__m256 value) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), value); }
+
+	SIMD_TARGET_AVX2 inline uint32_t storeMask8(int mask, uint8_t* visible)
+	{
+		uint32_t count = 0;
+		for (int lane = 0; lane < 8; lane++)
+		{
+			visible[lane] = static_cast<uint8_t>((mask >> lane) & 1);
+			count += visible[lane];
+		}
+		return count;
+	}
+
+	SIMD_TARGET_AVX2 size_t multiplyMat4Avx2(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			// each column of a in both halves: one register computes two result columns
+			const __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[i][0][0]));
+			const __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[i][1][0]));
+			const __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[i][2][0]));
+			const __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[i][3][0]));
+			for (int column = 0; column < 4; column += 2)
+			{
+				const float* low = &b[i][column][0];
+				const float* high = &b[i][column + 1][0];
+				__m256 result = _mm256_mul_ps(a0, _mm256_setr_ps(low[0], low[0], low[0], low[0], high[0], high[0], high[0], high[0]));
+				result = _mm256_fmadd_ps(a1, _mm256_setr_ps(low[1], low[1], low[1], low[1], high[1], high[1], high[1], high[1]), result);
+				result = _mm256_fmadd_ps(a2, _mm256_setr_ps(low[2], low[2], low[2], low[2], high[2], high[2], high[2], high[2]), result);
+				result = _mm256_fmadd_ps(a3, _mm256_setr_ps(low[3], low[3], low[3], low[3], high[3], high[3], high[3], high[3]), result);
+				_mm256_storeu_ps(&out[i][column][0], result);
+			}
+		}
+		return count;
+	}
+
+	SIMD_TARGET_AVX2 size_t transformAabbsAvx2(const glm::mat4& m, const AabbArrays& in, AabbArrays& out, size_t count)
+	{
+		const __m256 half = _mm256_set1_ps(0.5f);
+		size_t simdCount = count & ~size_t(7);
+		for (size_t i = 0; i < simdCount; i += 8)
+		{
+			__m256 minX = _mm256_loadu_ps(&in.minX[i]), maxX = _mm256_loadu_ps(&in.maxX[i]);
+			__m256 minY = _mm256_loadu_ps(&in.minY[i]), maxY = _mm256_loadu_ps(&in.maxY[i]);
+			__m256 minZ = _mm256_loadu_ps(&in.minZ[i]), maxZ = _mm256_loadu_ps(&in.maxZ[i]);
+			__m256 cx = _mm256_mul_ps(_mm256_add_ps(minX, maxX), half), ex = _mm256_mul_ps(_mm256_sub_ps(maxX, minX), half);
+			__m256 cy = _mm256_mul_ps(_mm256_add_ps(minY, maxY), half), ey = _mm256_mul_ps(_mm256_sub_ps(maxY, minY), half);
+			__m256 cz = _mm256_mul_ps(_mm256_add_ps(minZ, maxZ), half), ez = _mm256_mul_ps(_mm256_sub_ps(maxZ, minZ), half);
+
+			float* outMin[3] = { &out.minX[i], &out.minY[i], &out.minZ[i] };
+			float* outMax[3] = { &out.maxX[i], &out.maxY[i], &out.maxZ[i] };
+			for (int row = 0; row < 3; row++)
+			{
+				__m256 center = _mm256_fmadd_ps(_mm256_set1_ps(m[0][row]), cx,
+					_mm256_fmadd_ps(_mm256_set1_ps(m[1][row]), cy, _mm256_fmadd_ps(_mm256_set1_ps(m[2][row]), cz, _mm256_set1_ps(m[3][row]))));
+				__m256 extent = _mm256_fmadd_ps(abs8(_mm256_set1_ps(m[0][row])), ex,
+					_mm256_fmadd_ps(abs8(_mm256_set1_ps(m[1][row])), ey, _mm256_mul_ps(abs8(_mm256_set1_ps(m[2][row])), ez)));
+				_mm256_storeu_ps(outMin[row], _mm256_sub_ps(center, extent));
+				_mm256_storeu_ps(outMax[row], _mm256_add_ps(center, extent));
+			}
+		}
+		return simdCount;
+	}
+
+	SIMD_TARGET_AVX2 size_t cullSpheresAvx2(const FrustumPlanes& frustum, const SphereArrays& spheres, uint8_t* visible, size_t count,
+		uint32_t& visibleCount)
+	{
+		size_t simdCount = count & ~size_t(7);
+		for (size_t i = 0; i < simdCount; i += 8)
+		{
+			__m256 x = _mm256_loadu_ps(&spheres.x[i]);
+			__m256 y = _mm256_loadu_ps(&spheres.y[i]);
+			__m256 z = _mm256_loadu_ps(&spheres.z[i]);
+			__m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&spheres.radius[i]));
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (const glm::vec4& plane : frustum.planes)
+			{
+				__m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.x), x,
+					_mm256_fmadd_ps(_mm256_set1_ps(plane.y), y, _mm256_fmadd_ps(_mm256_set1_ps(plane.z), z, _mm256_set1_ps(plane.w))));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+			}
+			visibleCount += storeMask8(_mm256_movemask_ps(inside), &visible[i]);
+		}
+		return simdCount;
+	}
+
+	SIMD_TARGET_AVX2 size_t cullAabbsAvx2(const FrustumPlanes& frustum, const AabbArrays& boxes, uint8_t* visible, size_t count,
+		uint32_t& visibleCount)
+	{
+		size_t simdCount = count & ~size_t(7);
+		for (size_t i = 0; i < simdCount; i += 8)
+		{
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (const glm::vec4& plane : frustum.planes)
+			{
+				__m256 x = _mm256_loadu_ps(plane.x >= 0.0f ? &boxes.maxX[i] : &boxes.minX[i]);
+				__m256 y = _mm256_loadu_ps(plane.y >= 0.0f ? &boxes.maxY[i] : &boxes.minY[i]);
+				__m256 z = _mm256_loadu_ps(plane.z >= 0.0f ? &boxes.maxZ[i] : &boxes.minZ[i]);
+				__m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.x), x,
+					_mm256_fmadd_ps(_mm256_set1_ps(plane.y), y, _mm256_fmadd_ps(_mm256_set1_ps(plane.z), z, _mm256_set1_ps(plane.w))));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+			}
+			visibleCount += storeMask8(_mm256_movemask_ps(inside), &visible[i]);
+		}
+		return simdCount;
+	}
+#endif
+
+	SimdLevel clampLevel(SimdLevel level)
+	{
+		return std::min(level, CSimdMath::getBestSimdLevel());
+	}
+
+	// ---- test data ----
+
+	glm::mat4 randomMatrix(uint64_t& state)
+	{
+		glm::mat4 matrix = glm::rotate(glm::mat4(1.0f), randomRange(state, 0.0f, 6.2831853f),
+			glm::normalize(glm::vec3(randomRange(state, -1.0f, 1.0f), randomRange(state, -1.0f, 1.0f), 1.0f)));
+		matrix = glm::scale(matrix, glm::vec3(randomRange(state, 0.5f, 2.0f)));
+		matrix[3] = glm::vec4(randomRange(state, -50.0f, 50.0f), randomRange(state, -50.0f, 50.0f), randomRange(state, 0.0f, 10.0f), 1.0f);
+		return matrix;
+	}
+
+	// trees scattered over a 200 x 200 forest floor
+	void randomForest(uint64_t& state, size_t count, AabbArrays& boxes, SphereArrays& spheres)
+	{
+		boxes.resize(count);
+		spheres.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			float x = randomRange(state, -100.0f, 100.0f);
+			float y = randomRange(state, -100.0f, 100.0f);
+			float radius = randomRange(state, 0.5f, 3.0f);
+			float height = randomRange(state, 2.0f, 12.0f);
+			boxes.minX[i] = x - radius; boxes.maxX[i] = x + radius;
+			boxes.minY[i] = y - radius; boxes.maxY[i] = y + radius;
+			boxes.minZ[i] = 0.0f;       boxes.maxZ[i] = height;
+			spheres.x[i] = x;
+			spheres.y[i] = y;
+			spheres.z[i] = height * 0.5f;
+			spheres.radius[i] = std::sqrt(radius * radius * 2.0f + height * height * 0.25f);
+		}
+	}
+
+	glm::mat4 forestCamera(float aspect)
+	{
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f, -60.0f, 15.0f), glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+		glm::mat4 proj = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 120.0f);
+		proj[1][1] *= -1.0f;
+		return proj * view;
+	}
+}
+
+const char* toString(SimdLevel level)
+{
+	return level < SimdLevel::Count ? LEVEL_NAMES[static_cast<uint32_t>(level)] : "unknown";
+}
+
+void AabbArrays::resize(size_t count)
+{
+	minX.resize(count); minY.resize(count); minZ.resize(count);
+	maxX.resize(count); maxY.resize(count); maxZ.resize(count);
+}
+
+void SphereArrays::resize(size_t count)
+{
+	x.resize(count); y.resize(count); z.resize(count); radius.resize(count);
+}
+
+SimdLevel CSimdMath::getBestSimdLevel()
+{
+	static const SimdLevel level = detectSimdLevel();
+	return level;
+}
+
+FrustumPlanes CSimdMath::extractFrustumPlanes(const glm::mat4& viewProj)
+{
+	// rows of the matrix (glm is column-major)
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(viewProj[0][row], viewProj[1][row], viewProj[2][row], viewProj[3][row]);
+	}
+
+	FrustumPlanes frustum;
+	frustum.planes[0] = rows[3] + rows[0];    // left   -w <= x
+	frustum.planes[1] = rows[3] - rows[0];    // right   x <= w
+	frustum.planes[2] = rows[3] + rows[1];    // -w <= y
+	frustum.planes[3] = rows[3] - rows[1];    //  y <= w
+	frustum.planes[4] = rows[2];              // near    0 <= z (Vulkan depth)
+	frustum.planes[5] = rows[3] - rows[2];    // far     z <= w
+	for (glm::vec4& plane : frustum.planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+	return frustum;
+}
+
+void CSimdMath::multiplyMat4(SimdLevel level, const glm::mat4* a, const glm::mat4* b, glm::mat4* out, size_t count)
+{
+	size_t done = 0;
+	switch (clampLevel(level))
+	{
+#ifdef SIMD_MATH_AVX2
+	case SimdLevel::AVX2: done = multiplyMat4Avx2(a, b, out, count); break;
+#endif
+#ifdef SIMD_MATH_SSE2
+	case SimdLevel::SSE2: done = multiplyMat4Sse2(a, b, out, count); break;
+#endif
+	default: break;
+	}
+	multiplyMat4Scalar(a, b, out, done, count);
+}
+
+void CSimdMath::transformAabbs(SimdLevel level, const glm::mat4& matrix, const AabbArrays& in, AabbArrays& out)
+{
+	size_t count = in.size();
+	out.resize(count);
+	size_t done = 0;
+	switch (clampLevel(level))
+	{
+#ifdef SIMD_MATH_AVX2
+	case SimdLevel::AVX2: done = transformAabbsAvx2(matrix, in, out, count); break;
+#endif
+#ifdef SIMD_MATH_SSE2
+	case SimdLevel::SSE2: done = transformAabbsSse2(matrix, in, out, count); break;
+#endif
+	default: break;
+	}
+	transformAabbsScalar(matrix, in, out, done, count);
+}
+
+uint32_t CSimdMath::cullSpheres(SimdLevel level, const FrustumPlanes& frustum, const SphereArrays& spheres, uint8_t* visible)
+{
+	size_t count = spheres.size();
+	size_t done = 0;
+	uint32_t visibleCount = 0;
+	switch (clampLevel(level))
+	{
+#ifdef SIMD_MATH_AVX2
+	case SimdLevel::AVX2: done = cullSpheresAvx2(frustum, spheres, visible, count, visibleCount); break;
+#endif
+#ifdef SIMD_MATH_SSE2
+	case SimdLevel::SSE2: done = cullSpheresSse2(frustum, spheres, visible, count, visibleCount); break;
+#endif
+	default: break;
+	}
+	return visibleCount + cullSpheresScalar(frustum, spheres, visible, done, count);
+}
+
+uint32_t CSimdMath::cullAabbs(SimdLevel level, const FrustumPlanes& frustum, const AabbArrays& boxes, uint8_t* visible)
+{
+	size_t count = boxes.size();
+	size_t done = 0;
+	uint32_t visibleCount = 0;
+	switch (clampLevel(level))
+	{
+#ifdef SIMD_MATH_AVX2
+	case SimdLevel::AVX2: done = cullAabbsAvx2(frustum, boxes, visible, count, visibleCount); break;
+#endif
+#ifdef SIMD_MATH_SSE2
+	case SimdLevel::SSE2: done = cullAabbsSse2(frustum, boxes, visible, count, visibleCount); break;
+#endif
+	default: break;
+	}
+	return visibleCount + cullAabbsScalar(frustum, boxes, visible, done, count);
+}
+
+bool CSimdMath::selfTest()
+{
+	bool passed = true;
+	auto check = [&](bool condition, const char* what, SimdLevel level)
+	{
+		if (condition == false)
+		{
+			printf("  FAILED (%s): %s\n", toString(level), what);
+			passed = false;
+		}
+	};
+
+	const size_t count = 1003;    // not a multiple of 4 or 8: the scalar tails run too
+	uint64_t state = 0x853C49E6748FEA9Bull;
+
+	std::vector<glm::mat4> a(count), b(count), reference(count), result(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		a[i] = randomMatrix(state);
+		b[i] = randomMatrix(state);
+		reference[i] = a[i] * b[i];
+	}
+
+	AabbArrays boxes;
+	SphereArrays spheres;
+	randomForest(state, count, boxes, spheres);
+	glm::mat4 transform = randomMatrix(state);
+	FrustumPlanes frustum = extractFrustumPlanes(forestCamera(16.0f / 9.0f));
+
+	// planes: a point in front of the camera is inside, one behind it is not
+	{
+		bool inside = true, behind = true;
+		for (const glm::vec4& plane : frustum.planes)
+		{
+			inside = inside && glm::dot(glm::vec3(plane), glm::vec3(0.0f, 0.0f, 5.0f)) + plane.w >= 0.0f;
+			behind = behind && glm::dot(glm::vec3(plane), glm::vec3(0.0f, -70.0f, 15.0f)) + plane.w >= 0.0f;
+		}
+		check(inside && behind == false, "frustum planes of ubo.proj * ubo.view", SimdLevel::Scalar);
+	}
+
+	for (uint32_t levelIndex = 0; levelIndex < static_cast<uint32_t>(SimdLevel::Count); levelIndex++)
+	{
+		SimdLevel level = static_cast<SimdLevel>(levelIndex);
+		if (isSupported(level) == false)
+		{
+			printf("  %s not supported here, skipped\n", toString(level));
+			continue;
+		}
+
+		// mat4 multiply: FMA rounds differently from glm, so compare relative to the magnitudes involved
+		multiplyMat4(level, a.data(), b.data(), result.data(), count);
+		float maxError = 0.0f;
+		for (size_t i = 0; i < count; i++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				glm::vec4 difference = glm::abs(result[i][column] - reference[i][column]);
+				float scale = 1.0f + glm::length(reference[i][column]);
+				maxError = std::max(maxError, std::max(std::max(difference.x, difference.y), std::max(difference.z, difference.w)) / scale);
+			}
+		}
+		check(maxError < 1e-5f, "mat4 multiply matches glm", level);
+
+		// AABB transform: the 8 transformed corners with glm must fit exactly in the box and touch every side
+		AabbArrays transformed;
+		transformAabbs(level, transform, boxes, transformed);
+		bool contains = true, tight = true;
+		for (size_t i = 0; i < count; i++)
+		{
+			glm::vec3 cornerMin(1e30f), cornerMax(-1e30f);
+			for (int corner = 0; corner < 8; corner++)
+			{
+				glm::vec3 position((corner & 1) ? boxes.maxX[i] : boxes.minX[i], (corner & 2) ? boxes.maxY[i] : boxes.minY[i],
+					(corner & 4) ? boxes.maxZ[i] : boxes.minZ[i]);
+				glm::vec3 world = glm::vec3(transform * glm::vec4(position, 1.0f));
+				cornerMin = glm::min(cornerMin, world);
+				cornerMax = glm::max(cornerMax, world);
+			}
+			glm::vec3 boxMin(transformed.minX[i], transformed.minY[i], transformed.minZ[i]);
+			glm::vec3 boxMax(transformed.maxX[i], transformed.maxY[i], transformed.maxZ[i]);
+			const float epsilon = 1e-3f;
+			contains = contains && glm::all(glm::lessThanEqual(boxMin, cornerMin + epsilon)) && glm::all(glm::greaterThanEqual(boxMax, cornerMax - epsilon));
+			tight = tight && glm::all(glm::lessThan(glm::abs(boxMin - cornerMin), glm::vec3(epsilon)))
+				&& glm::all(glm::lessThan(glm::abs(boxMax - cornerMax), glm::vec3(epsilon)));
+		}
+		check(contains, "transformed AABB contains the transformed corners (glm)", level);
+		check(tight, "transformed AABB is the corners' bounds (glm)", level);
+
+		// culling: same answer as a glm test, except for objects that touch a plane within rounding
+		std::vector<uint8_t> sphereVisible(count), boxVisible(count);
+		uint32_t sphereCount = cullSpheres(level, frustum, spheres, sphereVisible.data());
+		uint32_t boxCount = cullAabbs(level, frustum, boxes, boxVisible.data());
+		uint32_t sphereMismatches = 0, boxMismatches = 0, sphereSum = 0, boxSum = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			float sphereMargin = 1e30f, boxMargin = 1e30f;
+			glm::vec3 center(spheres.x[i], spheres.y[i], spheres.z[i]);
+			for (const glm::vec4& plane : frustum.planes)
+			{
+				sphereMargin = std::min(sphereMargin, glm::dot(glm::vec3(plane), center) + plane.w + spheres.radius[i]);
+				float furthest = -1e30f;
+				for (int corner = 0; corner < 8; corner++)
+				{
+					glm::vec3 position((corner & 1) ? boxes.maxX[i] : boxes.minX[i], (corner & 2) ? boxes.maxY[i] : boxes.minY[i],
+						(corner & 4) ? boxes.maxZ[i] : boxes.minZ[i]);
+					furthest = std::max(furthest, glm::dot(glm::vec3(plane), position) + plane.w);
+				}
+				boxMargin = std::min(boxMargin, furthest);
+			}
+			sphereMismatches += (std::abs(sphereMargin) > 1e-4f && (sphereMargin >= 0.0f) != (sphereVisible[i] != 0)) ? 1 : 0;
+			boxMismatches += (std::abs(boxMargin) > 1e-4f && (boxMargin >= 0.0f) != (boxVisible[i] != 0)) ? 1 : 0;
+			sphereSum += sphereVisible[i];
+			boxSum += boxVisible[i];
+		}
+		check(sphereMismatches == 0, "sphere culling matches glm", level);
+		check(boxMismatches == 0, "AABB culling matches glm", level);
+		check(sphereSum == sphereCount && boxSum == boxCount, "visible counts match the flags", level);
+		check(boxCount > 0 && boxCount < count, "the test camera sees part of the forest", level);
+	}
+
+	printf(passed ? "SIMD math: all checks passed\n" : "SIMD math: FAILED\n");
+	return passed;
+}
+
+void CSimdMath::benchmark()
+{
+	const size_t count = 100000;
+	const uint32_t iterations = 50;
+	uint64_t state = 0x9E3779B97F4A7C15ull;
+
+	std::vector<glm::mat4> a(count), b(count), result(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		a[i] = randomMatrix(state);
+		b[i] = randomMatrix(state);
+	}
+	AabbArrays boxes, transformed;
+	SphereArrays spheres;
+	randomForest(state, count, boxes, spheres);
+	glm::mat4 transform = randomMatrix(state);
+	FrustumPlanes frustum = extractFrustumPlanes(forestCamera(16.0f / 9.0f));
+	std::vector<uint8_t> visible(count);
+
+	printf("SIMD math kernels: %zu objects, %u runs, best level here: %s\n", count, iterations, toString(getBestSimdLevel()));
+	printf("  level    mat4 multiply   AABB transform   sphere cull   AABB cull   (objects per ms)\n");
+
+	auto measure = [&](const auto& kernel)
+	{
+		kernel();    // warm up the caches
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t run = 0; run < iterations; run++)
+		{
+			kernel();
+		}
+		double ms = elapsedMs(start);
+		return count * iterations / std::max(ms, 1e-6);
+	};
+
+	for (uint32_t levelIndex = 0; levelIndex < static_cast<uint32_t>(SimdLevel::Count); levelIndex++)
+	{
+		SimdLevel level = static_cast<SimdLevel>(levelIndex);
+		if (isSupported(level) == false)
+		{
+			printf("  %-6s   not supported\n", toString(level));
+			continue;
+		}
+		double multiply = measure([&]() { multiplyMat4(level, a.data(), b.data(), result.data(), count); });
+		double transformRate = measure([&]() { transformAabbs(level, transform, boxes, transformed); });
+		double sphereCull = measure([&]() { cullSpheres(level, frustum, spheres, visible.data()); });
+		double boxCull = measure([&]() { cullAabbs(level, frustum, boxes, visible.data()); });
+		printf("  %-6s   %13.0f   %14.0f   %11.0f   %9.0f\n", toString(level), multiply, transformRate, sphereCull, boxCull);
+	}
+}
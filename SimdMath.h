@@ -0,0 +1,78 @@
+/*======================================================================
+VulkanPBR_AcornForest : SimdMath.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Batched math kernels for CPU culling and transform updates:
+  - mat4 multiply of matrix arrays (out[i] = a[i] * b[i], glm layout)
+  - AABB transform (center/extent form, exact bounds of the rotated box)
+  - sphere and AABB against the 6 frustum planes
+Bounds are structure-of-arrays so one SIMD register holds the same
+coordinate of 4 (SSE2) or 8 (AVX2 + FMA) objects. Every kernel has a
+scalar version; the AVX2 one is compiled for that target only and used
+when the CPU reports it (getBestSimdLevel()). Counts that are not a
+multiple of the lane count finish with the scalar kernel.
+
+selfTest() (--validate-simd) compares every level to plain glm,
+benchmark() (--bench-simd) prints objects per ms for every level.
+=======================================================================*/
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+enum class SimdLevel : uint32_t
+{
+	Scalar,
+	SSE2,
+	AVX2,        // with FMA
+	Count,
+};
+
+const char* toString(SimdLevel level);
+
+// frustum planes: xyz = inward normal (unit length), w = distance; inside when dot(xyz, p) + w >= 0
+struct FrustumPlanes
+{
+	glm::vec4 planes[6];
+};
+
+struct AabbArrays
+{
+	std::vector<float> minX, minY, minZ;
+	std::vector<float> maxX, maxY, maxZ;
+
+	void resize(size_t count);
+	size_t size() const { return minX.size(); }
+};
+
+struct SphereArrays
+{
+	std::vector<float> x, y, z, radius;
+
+	void resize(size_t count);
+	size_t size() const { return x.size(); }
+};
+
+class CSimdMath
+{
+public:
+
+	static SimdLevel getBestSimdLevel();    // CPU and compiler support, detected once
+	static bool isSupported(SimdLevel level) { return level <= getBestSimdLevel(); }
+
+	// planes of a view-projection matrix with Vulkan depth (0..1)
+	static FrustumPlanes extractFrustumPlanes(const glm::mat4& viewProj);
+
+	// An unsupported level runs the best supported one.
+	static void multiplyMat4(SimdLevel level, const glm::mat4* a, const glm::mat4* b, glm::mat4* out, size_t count);
+	static void transformAabbs(SimdLevel level, const glm::mat4& matrix, const AabbArrays& in, AabbArrays& out);
+	// visible[i] = 1 if the object is at least partly inside; returns the visible count
+	static uint32_t cullSpheres(SimdLevel level, const FrustumPlanes& frustum, const SphereArrays& spheres, uint8_t* visible);
+	static uint32_t cullAabbs(SimdLevel level, const FrustumPlanes& frustum, const AabbArrays& boxes, uint8_t* visible);
+
+	static bool selfTest();
+	static void benchmark();
+};
@@ -0,0 +1,123 @@
+/*======================================================================
+VulkanPBR_AcornForest : StartupTimeline.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "StartupTimeline.h"
+
+#include <algorithm>
+#include <cstdio>
+
+void CStartupTimeline::start()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Origin = Clock::now();
+	m_Steps.clear();
+	m_Threads.assign(1, std::this_thread::get_id());    // the caller is "main"
+}
+
+void CStartupTimeline::run(const std::string& name, const std::function<void()>& step)
+{
+	Clock::time_point start = Clock::now();
+	try
+	{
+		step();
+	}
+	catch (...)
+	{
+		record(name + " (failed)", start, Clock::now());
+		throw;
+	}
+	record(name, start, Clock::now());
+}
+
+void CStartupTimeline::record(const std::string& name, Clock::time_point start, Clock::time_point end)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	std::thread::id id = std::this_thread::get_id();
+	auto found = std::find(m_Threads.begin(), m_Threads.end(), id);
+	uint32_t thread = static_cast<uint32_t>(found - m_Threads.begin());
+	if (found == m_Threads.end())
+	{
+		m_Threads.push_back(id);
+	}
+
+	Step step;
+	step.name = name;
+	step.startMs = std::chrono::duration<double, std::milli>(start - m_Origin).count();
+	step.endMs = std::chrono::duration<double, std::milli>(end - m_Origin).count();
+	step.thread = thread;
+	m_Steps.push_back(step);
+}
+
+double CStartupTimeline::getTotalMs() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	double total = 0.0;
+	for (const Step& step : m_Steps)
+	{
+		total = std::max(total, step.endMs);
+	}
+	return total;
+}
+
+double CStartupTimeline::getStepSumMs() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	double sum = 0.0;
+	for (const Step& step : m_Steps)
+	{
+		sum += step.endMs - step.startMs;
+	}
+	return sum;
+}
+
+std::vector<CStartupTimeline::Step> CStartupTimeline::getSteps() const
+{
+	std::vector<Step> steps;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		steps = m_Steps;
+	}
+	std::stable_sort(steps.begin(), steps.end(), [](const Step& a, const Step& b) { return a.startMs < b.startMs; });
+	return steps;
+}
+
+void CStartupTimeline::print() const
+{
+	const int BAR_WIDTH = 48;
+
+	std::vector<Step> steps = getSteps();
+	double total = getTotalMs();
+	double stepSum = getStepSumMs();
+	double scale = (total > 0.0) ? BAR_WIDTH / total : 0.0;
+
+	printf("Startup timeline: %.1f ms wall, %.1f ms of steps (%.2fx overlap)\n", total, stepSum,
+		total > 0.0 ? stepSum / total : 1.0);
+	printf("  %9s %9s %9s  %-8s %-28s\n", "start", "end", "ms", "thread", "step");
+	for (const Step& step : steps)
+	{
+		char bar[BAR_WIDTH + 1];
+		int begin = std::min(static_cast<int>(step.startMs * scale), BAR_WIDTH - 1);
+		int end = std::max(std::min(static_cast<int>(step.endMs * scale + 0.5), BAR_WIDTH), begin + 1);
+		for (int i = 0; i < BAR_WIDTH; i++)
+		{
+			bar[i] = (i >= begin && i < end) ? '#' : '.';
+		}
+		bar[BAR_WIDTH] = '\0';
+
+		char thread[24];
+		if (step.thread == 0)
+		{
+			snprintf(thread, sizeof(thread), "main");
+		}
+		else
+		{
+			snprintf(thread, sizeof(thread), "worker%u", step.thread);
+		}
+
+		printf("  %9.2f %9.2f %9.2f  %-8s %-28s |%s|\n", step.startMs, step.endMs, step.endMs - step.startMs,
+			thread, step.name.c_str(), bar);
+	}
+}
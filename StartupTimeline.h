@@ -0,0 +1,56 @@
+/*======================================================================
+VulkanPBR_AcornForest : StartupTimeline.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Per-step start/end timestamps for initialization.
+Steps can be recorded from any thread. print() lists them in start order
+with the thread that ran them and a text Gantt bar, so overlap between
+the main thread and the workers is visible (--startup-timeline).
+=======================================================================*/
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CStartupTimeline
+{
+public:
+
+	struct Step
+	{
+		std::string name;
+		double      startMs;    // relative to start()
+		double      endMs;
+		uint32_t    thread;     // 0: the thread that called start(), then in order of appearance
+	};
+
+private:
+
+	using Clock = std::chrono::steady_clock;
+
+	Clock::time_point               m_Origin = Clock::now();
+	mutable std::mutex              m_Mutex;
+	std::vector<Step>               m_Steps;
+	std::vector<std::thread::id>    m_Threads;
+
+	void record(const std::string& name, Clock::time_point start, Clock::time_point end);
+
+public:
+
+	void start();    // clears the timeline; timestamps are relative to this call, the caller is "main"
+
+	// Runs step on the calling thread and records it, also when it throws.
+	void run(const std::string& name, const std::function<void()>& step);
+
+	double getTotalMs() const;     // start() to the end of the last step
+	double getStepSumMs() const;   // sum of step durations (> total when steps overlapped)
+	std::vector<Step> getSteps() const;
+
+	void print() const;
+};
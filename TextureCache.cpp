@@ -0,0 +1,182 @@
+/*======================================================================
+VulkanPBR_AcornForest : TextureCache.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "TextureCache.h"
+#include "CacheFile.h"
+#include "TextureCompressor.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace
+{
+	const uint32_t TEXTURE_CACHE_VERSION = 1;
+	constexpr CCacheFile::Identifier TEXTURE_CACHE_IDENTIFIER = CCacheFile::makeIdentifier("AFTX 1");
+
+	struct CacheHeader
+	{
+		uint8_t  identifier[12];
+		uint32_t version;
+		uint32_t format;        // TextureFormat
+		uint32_t mipFilter;     // MipFilter used for levels 1..N
+		uint32_t width;
+		uint32_t height;
+		uint32_t levelCount;
+		uint32_t reserved;
+		uint64_t sourceSize;    // source file size and write time when the entry was built
+		int64_t  sourceTime;
+	};
+
+	struct CacheLevel
+	{
+		uint64_t offset;        // from the start of the level data
+		uint64_t length;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	// FNV-1a of the normalized source path: textures with the same file name in different folders get different entries
+	uint64_t hashPath(const std::string& path)
+	{
+		std::string normalized = std::filesystem::path(path).lexically_normal().generic_string();
+		return CCacheFile::hashBytes(CCacheFile::FNV_OFFSET_BASIS, normalized.data(), normalized.size());
+	}
+
+	// size a level of the given extent must have: whole 4x4 blocks for BCn, 4 bytes per texel for RGBA8
+	uint64_t getLevelSize(TextureFormat format, uint32_t width, uint32_t height)
+	{
+		uint32_t blockSize = CTextureCompressor::getBlockSize(format);
+		if (blockSize == 0)
+		{
+			return uint64_t(width) * height * 4;
+		}
+		return uint64_t((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+	}
+
+	bool getSourceStamp(const std::string& path, uint64_t& size, int64_t& time)
+	{
+		std::error_code error;
+		size = static_cast<uint64_t>(std::filesystem::file_size(path, error));
+		if (error)
+		{
+			return false;
+		}
+		time = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+		return error.value() == 0;
+	}
+}
+
+std::string CTextureCache::getCachePath(const std::string& sourcePath, TextureFormat format, MipFilter filter)
+{
+	std::string name = std::filesystem::path(sourcePath).filename().string();
+	std::string filterName = (filter == MipFilter::Kaiser) ? "kaiser" : "box";    // BCn chains are always built on the CPU
+	char key[20];
+	snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hashPath(sourcePath)));
+	return std::string(CACHE_DIRECTORY) + "/" + name + "." + key + "." + toString(format) + "." + filterName + ".aftx";
+}
+
+bool CTextureCache::load(const std::string& sourcePath, TextureFormat format, MipFilter filter, TextureData& tex)
+{
+	uint64_t sourceSize;
+	int64_t sourceTime;
+	if (getSourceStamp(sourcePath, sourceSize, sourceTime) == false)
+	{
+		return false;
+	}
+
+	std::ifstream file;
+	CacheHeader header{};
+	uint64_t fileSize = 0;
+	if (CCacheFile::readHeader(getCachePath(sourcePath, format, filter), TEXTURE_CACHE_IDENTIFIER, TEXTURE_CACHE_VERSION, file, header, fileSize) == false ||
+		header.format != static_cast<uint32_t>(format) ||
+		header.mipFilter != static_cast<uint32_t>(filter) ||
+		header.sourceSize != sourceSize ||
+		header.sourceTime != sourceTime ||
+		header.width == 0 || header.height == 0 ||
+		header.levelCount == 0 || header.levelCount > 32)
+	{
+		return false;
+	}
+
+	std::vector<CacheLevel> levels(header.levelCount);
+	file.read(reinterpret_cast<char*>(levels.data()), sizeof(CacheLevel) * levels.size());
+	if (file.good() == false)
+	{
+		return false;
+	}
+
+	// every level has to be the halved extent of the previous one, packed right after it,
+	// and exactly as large as its extent implies; the total must fit in what is left of the file
+	uint64_t headerSize = sizeof(CacheHeader) + sizeof(CacheLevel) * levels.size();
+	if (fileSize < headerSize)
+	{
+		return false;
+	}
+
+	uint64_t dataSize = 0;
+	for (uint32_t i = 0; i < header.levelCount; i++)
+	{
+		const CacheLevel& level = levels[i];
+		uint32_t width = std::max(header.width >> i, 1u);
+		uint32_t height = std::max(header.height >> i, 1u);
+		if (level.width != width || level.height != height ||
+			level.offset != dataSize ||
+			level.length != getLevelSize(format, width, height) ||
+			level.length > fileSize - headerSize - dataSize)
+		{
+			return false;
+		}
+		dataSize += level.length;
+	}
+
+	tex.pixels.resize(static_cast<size_t>(dataSize));
+	file.read(reinterpret_cast<char*>(tex.pixels.data()), static_cast<std::streamsize>(dataSize));
+	if (file.good() == false)
+	{
+		return false;
+	}
+
+	tex.path = sourcePath;
+	tex.format = format;
+	tex.width = header.width;
+	tex.height = header.height;
+	tex.mipLevels = header.levelCount;
+	tex.mips.clear();
+	for (const CacheLevel& level : levels)
+	{
+		tex.mips.push_back({ static_cast<size_t>(level.offset), static_cast<size_t>(level.length), level.width, level.height });
+	}
+	return true;
+}
+
+void CTextureCache::store(const TextureData& tex, MipFilter filter)
+{
+	CacheHeader header{};
+	CCacheFile::initHeader(header, TEXTURE_CACHE_IDENTIFIER, TEXTURE_CACHE_VERSION);
+	header.format = static_cast<uint32_t>(tex.format);
+	header.mipFilter = static_cast<uint32_t>(filter);
+	header.width = tex.width;
+	header.height = tex.height;
+	header.levelCount = static_cast<uint32_t>(tex.mips.size());
+	if (getSourceStamp(tex.path, header.sourceSize, header.sourceTime) == false)
+	{
+		return;
+	}
+
+	std::vector<CacheLevel> levels;
+	for (const TextureMip& mip : tex.mips)
+	{
+		levels.push_back({ mip.offset, mip.size, mip.width, mip.height });
+	}
+
+	CCacheFile::write(getCachePath(tex.path, tex.format, filter), header, [&](std::ofstream& file)
+	{
+		file.write(reinterpret_cast<const char*>(levels.data()), sizeof(CacheLevel) * levels.size());
+		file.write(reinterpret_cast<const char*>(tex.pixels.data()), static_cast<std::streamsize>(tex.pixels.size()));
+	}, "Texture cache");
+}
@@ -0,0 +1,31 @@
+/*======================================================================
+VulkanPBR_AcornForest : TextureCache.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+On-disk cache of processed textures (Asset/Cache, .aftx files).
+The container follows the KTX2 layout in spirit: identifier, header,
+level index, then the block data of every mip level, so it can be
+copied into a staging buffer without any further processing.
+An entry is only used if the source file's size and write time match
+the values recorded when it was written.
+=======================================================================*/
+#pragma once
+
+#include <string>
+
+#include "TextureLoader.h"
+
+class CTextureCache
+{
+public:
+
+	// one entry per source file, format and mip filter
+	static std::string getCachePath(const std::string& sourcePath, TextureFormat format, MipFilter filter);
+
+	// returns false if there is no entry or it is out of date
+	static bool load(const std::string& sourcePath, TextureFormat format, MipFilter filter, TextureData& tex);
+
+	// failures are reported but not fatal: the texture is simply encoded again next run
+	static void store(const TextureData& tex, MipFilter filter);
+};
@@ -0,0 +1,879 @@
+/*======================================================================
+VulkanPBR_AcornForest : TextureCompressor.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Block encoders. All of them work on the stored (sRGB-encoded) values,
+which is also where the hardware interpolates the palette.
+
+BC1 colour : principal axis fit + one least-squares refinement pass,
+             always 4-colour mode (c0 > c1) so the block is also valid
+             inside BC3.
+BC4 (BC3 alpha, BC5 red/green) : min/max endpoints, 8-value mode.
+BC7        : mode 6 only (one subset, RGBA 7777 + p-bit, 4-bit indices).
+             Not as good as a full mode search, but much better than
+             BC3 on gradients and cheap enough to run at load time.
+=======================================================================*/
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "TextureCompressor.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	//==================================================================
+	// block helpers
+	//==================================================================
+
+	// copies a 4x4 texel block, clamping at the edges of small mips
+	void fetchBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t block[16][4])
+	{
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			uint32_t sy = std::min(blockY * 4 + y, height - 1);
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				uint32_t sx = std::min(blockX * 4 + x, width - 1);
+				memcpy(block[y * 4 + x], pixels + (size_t(sy) * width + sx) * 4, 4);
+			}
+		}
+	}
+
+	void storeBlock(const uint8_t block[16][4], uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY)
+	{
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				uint32_t px = blockX * 4 + x;
+				uint32_t py = blockY * 4 + y;
+				if (px < width && py < height)
+				{
+					memcpy(pixels + (size_t(py) * width + px) * 4, block[y * 4 + x], 4);
+				}
+			}
+		}
+	}
+
+	// principal axis of the block's colours (first `channels` components), by power iteration
+	void principalAxis(const uint8_t block[16][4], int channels, float mean[4], float axis[4])
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			mean[c] = 0.0f;
+			axis[c] = 0.0f;
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < channels; c++)
+			{
+				mean[c] += block[i][c];
+			}
+		}
+		for (int c = 0; c < channels; c++)
+		{
+			mean[c] /= 16.0f;
+		}
+
+		float cov[4][4] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			float d[4];
+			for (int c = 0; c < channels; c++)
+			{
+				d[c] = block[i][c] - mean[c];
+			}
+			for (int a = 0; a < channels; a++)
+			{
+				for (int b = 0; b < channels; b++)
+				{
+					cov[a][b] += d[a] * d[b];
+				}
+			}
+		}
+
+		// start from the (max - min) diagonal, which is usually close already
+		for (int c = 0; c < channels; c++)
+		{
+			uint8_t lo = 255, hi = 0;
+			for (int i = 0; i < 16; i++)
+			{
+				lo = std::min(lo, block[i][c]);
+				hi = std::max(hi, block[i][c]);
+			}
+			axis[c] = float(hi - lo) + 1e-3f;
+		}
+
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = {};
+			for (int a = 0; a < channels; a++)
+			{
+				for (int b = 0; b < channels; b++)
+				{
+					next[a] += cov[a][b] * axis[b];
+				}
+			}
+			float length = 0.0f;
+			for (int c = 0; c < channels; c++)
+			{
+				length = std::max(length, std::fabs(next[c]));
+			}
+			if (length < 1e-6f)
+			{
+				break;    // flat block: keep the previous axis
+			}
+			for (int c = 0; c < channels; c++)
+			{
+				axis[c] = next[c] / length;
+			}
+		}
+	}
+
+	//==================================================================
+	// BC1 colour block
+	//==================================================================
+
+	inline uint16_t packRgb565(const float rgb[3])
+	{
+		int r = std::min(31, std::max(0, int(rgb[0] * (31.0f / 255.0f) + 0.5f)));
+		int g = std::min(63, std::max(0, int(rgb[1] * (63.0f / 255.0f) + 0.5f)));
+		int b = std::min(31, std::max(0, int(rgb[2] * (31.0f / 255.0f) + 0.5f)));
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	inline void unpackRgb565(uint16_t c, int rgb[3])
+	{
+		int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	// 4-colour palette: c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1
+	void bc1Palette(uint16_t c0, uint16_t c1, int palette[4][3])
+	{
+		unpackRgb565(c0, palette[0]);
+		unpackRgb565(c1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+	}
+
+	// picks the nearest palette entry per texel, returns total squared error
+	uint32_t bc1Indices(const uint8_t block[16][4], uint16_t c0, uint16_t c1, uint32_t& indices)
+	{
+		int palette[4][3];
+		bc1Palette(c0, c1, palette);
+
+		uint32_t error = 0;
+		indices = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			uint32_t best = UINT32_MAX;
+			uint32_t bestIndex = 0;
+			for (uint32_t p = 0; p < 4; p++)
+			{
+				int dr = block[i][0] - palette[p][0];
+				int dg = block[i][1] - palette[p][1];
+				int db = block[i][2] - palette[p][2];
+				uint32_t d = uint32_t(dr * dr + dg * dg + db * db);
+				if (d < best)
+				{
+					best = d;
+					bestIndex = p;
+				}
+			}
+			indices |= bestIndex << (2 * i);
+			error += best;
+		}
+		return error;
+	}
+
+	// least-squares endpoints for fixed indices
+	bool bc1Refit(const uint8_t block[16][4], uint32_t indices, float e0[3], float e1[3])
+	{
+		static const float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };    // weight of c1
+
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[3] = {}, bx[3] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			float w1 = weights[(indices >> (2 * i)) & 3];
+			float w0 = 1.0f - w1;
+			aa += w0 * w0;
+			ab += w0 * w1;
+			bb += w1 * w1;
+			for (int c = 0; c < 3; c++)
+			{
+				ax[c] += w0 * block[i][c];
+				bx[c] += w1 * block[i][c];
+			}
+		}
+
+		float det = aa * bb - ab * ab;
+		if (std::fabs(det) < 1e-6f)
+		{
+			return false;
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			e0[c] = std::min(255.0f, std::max(0.0f, (ax[c] * bb - bx[c] * ab) / det));
+			e1[c] = std::min(255.0f, std::max(0.0f, (bx[c] * aa - ax[c] * ab) / det));
+		}
+		return true;
+	}
+
+	// keeps c0 > c1 so the block decodes in 4-colour mode (indices are picked afterwards)
+	void bc1Order(uint16_t& c0, uint16_t& c1)
+	{
+		if (c0 < c1)
+		{
+			std::swap(c0, c1);
+		}
+	}
+
+	void encodeBC1Color(const uint8_t block[16][4], uint8_t* out)
+	{
+		float mean[4], axis[4];
+		principalAxis(block, 3, mean, axis);
+
+		// extreme projections along the axis
+		float minT = FLT_MAX, maxT = -FLT_MAX;
+		for (int i = 0; i < 16; i++)
+		{
+			float t = 0.0f;
+			for (int c = 0; c < 3; c++)
+			{
+				t += (block[i][c] - mean[c]) * axis[c];
+			}
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+		float axisLength2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		if (axisLength2 < 1e-6f)
+		{
+			axisLength2 = 1.0f;
+		}
+
+		float e0[3], e1[3];
+		for (int c = 0; c < 3; c++)
+		{
+			e0[c] = mean[c] + axis[c] * maxT / axisLength2;
+			e1[c] = mean[c] + axis[c] * minT / axisLength2;
+		}
+
+		uint16_t c0 = packRgb565(e0);
+		uint16_t c1 = packRgb565(e1);
+		bc1Order(c0, c1);
+		uint32_t indices;
+		uint32_t error = bc1Indices(block, c0, c1, indices);
+
+		// one refinement pass with the indices we just found
+		if (bc1Refit(block, indices, e0, e1))
+		{
+			uint16_t r0 = packRgb565(e0);
+			uint16_t r1 = packRgb565(e1);
+			bc1Order(r0, r1);
+			uint32_t refitIndices;
+			uint32_t refitError = bc1Indices(block, r0, r1, refitIndices);
+			if (refitError < error)
+			{
+				c0 = r0;
+				c1 = r1;
+				indices = refitIndices;
+			}
+		}
+		if (c0 == c1)
+		{
+			indices = 0;    // single colour: c0 == c1 would otherwise select 3-colour mode
+		}
+
+		memcpy(out + 0, &c0, 2);
+		memcpy(out + 2, &c1, 2);
+		memcpy(out + 4, &indices, 4);
+	}
+
+	void decodeBC1Color(const uint8_t* in, uint8_t block[16][4])
+	{
+		uint16_t c0, c1;
+		uint32_t indices;
+		memcpy(&c0, in + 0, 2);
+		memcpy(&c1, in + 2, 2);
+		memcpy(&indices, in + 4, 4);
+
+		int palette[4][3];
+		bc1Palette(c0, c1, palette);
+		for (int i = 0; i < 16; i++)
+		{
+			const int* p = palette[(indices >> (2 * i)) & 3];
+			block[i][0] = uint8_t(p[0]);
+			block[i][1] = uint8_t(p[1]);
+			block[i][2] = uint8_t(p[2]);
+			block[i][3] = 255;
+		}
+	}
+
+	//==================================================================
+	// BC4 single channel block (BC3 alpha, BC5 red and green)
+	//==================================================================
+
+	// 8-value mode (a0 > a1): a0, a1, then six interpolated steps
+	void bc4Palette(uint8_t a0, uint8_t a1, int palette[8])
+	{
+		palette[0] = a0;
+		palette[1] = a1;
+		if (a0 > a1)
+		{
+			for (int i = 1; i < 7; i++)
+			{
+				palette[i + 1] = ((7 - i) * a0 + i * a1 + 3) / 7;
+			}
+		}
+		else
+		{
+			for (int i = 1; i < 5; i++)
+			{
+				palette[i + 1] = ((5 - i) * a0 + i * a1 + 2) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	void encodeBC4(const uint8_t block[16][4], int channel, uint8_t* out)
+	{
+		uint8_t lo = 255, hi = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			lo = std::min(lo, block[i][channel]);
+			hi = std::max(hi, block[i][channel]);
+		}
+
+		out[0] = hi;
+		out[1] = lo;
+
+		uint64_t bits = 0;
+		if (hi != lo)
+		{
+			int palette[8];
+			bc4Palette(hi, lo, palette);
+			for (int i = 0; i < 16; i++)
+			{
+				int best = INT32_MAX;
+				uint64_t bestIndex = 0;
+				for (int p = 0; p < 8; p++)
+				{
+					int d = std::abs(block[i][channel] - palette[p]);
+					if (d < best)
+					{
+						best = d;
+						bestIndex = uint64_t(p);
+					}
+				}
+				bits |= bestIndex << (3 * i);
+			}
+		}
+		for (int b = 0; b < 6; b++)
+		{
+			out[2 + b] = uint8_t(bits >> (8 * b));
+		}
+	}
+
+	void decodeBC4(const uint8_t* in, int channel, uint8_t block[16][4])
+	{
+		int palette[8];
+		bc4Palette(in[0], in[1], palette);
+
+		uint64_t bits = 0;
+		for (int b = 0; b < 6; b++)
+		{
+			bits |= uint64_t(in[2 + b]) << (8 * b);
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			block[i][channel] = uint8_t(palette[(bits >> (3 * i)) & 7]);
+		}
+	}
+
+	//==================================================================
+	// BC7 mode 6
+	//==================================================================
+
+	const int BC7_WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	inline int bc7Interpolate(int e0, int e1, int index)
+	{
+		return ((64 - BC7_WEIGHTS_4[index]) * e0 + BC7_WEIGHTS_4[index] * e1 + 32) >> 6;
+	}
+
+	// endpoint = 7-bit value per channel plus one shared p-bit (the LSB)
+	struct Bc7Endpoint
+	{
+		int color7[4];
+		int pBit;
+
+		int value(int c) const { return (color7[c] << 1) | pBit; }
+	};
+
+	// rounds a float RGBA endpoint to the closest 7777+p value, trying both p-bits
+	Bc7Endpoint bc7Quantize(const float e[4])
+	{
+		Bc7Endpoint best{};
+		float bestError = FLT_MAX;
+		for (int p = 0; p < 2; p++)
+		{
+			Bc7Endpoint candidate{};
+			candidate.pBit = p;
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++)
+			{
+				candidate.color7[c] = std::min(127, std::max(0, int((e[c] - p) * 0.5f + 0.5f)));
+				float d = e[c] - candidate.value(c);
+				error += d * d;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				best = candidate;
+			}
+		}
+		return best;
+	}
+
+	uint32_t bc7Indices(const uint8_t block[16][4], const Bc7Endpoint& e0, const Bc7Endpoint& e1, uint8_t indices[16])
+	{
+		int palette[16][4];
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				palette[i][c] = bc7Interpolate(e0.value(c), e1.value(c), i);
+			}
+		}
+
+		uint32_t error = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			uint32_t best = UINT32_MAX;
+			for (int p = 0; p < 16; p++)
+			{
+				uint32_t d = 0;
+				for (int c = 0; c < 4; c++)
+				{
+					int diff = block[i][c] - palette[p][c];
+					d += uint32_t(diff * diff);
+				}
+				if (d < best)
+				{
+					best = d;
+					indices[i] = uint8_t(p);
+				}
+			}
+			error += best;
+		}
+		return error;
+	}
+
+	bool bc7Refit(const uint8_t block[16][4], const uint8_t indices[16], float e0[4], float e1[4])
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = {}, bx[4] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			float w1 = BC7_WEIGHTS_4[indices[i]] / 64.0f;
+			float w0 = 1.0f - w1;
+			aa += w0 * w0;
+			ab += w0 * w1;
+			bb += w1 * w1;
+			for (int c = 0; c < 4; c++)
+			{
+				ax[c] += w0 * block[i][c];
+				bx[c] += w1 * block[i][c];
+			}
+		}
+
+		float det = aa * bb - ab * ab;
+		if (std::fabs(det) < 1e-6f)
+		{
+			return false;
+		}
+		for (int c = 0; c < 4; c++)
+		{
+			e0[c] = std::min(255.0f, std::max(0.0f, (ax[c] * bb - bx[c] * ab) / det));
+			e1[c] = std::min(255.0f, std::max(0.0f, (bx[c] * aa - ax[c] * ab) / det));
+		}
+		return true;
+	}
+
+	// little-endian bit writer over a 128-bit block
+	struct BitWriter
+	{
+		uint8_t* out;
+		uint32_t position = 0;
+
+		void write(uint32_t value, uint32_t count)
+		{
+			for (uint32_t i = 0; i < count; i++, position++)
+			{
+				if ((value >> i) & 1)
+				{
+					out[position >> 3] |= uint8_t(1u << (position & 7));
+				}
+			}
+		}
+	};
+
+	struct BitReader
+	{
+		const uint8_t* in;
+		uint32_t position = 0;
+
+		uint32_t read(uint32_t count)
+		{
+			uint32_t value = 0;
+			for (uint32_t i = 0; i < count; i++, position++)
+			{
+				value |= uint32_t((in[position >> 3] >> (position & 7)) & 1) << i;
+			}
+			return value;
+		}
+	};
+
+	void encodeBC7(const uint8_t block[16][4], uint8_t* out)
+	{
+		float mean[4], axis[4];
+		principalAxis(block, 4, mean, axis);
+
+		float minT = FLT_MAX, maxT = -FLT_MAX;
+		for (int i = 0; i < 16; i++)
+		{
+			float t = 0.0f;
+			for (int c = 0; c < 4; c++)
+			{
+				t += (block[i][c] - mean[c]) * axis[c];
+			}
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+		float axisLength2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3];
+		if (axisLength2 < 1e-6f)
+		{
+			axisLength2 = 1.0f;
+		}
+
+		float f0[4], f1[4];
+		for (int c = 0; c < 4; c++)
+		{
+			f0[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * minT / axisLength2));
+			f1[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * maxT / axisLength2));
+		}
+
+		Bc7Endpoint e0 = bc7Quantize(f0);
+		Bc7Endpoint e1 = bc7Quantize(f1);
+		uint8_t indices[16];
+		uint32_t error = bc7Indices(block, e0, e1, indices);
+
+		// two refinement passes
+		for (int pass = 0; pass < 2; pass++)
+		{
+			if (bc7Refit(block, indices, f0, f1) == false)
+			{
+				break;
+			}
+			Bc7Endpoint r0 = bc7Quantize(f0);
+			Bc7Endpoint r1 = bc7Quantize(f1);
+			uint8_t refitIndices[16];
+			uint32_t refitError = bc7Indices(block, r0, r1, refitIndices);
+			if (refitError >= error)
+			{
+				break;
+			}
+			e0 = r0;
+			e1 = r1;
+			error = refitError;
+			memcpy(indices, refitIndices, sizeof(indices));
+		}
+
+		// the anchor (texel 0) index is stored with 3 bits: its MSB must be 0
+		if (indices[0] & 8)
+		{
+			std::swap(e0, e1);
+			for (uint8_t& index : indices)
+			{
+				index = uint8_t(15 - index);
+			}
+		}
+
+		memset(out, 0, 16);
+		BitWriter writer{ out };
+		writer.write(1u << 6, 7);    // mode 6
+		for (int c = 0; c < 4; c++)
+		{
+			writer.write(uint32_t(e0.color7[c]), 7);
+			writer.write(uint32_t(e1.color7[c]), 7);
+		}
+		writer.write(uint32_t(e0.pBit), 1);
+		writer.write(uint32_t(e1.pBit), 1);
+		writer.write(indices[0], 3);
+		for (int i = 1; i < 16; i++)
+		{
+			writer.write(indices[i], 4);
+		}
+	}
+
+	// decodes mode 6 only (the only mode encodeBC7 emits); other modes decode as magenta
+	void decodeBC7(const uint8_t* in, uint8_t block[16][4])
+	{
+		BitReader reader{ in };
+		if (reader.read(7) != (1u << 6))
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				block[i][0] = 255; block[i][1] = 0; block[i][2] = 255; block[i][3] = 255;
+			}
+			return;
+		}
+
+		Bc7Endpoint e0{}, e1{};
+		for (int c = 0; c < 4; c++)
+		{
+			e0.color7[c] = int(reader.read(7));
+			e1.color7[c] = int(reader.read(7));
+		}
+		e0.pBit = int(reader.read(1));
+		e1.pBit = int(reader.read(1));
+
+		for (int i = 0; i < 16; i++)
+		{
+			int index = int(reader.read(i == 0 ? 3 : 4));
+			for (int c = 0; c < 4; c++)
+			{
+				block[i][c] = uint8_t(bc7Interpolate(e0.value(c), e1.value(c), index));
+			}
+		}
+	}
+
+	//==================================================================
+
+	void encodeBlock(TextureFormat format, const uint8_t block[16][4], uint8_t* out)
+	{
+		switch (format)
+		{
+		case TextureFormat::BC1:
+			encodeBC1Color(block, out);
+			break;
+		case TextureFormat::BC3:
+			encodeBC4(block, 3, out);
+			encodeBC1Color(block, out + 8);
+			break;
+		case TextureFormat::BC5:
+			encodeBC4(block, 0, out);
+			encodeBC4(block, 1, out + 8);
+			break;
+		case TextureFormat::BC7:
+			encodeBC7(block, out);
+			break;
+		default:
+			throw std::runtime_error("Failed to encode block: not a block-compressed format!");
+		}
+	}
+
+	void decodeBlock(TextureFormat format, const uint8_t* in, uint8_t block[16][4])
+	{
+		switch (format)
+		{
+		case TextureFormat::BC1:
+			decodeBC1Color(in, block);
+			break;
+		case TextureFormat::BC3:
+			decodeBC1Color(in + 8, block);
+			decodeBC4(in, 3, block);
+			break;
+		case TextureFormat::BC5:
+			for (int i = 0; i < 16; i++)
+			{
+				block[i][2] = 0;
+				block[i][3] = 255;
+			}
+			decodeBC4(in, 0, block);
+			decodeBC4(in + 8, 1, block);
+			break;
+		case TextureFormat::BC7:
+			decodeBC7(in, block);
+			break;
+		default:
+			throw std::runtime_error("Failed to decode block: not a block-compressed format!");
+		}
+	}
+}
+
+const char* toString(TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::RGBA8: return "RGBA8";
+	case TextureFormat::BC1:   return "BC1";
+	case TextureFormat::BC3:   return "BC3";
+	case TextureFormat::BC5:   return "BC5";
+	case TextureFormat::BC7:   return "BC7";
+	}
+	return "unknown";
+}
+
+uint32_t CTextureCompressor::getBlockSize(TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::BC1: return 8;
+	case TextureFormat::BC3: return 16;
+	case TextureFormat::BC5: return 16;
+	case TextureFormat::BC7: return 16;
+	default:                 return 0;
+	}
+}
+
+TextureData CTextureCompressor::compress(const TextureData& source, TextureFormat format)
+{
+	if (source.format != TextureFormat::RGBA8)
+	{
+		throw std::runtime_error("Failed to compress texture: source is already compressed: " + source.path);
+	}
+
+	uint32_t blockSize = getBlockSize(format);
+	if (blockSize == 0)
+	{
+		return source;
+	}
+
+	// BCn textures cannot be blitted on the GPU, so the whole chain has to exist here
+	const TextureData* input = &source;
+	TextureData withMips;
+	if (source.hasCpuMips() == false)
+	{
+		withMips = source;
+		CTextureLoader::generateMipChain(withMips, MipFilter::Box);
+		input = &withMips;
+	}
+
+	TextureData result;
+	result.path = source.path;
+	result.format = format;
+	result.width = source.width;
+	result.height = source.height;
+	result.mipLevels = source.mipLevels;
+
+	size_t totalSize = 0;
+	for (const TextureMip& mip : input->mips)
+	{
+		size_t blocks = size_t((mip.width + 3) / 4) * ((mip.height + 3) / 4);
+		result.mips.push_back({ totalSize, blocks * blockSize, mip.width, mip.height });
+		totalSize += blocks * blockSize;
+	}
+	result.pixels.resize(totalSize);
+
+	uint8_t block[16][4];
+	for (uint32_t level = 0; level < result.mipLevels; level++)
+	{
+		const TextureMip& src = input->mips[level];
+		const TextureMip& dst = result.mips[level];
+		uint32_t blocksX = (src.width + 3) / 4;
+		uint32_t blocksY = (src.height + 3) / 4;
+
+		uint8_t* out = &result.pixels[dst.offset];
+		for (uint32_t by = 0; by < blocksY; by++)
+		{
+			for (uint32_t bx = 0; bx < blocksX; bx++)
+			{
+				fetchBlock(&input->pixels[src.offset], src.width, src.height, bx, by, block);
+				encodeBlock(format, block, out);
+				out += blockSize;
+			}
+		}
+	}
+	return result;
+}
+
+std::vector<uint8_t> CTextureCompressor::decompressLevel(const TextureData& tex, uint32_t level)
+{
+	const TextureMip& mip = tex.mips.at(level);
+	if (tex.format == TextureFormat::RGBA8)
+	{
+		return std::vector<uint8_t>(tex.pixels.begin() + mip.offset, tex.pixels.begin() + mip.offset + mip.size);
+	}
+
+	uint32_t blockSize = getBlockSize(tex.format);
+	uint32_t blocksX = (mip.width + 3) / 4;
+	uint32_t blocksY = (mip.height + 3) / 4;
+
+	std::vector<uint8_t> rgba(size_t(mip.width) * mip.height * 4);
+	uint8_t block[16][4];
+	const uint8_t* in = &tex.pixels[mip.offset];
+	for (uint32_t by = 0; by < blocksY; by++)
+	{
+		for (uint32_t bx = 0; bx < blocksX; bx++)
+		{
+			decodeBlock(tex.format, in, block);
+			storeBlock(block, rgba.data(), mip.width, mip.height, bx, by);
+			in += blockSize;
+		}
+	}
+	return rgba;
+}
+
+void CTextureCompressor::benchmark(const std::vector<std::string>& paths)
+{
+	const TextureFormat formats[] = { TextureFormat::BC1, TextureFormat::BC3, TextureFormat::BC5, TextureFormat::BC7 };
+
+	printf("Block compression benchmark (all mips encoded, PSNR of level 0)\n");
+	printf("%-32s %6s %10s %10s %10s %8s %10s\n", "texture", "format", "encode ms", "MTexel/s", "size KB", "ratio", "PSNR dB");
+
+	for (const std::string& path : paths)
+	{
+		TextureData source = CTextureLoader::decode(path, MipFilter::Box);
+
+		double texels = 0.0;
+		for (const TextureMip& mip : source.mips)
+		{
+			texels += double(mip.width) * mip.height;
+		}
+
+		for (TextureFormat format : formats)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			TextureData compressed = compress(source, format);
+			auto end = std::chrono::high_resolution_clock::now();
+			double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+			// BC1 has no alpha and BC5 only stores red and green
+			int channels = (format == TextureFormat::BC5) ? 2 : (format == TextureFormat::BC1) ? 3 : 4;
+
+			std::vector<uint8_t> decoded = decompressLevel(compressed, 0);
+			double squaredError = 0.0;
+			for (size_t i = 0; i < decoded.size(); i += 4)
+			{
+				for (int c = 0; c < channels; c++)
+				{
+					double d = double(decoded[i + c]) - double(source.pixels[i + c]);
+					squaredError += d * d;
+				}
+			}
+			double mse = squaredError / (double(source.width) * source.height * channels);
+			double psnr = (mse > 0.0) ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+
+			printf("%-32s %6s %10.2f %10.2f %10.1f %7.1f:1 %10.2f\n",
+				path.c_str(), toString(format), ms, texels / (ms * 1000.0),
+				compressed.pixels.size() / 1024.0, double(source.pixels.size()) / compressed.pixels.size(), psnr);
+		}
+	}
+}
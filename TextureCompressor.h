@@ -0,0 +1,35 @@
+/*======================================================================
+VulkanPBR_AcornForest : TextureCompressor.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+CPU block compression (BC1 / BC3 / BC5 / BC7) of decoded RGBA8 textures.
+Every mip level is encoded, so the GPU never has to build mips for a
+compressed texture. Results are stored in the texture cache
+(TextureCache.h) so the encoder normally only runs once per asset.
+=======================================================================*/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "TextureLoader.h"
+
+class CTextureCompressor
+{
+public:
+
+	// bytes per 4x4 block; 0 for the uncompressed RGBA8 format
+	static uint32_t getBlockSize(TextureFormat format);
+
+	// Encodes every mip level of an RGBA8 texture. A box-filtered mip chain
+	// is generated first if the source only has level 0.
+	static TextureData compress(const TextureData& source, TextureFormat format);
+
+	// decodes one mip level back to RGBA8 (quality checks only, not used for rendering)
+	static std::vector<uint8_t> decompressLevel(const TextureData& tex, uint32_t level);
+
+	// headless benchmark: encode time, size and PSNR of level 0 for each format
+	static void benchmark(const std::vector<std::string>& paths);
+};
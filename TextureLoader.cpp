@@ -0,0 +1,389 @@
+/*======================================================================
+VulkanPBR_AcornForest : TextureLoader.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Mip filtering is done in linear space: texels are converted from sRGB
+with a lookup table, filtered as four floats (one SSE register per texel
+where available) and converted back. Alpha is filtered as-is.
+=======================================================================*/
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "TextureLoader.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "TextureCache.h"
+#include "TextureCompressor.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TEXTURE_LOADER_SSE2 1
+#endif
+
+namespace
+{
+	// sRGB <-> linear conversion tables (built once, thread-safe static init)
+	struct SrgbTables
+	{
+		float   toLinear[256];
+		uint8_t toSrgb[4096];    // indexed by linear value * 4095
+
+		SrgbTables()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				float c = i / 255.0f;
+				toLinear[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			for (int i = 0; i < 4096; i++)
+			{
+				float l = i / 4095.0f;
+				float c = (l <= 0.0031308f) ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+				toSrgb[i] = static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, c * 255.0f + 0.5f)));
+			}
+		}
+	};
+
+	const SrgbTables& getSrgbTables()
+	{
+		static const SrgbTables tables;
+		return tables;
+	}
+
+	// one RGBA texel in linear float space
+#ifdef TEXTURE_LOADER_SSE2
+	struct Float4 { __m128 v; };
+
+	inline Float4 zero4() { return { _mm_setzero_ps() }; }
+	inline Float4 add4(Float4 a, Float4 b) { return { _mm_add_ps(a.v, b.v) }; }
+	inline Float4 mad4(Float4 a, float w, Float4 acc) { return { _mm_add_ps(acc.v, _mm_mul_ps(a.v, _mm_set1_ps(w))) }; }
+	inline Float4 scale4(Float4 a, float s) { return { _mm_mul_ps(a.v, _mm_set1_ps(s)) }; }
+	inline Float4 saturate4(Float4 a) { return { _mm_min_ps(_mm_max_ps(a.v, _mm_setzero_ps()), _mm_set1_ps(1.0f)) }; }
+	inline void   store4(Float4 a, float* out) { _mm_storeu_ps(out, a.v); }
+
+	inline Float4 loadTexel(const uint8_t* texel, const SrgbTables& tables)
+	{
+		return { _mm_set_ps(texel[3] * (1.0f / 255.0f), tables.toLinear[texel[2]], tables.toLinear[texel[1]], tables.toLinear[texel[0]]) };
+	}
+#else
+	struct Float4 { float v[4]; };
+
+	inline Float4 zero4() { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+	inline Float4 add4(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+	inline Float4 mad4(Float4 a, float w, Float4 acc) { for (int i = 0; i < 4; i++) acc.v[i] += a.v[i] * w; return acc; }
+	inline Float4 scale4(Float4 a, float s) { for (int i = 0; i < 4; i++) a.v[i] *= s; return a; }
+	inline Float4 saturate4(Float4 a) { for (int i = 0; i < 4; i++) a.v[i] = std::min(1.0f, std::max(0.0f, a.v[i])); return a; }
+	inline void   store4(Float4 a, float* out) { std::memcpy(out, a.v, sizeof(a.v)); }
+
+	inline Float4 loadTexel(const uint8_t* texel, const SrgbTables& tables)
+	{
+		return { { tables.toLinear[texel[0]], tables.toLinear[texel[1]], tables.toLinear[texel[2]], texel[3] * (1.0f / 255.0f) } };
+	}
+#endif
+
+	inline void storeTexel(Float4 value, uint8_t* texel, const SrgbTables& tables)
+	{
+		float f[4];
+		store4(saturate4(value), f);
+		texel[0] = tables.toSrgb[static_cast<int>(f[0] * 4095.0f + 0.5f)];
+		texel[1] = tables.toSrgb[static_cast<int>(f[1] * 4095.0f + 0.5f)];
+		texel[2] = tables.toSrgb[static_cast<int>(f[2] * 4095.0f + 0.5f)];
+		texel[3] = static_cast<uint8_t>(f[3] * 255.0f + 0.5f);
+	}
+
+	// 2x2 box filter; odd edges reuse the last row/column (same footprint as vkCmdBlitImage)
+	void downsampleBox(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight)
+	{
+		const SrgbTables& tables = getSrgbTables();
+
+		for (uint32_t y = 0; y < dstHeight; y++)
+		{
+			const uint8_t* row0 = src + size_t(std::min(2 * y, srcHeight - 1)) * srcWidth * 4;
+			const uint8_t* row1 = src + size_t(std::min(2 * y + 1, srcHeight - 1)) * srcWidth * 4;
+
+			for (uint32_t x = 0; x < dstWidth; x++)
+			{
+				uint32_t x0 = std::min(2 * x, srcWidth - 1) * 4;
+				uint32_t x1 = std::min(2 * x + 1, srcWidth - 1) * 4;
+
+				Float4 sum = add4(add4(loadTexel(row0 + x0, tables), loadTexel(row0 + x1, tables)),
+					add4(loadTexel(row1 + x0, tables), loadTexel(row1 + x1, tables)));
+
+				storeTexel(scale4(sum, 0.25f), dst + (size_t(y) * dstWidth + x) * 4, tables);
+			}
+		}
+	}
+
+	// 6-tap Kaiser-windowed sinc weights for a 2:1 decimation
+	// taps sit at 0.25, 0.75 and 1.25 destination texels from the sample centre
+	struct KaiserKernel
+	{
+		float weights[6];
+
+		KaiserKernel()
+		{
+			const float beta = 4.0f;      // window shape
+			const float radius = 1.5f;    // window half-width in destination texels
+			const float pi = 3.14159265f;
+
+			auto besselI0 = [](float x)
+			{
+				float sum = 1.0f, term = 1.0f;
+				for (int k = 1; k < 16; k++)
+				{
+					term *= (x / (2.0f * k)) * (x / (2.0f * k));
+					sum += term;
+				}
+				return sum;
+			};
+
+			const float distances[3] = { 1.25f, 0.75f, 0.25f };
+			float total = 0.0f;
+			for (int i = 0; i < 3; i++)
+			{
+				float d = distances[i];
+				float sinc = std::sin(pi * d) / (pi * d);
+				float ratio = d / radius;
+				float window = besselI0(beta * std::sqrt(1.0f - ratio * ratio)) / besselI0(beta);
+				weights[i] = weights[5 - i] = sinc * window;
+				total += 2.0f * weights[i];
+			}
+			for (float& w : weights)
+			{
+				w /= total;
+			}
+		}
+	};
+
+	void downsampleKaiser(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight)
+	{
+		static const KaiserKernel kernel;
+		const SrgbTables& tables = getSrgbTables();
+
+		// horizontal pass: srcHeight rows of dstWidth linear texels
+		std::vector<Float4> temp(size_t(dstWidth) * srcHeight);
+		for (uint32_t y = 0; y < srcHeight; y++)
+		{
+			const uint8_t* row = src + size_t(y) * srcWidth * 4;
+			for (uint32_t x = 0; x < dstWidth; x++)
+			{
+				Float4 acc = zero4();
+				for (int t = 0; t < 6; t++)
+				{
+					int sx = std::min(std::max(int(2 * x) - 2 + t, 0), int(srcWidth) - 1);
+					acc = mad4(loadTexel(row + sx * 4, tables), kernel.weights[t], acc);
+				}
+				temp[size_t(y) * dstWidth + x] = acc;
+			}
+		}
+
+		// vertical pass
+		for (uint32_t y = 0; y < dstHeight; y++)
+		{
+			for (uint32_t x = 0; x < dstWidth; x++)
+			{
+				Float4 acc = zero4();
+				for (int t = 0; t < 6; t++)
+				{
+					int sy = std::min(std::max(int(2 * y) - 2 + t, 0), int(srcHeight) - 1);
+					acc = mad4(temp[size_t(sy) * dstWidth + x], kernel.weights[t], acc);
+				}
+				storeTexel(acc, dst + (size_t(y) * dstWidth + x) * 4, tables);
+			}
+		}
+	}
+}
+
+const char* toString(MipFilter filter)
+{
+	switch (filter)
+	{
+	case MipFilter::None:   return "GPU";
+	case MipFilter::Box:    return "CPU box";
+	case MipFilter::Kaiser: return "CPU kaiser";
+	}
+	return "unknown";
+}
+
+uint32_t CTextureLoader::calculateMipLevels(uint32_t width, uint32_t height)
+{
+	// floor(log2(max(w, h))) + 1: level 0 is the texture itself
+	return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+}
+
+TextureData CTextureLoader::decode(const std::string& path, MipFilter filter)
+{
+	int texWidth, texHeight, texChannels;
+
+	// STBI_rgb_alpha: add an alpha channel if the file has none
+	stbi_uc* pixels = stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+	if (!pixels)
+	{
+		throw std::runtime_error("Failed to load texture image: " + path);
+	}
+
+	TextureData tex;
+	tex.path = path;
+	tex.width = static_cast<uint32_t>(texWidth);
+	tex.height = static_cast<uint32_t>(texHeight);
+	tex.mipLevels = calculateMipLevels(tex.width, tex.height);
+
+	size_t baseSize = size_t(tex.width) * tex.height * 4;
+	tex.pixels.assign(pixels, pixels + baseSize);
+	tex.mips.push_back({ 0, baseSize, tex.width, tex.height });
+	stbi_image_free(pixels);
+
+	if (filter != MipFilter::None)
+	{
+		generateMipChain(tex, filter);
+	}
+	return tex;
+}
+
+TextureData CTextureLoader::load(const std::string& path, MipFilter filter, TextureFormat format)
+{
+	PROFILE_SCOPE("CTextureLoader::load");
+
+	if (format == TextureFormat::RGBA8)
+	{
+		return decode(path, filter);
+	}
+
+	// block-compressed textures always carry a CPU-built mip chain
+	MipFilter cpuFilter = (filter == MipFilter::None) ? MipFilter::Box : filter;
+
+	TextureData tex;
+	if (CTextureCache::load(path, format, cpuFilter, tex))
+	{
+		return tex;
+	}
+
+	tex = CTextureCompressor::compress(decode(path, cpuFilter), format);
+	CTextureCache::store(tex, cpuFilter);
+	return tex;
+}
+
+std::vector<TextureData> CTextureLoader::decodeBatch(const std::vector<std::string>& paths, MipFilter filter, CJobSystem& jobSystem,
+	TextureFormat format)
+{
+	std::vector<TextureData> textures(paths.size());
+	std::vector<std::exception_ptr> errors(paths.size());
+
+	jobSystem.parallelFor(static_cast<uint32_t>(paths.size()), 1, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			try
+			{
+				textures[i] = load(paths[i], filter, format);
+			}
+			catch (...)
+			{
+				errors[i] = std::current_exception();    // rethrown on the calling thread below
+			}
+		}
+	});
+
+	for (const std::exception_ptr& error : errors)
+	{
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
+	return textures;
+}
+
+void CTextureLoader::generateMipChain(TextureData& tex, MipFilter filter)
+{
+	// compute the final layout first so pixels is resized only once
+	tex.mips.resize(1);
+	size_t totalSize = tex.mips[0].size;
+	uint32_t mipWidth = tex.width;
+	uint32_t mipHeight = tex.height;
+	for (uint32_t level = 1; level < tex.mipLevels; level++)
+	{
+		mipWidth = mipWidth > 1 ? mipWidth / 2 : 1;
+		mipHeight = mipHeight > 1 ? mipHeight / 2 : 1;
+
+		size_t size = size_t(mipWidth) * mipHeight * 4;
+		tex.mips.push_back({ totalSize, size, mipWidth, mipHeight });
+		totalSize += size;
+	}
+	tex.pixels.resize(totalSize);
+
+	for (uint32_t level = 1; level < tex.mipLevels; level++)
+	{
+		const TextureMip& src = tex.mips[level - 1];
+		const TextureMip& dst = tex.mips[level];
+
+		if (filter == MipFilter::Kaiser)
+		{
+			downsampleKaiser(&tex.pixels[src.offset], src.width, src.height, &tex.pixels[dst.offset], dst.width, dst.height);
+		}
+		else
+		{
+			downsampleBox(&tex.pixels[src.offset], src.width, src.height, &tex.pixels[dst.offset], dst.width, dst.height);
+		}
+	}
+}
+
+void CTextureLoader::benchmark(const std::vector<std::string>& paths, uint32_t copies, uint32_t maxThreads, MipFilter filter)
+{
+	std::vector<std::string> batch;
+	for (uint32_t i = 0; i < copies; i++)
+	{
+		batch.push_back(paths[i % paths.size()]);
+	}
+
+	if (maxThreads == 0)
+	{
+		maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	printf("Texture load benchmark: %u textures, mips: %s\n", copies, toString(filter));
+	printf("%8s %12s %12s %10s\n", "threads", "wall (ms)", "MTexel/s", "speedup");
+
+	// 1, 2, 4, ... and finally maxThreads itself
+	std::vector<uint32_t> threadCounts;
+	for (uint32_t threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	double singleThreadMs = 0.0;
+	for (uint32_t threads : threadCounts)
+	{
+		CJobSystem jobSystem(threads - 1);    // the calling thread is the remaining worker
+
+		auto start = std::chrono::high_resolution_clock::now();
+		std::vector<TextureData> textures = decodeBatch(batch, filter, jobSystem);
+		auto end = std::chrono::high_resolution_clock::now();
+
+		double ms = std::chrono::duration<double, std::milli>(end - start).count();
+		if (threads == 1)
+		{
+			singleThreadMs = ms;
+		}
+
+		double texels = 0.0;
+		for (const TextureData& tex : textures)
+		{
+			texels += double(tex.width) * tex.height;
+		}
+		printf("%8u %12.2f %12.2f %9.2fx\n", threads, ms, texels / (ms * 1000.0), singleThreadMs / ms);
+	}
+}
@@ -0,0 +1,87 @@
+/*======================================================================
+VulkanPBR_AcornForest : TextureLoader.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+CPU side of the texture pipeline: PNG/JPG decode (stb_image) and
+optional mip chain generation, run in parallel on the job system.
+Nothing in here touches Vulkan, so it can be benchmarked headless.
+The GPU upload lives in CVulkanFramework::uploadTextures().
+=======================================================================*/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CJobSystem;
+
+// CPU mipmap filter. None leaves mip generation to the GPU (compute shader or vkCmdBlitImage).
+enum class MipFilter
+{
+	None,
+	Box,       // 2x2 average in linear space
+	Kaiser     // separable 6-tap Kaiser-windowed sinc, sharper than Box
+};
+
+// storage format of TextureData::pixels
+// RGBA8 is VK_FORMAT_R8G8B8A8_SRGB; the BCn formats are encoded by CTextureCompressor
+enum class TextureFormat
+{
+	RGBA8,
+	BC1,       // RGB, 8 bytes per 4x4 block (sRGB)
+	BC3,       // RGBA, 16 bytes per block (sRGB)
+	BC5,       // two channels (RG), 16 bytes per block, for normal maps
+	BC7        // RGBA, 16 bytes per block (sRGB), best quality
+};
+
+// one mip level inside TextureData::pixels
+struct TextureMip
+{
+	size_t   offset;
+	size_t   size;
+	uint32_t width;
+	uint32_t height;
+};
+
+// decoded RGBA8 (sRGB) texture with all of its mip levels tightly packed
+struct TextureData
+{
+	std::string              path;
+	TextureFormat            format = TextureFormat::RGBA8;
+	uint32_t                 width = 0;
+	uint32_t                 height = 0;
+	uint32_t                 mipLevels = 1;    // full chain length, even if only level 0 is in pixels
+	std::vector<uint8_t>     pixels;
+	std::vector<TextureMip>  mips;             // CPU-generated levels; size() == 1 when the GPU builds the mips
+
+	bool hasCpuMips() const { return mips.size() == mipLevels; }
+};
+
+class CTextureLoader
+{
+public:
+
+	static uint32_t calculateMipLevels(uint32_t width, uint32_t height);
+
+	// decodes one file (and builds its mips unless filter == None). Throws on failure.
+	static TextureData decode(const std::string& path, MipFilter filter);
+
+	// Returns the texture in the requested format. Block-compressed formats are read
+	// from the texture cache when it is up to date, otherwise decoded, encoded and cached.
+	static TextureData load(const std::string& path, MipFilter filter, TextureFormat format);
+
+	// loads every file on the job system; output order matches paths
+	static std::vector<TextureData> decodeBatch(const std::vector<std::string>& paths, MipFilter filter, CJobSystem& jobSystem,
+		TextureFormat format = TextureFormat::RGBA8);
+
+	// appends mip levels 1..N to tex.pixels, downsampling from level 0
+	static void generateMipChain(TextureData& tex, MipFilter filter);
+
+	// headless benchmark: decodes paths (repeated to copies entries) with 1..maxThreads workers
+	// and prints total wall time per thread count
+	static void benchmark(const std::vector<std::string>& paths, uint32_t copies, uint32_t maxThreads, MipFilter filter);
+};
+
+const char* toString(MipFilter filter);
+const char* toString(TextureFormat format);
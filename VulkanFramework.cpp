@@ -64,10 +64,8 @@ Current Benchmark: Vulkan ImGui Implementation
 #include "VulkanFramework.h"
 
 //#define TINYGLTF_IMPLEMENTATION
-#define STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include <stb_image.h>
 //#include "tiny_gltf.h"
+// stb_image̎TextureLoader.cppɈړ܂  stb_image implementation now lives in TextureLoader.cpp
 
 #define TINYOBJLOADER_IMPLEMENTATION        // tinyobjloaderfǂݍ
 #include <tiny_obj_loader.h>
@@ -95,19 +93,45 @@ Current Benchmark: Vulkan ImGui Implementation
 #include <algorithm>    // std::min/max : chooseSwapExtent()
 #include <cstdint>      // UINT32_MAX   : in chooseSwapExtent()
 #include <stdexcept>    // std::runtime errorAȂ
+#include <exception>    // std::exception_ptr : [J[Xbh̗OĂяoōăX[
 #include <cstdlib>      // EXIT_SUCCESSEEXIT_FAILURE : main()
 #include <fstream>      // VF[_[̃oCif[^ǂݍށ@for loading shader binary data
+#include <cstdio>       // printf : x`}[No  benchmark tables
+#include <thread>       // std::thread : t[y[VOx`}[N
+#include <atomic>
+#include <cmath>        // std::fmod : fEz̉]
 #include <glm/glm.hpp>  // glm::vec2, vec3 : Vertex\
 
 const uint32_t WIDTH = 1920;
 const uint32_t HEIGHT = 1080;
 
 const std::string MODEL_PATH = "Asset/Model/viking_room.obj";
-const std::string TEXTURE_PATH = "Asset/Texture/viking_room.png";
+const std::vector<std::string> TEXTURE_PATHS =
+{
+	"Asset/Texture/viking_room.png"
+};
+
+// CPŨeNX`[tH[}bg -> VkFormat
+// BCn formats are stored as sRGB except BC5, which holds two linear channels (normal maps)
+VkFormat toVkFormat(TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::BC1: return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+	case TextureFormat::BC3: return VK_FORMAT_BC3_SRGB_BLOCK;
+	case TextureFormat::BC5: return VK_FORMAT_BC5_UNORM_BLOCK;
+	case TextureFormat::BC7: return VK_FORMAT_BC7_SRGB_BLOCK;
+	default:                 return VK_FORMAT_R8G8B8A8_SRGB;
+	}
+}
 
 // ɏt[̍ő吔 
 // how many frames should be processed concurrently 
-const int MAX_FRAMES_IN_FLIGHT = 2;		
+const uint32_t MAX_FRAMES_IN_FLIGHT = 4;    // --frames-in-flight̏  upper bound for --frames-in-flight
+
+// oChXeNX`[z̏ifoCX̐łɏȂꍇj
+// upper bound of the bindless texture array; clamped further by the device limits
+const uint32_t MAX_BINDLESS_TEXTURES = 4096;		
 
 // Vulkañof[VC[FSDK̃G[`FbNdg
 // Vulkan Validation layers: SDK's own error checking implementation
@@ -273,10 +297,63 @@ const bool enableValidationLayers = true;
 
 void CVulkanFramework::run()
 {
-	initWindow();
+	// --profile: NCPU][L^AIChrome Trace JSONƂďo܂
+	// --profile: record CPU zones from startup on, written as Chrome Trace JSON at exit
+	CProfiler::setThreadName("Main");
+	CProfiler::setEnabled(m_Config.profilePath.empty() == false);
+
+	m_JobSystem = std::make_unique<CJobSystem>(m_Config.workerThreads);    // [J[XbhN
+	m_StartupTimeline.start();
+
+	startupStep("initWindow", [this]() { initWindow(); });
 	initVulkan();
-	mainLoop();
+
+	if (m_Config.startupTimeline)
+	{
+		m_StartupTimeline.print();
+	}
+
+	// x`}[N[hFʂo͂ďI
+	if (m_Config.benchMipGen)
+	{
+		benchmarkMipGeneration();
+	}
+	else if (m_Config.benchLatency)
+	{
+		benchmarkFramePacing();
+	}
+	else if (m_Config.benchLights)
+	{
+		benchmarkLights();
+	}
+	else if (m_Config.benchPrepass)
+	{
+		benchmarkDepthPrepass();
+	}
+	else if (m_Config.benchDraws)
+	{
+		benchmarkDrawSorting();
+	}
+	else if (m_Config.benchImpostors)
+	{
+		benchmarkImpostors();
+	}
+	else
+	{
+		mainLoop();
+	}
+
+	if (m_Config.memoryReportPath.empty() == false)
+	{
+		m_MemoryTracker.writeJson(m_Config.memoryReportPath, m_DeviceProperties.deviceName);    // Ĩ[|[gis[N܂ށj
+	}
 	cleanup();
+
+	if (m_Config.profilePath.empty() == false)
+	{
+		uint32_t zones = CProfiler::writeChromeTrace(m_Config.profilePath);
+		printf("Profiler: %u zones written to %s (open in ui.perfetto.dev)\n", zones, m_Config.profilePath.c_str());
+	}
 }
 
 // C[v
@@ -285,9 +362,7 @@ void CVulkanFramework::mainLoop()
 
 	while (glfwWindowShouldClose(m_Window) == false)
 	{
-		glfwPollEvents();    // Cxgҋ@  Update/event checker
-		drawFrame();         // t[`
-		drawImGuiFrame();
+		runFrame();
 	}
 
 	// vOIiЕtj̑OɁAɓĂ鏈ς܂܂B
@@ -315,41 +390,134 @@ void CVulkanFramework::initWindow()
 }
 
 // Vulkan
+// ˑ֌ŴȂXebv̓[J[XbhŕɎs܂F
+//   OBJ͍͂ŏAeNX`[fR[hBCnΉmFipickPhysicalDeviceǰA
+//   pCvCiOtBbNXE~bv}bvpRs[gj̓foCXƃCAEgł
+// CXbh͂̊ԂɃfoCXEXbv`F[EA^b`gpӂAʂKvɂȂ钼Oő҂܂
+// Initialization as a dependency graph: steps that do not need each other run on the worker pool.
+//   OBJ parsing starts immediately, texture decode once BCn support is known (pickPhysicalDevice),
+//   pipelines (graphics and mip compute) once the device and layouts exist. The main thread brings up
+//   the device, swapchain and attachments meanwhile, and only waits right before a result is needed.
 void CVulkanFramework::initVulkan()
 {
-	createInstance();			    // CX^X			
-	setupDebugMessenger();          // fobOR[obNݒ
-	createSurface();                // EChET[tFX
-	pickPhysicalDevice();           // VulkanΏۃOtBbNXJ[h̑I
-	createLogicalDevice();          // OtBbNXJ[hƃC^[tF[XfoCXݒ
-	createSwapChain();              // SwapChain
-	createImageViews();             // SwapChainp̉摜r[
-	createRenderPass();             // _[pX
-	createDescriptorSetLayout();    // \[XŃXNv^[CAEg 
-	createGraphicsPipeline();       // OtBbNXpCvC
-	createColorResources();         // J[\[XiMSAA)
-	createDepthResources();         // fvX\[X
-	createFramebuffers();           // t[obt@ifvX\[X̌j
-	createCommandPool(m_CommandPool, 0);    // R}hobt@[i[v[𐶐     
-	createTextureImage();           // eNX`[}bsOp摜
-	createTextureImageView();       // eNX`[ANZX邽߂̃C[Wr[
-	createTextureSampler();         // eNX`[Tv[
-	loadModel();                    // ff[^ǂݍ
-	createVertexBuffer();           // _obt@[
-	createIndexBuffer();		    // CfbNXobt@[
-	createUniformBuffers();         // jtH[obt@[
-	createDescriptorPool();         // fXNv^[Zbgi[v[𐶐
-	createDescriptorSets();         // fXNv^[Zbg𐶐
-	createCommandBuffers();         // R}hobt@[
-	createSyncObjects();            // IuWFNg
-
-	// ImGui
-	createImGuiRenderPass();
-	createImGuiDescriptorPool();
-	initImGui();
-	createImGuiFramebuffers();
-	createCommandPool(m_ImGuiCommandPool, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
-	allocateImGuiCommandBuffers();
+	try
+	{
+		JobHandle modelJob = submitStartupJob("loadModel", [this]() { loadModel(); });    // ff[^ǂݍ
+		JobHandle environmentJob = submitStartupJob("loadEnvironmentLighting", [this]() { loadEnvironmentLighting(); });    // IBLLbVE}bv
+
+		startupStep("createInstance", [this]() { createInstance(); });                  // CX^X
+		startupStep("setupDebugMessenger", [this]() { setupDebugMessenger(); });        // fobOR[obNݒ
+		startupStep("createSurface", [this]() { createSurface(); });                    // EChET[tFX
+		startupStep("pickPhysicalDevice", [this]() { pickPhysicalDevice(); });          // VulkanΏۃOtBbNXJ[h̑I
+
+		JobHandle decodeJob = submitStartupJob("decodeTextures", [this]() { decodeTextures(); });    // fR[hECPU~bvEBCn
+
+		startupStep("createLogicalDevice", [this]() { createLogicalDevice(); });        // OtBbNXJ[hƃC^[tF[XfoCXݒ
+
+		JobHandle mipGenJob = submitStartupJob("createMipGenerator", [this]() { createMipGenerator(); });    // ~bv}bvpRs[gpCvC
+		JobHandle iblBakerJob = submitStartupJob("createIblBaker", [this]() { createIblBaker(); });          // IBLxCNpRs[gpCvC
+		JobHandle lightCullerJob = submitStartupJob("createLightCuller", [this]() { createLightCuller(); });    // CgU蕪pRs[gpCvC
+		JobHandle shadowPassJob = submitStartupJob("createShadowPass", [this]() { createShadowPass(); });    // epfvXpCvC
+
+		startupStep("createSwapChain", [this]() { createSwapChain(); });                // SwapChain
+		startupStep("createImageViews", [this]() { createImageViews(); });              // SwapChainp̉摜r[
+		startupStep("createRenderPass", [this]() { createRenderPass(); });              // _[pX
+		startupStep("createDescriptorSetLayout", [this]() { createDescriptorSetLayout(); });    // \[XŃXNv^[CAEg
+
+		JobHandle pipelineJob = submitStartupJob("createGraphicsPipeline", [this]() { createGraphicsPipeline(); });    // OtBbNXpCvC
+
+		startupStep("createColorResources", [this]() { createColorResources(); });      // J[\[XiMSAA)
+		startupStep("createDepthResources", [this]() { createDepthResources(); });      // fvX\[X
+		startupStep("createFramebuffers", [this]() { createFramebuffers(); });          // t[obt@ifvX\[X̌j
+		startupStep("createCommandPool", [this]() { createCommandPool(m_CommandPool, 0); });    // R}hobt@[i[v[𐶐
+		startupStep("createUniformBuffers", [this]() { createUniformBuffers(); });      // jtH[obt@[
+		startupStep("createDescriptorPool", [this]() { createDescriptorPool(); });      // fXNv^[Zbgi[v[𐶐
+
+		waitStartupJob(decodeJob);
+		waitStartupJob(mipGenJob);
+		startupStep("createTextureImage", [this]() { createTextureImage(); });          // eNX`[̃Abv[hi~bv}bv܂ށj
+		startupStep("createTextureImageView", [this]() { createTextureImageView(); });  // eNX`[ANZX邽߂̃C[Wr[
+		startupStep("createTextureSampler", [this]() { createTextureSampler(); });      // eNX`[Tv[
+
+		waitStartupJob(environmentJob);
+		waitStartupJob(iblBakerJob);
+		startupStep("createEnvironmentLighting", [this]() { createEnvironmentLighting(); });    // IBLeNX`[iLbV̓xCNj
+		waitStartupJob(lightCullerJob);
+		startupStep("createLightBuffers", [this]() { createLightBuffers(); });          // CgENX^[obt@[iGPUCPUU蕪j
+		waitStartupJob(shadowPassJob);
+		startupStep("createShadowMap", [this]() { createShadowMap(); });                // VhEJXP[h̃fvXz
+		startupStep("createDescriptorSets", [this]() { createDescriptorSets(); });      // fXNv^[Zbg𐶐
+		startupStep("createBindlessDescriptors", [this]() { createBindlessDescriptors(); });    // oChXeNX`[zE}eA
+
+		waitStartupJob(modelJob);
+		startupStep("createVertexBuffer", [this]() { createVertexBuffer(); });          // _obt@[
+		startupStep("createShadowCasters", [this]() { createShadowCasters(); });        // CfbNXep`Nɕבւ
+		startupStep("createSceneGraph", [this]() { createSceneGraph(); });              // gXtH[Kw
+		startupStep("createForest", [this]() { createForest(); });                      // X̖؂̔zuif̃CX^Xj
+		startupStep("createInstanceBuffer", [this]() { createInstanceBuffer(); });      // CX^Xobt@[
+		startupStep("createIndexBuffer", [this]() { createIndexBuffer(); });            // CfbNXobt@[
+		startupStep("createImpostors", [this]() { createImpostors(); });                // C|X^[AgX̃xCNiXꍇj
+
+		waitStartupJob(pipelineJob);
+		startupStep("createCommandBuffers", [this]() { createCommandBuffers(); });      // R}hobt@[
+		startupStep("createSyncObjects", [this]() { createSyncObjects(); });            // IuWFNg
+
+		// ImGui
+		startupStep("initImGui", [this]()
+		{
+			createImGuiRenderPass();
+			createImGuiDescriptorPool();
+			initImGui();
+			createImGuiFramebuffers();
+			createCommandPool(m_ImGuiCommandPool, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+			allocateImGuiCommandBuffers();
+		});
+	}
+	catch (...)
+	{
+		m_JobSystem->waitIdle();    // s̃WuthisQƂĂ̂ŏI҂  running jobs still reference this
+		throw;
+	}
+}
+
+// NXebvCXbhŎsA^CCɋL^܂
+void CVulkanFramework::startupStep(const char* name, const std::function<void()>& step)
+{
+	PROFILE_SCOPE(name);
+	m_StartupTimeline.run(name, step);
+}
+
+// NXebv[J[XbhŎs܂BOwaitStartupJob()ŃCXbhɍăX[܂
+// runs a startup step on the worker pool; its exception is rethrown on the main thread by waitStartupJob()
+JobHandle CVulkanFramework::submitStartupJob(const char* name, std::function<void()> step, const std::vector<JobHandle>& dependencies)
+{
+	return m_JobSystem->submit([this, name, step]()
+	{
+		try
+		{
+			PROFILE_SCOPE(name);
+			m_StartupTimeline.run(name, step);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(m_StartupErrorMutex);
+			if (m_StartupError == nullptr)
+			{
+				m_StartupError = std::current_exception();
+			}
+		}
+	}, dependencies);
+}
+
+void CVulkanFramework::waitStartupJob(const JobHandle& job)
+{
+	m_JobSystem->wait(job);
+
+	std::lock_guard<std::mutex> lock(m_StartupErrorMutex);
+	if (m_StartupError)
+	{
+		std::rethrow_exception(m_StartupError);
+	}
 }
 
 // VulkanCX^X Create Vulkan Instance
@@ -366,7 +534,7 @@ void CVulkanFramework::createInstance()
 	appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 	appInfo.pEngineName = "No Engine";
 	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-	appInfo.apiVersion = VK_API_VERSION_1_0;
+	appInfo.apiVersion = VK_API_VERSION_1_2;    // 1.1: VK_IMAGE_CREATE_EXTENDED_USAGE_BIT, 1.2: descriptor indexing
 
 	VkInstanceCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -429,6 +597,7 @@ void CVulkanFramework::pickPhysicalDevice()
 		if (isDeviceSuitable(device) == true)
 		{
 			m_PhysicalDevice = device;
+			queryDeviceProperties();
 			m_MSAASamples = getMaxUseableSampleCount();   // ITvrbg̍ő吔l
 			break;
 		}
@@ -444,6 +613,7 @@ void CVulkanFramework::pickPhysicalDevice()
 void CVulkanFramework::createLogicalDevice()
 {
 	QueueFamilyIndices indices = findQueueFamilies(m_PhysicalDevice);    // WJfoCXL[@Preparing logical device queue
+	m_GraphicsQueueFamily = indices.graphicsFamily.value();
 
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;               // WJfoCXL[
 	std::set<uint32_t> uniqueQueueFamilies =
@@ -461,21 +631,67 @@ void CVulkanFramework::createLogicalDevice()
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
 
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+
 	VkPhysicalDeviceFeatures deviceFeatures{};
 	deviceFeatures.samplerAnisotropy = VK_TRUE;    // AnisotropyL
 	deviceFeatures.sampleRateShading = VK_TRUE;    // TvVF[fBOL
+	deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;    // BCneNX`[iΉĂꍇ̂݁j
+
+
+	// Vulkan 1.2@\FoChXpdescriptor indexing
+	// Vulkan 1.2 features: descriptor indexing for the bindless texture array
+	bool vulkan12 = (m_DeviceProperties.apiVersion >= VK_API_VERSION_1_2);
+
+	VkPhysicalDeviceVulkan12Features supported12{};
+	supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	if (vulkan12)
+	{
+		VkPhysicalDeviceFeatures2 supported2{};
+		supported2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supported2.pNext = &supported12;
+		vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &supported2);
+	}
 
+	m_BindlessSupported = supported12.runtimeDescriptorArray &&
+		supported12.shaderSampledImageArrayNonUniformIndexing &&
+		supported12.descriptorBindingSampledImageUpdateAfterBind &&
+		supported12.descriptorBindingPartiallyBound &&
+		supported12.descriptorBindingVariableDescriptorCount;
+
+	VkPhysicalDeviceVulkan12Features enabled12{};
+	enabled12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	m_TimelineSupported = vulkan12 && supported12.timelineSemaphore;
+	enabled12.timelineSemaphore = supported12.timelineSemaphore;
+	if (m_BindlessSupported)
+	{
+		enabled12.runtimeDescriptorArray = VK_TRUE;
+		enabled12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		enabled12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		enabled12.descriptorBindingPartiallyBound = VK_TRUE;
+		enabled12.descriptorBindingVariableDescriptorCount = VK_TRUE;
+	}
 
 	VkDeviceCreateInfo createInfo{};    // WJfoCX\
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	createInfo.pNext = vulkan12 ? &enabled12 : nullptr;
 
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();    // p[^̃|C^[@pointer to the logical device queue info (above)
 
 	createInfo.pEnabledFeatures = &deviceFeatures;             // currently empty (will revisit later)
 
-	createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-	createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+	// VK_EXT_memory_budgetiCӁjFq[vƂ̗\ZƎgp  optional: per-heap budget and usage for the memory report
+	std::vector<const char*> extensions = deviceExtensions;
+	m_MemoryBudgetSupported = isDeviceExtensionAvailable(m_PhysicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	if (m_MemoryBudgetSupported)
+	{
+		extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+
+	createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+	createInfo.ppEnabledExtensionNames = extensions.data();
 
 	// L̃p[^ɊÂĎۂ̃WJfoCX𐶐܂B
 	// Creating the logical device itself
@@ -486,6 +702,11 @@ void CVulkanFramework::createLogicalDevice()
 
 	vkGetDeviceQueue(m_LogicalDevice, indices.graphicsFamily.value(), 0, &m_GraphicsQueue);    //@OtBbNXL[ graphics queue
 	vkGetDeviceQueue(m_LogicalDevice, indices.presentFamily.value(), 0, &m_PresentQueue);      //@v[e[VL[ presentation queue
+
+	m_MemoryTracker.init(m_PhysicalDevice, m_MemoryProperties, m_MemoryBudgetSupported);
+	m_LayoutCache.create(m_LogicalDevice);
+	m_PipelineCache.create(m_LogicalDevice, m_DeviceProperties, m_Config.pipelineCachePath);
+	m_PipelineVariants.create(m_LogicalDevice, [this](uint32_t featureKey) { return createPipelineVariant(featureKey); });
 }
 
 // Xbv`FCi摜̐؂ւj
@@ -512,13 +733,11 @@ void CVulkanFramework::createSwapChain()
 	//	imageCount = swapChainSupport.capabilities.maxImageCount;
 	//}
 
+	// --swapchain-images: 0Ȃmin + 1AT[tFX͈͓̔ɃNv܂
+	// --swapchain-images: 0 means min + 1, always clamped to the surface limits (maxImageCount 0 = no maximum)
 	m_MinImageCount = swapChainSupport.capabilities.minImageCount;
-	m_ImageCount = m_MinImageCount + 1;
-	if (swapChainSupport.capabilities.maxImageCount > 0                 // zero here means there is no maximum!
-		&& m_ImageCount > swapChainSupport.capabilities.maxImageCount)
-	{
-		m_ImageCount = swapChainSupport.capabilities.maxImageCount;
-	}
+	m_ImageCount = selectImageCount(m_Config.swapchainImages, swapChainSupport.capabilities);
+	m_PresentMode = presentMode;
 
 	VkSwapchainCreateInfoKHR createInfo{};    // SwapChain\
 	createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -585,11 +804,13 @@ void CVulkanFramework::createRenderPass()
 	colorAttachment.samples = m_MSAASamples;            // }`TvOrbg
 
 	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;    // pXŃ\[ûŕۑsv  resolved in the pass, samples never written back
 	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;    
 	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
-	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	// CAEgJځE̓t[Ot̃oAōs܂ibuildFrameGraphs()jBpXł͑Jڂ܂
+	// layout transitions and synchronization are the frame graph's barriers (buildFrameGraphs()): no transitions in the pass
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; 
 
 	// A^b`gtbNXCfbNX
@@ -608,7 +829,7 @@ void CVulkanFramework::createRenderPass()
 	colorAttachmentResolve.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 	colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 	//colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;    // \[uAv[g邱Ƃł܂
 	colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;  // ImGuȉꍇ
 
@@ -624,7 +845,7 @@ void CVulkanFramework::createRenderPass()
 	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 	// fvXA^b`gt@X
@@ -640,15 +861,6 @@ void CVulkanFramework::createRenderPass()
 	subpass.pDepthStencilAttachment = &depthAttachmentReference;
 	subpass.pResolveAttachments = &colorAttachmentResolveReference;
 
-	// TupXˑ֌W
-	VkSubpassDependency dependency{};
-	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependency.dstSubpass = 0;    // TupXCfbNX 0 subpass index 0 (our first and only subpass)
-	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-	dependency.srcAccessMask = 0;
-	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
 	// _[pX\̐
 	// attachmentsFcreateCommandBuffers()clearValuesԂƓɂ邱
 	std::array<VkAttachmentDescription, 3> attachments = { colorAttachment, depthAttachment, colorAttachmentResolve };
@@ -659,8 +871,8 @@ void CVulkanFramework::createRenderPass()
 	renderPassInfo.pAttachments = attachments.data();
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 1;
-	renderPassInfo.pDependencies = &dependency;
+	renderPassInfo.dependencyCount = 0;    // TupXˑ֌WȂFt[Ot̃oA  the frame graph's barriers instead
+	renderPassInfo.pDependencies = nullptr;
 
 	// L̍\̂̏ɊÂĎۂ̃_[pX𐶐܂B
 	if (vkCreateRenderPass(m_LogicalDevice, &renderPassInfo, nullptr, &m_RenderPass) != VK_SUCCESS)
@@ -670,61 +882,95 @@ void CVulkanFramework::createRenderPass()
 }
 
 // \[XCAEgFǂȃ\[Xiobt@[AC[WȂǁjOtBbNXpCvCɃANZX邩
+// oCfBO̓VF[_[iSPIR-Vjǂݎ܂BCAEgm_LayoutCacheŋL܂B
+// bindings are reflected from the SPIR-V of the pipeline's stages; identical layouts are shared through m_LayoutCache
 void CVulkanFramework::createDescriptorSetLayout()
 {
-	VkDescriptorSetLayoutBinding uboLayoutBinding{};    // UniversalBufferObjectCAEgoCfBO\
-	uboLayoutBinding.binding = 0;
-	uboLayoutBinding.descriptorCount = 1;               // MVPgXtH[1̃obt@[IuWFNgɊi[Ă܂
-	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	uboLayoutBinding.pImmutableSamplers = nullptr;               // C optional, image samplingp
-	uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;    // QƂłVF[_[Xe[Wi݁A_VF[_[ŃXNv^[j
-
-	// C[WTv[p Combined Image Sampler
-	VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-	samplerLayoutBinding.binding = 1;
-	samplerLayoutBinding.descriptorCount = 1; 
-	samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	samplerLayoutBinding.pImmutableSamplers = nullptr;
-	samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;    // VERTEX_BIT: Heightmap, etc
+	// oChXpZbg1F0 = }eASSBOA1 = eNX`[ziTCYȂz = ϒAŌ̃oCfBÔ݁j
+	// bindless set 1: binding 0 = material SSBO, binding 1 = unsized texture array (variable count, must be the last binding)
+	m_UseBindless = m_BindlessSupported && std::ifstream("shaders/frag_bindless.spv").good();
+	if (m_UseBindless)
+	{
+		const VkPhysicalDeviceVulkan12Properties& properties12 = m_DeviceProperties12;
+		m_BindlessCapacity = std::min({ MAX_BINDLESS_TEXTURES,
+			properties12.maxDescriptorSetUpdateAfterBindSampledImages,
+			properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			properties12.maxDescriptorSetUpdateAfterBindSamplers,
+			properties12.maxPerStageDescriptorUpdateAfterBindSamplers });
+	}
 
-	std::array<VkDescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
-	VkDescriptorSetLayoutCreateInfo layoutInfo{};
-	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-	layoutInfo.pBindings = bindings.data();
+	m_ShaderReflection.clear();
+	m_ShaderReflection.addStage(readFile("shaders/vert.spv"));
+	m_ShaderReflection.addStage(readFile(m_UseBindless ? "shaders/frag_bindless.spv" : "shaders/frag.spv"));
 
-	if (vkCreateDescriptorSetLayout(m_LogicalDevice, &layoutInfo, nullptr, &m_DescriptorSetLayout) != VK_SUCCESS)
+	// Zbg0FUBOEeNX`[AZbg1FoChXiΉĂꍇj
+	m_SetLayouts.clear();
+	for (uint32_t set = 0; set < m_ShaderReflection.getSetCount(); set++)
 	{
-		throw std::runtime_error("Failed to create descriptor set layout!");
+		m_SetLayouts.push_back(m_LayoutCache.getSetLayout(m_ShaderReflection.getSetLayoutDesc(set, m_BindlessCapacity)));
 	}
+	if (m_SetLayouts.size() != (m_UseBindless ? 2u : 1u))
+	{
+		throw std::runtime_error("Failed to create descriptor set layout: shaders declare an unexpected number of descriptor sets!");
+	}
+	m_DescriptorSetLayout = m_SetLayouts[0];
+	m_BindlessSetLayout = m_UseBindless ? m_SetLayouts[1] : VK_NULL_HANDLE;
 }
 
 // OtBbNXpCvC
 void CVulkanFramework::createGraphicsPipeline()
 {
-	const std::vector<char> vertShaderCode = readFile("shaders/vert.spv");    // _VF[_[Ot@C̓ǂݍ
-	const std::vector<char> fragShaderCode = readFile("shaders/frag.spv");    // tOgVF[_[Ot@C̓ǂݍ
+	// VF[_[W[̓oAgŎĝŁASwapChainĐłc܂
+	// the modules stay alive for lazily compiled variants and survive swapchain recreation
+	if (m_VertShaderModule == VK_NULL_HANDLE)
+	{
+		m_VertShaderModule = createShaderModule(readFile("shaders/vert.spv"));    // _VF[_[W[i_f[^AFf[^܂߁j
+		m_FragShaderModule = createShaderModule(readFile(m_UseBindless ? "shaders/frag_bindless.spv" : "shaders/frag.spv"));    // tOgVF[_[W[
+	}
 
-	VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);     // _VF[_[W[i_f[^AFf[^܂߁j
-	VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);     // tOgVF[_[W[
+	// ZbgCAEgicreateDescriptorSetLayout()jƃVF[_[̃vbV萔ubNi`悲Ƃ̃}eACfbNXjB
+	// LbVς݂Ȃ̂SwapChainĐCAEgԂ܂B
+	// set layouts plus the shaders' push-constant blocks (per-draw material index); cached, so a rebuild reuses it
+	m_PipelineLayout = m_LayoutCache.getPipelineLayout(m_SetLayouts, m_ShaderReflection.getPushConstantRanges());
+
+	// ݂̃oAg͂iNWujŃRpCAŏ̃t[Ŏ~܂Ȃ悤ɂ܂
+	// the current variant is compiled here (startup job) so the first frame does not stall on it
+	m_PipelineVariants.get(m_Config.shaderFeatures);
+}
+
+// VF[_[oAg1̃OtBbNXpCvCFgpm_PipelineVariantsĂ΂܂i[J[Xbh̏ꍇj
+// builds the pipeline of one feature key; called by m_PipelineVariants on first use, possibly on a worker thread
+VkPipeline CVulkanFramework::createPipelineVariant(uint32_t featureKey)
+{
+	// ꉻ萔Fȋ@\̓̕hCo[̃RpCɍ폜܂
+	// specialization constants: branches of disabled features are folded away by the driver's compiler
+	CShaderSpecialization vertSpecialization(featureKey, m_ShaderReflection, VK_SHADER_STAGE_VERTEX_BIT);
+	CShaderSpecialization fragSpecialization(featureKey, m_ShaderReflection, VK_SHADER_STAGE_FRAGMENT_BIT);
 
 	// VF[_Xe[WFpCvCŃVF[_[𗘗piK	
 	// Shader Stages: Assigning shader code to its specific pipeline stage
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};                    // _VF[_[Xe[W\
 	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;                   // enum for programmable stages in Graphics Pipeline: Intro
-	vertShaderStageInfo.module = vertShaderModule;
+	vertShaderStageInfo.module = m_VertShaderModule;
 	vertShaderStageInfo.pName = "main";                                       // _VF[_[Gg[|Cg֐(shaders.vert)
+	vertShaderStageInfo.pSpecializationInfo = vertSpecialization.get();
 
 	VkPipelineShaderStageCreateInfo fragShaderStageInfo{};                    // tOgVF[_[Xe[W\
 	fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	fragShaderStageInfo.module = fragShaderModule;
+	fragShaderStageInfo.module = m_FragShaderModule;
 	fragShaderStageInfo.pName = "main";                                       // tOgVF[_[Gg[|Cg֐(shaders.frag)
+	fragShaderStageInfo.pSpecializationInfo = fragSpecialization.get();
 
 	// pCvC̃^C~OŎg`ɂ܂B
 	VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };    // VF[_[\̔z
 
+	// fvXvpXF_VF[_[̂݁iAt@eXg̏ꍇdiscard̂߂ɃtOgVF[_[j
+	// depth prepass: vertex stage only, unless the alpha test has to discard in the fragment stage
+	bool depthPrepass = (featureKey & PIPELINE_DEPTH_PREPASS) != 0;
+	uint32_t stageCount = (depthPrepass && (featureKey & SHADER_FEATURE_ALPHA_TEST) == 0) ? 1 : 2;
+
 	// pCvC̍ۂɕKvȒiK necessary steps in creating a graphics pipeline
 
 	// 1.) _CvbgF_VF[_[ɓn钸_̃tH[}bg
@@ -734,12 +980,24 @@ void CVulkanFramework::createGraphicsPipeline()
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
 	// Vertex\̂VertexBindingDescriptionVertexAttributeDescriptionɎQƂ܂
-	auto bindingDescription = Vertex::getBindingDescription();
-	auto attributeDescriptions = Vertex::getAttributeDescriptions();
-
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	// oCfBO1FCX^XƂ̈ʒuEXP[im_InstanceBufferAX̖؁j  binding 1: per instance position and scale
+	auto vertexAttributes = Vertex::getAttributeDescriptions();
+	std::array<VkVertexInputBindingDescription, 2> bindingDescriptions{};
+	bindingDescriptions[0] = Vertex::getBindingDescription();
+	bindingDescriptions[1].binding = 1;
+	bindingDescriptions[1].stride = sizeof(glm::vec4);
+	bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+	std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions{};
+	std::copy(vertexAttributes.begin(), vertexAttributes.end(), attributeDescriptions.begin());
+	attributeDescriptions[3].binding = 1;
+	attributeDescriptions[3].location = 3;
+	attributeDescriptions[3].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+	attributeDescriptions[3].offset = 0;
+
+	vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
 	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
 	// 2.) CvbgAZu[F _ǂȃWIg[`悳邩Aăg|W[o[ݒ
@@ -825,6 +1083,14 @@ void CVulkanFramework::createGraphicsPipeline()
 	depthStencil.depthWriteEnable = VK_TRUE;    // fvXeXgitOg̃fvXfvXobt@[ɏނ
 
 	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;    // fvXႢF߂
+
+	// vpX̌FvpXfvXƓtOgVF[fBOiݕsvj
+	// after a prepass: only the fragment that won the prepass is shaded, its depth is already written
+	if (featureKey & PIPELINE_DEPTH_EQUAL)
+	{
+		depthStencil.depthWriteEnable = VK_FALSE;
+		depthStencil.depthCompareOp = VK_COMPARE_OP_EQUAL;
+	}
 	depthStencil.depthBoundsTestEnable = VK_FALSE;       // fvXoEheXgpiTRUE: Bounds̃tOgۗ܂j
 	depthStencil.minDepthBounds = 0.0f;                  // C optional
 	depthStencil.maxDepthBounds = 1.0f;                  // C optional
@@ -875,6 +1141,18 @@ void CVulkanFramework::createGraphicsPipeline()
 	//colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
 	//colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
 
+	if (depthPrepass)
+	{
+		colorBlendAttachment.colorWriteMask = 0;    // fvX̂  depth only
+	}
+	else if (featureKey & SHADER_FEATURE_OVERDRAW)
+	{
+		// I[o[h[\FVF[fBOꂽtOgƂɐFZ  overdraw view: every shaded fragment adds its heat step
+		colorBlendAttachment.blendEnable = VK_TRUE;
+		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	}
+
 	VkPipelineColorBlendStateCreateInfo colorBlending{};    // pCvCJ[uhXe[g\
 	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
 	colorBlending.logicOpEnable = VK_FALSE;       // VK_TRUE: ÃxfBO
@@ -901,18 +1179,7 @@ void CVulkanFramework::createGraphicsPipeline()
 	// 9.) pCvCCAEgiŏڂׂ܂j
 	// Pipeline Layout (empty for now, revisit later)
 
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};     // pCvCCAEg\
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 1;
-	pipelineLayoutInfo.pSetLayouts = &m_DescriptorSetLayout;     // ŃXNv^[ZbgCAEg
-	pipelineLayoutInfo.pushConstantRangeCount = 0;               // C optional
-	pipelineLayoutInfo.pPushConstantRanges = nullptr;            // C optional
-
-	// L̍\̂̏ɊÂĎۂ̃pCvCCAEg𐶐܂B
-	if (vkCreatePipelineLayout(m_LogicalDevice, &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to create pipeline layout!");
-	}
+	// m_PipelineLayoutFcreateGraphicsPipeline()Ŏ擾ς݁iSoAgʁj  shared by every variant
 
 	// 10.) OtBbNXpCvCFS̒iKgݍ킹ăpCvC𐶐܂B
 	// ȂOɂ̂悤ɃOtBbNXpCvC\̂𐶐Kv܂B
@@ -921,7 +1188,7 @@ void CVulkanFramework::createGraphicsPipeline()
 
 	VkGraphicsPipelineCreateInfo pipelineInfo{};    // pCvC\
 	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipelineInfo.stageCount = 2;                    // VF[_[Xe[Wɍ킹	 Make sure this info is aligned with Shader Stages above
+	pipelineInfo.stageCount = stageCount;           // VF[_[Xe[Wɍ킹	 Make sure this info is aligned with Shader Stages above
 	pipelineInfo.pStages = shaderStages;            // VF[_[Xe[Wz̃|C^[
 
 	// ܂ł̒iKpCvC\̏|C^[ɎQƂ܂B
@@ -955,17 +1222,15 @@ void CVulkanFramework::createGraphicsPipeline()
 	pipelineInfo.basePipelineIndex = -1;                 // C optional
 
 	// L̍\̂̏ɊÂāA悤₭ۂ̃OtBbNXpCvCł܂B
-	// 2ڂ̈FpCvCLbV(Œׂ܂j
+	// 2ڂ̈FpCvCLbViO̎sŃfBXNɕۑ́j
 	// Creating the actual graphics pipeline from data struct
-	// Second argument: pipeline cache (revisit later)
-	if (vkCreateGraphicsPipelines(m_LogicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_GraphicsPipeline) != VK_SUCCESS)
+	// Second argument: pipeline cache, persisted across runs
+	VkPipeline pipeline;
+	if (vkCreateGraphicsPipelines(m_LogicalDevice, m_PipelineCache.get(), 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create graphics pipeline!");
 	}
-
-	// pς݂̃VF[_[W[폜܂B
-	vkDestroyShaderModule(m_LogicalDevice, fragShaderModule, nullptr);
-	vkDestroyShaderModule(m_LogicalDevice, vertShaderModule, nullptr);
+	return pipeline;
 }
 
 // }`TvOpJ[obt@[𐶐
@@ -973,18 +1238,8 @@ void CVulkanFramework::createColorResources()
 {
 	VkFormat colorFormat = m_SwapChainImageFormat;
 
-	createImage(
-		m_SwapChainExtent.width,
-		m_SwapChainExtent.height,
-		1,
-		m_MSAASamples,
-		colorFormat,
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		m_ColorImage,
-		m_ColorImageMemory
-	);
+	createTransientAttachment(colorFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, m_ColorImage, m_ColorImageMemory, m_ColorImageInfo);
+	m_ColorImageInfo.bytesPerSample = 4;    // Xbv`F[8bit RGBA/BGRA
 
 	// }`TvOpC[Wr[̍ۂɃ~bv}bv́u1vɐݒ肵ȂƂ܂iVulkaň܂j
 	// ̃C[Wr[̓eNX`[ƂĎgȂ̂ŕ`iɉe܂
@@ -997,19 +1252,67 @@ void CVulkanFramework::createColorResources()
 void CVulkanFramework::createDepthResources()
 {
 	VkFormat depthFormat = findDepthFormat();
+	createTransientAttachment(depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, m_DepthImage, m_DepthImageMemory, m_DepthImageInfo);
+	m_DepthImageInfo.bytesPerSample = (depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT) ? 5 : 4;
+	m_DepthImageView = createImageView(m_DepthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
+
+	reportAttachmentMemory();
+}
+
+// _[pXŊA^b`gFTRANSIENT_ATTACHMENT + LAZILY_ALLOCATEDiΉĂꍇj
+// ^CGPUł̓I`bv[ŏA[͊mۂ܂
+// attachment that never leaves the render pass: TRANSIENT usage, lazily allocated memory where the GPU has it
+// (tilers keep it on chip and commit little or no memory), plain DEVICE_LOCAL otherwise
+void CVulkanFramework::createTransientAttachment(VkFormat format, VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& imageMemory, AttachmentMemoryInfo& info)
+{
 	createImage(
 		m_SwapChainExtent.width,
 		m_SwapChainExtent.height,
 		1,
 		m_MSAASamples,
-		depthFormat,
+		format,
 		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		m_DepthImage,
-		m_DepthImageMemory
+		VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | usage,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT,
+		image,
+		imageMemory
 	);
-	m_DepthImageView = createImageView(m_DepthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
+
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(m_LogicalDevice, image, &memRequirements);
+	info.size = memRequirements.size;
+	info.lazy = isMemoryTypeAvailable(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+}
+
+// MSAAA^b`g̃[gpʂ1t[̏oʁijo
+// MSAA memory use and estimated attachment stores per frame.
+// Before: the MSAA color was stored (samples * 4 bytes per pixel) on top of the resolve.
+// Now: only the single-sample resolve reaches memory; color and depth samples are discarded.
+void CVulkanFramework::reportAttachmentMemory()
+{
+	const double MB = 1024.0 * 1024.0;
+	VkDeviceSize pixels = VkDeviceSize(m_SwapChainExtent.width) * m_SwapChainExtent.height;
+	VkDeviceSize resolveBytes = pixels * 4;
+	VkDeviceSize storedBefore = pixels * m_MSAASamples * m_ColorImageInfo.bytesPerSample + resolveBytes;
+
+	VkDeviceSize committed = 0;
+	for (auto attachment : { std::make_pair(m_ColorImageMemory, &m_ColorImageInfo), std::make_pair(m_DepthImageMemory, &m_DepthImageInfo) })
+	{
+		VkDeviceSize bytes = attachment.second->size;
+		if (attachment.second->lazy)
+		{
+			vkGetDeviceMemoryCommitment(m_LogicalDevice, attachment.first, &bytes);
+		}
+		committed += bytes;
+	}
+
+	printf("MSAA %ux at %ux%u: color %.1f MB%s, depth %.1f MB%s, %.1f MB committed\n",
+		static_cast<uint32_t>(m_MSAASamples), m_SwapChainExtent.width, m_SwapChainExtent.height,
+		m_ColorImageInfo.size / MB, m_ColorImageInfo.lazy ? " (lazy)" : "",
+		m_DepthImageInfo.size / MB, m_DepthImageInfo.lazy ? " (lazy)" : "",
+		committed / MB);
+	printf("  attachment stores per frame: %.1f MB -> %.1f MB (resolve only), %.1f GB/s saved at 60 FPS\n",
+		storedBefore / MB, resolveBytes / MB, (storedBefore - resolveBytes) * 60.0 / (1024.0 * MB));
 }
 
 // t[obt@[
@@ -1041,86 +1344,84 @@ void CVulkanFramework::createFramebuffers()
 }
 
 
-// eNX`[}bsOp摜pӂ܂
-void CVulkanFramework::createTextureImage()
+// ~bv}bvpRs[gpCvC
+// Uses the compute path unless it is disabled, the shader has not been compiled (Shaders/compile.bat)
+// or the device cannot write the texture format through a storage view; vkCmdBlitImage is the fallback.
+void CVulkanFramework::createMipGenerator()
 {
-	int texWidth, texHeight, texChannels;
-
-	// STBI_rgb_alpha: `lȂꍇAIɒǉ܂B
-	stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-	VkDeviceSize imageSize = texWidth * texHeight * 4;
-
-	// max   : widthheight傫TCY̕
-	// log2  : ̒l܂2ŏZł邩ie~bv}bvx͌̃x̔̂߁j
-	// floor : maxl % 2 != 0@̏ꍇAfloorɒȂő吮ƂĈ܂
-	// +1    : ̃eNX`[̂x0Ƃ܂([v[i] -1)
-	m_MipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
+	m_ComputeMipGen = false;
+	if (m_Config.computeMipmaps == false)
+	{
+		return;
+	}
 
-	if (!pixels)
+	const std::string shaderPath = "shaders/mipgen.spv";
+	if (std::ifstream(shaderPath).good() == false)
 	{
-		throw std::runtime_error("Failed to load texture image!");
+		std::cout << shaderPath << " not found, using blit mipmaps" << std::endl;
+		return;
 	}
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, queueFamilies.data());
+	uint32_t graphicsFamily = m_GraphicsQueueFamily;    // [J[XbhŎsFT[tFXɃANZXȂ  runs on a worker: no surface queries
+
+	if (m_DeviceProperties.apiVersion < VK_API_VERSION_1_1 ||
+		(queueFamilies[graphicsFamily].queueFlags & VK_QUEUE_COMPUTE_BIT) == 0 ||
+		CMipGenerator::isFormatSupported(m_PhysicalDevice, VK_FORMAT_R8G8B8A8_SRGB) == false)
+	{
+		std::cout << "Compute mipmaps not supported on this GPU, using blit mipmaps" << std::endl;
+		return;
+	}
 
-	createBuffer(
-		imageSize,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		stagingBuffer,
-		stagingBufferMemory
-	);
+	m_MipGenerator.create(m_LogicalDevice, m_PhysicalDevice, readFile(shaderPath), m_MemoryTracker);
+	m_ComputeMipGen = true;
+}
 
-	void* data;
-	vkMapMemory(m_LogicalDevice, stagingBufferMemory, 0, imageSize, 0, &data);
-	memcpy(data, pixels, static_cast<size_t>(imageSize));
-	vkUnmapMemory(m_LogicalDevice, stagingBufferMemory);
+// eNX`[̃fR[hiNɃ[J[XbhŎsAfoCXsvj
+// fR[hCPU~bv}bv͂Ƀ[J[Xbhŕ񏈗܂
+// decode (and CPU mip generation) of every texture, itself spread over the worker pool; needs no device
+// BCntH[}bg̓LbV(Asset/Cache)ǂݍ݁AȂꍇ͂ŃGR[h܂
+void CVulkanFramework::decodeTextures()
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
 
-	// pς݃sNZz폜
-	stbi_image_free(pixels);
+	m_TextureFormat = m_Config.textureFormat;
+	if (m_TextureFormat != TextureFormat::RGBA8 && m_TextureCompressionBC == false)
+	{
+		std::cout << "BCn textures not supported on this GPU, using RGBA8" << std::endl;
+		m_TextureFormat = TextureFormat::RGBA8;
+	}
 
-	// eNX`[C[W
-	createImage(
-		texWidth,
-		texHeight,
-		m_MipLevels,
-		VK_SAMPLE_COUNT_1_BIT,
-		VK_FORMAT_R8G8B8A8_SRGB,
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		m_TextureImage,
-		m_TextureImageMemory
-	);
+	m_DecodedTextures = CTextureLoader::decodeBatch(TEXTURE_PATHS, m_Config.mipFilter, *m_JobSystem, m_TextureFormat);
 
-	transitionImageLayout(
-		m_TextureImage,
-		VK_FORMAT_R8G8B8A8_SRGB,
-		VK_IMAGE_LAYOUT_UNDEFINED,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		m_MipLevels);
+	auto endTime = std::chrono::high_resolution_clock::now();
+	m_TextureLoadTimeMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
 
-	// Rs[s
-	copyBufferToImage(
-		stagingBuffer,
-		m_TextureImage,
-		static_cast<uint32_t>(texWidth),
-		static_cast<uint32_t>(texHeight)
-	);
+// eNX`[}bsOp摜pӂ܂FdecodeTextures()̌ʂ1ɂ܂Ƃ߂ăAbv[h
+// uploads everything decodeTextures() produced in one batch
+void CVulkanFramework::createTextureImage()
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
 
-	// Еt
-	vkDestroyBuffer(m_LogicalDevice, stagingBuffer, nullptr);
-	vkFreeMemory(m_LogicalDevice, stagingBufferMemory, nullptr);
+	uploadTextures(m_DecodedTextures);
+	m_DecodedTextures.clear();
+	m_DecodedTextures.shrink_to_fit();
 
-	// ~bv}bv
-	generateMipmaps(m_TextureImage, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, m_MipLevels);
+	auto endTime = std::chrono::high_resolution_clock::now();
+	m_TextureLoadTimeMs += std::chrono::duration<double, std::milli>(endTime - startTime).count();
 }
 
 // createTextureImage()̃C[WC[Wr[𐶐
 void CVulkanFramework::createTextureImageView()
 {
-	m_TextureImageView = createImageView(m_TextureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, m_MipLevels);
+	for (Texture& texture : m_Textures)
+	{
+		texture.view = createImageView(texture.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT, texture.mipLevels, VK_IMAGE_USAGE_SAMPLED_BIT);
+	}
 }
 
 // eNX`[Tv[FFiltering (Bilinear, AnisotropicȂ)AAddressingModeȂ
@@ -1146,13 +1447,8 @@ void CVulkanFramework::createTextureSampler()
 	// VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER: returns solid color when sampling beyond dimensions
 	// ݁AC[W̊OŃTvOsȂߐݒ𖳎܂AԂ悭gĂ̂MODE_REPEATł
 
-
-	VkPhysicalDeviceProperties properties{};
-	vkGetPhysicalDeviceProperties(m_PhysicalDevice, &properties);
-	m_PhysicalDeviceName = "GPU: " + std::string(properties.deviceName);
-
 	samplerInfo.anisotropyEnable = VK_TRUE;
-	samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;    // ő
+	samplerInfo.maxAnisotropy = m_DeviceProperties.limits.maxSamplerAnisotropy;    // ő
 
 	// CLAMP_TO_BORDEȐꍇA\ꂽJ[ 
 	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
@@ -1169,87 +1465,601 @@ void CVulkanFramework::createTextureSampler()
 	samplerInfo.mipLodBias = 0.0f;
 	// samplerInfo.minLod = static_cast<float>(m_MipLevels / 2);      // ~bv}bveXg mipmap test
 	samplerInfo.minLod = 0.0f;
-	samplerInfo.maxLod = static_cast<float>(m_MipLevels);
 
-	if (vkCreateSampler(m_LogicalDevice, &samplerInfo, nullptr, &m_TextureSampler) != VK_SUCCESS)
+	// ~bv̓C[Wr[̂ŁAmaxLod̓NvȂFSeNX`[VkSamplerL܂
+	// the image view already limits the mip range, so maxLod is left unclamped and every texture shares one cached VkSampler
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	m_SamplerCache.create(m_LogicalDevice, m_DeviceProperties.limits, true);
+	for (Texture& texture : m_Textures)
 	{
-		throw std::runtime_error("Failed to create texture sampler!");
+		texture.sampler = m_SamplerCache.getSampler(samplerInfo);
 	}
 }
 
-// f̃[h
-void CVulkanFramework::loadModel()
+// IBLFLbVǂݍ݁AȂΊ}bvǂݍ݂܂i[J[XbhAfoCXsvj
+// image based lighting, worker part: the disk cache entry, or the environment map to bake from on a miss
+void CVulkanFramework::loadEnvironmentLighting()
 {
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-	std::string warn, error;
+	auto startTime = std::chrono::high_resolution_clock::now();
 
-	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &error, MODEL_PATH.c_str()))    // Triangulate Faces by default
+	m_IblSourceKey = CIblCache::getSourceKey(m_Config.environmentMapPath);
+	m_IblCached = (m_IblSourceKey != 0) && CIblCache::load(m_IblSourceKey, m_IblData);
+	if (m_IblCached == false)
 	{
-		throw std::runtime_error(warn + error);
+		m_EnvironmentMap = CIblPrecompute::loadEnvironment(m_Config.environmentMapPath);
 	}
 
-	std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+	auto endTime = std::chrono::high_resolution_clock::now();
+	m_IblTimeMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
 
-	// SĂ̎OpIterateāA1̃fɂ܂Ƃ߂܂
-	// Iterate over all the shapes to combine all the faces into a single model
-	for (const auto& shape : shapes)
+// IBLxCNpRs[gpCvCFibl.spvȂARGBA16F̃Xg[WɔΉ̏ꍇCPUŃxCN
+// compute pipelines for the IBL bake; without ibl.spv or RGBA16F storage support the bake runs on the CPU
+void CVulkanFramework::createIblBaker()
+{
+	const std::string shaderPath = "shaders/ibl.spv";
+	if (std::ifstream(shaderPath).good() == false)
 	{
-		for (const auto& index : shape.mesh.indices)
-		{
-			Vertex vertex{};
+		std::cout << shaderPath << " not found, IBL is baked on the CPU" << std::endl;
+		return;
+	}
+	if (CIblBaker::isSupported(m_PhysicalDevice) == false)
+	{
+		std::cout << "IBL compute bake not supported on this GPU, IBL is baked on the CPU" << std::endl;
+		return;
+	}
 
-			vertex.pos = {
-			attrib.vertices[3 * index.vertex_index + 0],
-			attrib.vertices[3 * index.vertex_index + 1],
-			attrib.vertices[3 * index.vertex_index + 2]
-			};
+	m_IblBaker.create(m_LogicalDevice, readFile(shaderPath), m_PipelineCache.get());
+}
 
-			vertex.texCoord = {
-				attrib.texcoords[2 * index.texcoord_index + 0],
-				1.0 - attrib.texcoords[2 * index.texcoord_index + 1]
-			};
+// CgU蕪pRs[gpCvCFcluster_cull.spvȂꍇCPUŐU蕪iClusteredLights.cppj
+// compute pipeline for light culling; without cluster_cull.spv the clusters are built on the CPU
+void CVulkanFramework::createLightCuller()
+{
+	const std::string shaderPath = "shaders/cluster_cull.spv";
+	if (std::ifstream(shaderPath).good() == false)
+	{
+		std::cout << shaderPath << " not found, lights are culled on the CPU" << std::endl;
+		return;
+	}
 
-			vertex.color = { 1.0f, 1.0f, 1.0f };
+	m_LightCuller.create(m_LogicalDevice, readFile(shaderPath), m_PipelineCache.get());
+}
 
-			// _dtB^[
-			if (uniqueVertices.count(vertex) == 0)
-			{
-				uniqueVertices[vertex] = static_cast<uint32_t>(m_Vertices.size());
-				m_Vertices.push_back(vertex);
-			}
-			m_Indices.push_back(uniqueVertices[vertex]);
+// epfvX_[pXAshadow.spv΃pCvCiȂꍇ̓}bvNA邾FeȂj
+// depth-only render pass for the sun's cascades, plus its pipeline if shadow.spv exists (otherwise the map is only cleared)
+void CVulkanFramework::createShadowPass()
+{
+	VkFormat format = CShadowPass::findFormat(m_PhysicalDevice);
+	if (format == VK_FORMAT_UNDEFINED)
+	{
+		std::cout << "No sampled depth format for shadow maps, sun shadows are off" << std::endl;
+		return;
+	}
 
-			// tB^[Ȃ
-			//m_Vertices.push_back(vertex);
-			//m_Indices.push_back(m_Indices.size());
-		}
+	m_ShadowPass.create(m_LogicalDevice, format, m_Config.shadowMapSize);
+
+	const std::string shaderPath = "shaders/shadow.spv";
+	if (std::ifstream(shaderPath).good() == false)
+	{
+		std::cout << shaderPath << " not found, sun shadows are not rendered" << std::endl;
+		return;
 	}
-	// _mFEr
-	// std::cout << "_: "  << m_Vertices.size() << std::endl;
+	m_ShadowPass.createPipeline(readFile(shaderPath), m_PipelineCache.get(), Vertex::getBindingDescription(), Vertex::getAttributeDescriptions()[0]);
 }
 
-// _obt@[
-void CVulkanFramework::createVertexBuffer()
+// C|X^[FfAgX̑St[ɕ`ip̃ItXN[_[pXAN1jA~bv}bvB
+// `pCvC̓C̃_[pXpiSwapChainĐłĐjBxCNpVF[_[Ȃꍇ͑SbVŕ`
+// impostors: the model is drawn into every frame of the atlas by an offscreen render pass of its own, once at startup,
+// then the atlas gets its mips. The draw pipeline targets the main render pass and is rebuilt with the swapchain.
+// Without the bake shaders every forest tree stays a mesh.
+void CVulkanFramework::createImpostors()
 {
-	// _P @z̗vf
-	VkDeviceSize bufferSize = sizeof(m_Vertices[0]) * m_Vertices.size();
+	if (m_ForestTrees.empty())
+	{
+		return;
+	}
 
-	// Xe[WOobt@[FCPU[Վobt@[B_f[^ɓnAŏIIȒ_obt@[ɓn܂B
-	// Staging buffer: temporary buffer in CPU memory that takes in vertex array and sends it to the final vertex buffer
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	createBuffer(
-		bufferSize,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		stagingBuffer,
-		stagingBufferMemory);
+	const std::string bakeVertPath = "shaders/impostor_bake_vert.spv";
+	const std::string bakeFragPath = "shaders/impostor_bake_frag.spv";
+	if (std::ifstream(bakeVertPath).good() == false || std::ifstream(bakeFragPath).good() == false)
+	{
+		std::cout << bakeVertPath << " or " << bakeFragPath << " not found, every forest tree is drawn as a mesh" << std::endl;
+		return;
+	}
 
-	void* data;	// void|C^[G񃁃[}bvɎgp܂
+	auto startTime = std::chrono::high_resolution_clock::now();
 
-	// [Ƀ}bv
+	const ImpostorSettings& settings = m_ImpostorAtlas.getSettings();
+	uint32_t atlasSize = m_ImpostorAtlas.getAtlasSize();
+	uint32_t mipLevels = CImpostorPass::getMipLevels(settings.frameSize);
+	VkFormat depthFormat = findDepthFormat();
+	auto attributeDescriptions = Vertex::getAttributeDescriptions();
+	m_ImpostorPass.create(m_LogicalDevice, atlasSize, mipLevels, depthFormat, readFile(bakeVertPath), readFile(bakeFragPath), m_PipelineCache.get(),
+		Vertex::getBindingDescription(), attributeDescriptions[0], attributeDescriptions[2]);
+
+	// AgX2ixCNE~bv}bvblitƐETvOjƃxCNpfvXixCNɍ폜j
+	// the two atlas layers (bake target, blit source and destination, sampled) and the bake's depth buffer (freed after)
+	const VkImageUsageFlags atlasUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+		VK_IMAGE_USAGE_SAMPLED_BIT;
+	createImage(atlasSize, atlasSize, mipLevels, VK_SAMPLE_COUNT_1_BIT, CImpostorPass::ALBEDO_FORMAT, VK_IMAGE_TILING_OPTIMAL, atlasUsage,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_ImpostorAlbedoImage, m_ImpostorAlbedoMemory);
+	createImage(atlasSize, atlasSize, mipLevels, VK_SAMPLE_COUNT_1_BIT, CImpostorPass::NORMAL_DEPTH_FORMAT, VK_IMAGE_TILING_OPTIMAL, atlasUsage,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_ImpostorNormalDepthImage, m_ImpostorNormalDepthMemory);
+	VkImage depthImage;
+	VkDeviceMemory depthImageMemory;
+	createImage(atlasSize, atlasSize, 1, VK_SAMPLE_COUNT_1_BIT, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory);
+	m_ImpostorPass.setImages(m_ImpostorAlbedoImage, m_ImpostorNormalDepthImage, depthImage);
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	m_ImpostorPass.bake(commandBuffer, m_ImpostorAtlas, m_VertexBuffer, m_IndexBuffer, static_cast<uint32_t>(m_Indices.size()), m_Textures[0].view,
+		m_Textures[0].sampler);
+	endSingleTimeCommands(commandBuffer);    // ܂ő҂܂  waits for completion
+
+	m_ImpostorPass.finishBake();
+	vkDestroyImage(m_LogicalDevice, depthImage, nullptr);
+	freeMemory(depthImageMemory);
+
+	// t[̒[̓NviVF[_[łjA~bv}bv͉̖؂̂}܂
+	// clamped at the edges (the shader also clamps inside each frame); the mips keep distant trees from shimmering
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;    // the view limits the mip range
+	m_ImpostorSampler = m_SamplerCache.getSampler(samplerInfo);
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	m_ImpostorBakeMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+	printf("Impostors: %u x %u frames of %u texels (%u mips) baked in %.1f ms\n", settings.frames, settings.frames, settings.frameSize,
+		mipLevels, m_ImpostorBakeMs);
+
+	const std::string vertPath = "shaders/impostor_vert.spv";
+	const std::string fragPath = "shaders/impostor_frag.spv";
+	if (std::ifstream(vertPath).good() == false || std::ifstream(fragPath).good() == false)
+	{
+		std::cout << vertPath << " or " << fragPath << " not found, every forest tree is drawn as a mesh" << std::endl;
+		return;
+	}
+	m_ImpostorPass.setDrawShaders(readFile(vertPath), readFile(fragPath));
+	m_ImpostorPass.createPipeline(m_RenderPass, m_MSAASamples, m_SwapChainExtent, m_PipelineCache.get());
+	m_ImpostorPass.createDescriptorSets(m_UniformBuffers, sizeof(UniformBufferObject), m_ImpostorSampler);
+}
+
+// IBLeNX`[FLbVqbg̓Abv[ĥ݁A~X̏ꍇGPUiCPUjŃxCNăLbVɕۑ
+// IBL textures: a cache hit is a plain upload, a miss is baked on the GPU (CPU fallback) and written to the cache
+void CVulkanFramework::createEnvironmentLighting()
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	if (m_IblCached)
+	{
+		m_IblSource = "disk cache";
+		uploadEnvironmentLighting();
+	}
+	else if (m_IblBaker.isCreated())
+	{
+		m_IblSource = "GPU bake";
+		bakeEnvironmentLighting();
+		CIblCache::store(m_IblSourceKey, m_IblData);
+	}
+	else
+	{
+		m_IblSource = "CPU bake";
+		CIblPrecompute::compute(m_EnvironmentMap, m_IblData, *m_JobSystem);
+		uploadEnvironmentLighting();
+		CIblCache::store(m_IblSourceKey, m_IblData);
+	}
+
+	// CPŨf[^ƃxCNppCvC͂sv  CPU copies and bake pipelines are no longer needed
+	m_IblData = IblData();
+	m_EnvironmentMap = EnvironmentMap();
+	m_IblBaker.destroy();
+
+	// ~}@FU͕ʊpȂ̂REPEATAV͋ɂCLAMP  equirectangular: U is the azimuth (repeat), V clamps at the poles
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;    // r[~bv͈͂𐧌܂  the views limit the mip range, so both maps share one sampler
+
+	m_IblIrradiance.sampler = m_SamplerCache.getSampler(samplerInfo);
+	m_IblPrefiltered.sampler = m_SamplerCache.getSampler(samplerInfo);
+
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;    // LUTFNdotVEtlX
+	m_IblBrdfLut.sampler = m_SamplerCache.getSampler(samplerInfo);
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	m_IblTimeMs += std::chrono::duration<double, std::milli>(endTime - startTime).count();
+	printf("IBL: %s in %.1f ms\n", m_IblSource, m_IblTimeMs);
+}
+
+// IBLeNX`[3iTCYIblData::allocate()Ɠj
+// the three IBL textures, sized like IblData::allocate()
+void CVulkanFramework::createIblTextures(VkImageUsageFlags usage)
+{
+	const uint32_t widths[IBL_PASS_COUNT] = { IBL_IRRADIANCE_WIDTH, IBL_PREFILTERED_WIDTH, IBL_BRDF_LUT_SIZE };
+	const uint32_t heights[IBL_PASS_COUNT] = { IBL_IRRADIANCE_HEIGHT, IBL_PREFILTERED_HEIGHT, IBL_BRDF_LUT_SIZE };
+	const uint32_t levels[IBL_PASS_COUNT] = { 1, IBL_PREFILTERED_LEVELS, 1 };
+	Texture* textures[IBL_PASS_COUNT] = { &m_IblIrradiance, &m_IblPrefiltered, &m_IblBrdfLut };
+
+	for (uint32_t i = 0; i < IBL_PASS_COUNT; i++)
+	{
+		Texture& texture = *textures[i];
+		texture.format = CIblBaker::FORMAT;
+		texture.width = widths[i];
+		texture.height = heights[i];
+		texture.mipLevels = levels[i];
+
+		createImage(texture.width, texture.height, texture.mipLevels, VK_SAMPLE_COUNT_1_BIT, texture.format, VK_IMAGE_TILING_OPTIMAL,
+			usage | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture.image, texture.memory);
+		texture.view = createImageView(texture.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT, texture.mipLevels, VK_IMAGE_USAGE_SAMPLED_BIT);
+	}
+}
+
+// }bvAbv[hA3pXfBXpb`Aʂm_IblDataɓǂݖ߂܂iLbVۑpj
+// uploads the environment, dispatches the three passes and reads the result back into m_IblData for the cache
+void CVulkanFramework::bakeEnvironmentLighting()
+{
+	createIblTextures(VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+
+	std::vector<uint16_t> environmentTexels = m_EnvironmentMap.toHalf();
+	VkDeviceSize environmentSize = environmentTexels.size() * sizeof(uint16_t);
+
+	m_IblData.allocate();
+	VkDeviceSize readbackSize = m_IblData.irradiance.getSizeBytes() + m_IblData.prefiltered.getSizeBytes() + m_IblData.brdfLut.getSizeBytes();
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	createBuffer(environmentSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		stagingBuffer, stagingBufferMemory);
+
+	VkBuffer readbackBuffer;
+	VkDeviceMemory readbackBufferMemory;
+	createBuffer(readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		readbackBuffer, readbackBufferMemory);
+
+	void* data;
+	vkMapMemory(m_LogicalDevice, stagingBufferMemory, 0, environmentSize, 0, &data);
+	memcpy(data, environmentTexels.data(), static_cast<size_t>(environmentSize));
+	vkUnmapMemory(m_LogicalDevice, stagingBufferMemory);
+
+	Texture environment{};
+	environment.format = CIblBaker::FORMAT;
+	environment.width = m_EnvironmentMap.width;
+	environment.height = m_EnvironmentMap.height;
+	createImage(environment.width, environment.height, 1, VK_SAMPLE_COUNT_1_BIT, environment.format, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, environment.image, environment.memory);
+	environment.view = createImageView(environment.image, environment.format, VK_IMAGE_ASPECT_COLOR_BIT, 1, VK_IMAGE_USAGE_SAMPLED_BIT);
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+	// }bvFUNDEFINED -> TRANSFER_DST -> Rs[gVF[_[œǂݍ
+	recordLayoutBarrier(commandBuffer, environment.image, 1, RGAccess::fromLayout(VK_IMAGE_LAYOUT_UNDEFINED), RGAccess::transferDst());
+	VkBufferImageCopy region{};
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageExtent = { environment.width, environment.height, 1 };
+	vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, environment.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	recordLayoutBarrier(commandBuffer, environment.image, 1, RGAccess::transferDst(), RGAccess::sampledCompute());
+
+	// xCNTRANSFER_SRCFǂݖ߂ĂVF[_[ǂݍݗpɑJ
+	// the baker leaves the targets in TRANSFER_SRC: read back, then hand them to the fragment shader
+	m_IblBaker.record(commandBuffer, environment.view, m_IblIrradiance.image, m_IblPrefiltered.image, m_IblBrdfLut.image);
+	copyEnvironmentLighting(commandBuffer, readbackBuffer, false);
+	for (Texture* texture : { &m_IblIrradiance, &m_IblPrefiltered, &m_IblBrdfLut })
+	{
+		recordLayoutBarrier(commandBuffer, texture->image, texture->mipLevels, RGAccess::transferSrc(), RGAccess::sampledFragment());
+	}
+
+	endSingleTimeCommands(commandBuffer);
+	m_IblBaker.releaseTransient();
+
+	vkMapMemory(m_LogicalDevice, readbackBufferMemory, 0, readbackSize, 0, &data);
+	VkDeviceSize readbackOffset = 0;
+	for (IblImage* image : { &m_IblData.irradiance, &m_IblData.prefiltered, &m_IblData.brdfLut })
+	{
+		memcpy(image->texels.data(), static_cast<uint8_t*>(data) + readbackOffset, image->getSizeBytes());
+		readbackOffset += image->getSizeBytes();
+	}
+	vkUnmapMemory(m_LogicalDevice, readbackBufferMemory);
+
+	// Еt
+	vkDestroyImageView(m_LogicalDevice, environment.view, nullptr);
+	vkDestroyImage(m_LogicalDevice, environment.image, nullptr);
+	freeMemory(environment.memory);
+	vkDestroyBuffer(m_LogicalDevice, readbackBuffer, nullptr);
+	freeMemory(readbackBufferMemory);
+	vkDestroyBuffer(m_LogicalDevice, stagingBuffer, nullptr);
+	freeMemory(stagingBufferMemory);
+}
+
+// LbV̓eiCPUxCŇʁjIBLeNX`[ɃAbv[h
+// uploads m_IblData (cache entry or CPU bake) into the IBL textures
+void CVulkanFramework::uploadEnvironmentLighting()
+{
+	createIblTextures(VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+
+	VkDeviceSize stagingSize = m_IblData.irradiance.getSizeBytes() + m_IblData.prefiltered.getSizeBytes() + m_IblData.brdfLut.getSizeBytes();
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	createBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		stagingBuffer, stagingBufferMemory);
+
+	void* data;
+	vkMapMemory(m_LogicalDevice, stagingBufferMemory, 0, stagingSize, 0, &data);
+	VkDeviceSize stagingOffset = 0;
+	for (const IblImage* image : { &m_IblData.irradiance, &m_IblData.prefiltered, &m_IblData.brdfLut })
+	{
+		memcpy(static_cast<uint8_t*>(data) + stagingOffset, image->texels.data(), image->getSizeBytes());
+		stagingOffset += image->getSizeBytes();
+	}
+	vkUnmapMemory(m_LogicalDevice, stagingBufferMemory);
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	for (Texture* texture : { &m_IblIrradiance, &m_IblPrefiltered, &m_IblBrdfLut })
+	{
+		recordLayoutBarrier(commandBuffer, texture->image, texture->mipLevels, RGAccess::fromLayout(VK_IMAGE_LAYOUT_UNDEFINED), RGAccess::transferDst());
+	}
+	copyEnvironmentLighting(commandBuffer, stagingBuffer, true);
+	for (Texture* texture : { &m_IblIrradiance, &m_IblPrefiltered, &m_IblBrdfLut })
+	{
+		recordLayoutBarrier(commandBuffer, texture->image, texture->mipLevels, RGAccess::transferDst(), RGAccess::sampledFragment());
+	}
+	endSingleTimeCommands(commandBuffer);
+
+	vkDestroyBuffer(m_LogicalDevice, stagingBuffer, nullptr);
+	freeMemory(stagingBufferMemory);
+}
+
+// IBLeNX`[3ƃobt@[iIblData3ɕׂ́j̊Ԃ̃Rs[A~bvxƂ1̈
+// copies between the IBL textures and a buffer holding the IblData images back to back, one region per level
+void CVulkanFramework::copyEnvironmentLighting(VkCommandBuffer commandBuffer, VkBuffer buffer, bool toImages)
+{
+	const IblImage* images[IBL_PASS_COUNT] = { &m_IblData.irradiance, &m_IblData.prefiltered, &m_IblData.brdfLut };
+	const Texture* textures[IBL_PASS_COUNT] = { &m_IblIrradiance, &m_IblPrefiltered, &m_IblBrdfLut };
+
+	VkDeviceSize imageOffset = 0;
+	for (uint32_t i = 0; i < IBL_PASS_COUNT; i++)
+	{
+		std::vector<VkBufferImageCopy> regions(images[i]->levels);
+		for (uint32_t level = 0; level < images[i]->levels; level++)
+		{
+			VkBufferImageCopy& region = regions[level];
+			region.bufferOffset = imageOffset + images[i]->getLevelOffset(level) * sizeof(uint16_t);
+			region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+			region.imageOffset = { 0, 0, 0 };
+			region.imageExtent = { images[i]->getLevelWidth(level), images[i]->getLevelHeight(level), 1 };
+		}
+
+		if (toImages)
+		{
+			vkCmdCopyBufferToImage(commandBuffer, buffer, textures[i]->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				static_cast<uint32_t>(regions.size()), regions.data());
+		}
+		else
+		{
+			vkCmdCopyImageToBuffer(commandBuffer, textures[i]->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer,
+				static_cast<uint32_t>(regions.size()), regions.data());
+		}
+		imageOffset += images[i]->getSizeBytes();
+	}
+}
+
+// S~bvx̃CAEgJڂL^܂iXe[WEANZXRGAccessj
+// records a layout transition of every mip level, stages and access taken from the render graph access table
+void CVulkanFramework::recordLayoutBarrier(VkCommandBuffer commandBuffer, VkImage image, uint32_t mipLevels, const RGAccess& source, const RGAccess& destination)
+{
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = source.layout;
+	barrier.newLayout = destination.layout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mipLevels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = source.isWrite() ? source.access : 0;
+	barrier.dstAccessMask = destination.access;
+
+	vkCmdPipelineBarrier(commandBuffer, source.stages, destination.stages, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+// f̃[h
+void CVulkanFramework::loadModel()
+{
+	tinyobj::attrib_t attrib;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string warn, error;
+
+	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &error, MODEL_PATH.c_str()))    // Triangulate Faces by default
+	{
+		throw std::runtime_error(warn + error);
+	}
+
+	std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+
+	// SĂ̎OpIterateāA1̃fɂ܂Ƃ߂܂
+	// Iterate over all the shapes to combine all the faces into a single model
+	for (const auto& shape : shapes)
+	{
+		for (const auto& index : shape.mesh.indices)
+		{
+			Vertex vertex{};
+
+			vertex.pos = {
+			attrib.vertices[3 * index.vertex_index + 0],
+			attrib.vertices[3 * index.vertex_index + 1],
+			attrib.vertices[3 * index.vertex_index + 2]
+			};
+
+			vertex.texCoord = {
+				attrib.texcoords[2 * index.texcoord_index + 0],
+				1.0 - attrib.texcoords[2 * index.texcoord_index + 1]
+			};
+
+			vertex.color = { 1.0f, 1.0f, 1.0f };
+
+			// _dtB^[
+			if (uniqueVertices.count(vertex) == 0)
+			{
+				uniqueVertices[vertex] = static_cast<uint32_t>(m_Vertices.size());
+				m_Vertices.push_back(vertex);
+			}
+			m_Indices.push_back(uniqueVertices[vertex]);
+
+			// tB^[Ȃ
+			//m_Vertices.push_back(vertex);
+			//m_Indices.push_back(m_Indices.size());
+		}
+	}
+	// _mFEr
+	// std::cout << "_: "  << m_Vertices.size() << std::endl;
+}
+
+// gXtH[KwFX̃[g̉ɃfiglTF̃m[hKwɒǉ܂j
+// transform hierarchy: the model below the forest root; glTF node hierarchies are added below the root the same way
+void CVulkanFramework::createSceneGraph()
+{
+	m_RootNode = m_SceneGraph.addNode(SCENE_NO_PARENT, glm::mat4(1.0f));
+	m_ModelNode = m_SceneGraph.addNode(m_RootNode, glm::rotate(glm::mat4(1.0f), glm::radians(m_ModelAngle), glm::vec3(0.0f, 0.0f, 1.0f)));
+}
+
+// XFf؂ƂĎ̉~Ղɔzuif̂͋󂫒n̒SjBJ͐XnʒuɉAt@[v[͐X̒[܂ŁB
+// ؂̓JiŒj߂Ȃ̂ŁA̖؂m_ForestTrees̐擪͈̔͂ɂȂ܂B
+// forest: the model instanced as trees over a disk around a clearing, the model itself in the middle. The camera backs
+// off to look over the forest and the far plane reaches its edge. The trees are sorted by distance from the (fixed)
+// camera, so the ones within the impostor distance are a prefix of m_ForestTrees.
+void CVulkanFramework::createForest()
+{
+	if (m_Config.forestTrees == 0)
+	{
+		return;
+	}
+
+	glm::vec3 boundsMin = m_ShadowCasters[0].boundsMin;
+	glm::vec3 boundsMax = m_ShadowCasters[0].boundsMax;
+	for (const ShadowCaster& caster : m_ShadowCasters)
+	{
+		boundsMin = glm::min(boundsMin, caster.boundsMin);
+		boundsMax = glm::max(boundsMax, caster.boundsMax);
+	}
+	ImpostorSettings settings;
+	settings.distance = m_Config.impostorDistance;
+	m_ImpostorAtlas.setup(settings, boundsMin, boundsMax);
+
+	const float MAX_TREE_SCALE = 1.2f;    // CImpostorAtlas::createForest()
+	float spacing = 2.5f * m_ImpostorAtlas.getRadius();
+	m_CameraPosition = glm::vec3(6.0f, 6.0f, 2.5f);
+	float clearingRadius = glm::length(glm::vec2(m_CameraPosition)) + spacing;
+
+	m_ForestTrees = CImpostorAtlas::createForest(m_Config.forestTrees, clearingRadius, spacing);
+	CImpostorAtlas::sortByDistance(m_ForestTrees, m_CameraPosition);
+
+	float forestRadius = clearingRadius;
+	for (const glm::vec4& tree : m_ForestTrees)
+	{
+		forestRadius = std::max(forestRadius, glm::length(glm::vec2(tree)));
+	}
+	m_FarPlane = forestRadius + glm::length(glm::vec2(m_CameraPosition)) + 2.0f * MAX_TREE_SCALE * m_ImpostorAtlas.getRadius();
+	printf("Forest: %zu trees within %.0f units, far plane %.0f\n", m_ForestTrees.size(), forestRadius, m_FarPlane);
+}
+
+// CX^Xobt@[F_obt@[ƓXe[WOoRBXȂꍇf̂1iʒu0EXP[1j
+// instance buffer, uploaded through a staging buffer like the vertex buffer. Without a forest it holds just the model
+// itself (position 0, scale 1), which every mesh draw uses as instance 0.
+void CVulkanFramework::createInstanceBuffer()
+{
+	std::vector<glm::vec4> instances;
+	instances.reserve(1 + m_ForestTrees.size());
+	instances.push_back(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	instances.insert(instances.end(), m_ForestTrees.begin(), m_ForestTrees.end());
+	VkDeviceSize bufferSize = sizeof(instances[0]) * instances.size();
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	createBuffer(
+		bufferSize,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		stagingBuffer,
+		stagingBufferMemory);
+
+	void* data;
+	vkMapMemory(m_LogicalDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
+	memcpy(data, instances.data(), (size_t)bufferSize);
+	vkUnmapMemory(m_LogicalDevice, stagingBufferMemory);
+
+	createBuffer(
+		bufferSize,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		m_InstanceBuffer,
+		m_InstanceBufferMemory);
+
+	copyBuffer(stagingBuffer, m_InstanceBuffer, bufferSize);
+
+	vkDestroyBuffer(m_LogicalDevice, stagingBuffer, nullptr);
+	freeMemory(stagingBufferMemory);
+}
+
+// ẽLX^[FXY4x4`Nɕבւi{̂̕`͑SCfbNX̂܂܁jBJXP[hƂɌ`N̂ݕ`
+// CfbNXobt@[̃Abv[hOɌĂԂ
+// shadow casters: the indices are reordered into 4x4 chunks over XY (the main draw still uses all of them),
+// each cascade only draws the chunks inside it. Must run before the index buffer is uploaded.
+void CVulkanFramework::createShadowCasters()
+{
+	m_ShadowCasters = CShadowCascades::buildCasters(&m_Vertices[0].pos.x, sizeof(Vertex), m_Indices, 4);
+
+	// Z܂̉]łe̐[x͈͂Ɏ܂鋅i_Sj  sphere around the origin that bounds the model at any rotation about Z
+	float radius = 0.0f;
+	for (const ShadowCaster& caster : m_ShadowCasters)
+	{
+		glm::vec3 extent = glm::max(glm::abs(caster.boundsMin), glm::abs(caster.boundsMax));
+		radius = std::max(radius, glm::length(extent));
+	}
+	m_ShadowCascades.setSceneBounds(glm::vec3(0.0f), radius);
+}
+
+// _obt@[
+void CVulkanFramework::createVertexBuffer()
+{
+	// _P @z̗vf
+	VkDeviceSize bufferSize = sizeof(m_Vertices[0]) * m_Vertices.size();
+
+	// Xe[WOobt@[FCPU[Վobt@[B_f[^ɓnAŏIIȒ_obt@[ɓn܂B
+	// Staging buffer: temporary buffer in CPU memory that takes in vertex array and sends it to the final vertex buffer
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	createBuffer(
+		bufferSize,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		stagingBuffer,
+		stagingBufferMemory);
+
+	void* data;	// void|C^[G񃁃[}bvɎgp܂
+
+	// [Ƀ}bv
 	vkMapMemory(m_LogicalDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
 	memcpy(data, m_Vertices.data(), (size_t)bufferSize);
 	vkUnmapMemory(m_LogicalDevice, stagingBufferMemory);
@@ -1267,7 +2077,7 @@ void CVulkanFramework::createVertexBuffer()
 
 	// pς݂̃Xe[WOobt@[ƃ[̌Еt
 	vkDestroyBuffer(m_LogicalDevice, stagingBuffer, nullptr);
-	vkFreeMemory(m_LogicalDevice, stagingBufferMemory, nullptr);
+	freeMemory(stagingBufferMemory);
 }
 
 // CfbNXobt@[F_obt@[ƂقړiႢ͔Ԍ@@AAŕ\Ă܂
@@ -1304,7 +2114,7 @@ void CVulkanFramework::createIndexBuffer()
 
 	// pς݂̃Xe[WOobt@[ƃ[̌Еt
 	vkDestroyBuffer(m_LogicalDevice, stagingBuffer, nullptr);
-	vkFreeMemory(m_LogicalDevice, stagingBufferMemory, nullptr);
+	freeMemory(stagingBufferMemory);
 }
 
 // jtH[obt@[FVF[_[pUBO(Uniform Buffer Object)f[^
@@ -1328,182 +2138,793 @@ void CVulkanFramework::createUniformBuffers()
 	}
 }
 
-// fXNv^[Zbgi[ŃXNv^[v[𐶐
-void CVulkanFramework::createDescriptorPool()
+// 摜Ƃ̃Cgobt@[iwb_[{ő僉CgjƃNX^[obt@[
+// GPUU蕪̏ꍇANX^[obt@[̓Rs[gVF[_[̂ŃfoCX[J
+// per-image light buffer (header + MAX_POINT_LIGHTS) and cluster buffer; the cluster buffer is device local when
+// the compute pass writes it, host visible when the CPU fallback does
+void CVulkanFramework::createLightBuffers()
+{
+	size_t imageCount = m_SwapChainImages.size();
+	m_LightBuffers.resize(imageCount);
+	m_LightBuffersMemory.resize(imageCount);
+	m_LightBuffersMapped.resize(imageCount);
+	m_ClusterBuffers.resize(imageCount);
+	m_ClusterBuffersMemory.resize(imageCount);
+	m_ClusterBuffersMapped.assign(imageCount, nullptr);
+
+	const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	for (size_t i = 0; i < imageCount; i++)
+	{
+		createBuffer(sizeof(LightBufferHeader) + sizeof(PointLight) * MAX_POINT_LIGHTS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible,
+			m_LightBuffers[i], m_LightBuffersMemory[i]);
+		vkMapMemory(m_LogicalDevice, m_LightBuffersMemory[i], 0, VK_WHOLE_SIZE, 0, &m_LightBuffersMapped[i]);
+
+		createBuffer(CLUSTER_BUFFER_SIZE, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			m_LightCuller.isCreated() ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : hostVisible, m_ClusterBuffers[i], m_ClusterBuffersMemory[i]);
+		if (m_LightCuller.isCreated() == false)
+		{
+			vkMapMemory(m_LogicalDevice, m_ClusterBuffersMemory[i], 0, VK_WHOLE_SIZE, 0, &m_ClusterBuffersMapped[i]);
+			memset(m_ClusterBuffersMapped[i], 0, CLUSTER_BUFFER_SIZE);    // ̃NX^[  no lights until the first update
+		}
+	}
+}
+
+// VhE}bvFJXP[hƂ1C[BXbv`F[ɈˑȂ̂őS摜ŋLALbVꂽC[̓t[zĎc܂
+// the shadow map has one layer per cascade; it does not depend on the swapchain, so all images share it and
+// cached layers survive across frames. Cleared to the far plane once, so unrendered cascades are fully lit.
+void CVulkanFramework::createShadowMap()
+{
+	if (m_ShadowPass.getFormat() == VK_FORMAT_UNDEFINED)
+	{
+		return;
+	}
+
+	uint32_t size = m_ShadowPass.getSize();
+	ShadowSettings settings = m_ShadowCascades.getSettings();
+	settings.mapSize = size;    // eNZւ̃Xibvp  texel snapping
+	m_ShadowCascades.setSettings(settings);
+
+	createImage(size, size, 1, VK_SAMPLE_COUNT_1_BIT, m_ShadowPass.getFormat(), VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		m_ShadowImage, m_ShadowImageMemory, 0, SHADOW_CASCADE_COUNT);
+	m_ShadowPass.setImage(m_ShadowImage);
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	m_ShadowPass.clear(commandBuffer);
+	endSingleTimeCommands(commandBuffer);
+
+	// rTv[FPCF̓VF[_[3x3AjAΉȂn[hEFA2x2dȂ܂
+	// comparison sampler; the shaders do 3x3 PCF, with linear filtering (if supported) each tap is a 2x2 PCF as well
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(m_PhysicalDevice, m_ShadowPass.getFormat(), &formatProperties);
+	bool linear = (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0;
+
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+	samplerInfo.minFilter = samplerInfo.magFilter;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.anisotropyEnable = VK_FALSE;
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+	samplerInfo.compareEnable = VK_TRUE;
+	samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;    // Qƒl <= }bvF  lit when the reference is not behind the map
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = 0.0f;
+	m_ShadowSampler = m_SamplerCache.getSampler(samplerInfo);
+}
+
+// fXNv^[Zbgi[ŃXNv^[v[𐶐
+void CVulkanFramework::createDescriptorPool()
+{
+	// et[ɃZbg01pӂ܂iށE̓VF[_[j  one set 0 per swapchain image, sizes reflected from the shaders
+	std::vector<VkDescriptorPoolSize> poolSizes = m_ShaderReflection.getPoolSizes(0, static_cast<uint32_t>(m_SwapChainImages.size()), 0);
+
+	VkDescriptorPoolCreateInfo poolInfo{};    // fXNv^[v[\
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = static_cast<uint32_t>(m_SwapChainImages.size());    // +1 if w / Imgui
+
+	if (vkCreateDescriptorPool(m_LogicalDevice, &poolInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor pool!");
+	}
+}
+
+// fXNv^[ZbgigXtH[j
+void CVulkanFramework::createDescriptorSets()
+{
+	std::vector<VkDescriptorSetLayout> layouts(m_SwapChainImages.size(), m_DescriptorSetLayout);
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = m_DescriptorPool;    // fXNv^[v[
+	allocInfo.descriptorSetCount = static_cast<uint32_t>(m_SwapChainImages.size());
+	allocInfo.pSetLayouts = layouts.data();
+
+	m_DescriptorSets.resize(m_SwapChainImages.size());
+	if (vkAllocateDescriptorSets(m_LogicalDevice, &allocInfo, m_DescriptorSets.data()) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate descriptor sets!");
+	}
+
+	for (size_t i = 0; i < m_SwapChainImages.size(); i++)
+	{
+		VkDescriptorBufferInfo bufferInfo{};
+		bufferInfo.buffer = m_UniformBuffers[i];
+		bufferInfo.offset = 0;
+		bufferInfo.range = sizeof(UniformBufferObject);    // Sɏ㏑FVK_WHOLE_SIZEƓ
+
+		// Combined Image Sampler
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = m_Textures[0].view;
+		imageInfo.sampler = m_Textures[0].sampler;
+
+
+		std::vector<VkWriteDescriptorSet> descriptorWrites(2);    // fXNv^[̐ݒERtBO[V\
+		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[0].dstSet = m_DescriptorSets[i];
+		descriptorWrites[0].dstBinding = 0;                // jtH[obt@[oCfBOCfbNXu0v
+		descriptorWrites[0].dstArrayElement = 0;           // zgĂȂꍇAu0v
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descriptorWrites[0].descriptorCount = 1;
+		descriptorWrites[0].pBufferInfo = &bufferInfo;
+
+		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[1].dstSet = m_DescriptorSets[i];
+		descriptorWrites[1].dstBinding = 1;
+		descriptorWrites[1].dstArrayElement = 0;
+		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrites[1].descriptorCount = 1;
+		descriptorWrites[1].pImageInfo = &imageInfo;
+
+		// IBLF2 = ˏƓxA3 = vtB^[ς݁A4 = BRDF LUTiVF[_[錾Ăꍇ̂݁FÂSPIR-Vłj
+		// IBL bindings 2..4, written only if the shaders declare them so older SPIR-V keeps working
+		const Texture* iblTextures[IBL_PASS_COUNT] = { &m_IblIrradiance, &m_IblPrefiltered, &m_IblBrdfLut };
+		std::array<VkDescriptorImageInfo, IBL_PASS_COUNT> iblInfos{};
+		for (uint32_t pass = 0; pass < IBL_PASS_COUNT; pass++)
+		{
+			uint32_t binding = 2 + pass;
+			if (m_ShaderReflection.getBindings().count({ 0, binding }) == 0)
+			{
+				continue;
+			}
+			iblInfos[pass].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			iblInfos[pass].imageView = iblTextures[pass]->view;
+			iblInfos[pass].sampler = iblTextures[pass]->sampler;
+
+			VkWriteDescriptorSet write{};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = m_DescriptorSets[i];
+			write.dstBinding = binding;
+			write.dstArrayElement = 0;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			write.descriptorCount = 1;
+			write.pImageInfo = &iblInfos[pass];
+			descriptorWrites.push_back(write);
+		}
+
+		// NX^[CgF5 = Cgobt@[A6 = NX^[obt@[iIBLƓ錾Ăꍇ̂݁j
+		// clustered lights: 5 = light buffer, 6 = cluster buffer, written only if declared (like IBL)
+		VkBuffer lightBuffers[2] = { m_LightBuffers[i], m_ClusterBuffers[i] };
+		std::array<VkDescriptorBufferInfo, 2> lightInfos{};
+		for (uint32_t index = 0; index < 2; index++)
+		{
+			uint32_t binding = 5 + index;
+			if (m_ShaderReflection.getBindings().count({ 0, binding }) == 0)
+			{
+				continue;
+			}
+			lightInfos[index].buffer = lightBuffers[index];
+			lightInfos[index].offset = 0;
+			lightInfos[index].range = VK_WHOLE_SIZE;
+
+			VkWriteDescriptorSet write{};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = m_DescriptorSets[i];
+			write.dstBinding = binding;
+			write.dstArrayElement = 0;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			write.descriptorCount = 1;
+			write.pBufferInfo = &lightInfos[index];
+			descriptorWrites.push_back(write);
+		}
+
+		// z̉eF7 = VhE}bviJXP[hzArTv[j
+		// sun shadows: 7 = shadow map (cascade array, comparison sampler)
+		VkDescriptorImageInfo shadowInfo{};
+		if (m_ShaderReflection.getBindings().count({ 0, 7 }) != 0 && m_ShadowImage != VK_NULL_HANDLE)
+		{
+			shadowInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			shadowInfo.imageView = m_ShadowPass.getView();
+			shadowInfo.sampler = m_ShadowSampler;
+
+			VkWriteDescriptorSet write{};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = m_DescriptorSets[i];
+			write.dstBinding = 7;
+			write.dstArrayElement = 0;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			write.descriptorCount = 1;
+			write.pImageInfo = &shadowInfo;
+			descriptorWrites.push_back(write);
+		}
+
+		// fXNv^[ZbgXV܂
+		vkUpdateDescriptorSets(m_LogicalDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+	}
+
+	if (m_LightCuller.isCreated())
+	{
+		m_LightCuller.setBuffers(m_LightBuffers, m_ClusterBuffers);    // U蕪pX̃Zbgi摜Ɓj
+	}
+}
+
+// oChX̃eNX`[zƃ}eASSBO𐶐Aǂݍݍς݂̃eNX`[o^܂
+// Creates the bindless set (update-after-bind texture array + material SSBO) and registers the loaded textures.
+// One material per texture for now; the model uses material 0.
+void CVulkanFramework::createBindlessDescriptors()
+{
+	if (m_UseBindless == false)
+	{
+		return;
+	}
+
+	std::vector<VkDescriptorPoolSize> poolSizes = m_ShaderReflection.getPoolSizes(1, 1, m_BindlessCapacity);
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = 1;
+
+	if (vkCreateDescriptorPool(m_LogicalDevice, &poolInfo, nullptr, &m_BindlessPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create bindless descriptor pool!");
+	}
+
+	VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{};
+	variableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+	variableCountInfo.descriptorSetCount = 1;
+	variableCountInfo.pDescriptorCounts = &m_BindlessCapacity;
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.pNext = &variableCountInfo;
+	allocInfo.descriptorPool = m_BindlessPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &m_BindlessSetLayout;
+
+	if (vkAllocateDescriptorSets(m_LogicalDevice, &allocInfo, &m_BindlessSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate bindless descriptor set!");
+	}
+
+	// }eASSBOFeʕmۂA펞}bvi}eAǉɂ̂܂܏ށj
+	VkDeviceSize materialBufferSize = sizeof(MaterialData) * m_BindlessCapacity;
+	createBuffer(
+		materialBufferSize,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		m_MaterialBuffer,
+		m_MaterialBufferMemory
+	);
+	vkMapMemory(m_LogicalDevice, m_MaterialBufferMemory, 0, materialBufferSize, 0, &m_MaterialBufferMapped);
+
+	VkDescriptorBufferInfo materialInfo{};
+	materialInfo.buffer = m_MaterialBuffer;
+	materialInfo.offset = 0;
+	materialInfo.range = materialBufferSize;
+
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = m_BindlessSet;
+	descriptorWrite.dstBinding = 0;
+	descriptorWrite.dstArrayElement = 0;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.pBufferInfo = &materialInfo;
+	vkUpdateDescriptorSets(m_LogicalDevice, 1, &descriptorWrite, 0, nullptr);
+
+	for (Texture& texture : m_Textures)
+	{
+		texture.bindlessIndex = registerBindlessTexture(texture.view, texture.sampler);
+
+		MaterialData material{};
+		material.albedoTexture = texture.bindlessIndex;
+		addMaterial(material);
+	}
+}
+
+// eNX`[oChXzɒǉiUPDATE_AFTER_BIND̂ߕ`撆̃R}hobt@[Ăj
+uint32_t CVulkanFramework::registerBindlessTexture(VkImageView view, VkSampler sampler)
+{
+	if (m_BindlessTextureCount >= m_BindlessCapacity)
+	{
+		throw std::runtime_error("Failed to register texture: bindless texture array is full!");
+	}
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = view;
+	imageInfo.sampler = sampler;
+
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = m_BindlessSet;
+	descriptorWrite.dstBinding = 1;
+	descriptorWrite.dstArrayElement = m_BindlessTextureCount;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets(m_LogicalDevice, 1, &descriptorWrite, 0, nullptr);
+
+	return m_BindlessTextureCount++;
+}
+
+// }eASSBOɒǉ
+uint32_t CVulkanFramework::addMaterial(const MaterialData& material)
+{
+	if (m_Materials.size() >= m_BindlessCapacity)
+	{
+		throw std::runtime_error("Failed to add material: material buffer is full!");
+	}
+
+	uint32_t index = static_cast<uint32_t>(m_Materials.size());
+	m_Materials.push_back(material);
+	memcpy(static_cast<MaterialData*>(m_MaterialBufferMapped) + index, &material, sizeof(MaterialData));
+	return index;
+}
+
+// R}hv[̏񂩂R}hobt@[
+void CVulkanFramework::createCommandBuffers()
+{
+	// Xbv`F[摜ƂɃR}hv[1pӁFR}hv[͊OȂ̂ŁA
+	// ʁX̃v[ȂeR}hobt@[ʃXbhœɋL^ł܂
+	// one command pool per swapchain image: pools are externally synchronized, so separate pools
+	// let every command buffer be recorded on a different worker thread at the same time
+	size_t imageCount = m_SwapChainFramebuffers.size();    // t[obt@[TCYɍ킹
+	m_CommandBuffers.resize(imageCount);
+	m_FrameCommandPools.resize(imageCount);
+	for (size_t i = 0; i < imageCount; i++)
+	{
+		createCommandPool(m_FrameCommandPools[i], 0);
+		allocateCommandBuffers(&m_CommandBuffers[i], 1, m_FrameCommandPools[i]);
+	}
+
+	// 摜Ƃ̃^CX^vFJnEU蕪EfvXvpXEV[iR}hobt@[ƈꏏɍĒo܂j
+	// per-image timestamps (start, after culling, after the depth prepass, after the scene), re-submitted with the command buffers
+	if (CGpuTimer::isSupported(m_PhysicalDevice, findQueueFamilies(m_PhysicalDevice).graphicsFamily.value()))
+	{
+		m_FrameTimers.resize(imageCount);
+		for (CGpuTimer& timer : m_FrameTimers)
+		{
+			timer.create(m_LogicalDevice, m_PhysicalDevice, 4);
+		}
+	}
+
+	// VhEpXFĕ`悷JXP[ht[ς̂ŁAOL^ɖt[L^܂iImGuiƓj
+	// shadow pass: which cascades re-render changes every frame, so it is recorded per frame like ImGui
+	createCommandPool(m_ShadowCommandPool, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+	m_ShadowCommandBuffers.resize(imageCount);
+	allocateCommandBuffers(m_ShadowCommandBuffers.data(), static_cast<uint32_t>(imageCount), m_ShadowCommandPool);
+	if (m_FrameTimers.empty() == false)
+	{
+		m_ShadowTimers.resize(imageCount);
+		for (CGpuTimer& timer : m_ShadowTimers)
+		{
+			timer.create(m_LogicalDevice, m_PhysicalDevice, 2);
+		}
+	}
+	recordCommandBuffers();
+}
+
+// SXbv`F[摜̃R}hobt@[ɋL^܂
+// records every swapchain image's command buffer in parallel
+void CVulkanFramework::recordCommandBuffers()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	buildDrawList();
+	buildFrameGraphs();
+
+	size_t imageCount = m_CommandBuffers.size();
+	m_DrawStats.assign(imageCount, DrawRecordStats());
+	std::vector<std::exception_ptr> errors(imageCount);
+	m_JobSystem->parallelFor(static_cast<uint32_t>(imageCount), 1, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			try
+			{
+				recordCommandBuffer(i);
+			}
+			catch (...)
+			{
+				errors[i] = std::current_exception();    // Wu͗O𓊂Ȃ  rethrown on this thread below
+			}
+		}
+	});
+
+	for (const std::exception_ptr& error : errors)
+	{
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
+	m_CommandBuffersDirty = false;
+	m_RecordMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// R}hv[ZbgĂL^܂iv[̓ZbgtOȂŐFʂ̃Zbg͕sj
+// resets the frame command pools, then records again: the pools are created without the reset flag, so a recorded
+// buffer may only begin again after its pool was reset. The GPU must not be using the buffers (wait first).
+void CVulkanFramework::rerecordCommandBuffers()
+{
+	for (VkCommandPool commandPool : m_FrameCommandPools)
+	{
+		vkResetCommandPool(m_LogicalDevice, commandPool, 0);
+	}
+	recordCommandBuffers();
+}
+
+// t[OtF摜ƂɓpXAoCĥ͂̉摜̃Xbv`F[C[WƃNX^[obt@[
+// VhEEImGuĩR}hobt@[t[L^̂ŁAGPUҋ@irecordCommandBuffers()jɍ蒼܂
+// one graph per swapchain image: the same passes, bound to the image's swapchain image and cluster buffer. The
+// shadow and ImGui command buffers record from it every frame too, so it is only rebuilt with the GPU idle
+void CVulkanFramework::buildFrameGraphs()
+{
+	bool shadows = m_ShadowPass.isCreated() && (m_Config.shaderFeatures & SHADER_FEATURE_SHADOWS);
+	bool lightCulling = m_LightCuller.isCreated() && (m_Config.shaderFeatures & SHADER_FEATURE_CLUSTERED_LIGHTS);
+
+	VkImageSubresourceRange colorRange{};
+	colorRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	colorRange.baseMipLevel = 0;
+	colorRange.levelCount = 1;
+	colorRange.baseArrayLayer = 0;
+	colorRange.layerCount = 1;
+
+	VkImageSubresourceRange depthRange = colorRange;
+	depthRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	if (hasStencilComponent(findDepthFormat()))
+	{
+		depthRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+	}
+
+	m_FrameGraphs.assign(m_SwapChainImages.size(), CRenderGraph());
+	for (size_t i = 0; i < m_FrameGraphs.size(); i++)
+	{
+		CRenderGraph& graph = m_FrameGraphs[i];
+		m_FramePasses = declareForestFrame(graph, shadows, lightCulling);
+		graph.compile();
+
+		graph.bindImage(m_FramePasses.swapchain, m_SwapChainImages[i], colorRange);
+		graph.bindImage(m_FramePasses.color, m_ColorImage, colorRange);
+		graph.bindImage(m_FramePasses.depth, m_DepthImage, depthRange);
+		if (shadows)
+		{
+			graph.bindImage(m_FramePasses.shadowMap, m_ShadowImage, m_ShadowPass.getRange());
+		}
+		if (lightCulling)
+		{
+			graph.bindBuffer(m_FramePasses.clusters, m_ClusterBuffers[i]);
+		}
+	}
+}
+
+// h[XgFf̃`NiVhELX^[ƓCfbNX͈́jƁEpXƂ1pPbg
+// XꍇAepPbg̓f̂Ƌ̖؂CX^X`悵܂i̖؂̓C|X^[j
+// draw list: one packet per model chunk (the shadow caster index ranges) and pass. The depth is the distance from
+// the camera to the chunk center when recording; the command buffers are pre-recorded, so a spinning model keeps
+// the front-to-back order of the last re-record (only how much the early depth test rejects depends on it).
+// With a forest every packet is instanced over the model itself and the trees within the impostor distance
+// (all of them with impostors off); recordCommandBuffer() draws the rest as impostors.
+void CVulkanFramework::buildDrawList()
 {
-	std::array<VkDescriptorPoolSize, 2> poolSizes{};    // et[1̃fXNv^[pӂ܂
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;                              // [0] UBO gXtH[Ȃ
-	poolSizes[0].descriptorCount = static_cast<uint32_t>(m_SwapChainImages.size());
-	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;                      // [1] `p
-	poolSizes[1].descriptorCount = static_cast<uint32_t>(m_SwapChainImages.size());
-
+	m_DrawList.clear();
+
+	bool impostors = m_Config.impostors && m_ImpostorPass.isCreated();
+	m_NearTreeCount = impostors ? CImpostorAtlas::countCloser(m_ForestTrees, m_CameraPosition, m_Config.impostorDistance)
+		: static_cast<uint32_t>(m_ForestTrees.size());
+	const uint32_t instanceCount = 1 + m_NearTreeCount;    // CX^X0̓f  instance 0 is the model itself
+
+	// fvXvpXFCpX̓fvXtOgVF[fBÔŁAdPBRVF[fBÕI[o[h[ȂȂ܂B
+	// depth prepass: the main pass then shades only the fragments whose depth equals the prepass result,
+	// so the PBR shader runs once per visible sample
+	uint32_t prepassKey = PIPELINE_DEPTH_PREPASS | (m_Config.shaderFeatures & (SHADER_FEATURE_ALPHA_TEST | SHADER_FEATURE_UV_TILING));
+	uint32_t sceneKey = m_Config.shaderFeatures;
+	if (m_Config.depthPrepass)
+	{
+		sceneKey |= PIPELINE_DEPTH_EQUAL;
+	}
+	const uint32_t materialIndex = 0;    // f͌1̂݁F}eA0  the model uses material 0
 
-	VkDescriptorPoolCreateInfo poolInfo{};    // fXNv^[v[\
-	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-	poolInfo.pPoolSizes = poolSizes.data();
-	poolInfo.maxSets = static_cast<uint32_t>(m_SwapChainImages.size());    // +1 if w / Imgui
+	// ǉi\[gȂ̊jFvpX̑S`NAɃCpX̑S`N
+	// add order, the unsorted baseline: every prepass chunk, then every main pass chunk. The passes stay in order
+	// even unsorted, so all depth is written before the first EQUAL draw is shaded.
+	const glm::mat4& model = m_SceneGraph.getWorld(m_ModelNode);
+	auto getChunkDepth = [&](const ShadowCaster& chunk)
+	{
+		glm::vec3 center = glm::vec3(model * glm::vec4((chunk.boundsMin + chunk.boundsMax) * 0.5f, 1.0f));
+		return glm::length(center - m_CameraPosition);
+	};
+	if (m_Config.depthPrepass)
+	{
+		for (const ShadowCaster& chunk : m_ShadowCasters)
+		{
+			m_DrawList.add(DRAW_PASS_DEPTH_PREPASS, prepassKey, materialIndex, getChunkDepth(chunk), chunk.firstIndex, chunk.indexCount, 0, instanceCount);
+		}
+	}
+	for (const ShadowCaster& chunk : m_ShadowCasters)
+	{
+		m_DrawList.add(DRAW_PASS_OPAQUE, sceneKey, materialIndex, getChunkDepth(chunk), chunk.firstIndex, chunk.indexCount, 0, instanceCount);
+	}
 
-	if (vkCreateDescriptorPool(m_LogicalDevice, &poolInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
+	if (m_Config.sortDraws)
 	{
-		throw std::runtime_error("Failed to create descriptor pool!");
+		m_DrawList.sort(*m_JobSystem);
 	}
 }
 
-// fXNv^[ZbgigXtH[j
-void CVulkanFramework::createDescriptorSets()
+// VF[_[@\ioAgL[j̕ύXF̃t[̑OɃR}hobt@[L^܂
+// changes the shader feature key; the command buffers are re-recorded before the next frame
+void CVulkanFramework::setShaderFeatures(uint32_t features)
 {
-	std::vector<VkDescriptorSetLayout> layouts(m_SwapChainImages.size(), m_DescriptorSetLayout);
-
-	VkDescriptorSetAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	allocInfo.descriptorPool = m_DescriptorPool;    // fXNv^[v[
-	allocInfo.descriptorSetCount = static_cast<uint32_t>(m_SwapChainImages.size());
-	allocInfo.pSetLayouts = layouts.data();
-
-	m_DescriptorSets.resize(m_SwapChainImages.size());
-	if (vkAllocateDescriptorSets(m_LogicalDevice, &allocInfo, m_DescriptorSets.data()) != VK_SUCCESS)
+	if (features == m_Config.shaderFeatures)
 	{
-		throw std::runtime_error("Failed to allocate descriptor sets!");
+		return;
 	}
+	m_Config.shaderFeatures = features;
+	m_CommandBuffersDirty = true;
+}
 
-	for (size_t i = 0; i < m_SwapChainImages.size(); i++)
+void CVulkanFramework::setDepthPrepass(bool enabled)
+{
+	if (enabled == m_Config.depthPrepass)
 	{
-		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = m_UniformBuffers[i];
-		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(UniformBufferObject);    // Sɏ㏑FVK_WHOLE_SIZEƓ
-
-		// Combined Image Sampler
-		VkDescriptorImageInfo imageInfo{};
-		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imageInfo.imageView = m_TextureImageView;
-		imageInfo.sampler = m_TextureSampler;
-
+		return;
+	}
+	m_Config.depthPrepass = enabled;
+	m_CommandBuffersDirty = true;
+}
 
-		std::array<VkWriteDescriptorSet, 2> descriptorWrites{};    // fXNv^[̐ݒERtBO[V\
-		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[0].dstSet = m_DescriptorSets[i];
-		descriptorWrites[0].dstBinding = 0;                // jtH[obt@[oCfBOCfbNXu0v
-		descriptorWrites[0].dstArrayElement = 0;           // zgĂȂꍇAu0v
-		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrites[0].descriptorCount = 1;
-		descriptorWrites[0].pBufferInfo = &bufferInfo;
+void CVulkanFramework::setDrawSorting(bool enabled)
+{
+	if (enabled == m_Config.sortDraws)
+	{
+		return;
+	}
+	m_Config.sortDraws = enabled;
+	m_CommandBuffersDirty = true;
+}
 
-		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[1].dstSet = m_DescriptorSets[i];
-		descriptorWrites[1].dstBinding = 1;
-		descriptorWrites[1].dstArrayElement = 0;
-		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorWrites[1].descriptorCount = 1;
-		descriptorWrites[1].pImageInfo = &imageInfo;
+void CVulkanFramework::setImpostors(bool enabled)
+{
+	if (enabled == m_Config.impostors)
+	{
+		return;
+	}
+	m_Config.impostors = enabled;
+	m_CommandBuffersDirty = true;
+}
 
-		// fXNv^[ZbgXV܂
-		vkUpdateDescriptorSets(m_LogicalDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+void CVulkanFramework::setImpostorDistance(float distance)
+{
+	if (distance == m_Config.impostorDistance)
+	{
+		return;
 	}
+	m_Config.impostorDistance = distance;
+	m_CommandBuffersDirty = true;
 }
 
-// R}hv[̏񂩂R}hobt@[
-void CVulkanFramework::createCommandBuffers()
+// 1̃Xbv`F[摜̃R}hobt@[L^i[J[XbhĂ΂܂j
+// records the command buffer of one swapchain image (called on worker threads)
+void CVulkanFramework::recordCommandBuffer(uint32_t imageIndex)
 {
-	m_CommandBuffers.resize(m_SwapChainFramebuffers.size());    // t[obt@[TCYɍ킹
-	allocateCommandBuffers(m_CommandBuffers.data(), static_cast<uint32_t>(m_CommandBuffers.size()), m_CommandPool);
+	VkCommandBuffer commandBuffer = m_CommandBuffers[imageIndex];
 
 	// R}hobt@[o^Jn Starting command buffer recording
-	for (size_t i = 0; i < m_CommandBuffers.size(); i++)
+	VkCommandBufferBeginInfo beginInfo{};       // R}hobt@[Jn\
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = 0;                        // CӁ@optional
+	beginInfo.pInheritanceInfo = nullptr;       // pFSECONDARY̏ꍇ̂݁iǂ̃R}hobt@[Ăяoj
+												// only for secondary command buffers (which state to inherit from)
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to begin recording command buffer!");
+	}
+
+	CGpuTimer* timer = m_FrameTimers.empty() ? nullptr : &m_FrameTimers[imageIndex];
+	if (timer)
+	{
+		timer->reset(commandBuffer);
+		timer->timestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, "start");
+	}
+
+	// CgU蕪i_[pX̑OjF̉摜̃Cgobt@[NX^[obt@[
+	// light culling before the render pass, from this image's light buffer into its cluster buffer
+	const CRenderGraph& frameGraph = m_FrameGraphs[imageIndex];
+	if (m_FramePasses.lightCullPass != RG_NONE)
 	{
-		VkCommandBufferBeginInfo beginInfo{};       // R}hobt@[Jn\
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = 0;                        // CӁ@optional
-		beginInfo.pInheritanceInfo = nullptr;       // pFSECONDARY̏ꍇ̂݁iǂ̃R}hobt@[Ăяoj
-													// only for secondary command buffers (which state to inherit from)
+		frameGraph.recordBarriers(commandBuffer, m_FramePasses.lightCullPass);
+		m_LightCuller.record(commandBuffer, imageIndex);
+	}
+	if (timer)
+	{
+		timer->timestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, "cull");
+	}
 
-		if (vkBeginCommandBuffer(m_CommandBuffers[i], &beginInfo) != VK_SUCCESS)
+	// A^b`gEVhE}bvENX^[̃oAit[Otj
+	// barriers for the attachments, the shadow map and the clusters, from the frame graph
+	frameGraph.recordBarriers(commandBuffer, m_FramePasses.scenePass);
+
+	// _[pXJn
+	// Starting a render pass
+	VkRenderPassBeginInfo renderPassInfo{};		// _[pX\
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = m_RenderPass;
+	renderPassInfo.framebuffer = m_SwapChainFramebuffers[imageIndex];
+
+	renderPassInfo.renderArea.offset = { 0, 0 };
+
+	// ptH[}X̍œK̂߁A_[̈A^b`gTCYɍ킹܂B
+	// match render area to size of attachments for best performance
+	renderPassInfo.renderArea.extent = m_SwapChainExtent;
+
+	// createRenderPass(): VK_ATTACHMENT_LOAD_OP_CLEAR̃NAl (clearColor)
+	std::array<VkClearValue, 2> clearValues{};
+	clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };    // 
+	clearValues[1].depthStencil = { 1.0f, 0 };            // fvXXeVNAl (1.0f: t@[ Far Plane)
+
+	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+	renderPassInfo.pClearValues = clearValues.data();
+
+	// ۂ̃_[pXJn܂
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	// h[pPbgF\[gς݂ȂpXEpCvCE}eAEO牜̏BoChς݂̃Xe[g͍ăoCh܂B
+	// fvXvpXiTupXEfvXA^b`gj̃pPbg̓CpX̑Oɂ܂Ƃ܂܂B
+	// draw packets, in key order when sorted: pass, pipeline, material, front to back. State that is already bound is
+	// not bound again; the unsorted baseline binds the full state of every draw. Sorted or not, the depth prepass
+	// packets (same subpass and depth attachment, see buildDrawList()) all come before the main pass.
+	CDrawStateCache state(m_DrawList.isSorted());
+	const std::vector<DrawPacket>& packets = m_DrawList.getPackets();
+	for (size_t i = 0; i < packets.size(); i++)
+	{
+		const DrawPacket& packet = packets[i];
+		state.bindPipeline(commandBuffer, m_PipelineVariants.get(packet.pipelineKey));    // gpɃRpC
+		state.bindGeometry(commandBuffer, m_VertexBuffer, m_InstanceBuffer, m_IndexBuffer);
+		state.bindDescriptorSet(commandBuffer, m_PipelineLayout, 0, m_DescriptorSets[imageIndex]);
+		if (m_UseBindless)
 		{
-			throw std::runtime_error("Failed to begin recording command buffer!");
+			state.bindDescriptorSet(commandBuffer, m_PipelineLayout, 1, m_BindlessSet);    // oChXZbg
 		}
 
-		// _[pXJn
-		// Starting a render pass
-		VkRenderPassBeginInfo renderPassInfo{};		// _[pX\
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = m_RenderPass;
-		renderPassInfo.framebuffer = m_SwapChainFramebuffers[i];
+		// }eACfbNXFvbV萔ubNXe[Ŵ
+		// material index, pushed to the stages that declare a push-constant block
+		state.pushMaterial(commandBuffer, m_PipelineLayout, m_ShaderReflection.getPushConstantRanges(), packet.materialIndex);
 
-		renderPassInfo.renderArea.offset = { 0, 0 };
-
-		// ptH[}X̍œK̂߁A_[̈A^b`gTCYɍ킹܂B
-		// match render area to size of attachments for best performance
-		renderPassInfo.renderArea.extent = m_SwapChainExtent;
+		// `R}hiCfbNXobt@[j
+		state.drawIndexed(commandBuffer, packet.firstIndex, packet.indexCount, packet.firstInstance, packet.instanceCount);
 
-		// createRenderPass(): VK_ATTACHMENT_LOAD_OP_CLEAR̃NAl (clearColor)
-		std::array<VkClearValue, 2> clearValues{};
-		clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };    // 
-		clearValues[1].depthStencil = { 1.0f, 0 };            // fvXXeVNAl (1.0f: t@[ Far Plane)
+		// vpX̍Ō̃h[̌  after the last prepass draw
+		bool lastOfPrepass = packet.pass == DRAW_PASS_DEPTH_PREPASS && (i + 1 == packets.size() || packets[i + 1].pass != DRAW_PASS_DEPTH_PREPASS);
+		if (timer && lastOfPrepass)
+		{
+			timer->timestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, "prepass");
+		}
+	}
+	m_DrawStats[imageIndex] = state.getStats();
 
-		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-		renderPassInfo.pClearValues = clearValues.data();
+	// ̖؁FC|X^[̎lp`ibV̌AfvXobt@[jBm_InstanceBuffer̃bV̖؂̌납
+	// far trees as impostor quads, after the meshes and against the same depth buffer; their instances follow the
+	// near trees in m_InstanceBuffer
+	if (m_Config.impostors && m_ImpostorPass.isCreated())
+	{
+		uint32_t farTreeCount = static_cast<uint32_t>(m_ForestTrees.size()) - m_NearTreeCount;
+		m_ImpostorPass.record(commandBuffer, imageIndex, m_ImpostorAtlas, m_InstanceBuffer, 1 + m_NearTreeCount, farTreeCount);
+	}
 
-		// ۂ̃_[pXJn܂
-		vkCmdBeginRenderPass(m_CommandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	// @FR}hobt@[
+	//     AF_i_obt@[Ȃł_`悵Ă܂Bj
+	//     BFCX^XiCX^X_Opj
+	//     CFCfbNXobt@[̍ŏ_̃ItZbg
+	//     DFCfbNXobt@[ɑItZbg (g͂܂sj
+	//     EFCX^X̃ItZbgiCX^X_Opj
+
+	// arguments
+	// first    : commandBuffer
+	// second   : vertexCount  : even without vertex buffer, still drawing 3 vertices (triangle)
+	// third    : instanceCount: used for instanced rendering, otherwise 1)
+	// fourth   : firstIndexOffset : offset to start of index buffer (1 means GPU reads from second index)
+	// fifth    : indexAddOffset   : offset to add to indices (not sure what this is for)
+	// sixth    : instanceOffset   : used in instanced rendering
+
+	// _[pXI܂
+	vkCmdEndRenderPass(commandBuffer);
+
+	if (timer)
+	{
+		timer->timestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, "scene");
+	}
 
-		// OtBbNXpCvCƂȂ܂
-		vkCmdBindPipeline(m_CommandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline);
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to record command buffer!");
+	}
+}
 
-		// _obt@[oCh`̏͊ł
-		VkBuffer vertexBuffers[] = { m_VertexBuffer };
-		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(m_CommandBuffers[i], 0, 1, vertexBuffers, offsets);
+// VhEpX̋L^Ft[ĕ`悷JXP[ĥ݁iupdateShadows()̌ʁjBLbVꂽC[͂̂܂
+// records the cascades that re-render this frame (decided in updateShadows()); cached layers are left untouched
+void CVulkanFramework::recordShadowPass(uint32_t imageIndex)
+{
+	PROFILE_FUNCTION();
 
-		// CfbNXobt@[
-		vkCmdBindIndexBuffer(m_CommandBuffers[i], m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);    // VK_INDEX_TYPE_UINT16
+	VkCommandBuffer commandBuffer = m_ShadowCommandBuffers[imageIndex];
+	vkResetCommandBuffer(commandBuffer, 0);
 
-		// fXNv^[ZbgoCh܂
-		vkCmdBindDescriptorSets(
-			m_CommandBuffers[i],
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			m_PipelineLayout,
-			0,
-			1,
-			&m_DescriptorSets[i],
-			0,
-			nullptr)
-			;
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-		// `R}hiCfbNXobt@[j
-		vkCmdDrawIndexed(m_CommandBuffers[i], static_cast<uint32_t>(m_Indices.size()), 1, 0, 0, 0);
-		// @FR}hobt@[
-		//     AF_i_obt@[Ȃł_`悵Ă܂Bj
-		//     BFCX^XiCX^X_Opj
-		//     CFCfbNXobt@[̍ŏ_̃ItZbg
-		//     DFCfbNXobt@[ɑItZbg (g͂܂sj
-		//     EFCX^X̃ItZbgiCX^X_Opj
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to begin recording shadow command buffer!");
+	}
 
-		// arguments
-		// first    : commandBuffer
-		// second   : vertexCount  : even without vertex buffer, still drawing 3 vertices (triangle)
-		// third    : instanceCount: used for instanced rendering, otherwise 1)
-		// fourth   : firstIndexOffset : offset to start of index buffer (1 means GPU reads from second index)
-		// fifth    : indexAddOffset   : offset to add to indices (not sure what this is for)
-		// sixth    : instanceOffset   : used in instanced rendering
+	CGpuTimer* timer = m_ShadowTimers.empty() ? nullptr : &m_ShadowTimers[imageIndex];
+	if (timer)
+	{
+		timer->reset(commandBuffer);
+		timer->timestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, "start");
+	}
 
-		// _[pXI܂
-		vkCmdEndRenderPass(m_CommandBuffers[i]);
+	// LbVꂽJXP[h̏ꍇAV[̃oAƑ΂ɂȂJڂL^܂
+	// the transition is recorded even when every cascade is cached: the scene's barrier expects the attachment layout
+	if (m_FramePasses.shadowPass != RG_NONE)
+	{
+		m_FrameGraphs[imageIndex].recordBarriers(commandBuffer, m_FramePasses.shadowPass);
 
-		if (vkEndCommandBuffer(m_CommandBuffers[i]) != VK_SUCCESS)
+		const glm::mat4& model = m_SceneGraph.getWorld(m_ModelNode);
+		for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
 		{
-			throw std::runtime_error("Failed to record command buffer!");
+			const ShadowCascade& cascade = m_ShadowCascades.getCascade(i);
+			if (cascade.render)
+			{
+				m_ShadowPass.record(commandBuffer, i, cascade.viewProj * model, m_VertexBuffer, m_IndexBuffer, m_ShadowCasters, cascade.casters);
+			}
 		}
 	}
+
+	if (timer)
+	{
+		timer->timestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, "shadow");
+	}
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to record shadow command buffer!");
+	}
 }
 
 // ̐pIuWFNg
+// Xbv`F[Ƃ̂iacquire/presentj̓oCiZ}tHAt[̊̓^CCZ}tH
+// binary semaphores for acquire/present (required by the swapchain), one timeline semaphore for frame completion
 void CVulkanFramework::createSyncObjects()
 {
-	m_ImageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-	m_RenderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-	m_InFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-	m_ImagesInFlight.resize(m_SwapChainImages.size(), VK_NULL_HANDLE);
+	m_FramesInFlight = std::clamp(m_Config.framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT);
+	m_ImageAvailableSemaphores.resize(m_FramesInFlight);
+	m_RenderFinishedSemaphores.resize(m_FramesInFlight);
+	m_InFlightFences.resize(m_TimelineSupported ? 0 : m_FramesInFlight);
+	m_ImageFrames.assign(m_SwapChainImages.size(), 0);
 
 	VkSemaphoreCreateInfo semaphoreInfo{};
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -1512,15 +2933,110 @@ void CVulkanFramework::createSyncObjects()
 	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	for (size_t i = 0; i < m_FramesInFlight; i++)
 	{
 		if (vkCreateSemaphore(m_LogicalDevice, &semaphoreInfo, nullptr, &m_ImageAvailableSemaphores[i]) != VK_SUCCESS
-			|| vkCreateSemaphore(m_LogicalDevice, &semaphoreInfo, nullptr, &m_RenderFinishedSemaphores[i]) != VK_SUCCESS
-			|| vkCreateFence(m_LogicalDevice, &fenceInfo, nullptr, &m_InFlightFences[i]) != VK_SUCCESS)
+			|| vkCreateSemaphore(m_LogicalDevice, &semaphoreInfo, nullptr, &m_RenderFinishedSemaphores[i]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create synchronization objects for a frame!");
+		}
+	}
+	for (VkFence& fence : m_InFlightFences)
+	{
+		if (vkCreateFence(m_LogicalDevice, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create synchronization objects for a frame!");
 		}
 	}
+
+	if (m_TimelineSupported)
+	{
+		VkSemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = m_FrameNumber;    // ĐGPUҋ@ς  recreated only after the device went idle
+
+		VkSemaphoreCreateInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		timelineInfo.pNext = &typeInfo;
+		if (vkCreateSemaphore(m_LogicalDevice, &timelineInfo, nullptr, &m_FrameTimeline) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create frame timeline semaphore!");
+		}
+	}
+}
+
+void CVulkanFramework::destroySyncObjects()
+{
+	for (size_t i = 0; i < m_ImageAvailableSemaphores.size(); i++)
+	{
+		vkDestroySemaphore(m_LogicalDevice, m_RenderFinishedSemaphores[i], nullptr);
+		vkDestroySemaphore(m_LogicalDevice, m_ImageAvailableSemaphores[i], nullptr);
+	}
+	for (VkFence fence : m_InFlightFences)
+	{
+		vkDestroyFence(m_LogicalDevice, fence, nullptr);
+	}
+	if (m_FrameTimeline != VK_NULL_HANDLE)
+	{
+		vkDestroySemaphore(m_LogicalDevice, m_FrameTimeline, nullptr);
+		m_FrameTimeline = VK_NULL_HANDLE;
+	}
+	m_ImageAvailableSemaphores.clear();
+	m_RenderFinishedSemaphores.clear();
+	m_InFlightFences.clear();
+}
+
+// sɃt[ύXiGPUҋ@ɓIuWFNgĐj
+void CVulkanFramework::setFramesInFlight(uint32_t framesInFlight)
+{
+	vkDeviceWaitIdle(m_LogicalDevice);
+	destroySyncObjects();
+	m_Config.framesInFlight = framesInFlight;
+	createSyncObjects();
+}
+
+// v[g[h̓Xbv`F[Ɍ܂̂ŁÃt[ōĐ܂iImGui̕`撆ɉ󂳂Ȃ߁j
+// the present mode is fixed at swapchain creation: recreate it after the next present, not mid ImGui frame
+void CVulkanFramework::setPresentPolicy(PresentPolicy policy)
+{
+	if (policy == m_Config.presentPolicy)
+	{
+		return;
+	}
+	m_Config.presentPolicy = policy;
+	m_FramebufferResized = true;
+}
+
+// t[frameGPUI܂ő҂܂
+// Fence fallback: frame N used fence N % depth. If a later frame reused it, waiting on it is only more conservative.
+void CVulkanFramework::waitForFrame(uint64_t frame)
+{
+	if (frame == 0 || frame > m_FrameNumber)
+	{
+		return;
+	}
+	PROFILE_FUNCTION();
+
+	if (m_TimelineSupported)
+	{
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &m_FrameTimeline;
+		waitInfo.pValues = &frame;
+		if (vkWaitSemaphores(m_LogicalDevice, &waitInfo, UINT64_MAX) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to wait for frame timeline semaphore!");
+		}
+	}
+	else
+	{
+		if (vkWaitForFences(m_LogicalDevice, 1, &m_InFlightFences[frame % m_FramesInFlight], VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to wait for frame fence!");
+		}
+	}
 }
 
 // ==================
@@ -1572,7 +3088,7 @@ void CVulkanFramework::initImGui()
 	initInfo.Device = m_LogicalDevice;
 	initInfo.QueueFamily = indices.graphicsFamily.value();
 	initInfo.Queue = m_GraphicsQueue;
-	initInfo.PipelineCache = VK_NULL_HANDLE;
+	initInfo.PipelineCache = m_PipelineCache.get();
 	initInfo.DescriptorPool = m_ImGuiDescriptorPool;
 	initInfo.Allocator = NULL;
 	initInfo.MinImageCount = 2;
@@ -1599,7 +3115,7 @@ void CVulkanFramework::createImGuiRenderPass()
 	attachmentImGui.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	attachmentImGui.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	attachmentImGui.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-	attachmentImGui.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;    // Ō̃_[pXPRESENT_SRC_KHR
+	attachmentImGui.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;    // PRESENT_SRC_KHRւ̓t[Ot̍Ō̃oA  the graph's final barrier
 
 	VkAttachmentReference colorAttachmentReferenceImGui{};
 	colorAttachmentReferenceImGui.attachment = 0;
@@ -1610,23 +3126,14 @@ void CVulkanFramework::createImGuiRenderPass()
 	subpassImGui.colorAttachmentCount = 1;
 	subpassImGui.pColorAttachments = &colorAttachmentReferenceImGui;
 
-	VkSubpassDependency dependencyImGui{};
-	dependencyImGui.srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependencyImGui.dstSubpass = 0;
-	// source stage mask: wait for this output (pixels to already be in the framebuffer) before proceeding to next stage
-	dependencyImGui.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;    
-	dependencyImGui.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependencyImGui.srcAccessMask = 0;
-	dependencyImGui.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
 	VkRenderPassCreateInfo renderPassInfoImGui{};
 	renderPassInfoImGui.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	renderPassInfoImGui.attachmentCount = 1;
 	renderPassInfoImGui.pAttachments = &attachmentImGui;
 	renderPassInfoImGui.subpassCount = 1;
 	renderPassInfoImGui.pSubpasses = &subpassImGui;
-	renderPassInfoImGui.dependencyCount = 1;
-	renderPassInfoImGui.pDependencies = &dependencyImGui;
+	renderPassInfoImGui.dependencyCount = 0;    // V[݂̏҂̂̓t[Ot̃oA  the frame graph orders it after the scene
+	renderPassInfoImGui.pDependencies = nullptr;
 
 	if (vkCreateRenderPass(m_LogicalDevice, &renderPassInfoImGui, nullptr, &m_ImGuiRenderPass) != VK_SUCCESS)
 	{
@@ -1683,79 +3190,290 @@ void CVulkanFramework::createImGuiFramebuffers()
 		// et[AImGuit[obt@[𐶐
 		if (vkCreateFramebuffer(m_LogicalDevice, &framebufferCreateInfoImGui, nullptr, &m_ImGuiFramebuffers[i]) != VK_SUCCESS)
 		{
-			throw std::runtime_error("Failed to create ImGui framebuffer!");
+			throw std::runtime_error("Failed to create ImGui framebuffer!");
+		}
+	}
+}
+
+void CVulkanFramework::allocateImGuiCommandBuffers()
+{
+	m_ImGuiCommandBuffers.resize(m_SwapChainImageViews.size());
+	allocateCommandBuffers(m_ImGuiCommandBuffers.data(), static_cast<uint32_t>(m_ImGuiCommandBuffers.size()), m_ImGuiCommandPool);
+}
+
+void CVulkanFramework::drawImGuiFrame()
+{
+	PROFILE_FUNCTION();
+
+	// ImGui start
+	ImGui_ImplVulkan_NewFrame();
+	ImGui_ImplGlfw_NewFrame();
+	ImGui::NewFrame();
+
+	const std::string font = "Roboto-Regular";
+
+	ImGui::SetNextWindowPos(ImVec2(10, 10));
+	ImGui::Begin("Vulkan Custom Rendering Engine");
+	ImGui::Text("%s", m_PhysicalDeviceName.c_str());
+	ImGui::Text("%.1f FPS (%.2f ms)", ImGui::GetIO().Framerate, 1000.0f / ImGui::GetIO().Framerate);
+	ImGui::Text("Backface Culling Disabled");
+	const char* mipSource = (m_Config.mipFilter != MipFilter::None || m_TextureFormat != TextureFormat::RGBA8) ? toString(m_Config.mipFilter)
+		: (m_ComputeMipGen ? "GPU compute" : "GPU blit");
+	ImGui::Text("Textures: %zu loaded in %.1f ms (%s, %s, %u threads)",
+		m_Textures.size(), m_TextureLoadTimeMs, toString(m_TextureFormat), mipSource, m_JobSystem->getWorkerCount() + 1);
+	if (m_UseBindless)
+	{
+		ImGui::Text("Bindless: %u / %u textures, %zu materials", m_BindlessTextureCount, m_BindlessCapacity, m_Materials.size());
+	}
+	ImGui::Text("Startup: %.0f ms (%.2fx overlap)", m_StartupTimeline.getTotalMs(),
+		m_StartupTimeline.getStepSumMs() / std::max(m_StartupTimeline.getTotalMs(), 1e-3));
+	ImGui::Text("Samplers: %u unique / %u requested", m_SamplerCache.getSamplerCount(), m_SamplerCache.getRequestCount());
+	ImGui::Text("IBL: %s, %.1f ms (%s)", m_IblSource, m_IblTimeMs,
+		m_Config.environmentMapPath.empty() ? "procedural sky" : m_Config.environmentMapPath.c_str());
+	int lightCount = static_cast<int>(m_Config.lightCount);
+	if (ImGui::SliderInt("Point lights", &lightCount, 0, static_cast<int>(MAX_POINT_LIGHTS)))
+	{
+		m_Config.lightCount = static_cast<uint32_t>(lightCount);
+	}
+	ImGui::Text("Light culling: %.3f ms (%s), scene: %.3f ms", m_LightCullMs, m_LightCuller.isCreated() ? "GPU" : "CPU", m_ScenePassMs);
+	bool depthPrepass = m_Config.depthPrepass;
+	if (ImGui::Checkbox("Depth prepass", &depthPrepass))
+	{
+		setDepthPrepass(depthPrepass);
+	}
+	if (m_Config.depthPrepass)
+	{
+		ImGui::SameLine();
+		ImGui::Text("%.3f ms + shading %.3f ms", m_DepthPrepassMs, m_ScenePassMs);
+	}
+	bool sortDraws = m_Config.sortDraws;
+	if (ImGui::Checkbox("Sort draws", &sortDraws))
+	{
+		setDrawSorting(sortDraws);
+	}
+	if (m_DrawStats.empty() == false)
+	{
+		const DrawRecordStats& stats = m_DrawStats[0];
+		ImGui::SameLine();
+		ImGui::Text("%u draws, binds: %u pipeline, %u descriptor, %u vertex (%u skipped), recorded in %.3f ms", stats.draws,
+			stats.pipelineBinds, stats.descriptorBinds, stats.vertexBinds, stats.skipped, m_RecordMs);
+	}
+	drawShadowStats();
+	drawForestStats();
+	ImGui::Text("Layouts: %u set + %u pipeline / %u requested", m_LayoutCache.getSetLayoutCount(), m_LayoutCache.getPipelineLayoutCount(),
+		m_LayoutCache.getRequestCount());
+	ImGui::Text("Frames in flight: %u (%s)%s", m_FramesInFlight, m_TimelineSupported ? "timeline" : "fences",
+		m_Config.lowLatency ? ", low latency" : "");
+
+	int policy = static_cast<int>(m_Config.presentPolicy);
+	const char* policyNames[PRESENT_POLICY_COUNT];
+	for (uint32_t i = 0; i < PRESENT_POLICY_COUNT; i++)
+	{
+		policyNames[i] = toString(static_cast<PresentPolicy>(i));
+	}
+	if (ImGui::Combo("Present", &policy, policyNames, PRESENT_POLICY_COUNT))
+	{
+		setPresentPolicy(static_cast<PresentPolicy>(policy));
+	}
+	if (m_FrameLimiter.getTargetFps() > 0.0)
+	{
+		ImGui::Text("%s, %u images, %.0f FPS limit", toString(m_PresentMode), m_ImageCount, m_FrameLimiter.getTargetFps());
+	}
+	else
+	{
+		ImGui::Text("%s, %u images, uncapped", toString(m_PresentMode), m_ImageCount);
+	}
+	drawShaderVariants();
+	drawMemoryReport();
+	ImGui::Text("MSAA %ux: %.1f MB attachments%s", static_cast<uint32_t>(m_MSAASamples),
+		(m_ColorImageInfo.size + m_DepthImageInfo.size) / (1024.0 * 1024.0), m_ColorImageInfo.lazy ? " (lazily allocated)" : "");
+
+	ImGui::End();
+	ImGui::Render();
+}
+
+// ImGuiFVF[_[@\̐؂ւioAg͏gpɃRpCj  feature toggles, variants compile on first use
+void CVulkanFramework::drawShaderVariants()
+{
+	uint32_t features = m_Config.shaderFeatures;
+	if (ImGui::TreeNode("Variants", "Shader variant: %s", describeShaderVariant(features).c_str()) == false)
+	{
+		return;
+	}
+
+	const std::map<uint32_t, ReflectedSpecConstant>& specConstants = m_ShaderReflection.getSpecConstants();
+	for (uint32_t bit = 0; bit < SHADER_FEATURE_COUNT; bit++)
+	{
+		ShaderFeature feature = static_cast<ShaderFeature>(1u << bit);
+		bool enabled = (features & feature) != 0;
+		char label[64];
+		snprintf(label, sizeof(label), specConstants.count(bit) ? "%s" : "%s (not in shader)", toString(feature));
+		if (ImGui::Checkbox(label, &enabled))
+		{
+			features = enabled ? (features | feature) : (features & ~feature);
+		}
+	}
+	setShaderFeatures(features);
+
+	ImGui::Text("%u variants cached, %u compiles, last %.1f ms", m_PipelineVariants.getVariantCount(), m_PipelineVariants.getCompileCount(),
+		m_PipelineVariants.getLastCompileMs());
+	ImGui::Text("Pipeline cache: %.1f KB loaded from disk", m_PipelineCache.getLoadedBytes() / 1024.0);
+	ImGui::TreePop();
+}
+
+// ImGuiFfoCX[iJeS[ʁEq[v\Zj  device memory by category and heap budget
+void CVulkanFramework::drawMemoryReport()
+{
+	const double MB = 1.0 / (1024.0 * 1024.0);
+	MemoryStats total = m_MemoryTracker.getTotalStats();
+	if (ImGui::TreeNode("Memory", "VRAM: %.1f MB tracked (peak %.1f MB)", total.current * MB, total.peak * MB) == false)
+	{
+		return;
+	}
+
+	for (uint32_t i = 0; i < static_cast<uint32_t>(MemoryCategory::Count); i++)
+	{
+		MemoryCategory category = static_cast<MemoryCategory>(i);
+		MemoryStats stats = m_MemoryTracker.getCategoryStats(category);
+		if (stats.peak > 0)
+		{
+			ImGui::Text("%-10s %8.1f MB  peak %8.1f MB  %u allocs", toString(category), stats.current * MB, stats.peak * MB, stats.allocations);
+		}
+	}
+
+	std::vector<MemoryHeapReport> heaps = m_MemoryTracker.queryHeaps();
+	for (size_t i = 0; i < heaps.size(); i++)
+	{
+		const MemoryHeapReport& heap = heaps[i];
+		VkDeviceSize untracked = (heap.usage > heap.tracked.current) ? heap.usage - heap.tracked.current : 0;
+		ImGui::Text("Heap %zu%s: %.0f / %.0f MB%s, %.1f MB untracked (ImGui, driver)", i, heap.deviceLocal ? " (device)" : "",
+			heap.usage * MB, heap.budget * MB, m_MemoryTracker.isBudgetSupported() ? " budget" : "", untracked * MB);
+	}
+	ImGui::TreePop();
+}
+
+// ImGuiFžEVhEpXGPUԁEJXP[hƂ̕`搔iLbV͑O̕`搔j
+// sun controls, shadow pass GPU time and per-cascade draw counts (the last render's count while cached)
+void CVulkanFramework::drawShadowStats()
+{
+	if (ImGui::TreeNode("Shadows", "Shadows: %.3f ms GPU, %u / %u cascades rendered", m_ShadowPassMs, m_ShadowCascades.getRenderedCount(),
+		SHADOW_CASCADE_COUNT) == false)
+	{
+		return;
+	}
+
+	if (m_ShadowPass.isCreated() == false)
+	{
+		ImGui::Text("Shadow pass unavailable (shadow.spv or depth format missing)");
+	}
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		const ShadowCascade& cascade = m_ShadowCascades.getCascade(i);
+		if (cascade.render)
+		{
+			ImGui::Text("C%u %5.2f-%5.2f: rendered, %zu draws", i, cascade.splitNear, cascade.splitFar, cascade.casters.size());
+		}
+		else
+		{
+			ImGui::Text("C%u %5.2f-%5.2f: cached %u frames (%u draws)", i, cascade.splitNear, cascade.splitFar, cascade.framesCached,
+				cascade.lastDrawCount);
 		}
 	}
+	ImGui::SliderFloat("Sun azimuth", &m_SunAzimuth, 0.0f, 360.0f, "%.1f deg");
+	ImGui::SliderFloat("Sun elevation", &m_SunElevation, 5.0f, 90.0f, "%.1f deg");
+	ImGui::SliderFloat("Sun speed", &m_SunSpeed, 0.0f, 20.0f, "%.1f deg/s");
+	ImGui::Checkbox("Spin model", &m_Config.spinModel);
+	ImGui::TreePop();
 }
 
-void CVulkanFramework::allocateImGuiCommandBuffers()
+void CVulkanFramework::drawForestStats()
 {
-	m_ImGuiCommandBuffers.resize(m_SwapChainImageViews.size());
-	allocateCommandBuffers(m_ImGuiCommandBuffers.data(), static_cast<uint32_t>(m_ImGuiCommandBuffers.size()), m_ImGuiCommandPool);
+	if (m_ForestTrees.empty())
+	{
+		return;
+	}
+	uint32_t farTreeCount = static_cast<uint32_t>(m_ForestTrees.size()) - m_NearTreeCount;
+	if (ImGui::TreeNode("Forest", "Forest: %zu trees, %u meshes, %u impostors", m_ForestTrees.size(), m_NearTreeCount,
+		(m_Config.impostors && m_ImpostorPass.isCreated()) ? farTreeCount : 0) == false)
+	{
+		return;
+	}
+
+	if (m_ImpostorPass.isCreated() == false)
+	{
+		ImGui::Text("Impostors unavailable (impostor shaders missing)");
+	}
+	else
+	{
+		const ImpostorSettings& settings = m_ImpostorAtlas.getSettings();
+		ImGui::Text("Atlas: %u x %u frames of %u texels, baked in %.1f ms", settings.frames, settings.frames, settings.frameSize, m_ImpostorBakeMs);
+		bool impostors = m_Config.impostors;
+		if (ImGui::Checkbox("Impostors", &impostors))
+		{
+			setImpostors(impostors);
+		}
+		float distance = m_Config.impostorDistance;
+		if (ImGui::SliderFloat("Impostor distance", &distance, 1.0f, m_FarPlane, "%.0f"))
+		{
+			setImpostorDistance(distance);
+		}
+	}
+	ImGui::Text("Scene: %.3f ms GPU, far plane %.0f", m_DepthPrepassMs + m_ScenePassMs, m_FarPlane);
+	ImGui::TreePop();
 }
 
-void CVulkanFramework::drawImGuiFrame()
+// ImGuit[_[FimageIndex̃R}hobt@[̂݁iO̎gpt[̊ɌĂԂƁj
+// records the ImGui pass into imageIndex's command buffer only; the frame that last used that image must have completed
+void CVulkanFramework::recordImGuiCommandBuffer(uint32_t imageIndex)
 {
-	// ImGui start
-	ImGui_ImplVulkan_NewFrame();
-	ImGui_ImplGlfw_NewFrame();
-	ImGui::NewFrame();
-
-	const std::string font = "Roboto-Regular";
-
-	ImGui::SetNextWindowPos(ImVec2(10, 10));
-	ImGui::Begin("Vulkan Custom Rendering Engine");
-	ImGui::Text("%s", m_PhysicalDeviceName.c_str());
-	ImGui::Text("%.1f FPS (%.2f ms)", ImGui::GetIO().Framerate, 1000.0f / ImGui::GetIO().Framerate);
-	ImGui::Text("Backface Culling Disabled");
+	PROFILE_FUNCTION();
 
-	ImGui::End();
-	ImGui::Render();
+	VkCommandBuffer commandBuffer = m_ImGuiCommandBuffers[imageIndex];
 
-	createImGuiCommandBuffers();
-}
+	VkCommandBufferBeginInfo commandBufferBeginInfoImGui{};
+	commandBufferBeginInfoImGui.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	commandBufferBeginInfoImGui.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-// ImGuit[_[irj
-void CVulkanFramework::createImGuiCommandBuffers()
-{
-	for (size_t i = 0; i < m_ImGuiCommandBuffers.size(); i++)
+	if (vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfoImGui) != VK_SUCCESS)
 	{
-		VkCommandBufferBeginInfo commandBufferBeginInfoImGui{};
-		commandBufferBeginInfoImGui.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		throw std::runtime_error("Failed to begin recording ImGui command buffer!");
+	}
 
-		if (vkBeginCommandBuffer(m_ImGuiCommandBuffers[i], &commandBufferBeginInfoImGui) != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to begin recording ImGui command buffer!");
-		}
+	// V[݂̏҂oAit[Otj
+	// barrier after the scene's writes, from the frame graph
+	const CRenderGraph& frameGraph = m_FrameGraphs[imageIndex];
+	frameGraph.recordBarriers(commandBuffer, m_FramePasses.imguiPass);
 
-		// _[pXJn
-		// Starting a render pass
-		VkRenderPassBeginInfo renderPassInfo{};		// _[pX\
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = m_ImGuiRenderPass;
-		renderPassInfo.framebuffer = m_ImGuiFramebuffers[i]; 
-		renderPassInfo.renderArea.extent = m_SwapChainExtent;
+	// _[pXJn
+	// Starting a render pass
+	VkRenderPassBeginInfo renderPassInfo{};		// _[pX\
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = m_ImGuiRenderPass;
+	renderPassInfo.framebuffer = m_ImGuiFramebuffers[imageIndex];
+	renderPassInfo.renderArea.extent = m_SwapChainExtent;
 
-		// NAJ[
-		VkClearValue clearValue{};
-		clearValue.color = { 0.0f, 0.0f, 0.0f, 1.0f };    // 
-		renderPassInfo.clearValueCount = 1;
-		renderPassInfo.pClearValues = &clearValue;
+	// NAJ[
+	VkClearValue clearValue{};
+	clearValue.color = { 0.0f, 0.0f, 0.0f, 1.0f };    // 
+	renderPassInfo.clearValueCount = 1;
+	renderPassInfo.pClearValues = &clearValue;
 
-		// ۂ̃_[pXJn܂
-		vkCmdBeginRenderPass(m_ImGuiCommandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	// ۂ̃_[pXJn܂
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-		// ImGui_[
-		ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), m_ImGuiCommandBuffers[i]);
+	// ImGui_[
+	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
 
-		// _[pXI܂
-		vkCmdEndRenderPass(m_ImGuiCommandBuffers[i]);
+	// _[pXI܂
+	vkCmdEndRenderPass(commandBuffer);
 
-		VkResult result = vkEndCommandBuffer(m_ImGuiCommandBuffers[i]);
-		if (result != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to record command buffer!");
-		}
+	// t[̍ŌFPRESENT_SRC_KHRւ̑J  end of the frame: transition to PRESENT_SRC_KHR
+	frameGraph.recordFinalBarriers(commandBuffer);
+
+	VkResult result = vkEndCommandBuffer(commandBuffer);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to record command buffer!");
 	}
 }
 
@@ -1765,10 +3483,16 @@ void CVulkanFramework::createImGuiCommandBuffers()
 //====================================================================================
 
 // ėpC[Wr[֐
-VkImageView CVulkanFramework::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels)
+// viewUsage: C[Wusager[ŐꍇiFXg[WΉsRGBeNX`[TvOpɁj
+VkImageView CVulkanFramework::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, VkImageUsageFlags viewUsage)
 {
+	VkImageViewUsageCreateInfo usageInfo{};
+	usageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO;
+	usageInfo.usage = viewUsage;
+
 	VkImageViewCreateInfo viewInfo{};
 	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.pNext = (viewUsage != 0) ? &usageInfo : nullptr;
 	viewInfo.image = image;
 	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
 	viewInfo.format = format;
@@ -1789,16 +3513,17 @@ VkImageView CVulkanFramework::createImageView(VkImage image, VkFormat format, Vk
 }
 
 // ėpC[W֐
-void CVulkanFramework::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+void CVulkanFramework::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, VkImageCreateFlags flags, uint32_t arrayLayers)
 {
 	VkImageCreateInfo imageInfo{};
 	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.flags = flags;
 	imageInfo.imageType = VK_IMAGE_TYPE_2D;
 	imageInfo.extent.width = width;
 	imageInfo.extent.height = height;
 	imageInfo.extent.depth = 1;
 	imageInfo.mipLevels = mipLevels;
-	imageInfo.arrayLayers = 1;
+	imageInfo.arrayLayers = arrayLayers;    // 1ȊOFVhEJXP[hȂ  e.g. one layer per shadow cascade
 	imageInfo.format = format;
 	imageInfo.tiling = tiling;
 	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -1817,9 +3542,15 @@ void CVulkanFramework::createImage(uint32_t width, uint32_t height, uint32_t mip
 	VkMemoryAllocateInfo allocInfo{};
 	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 	allocInfo.allocationSize = memRequirements.size;
+	// x蓖ă[ȂifXNgbvGPUȂǁjꍇ͒ʏ̃[Ŋm
+	// no lazily allocated memory type (most desktop GPUs): fall back to regular memory
+	if ((properties & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) && isMemoryTypeAvailable(memRequirements.memoryTypeBits, properties) == false)
+	{
+		properties &= ~VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+	}
 	allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
-	if (vkAllocateMemory(m_LogicalDevice, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
+	if (m_MemoryTracker.allocate(m_LogicalDevice, allocInfo, CMemoryTracker::categorizeImage(usage), imageMemory) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to allocate image memory!");
 	}
@@ -1941,7 +3672,7 @@ void CVulkanFramework::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
 	allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
 	// L̍\̂ɊÂĎۂ̃[mۏs܂B
-	if (vkAllocateMemory(m_LogicalDevice, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+	if (m_MemoryTracker.allocate(m_LogicalDevice, allocInfo, CMemoryTracker::categorizeBuffer(usage, properties), bufferMemory) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to allocate vertex buffer memory!");
 	}
@@ -1950,6 +3681,13 @@ void CVulkanFramework::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
 	vkBindBufferMemory(m_LogicalDevice, buffer, bufferMemory, 0);
 }
 
+// foCX[Ji[gbJ[̏WvXVj
+// frees device memory and removes it from the memory tracker
+void CVulkanFramework::freeMemory(VkDeviceMemory memory)
+{
+	m_MemoryTracker.free(m_LogicalDevice, memory);
+}
+
 void CVulkanFramework::allocateCommandBuffers(VkCommandBuffer* commandBuffer,
 	uint32_t commandBufferCount, VkCommandPool &commandPool)
 {
@@ -2010,116 +3748,692 @@ void CVulkanFramework::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_
 		&region
 	);
 
-	endSingleTimeCommands(commandBuffer);
+	endSingleTimeCommands(commandBuffer);
+}
+
+// C[WCAEg̃CAEgɑJڂ܂
+void CVulkanFramework::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels)
+{
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+
+	// L[ςꍇAȉ̐ݒ肪Kvł
+	// ftHgł͂܂I@Kݒ肷邱
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mipLevels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	// Xe[WEANZX̓CAEg̓T^IȎg猈߂܂i_[OtƓ\j
+	// stages and access come from the typical use of each layout (same table as the render graph)
+	RGAccess source = RGAccess::fromLayout(oldLayout);
+	RGAccess destination = RGAccess::fromLayout(newLayout);
+	barrier.srcAccessMask = source.isWrite() ? source.access : 0;
+	barrier.dstAccessMask = destination.access;
+	VkPipelineStageFlags sourceStage = source.stages;
+	VkPipelineStageFlags destinationStage = destination.stages;
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		sourceStage, destinationStage,
+		0,              // VK_DEPENDENCY_BY_REGION_BIT
+		0, nullptr,     // [oA
+		0, nullptr,     // obt@[[oA
+		1, &barrier     // C[WoAiݎgpj
+	);
+
+	endSingleTimeCommands(commandBuffer);
+}
+
+// 񂾂gp\̃R}hJn܂
+VkCommandBuffer CVulkanFramework::beginSingleTimeCommands()
+{
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool = m_CommandPool;
+	allocInfo.commandBufferCount = 1;
+
+	VkCommandBuffer commandBuffer;
+	vkAllocateCommandBuffers(m_LogicalDevice, &allocInfo, &commandBuffer);
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+	return commandBuffer;
+}
+
+// 񂾂gp\̃R}hI܂
+void CVulkanFramework::endSingleTimeCommands(VkCommandBuffer commandBuffer)
+{
+	vkEndCommandBuffer(commandBuffer);
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+	vkQueueWaitIdle(m_GraphicsQueue);
+
+	vkFreeCommandBuffers(m_LogicalDevice, m_CommandPool, 1, &commandBuffer);
+}
+
+// ̃eNX`[1̃Xe[WOobt@[1̃R}hobt@[ŃAbv[h܂
+// Uploads a batch of decoded textures through one staging buffer and one command buffer.
+// Textures with CPU-generated mips are copied level by level; the rest get a blit chain.
+void CVulkanFramework::uploadTextures(const std::vector<TextureData>& textureData)
+{
+	// bufferOffset̓eNZubNTCYiBCn8/16oCgj̔{łKv܂
+	// copy offsets must be a multiple of the texel block size, so every texture starts 16-byte aligned
+	const VkDeviceSize stagingAlignment = 16;
+
+	VkDeviceSize stagingSize = 0;
+	bool needsBlit = false;
+	for (const TextureData& tex : textureData)
+	{
+		stagingSize += (tex.pixels.size() + stagingAlignment - 1) & ~(stagingAlignment - 1);
+		needsBlit |= (tex.hasCpuMips() == false && m_ComputeMipGen == false);
+	}
+
+	if (needsBlit)
+	{
+		// nꂽtH[}bgLinear BlittingT|[g邩mF
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(m_PhysicalDevice, VK_FORMAT_R8G8B8A8_SRGB, &formatProperties);
+
+		if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+		{
+			throw std::runtime_error("Texture image format does not support linear blitting!");
+		}
+	}
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+
+	createBuffer(
+		stagingSize,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		stagingBuffer,
+		stagingBufferMemory
+	);
+
+	void* data;
+	vkMapMemory(m_LogicalDevice, stagingBufferMemory, 0, stagingSize, 0, &data);
+	VkDeviceSize stagingOffset = 0;
+	for (const TextureData& tex : textureData)
+	{
+		memcpy(static_cast<uint8_t*>(data) + stagingOffset, tex.pixels.data(), tex.pixels.size());
+		stagingOffset += (tex.pixels.size() + stagingAlignment - 1) & ~(stagingAlignment - 1);
+	}
+	vkUnmapMemory(m_LogicalDevice, stagingBufferMemory);
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+	stagingOffset = 0;
+	for (const TextureData& tex : textureData)
+	{
+		Texture texture{};
+		texture.format = toVkFormat(tex.format);
+		texture.width = tex.width;
+		texture.height = tex.height;
+		texture.mipLevels = tex.mipLevels;
+
+		// Rs[gVF[_[Ń~bv}bv𐶐ꍇ̓Xg[WpUNORMr[Kv
+		bool computeMips = (tex.hasCpuMips() == false && m_ComputeMipGen);
+
+		// eNX`[C[W
+		createImage(
+			texture.width,
+			texture.height,
+			texture.mipLevels,
+			VK_SAMPLE_COUNT_1_BIT,
+			texture.format,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (computeMips ? VK_IMAGE_USAGE_STORAGE_BIT : 0),
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			texture.image,
+			texture.memory,
+			computeMips ? CMipGenerator::getImageCreateFlags() : 0
+		);
+
+		// S~bvx UNDEFINED -> TRANSFER_DST
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = texture.image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = texture.mipLevels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		// ~bvxƂ̃Rs[̈iGPUŃ~bv}bv𐶐ꍇ̓x0̂݁j
+		// one copy region per level in the staging data (level 0 only when the GPU builds the mips)
+		std::vector<VkBufferImageCopy> regions;
+		for (uint32_t level = 0; level < tex.mips.size(); level++)
+		{
+			VkBufferImageCopy region{};
+			region.bufferOffset = stagingOffset + tex.mips[level].offset;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = level;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = { 0, 0, 0 };
+			region.imageExtent = { tex.mips[level].width, tex.mips[level].height, 1 };
+			regions.push_back(region);
+		}
+
+		vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()), regions.data());
+
+		if (tex.hasCpuMips())
+		{
+			// S~bvxĂ̂ł̂܂܃VF[_[ǂݍݗpɑJ
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+		else if (computeMips)
+		{
+			m_MipGenerator.record(commandBuffer, texture.image, texture.format, texture.width, texture.height, texture.mipLevels);
+		}
+		else
+		{
+			recordMipmapBlits(commandBuffer, texture.image, static_cast<int32_t>(texture.width), static_cast<int32_t>(texture.height), texture.mipLevels);
+		}
+
+		stagingOffset += (tex.pixels.size() + stagingAlignment - 1) & ~(stagingAlignment - 1);
+		m_Textures.push_back(texture);
+	}
+
+	endSingleTimeCommands(commandBuffer);
+
+	// Еt
+	m_MipGenerator.releaseTransient();
+	vkDestroyBuffer(m_LogicalDevice, stagingBuffer, nullptr);
+	freeMemory(stagingBufferMemory);
+}
+
+// t[y[VÕx`}[NFt[1`4Aʏ^x[h̒xƃX[vbg
+// Frame pacing benchmark: latency vs throughput for 1..MAX_FRAMES_IN_FLIGHT frames in flight, with and without
+// low latency mode. Latency is measured from input sampling (glfwPollEvents) until the frame's timeline value
+// is signalled, by a thread blocked on the semaphore; presentation adds the swapchain queue on top of that.
+void CVulkanFramework::benchmarkFramePacing()
+{
+	if (m_TimelineSupported == false)
+	{
+		std::cout << "Frame pacing benchmark needs timeline semaphores (Vulkan 1.2)" << std::endl;
+		return;
+	}
+
+	const uint32_t warmupFrames = 30;
+	const uint32_t frameCount = 300;
+	const AppConfig originalConfig = m_Config;
+
+	printf("Frame pacing: %u frames per run, latency = input sample -> GPU frame complete\n", frameCount);
+	printf("  depth  mode          avg latency   max latency    throughput\n");
+
+	for (uint32_t depth = 1; depth <= MAX_FRAMES_IN_FLIGHT; depth++)
+	{
+		for (bool lowLatency : { false, true })
+		{
+			setFramesInFlight(depth);
+			m_Config.lowLatency = lowLatency;
+
+			const uint64_t firstFrame = m_FrameNumber + 1 + warmupFrames;
+			const uint64_t lastFrame = firstFrame + frameCount - 1;
+			std::vector<double> inputTimes(frameCount, 0.0);
+			std::vector<double> doneTimes(frameCount, 0.0);
+			std::atomic<bool> stop{ false };
+
+			// ĎXbhFet[̃^CClԂɑ҂AL^
+			std::thread watcher([&]()
+			{
+				for (uint64_t frame = firstFrame; frame <= lastFrame; frame++)
+				{
+					VkSemaphoreWaitInfo waitInfo{};
+					waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+					waitInfo.semaphoreCount = 1;
+					waitInfo.pSemaphores = &m_FrameTimeline;
+					waitInfo.pValues = &frame;
+					while (vkWaitSemaphores(m_LogicalDevice, &waitInfo, 100000000) == VK_TIMEOUT)    // 100 ms
+					{
+						if (stop)
+						{
+							return;
+						}
+					}
+					doneTimes[frame - firstFrame] = glfwGetTime();
+				}
+			});
+
+			while (m_FrameNumber < lastFrame && glfwWindowShouldClose(m_Window) == false)
+			{
+				runFrame();
+				if (m_FrameNumber >= firstFrame && m_FrameNumber <= lastFrame)
+				{
+					inputTimes[m_FrameNumber - firstFrame] = m_InputSampleTime;
+				}
+			}
+			vkDeviceWaitIdle(m_LogicalDevice);
+			stop = true;
+			watcher.join();
+
+			if (m_FrameNumber < lastFrame)
+			{
+				printf("  interrupted\n");
+				m_Config = originalConfig;
+				return;
+			}
+
+			double totalLatency = 0.0;
+			double maxLatency = 0.0;
+			uint32_t samples = 0;
+			for (uint32_t i = 0; i < frameCount; i++)
+			{
+				if (inputTimes[i] > 0.0)    // Xbv`F[ĐŃXLbvꂽt[
+				{
+					double latency = (doneTimes[i] - inputTimes[i]) * 1000.0;
+					totalLatency += latency;
+					maxLatency = std::max(maxLatency, latency);
+					samples++;
+				}
+			}
+			double fps = (frameCount - 1) / std::max(doneTimes.back() - doneTimes.front(), 1e-9);
+
+			printf("  %5u  %-12s  %8.2f ms   %8.2f ms   %7.1f FPS\n", depth, lowLatency ? "low latency" : "default",
+				samples ? totalLatency / samples : 0.0, maxLatency, fps);
+		}
+	}
+
+	m_Config = originalConfig;
+	setFramesInFlight(m_Config.framesInFlight);
+}
+
+// NX^[CeBÕx`}[NFCg1`4096ŐU蕪EV[GPUԁi^CX^vj
+// Clustered lighting benchmark: cull and scene GPU time for 1..4096 lights. The lights per occupied cluster
+// (what a fragment loops over) are printed next to the light count an unclustered forward pass would loop over.
+void CVulkanFramework::benchmarkLights()
+{
+	if (m_FrameTimers.empty())
+	{
+		std::cout << "Timestamps not supported on the graphics queue, cannot run light benchmark" << std::endl;
+		return;
+	}
+
+	const uint32_t warmupFrames = 30;
+	const uint32_t frameCount = 200;
+	const uint32_t lightCounts[] = { 1, 4, 16, 64, 256, 1024, 4096 };
+	const AppConfig originalConfig = m_Config;
+
+	setShaderFeatures(m_Config.shaderFeatures | SHADER_FEATURE_CLUSTERED_LIGHTS);
+	setPresentPolicy(PresentPolicy::Uncapped);    // ҂vȂ  do not measure vsync waits
+
+	printf("Clustered lighting: %u frames per count, %s culling, %u clusters (%ux%ux%u), max %u lights per cluster\n",
+		frameCount, m_LightCuller.isCreated() ? "GPU" : "CPU", CLUSTER_COUNT, CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z, MAX_LIGHTS_PER_CLUSTER);
+	printf("  lights   cull (ms)   scene (ms)   per cluster avg / max   overflow   unclustered\n");
+
+	for (uint32_t lightCount : lightCounts)
+	{
+		m_Config.lightCount = lightCount;
+
+		double cullMs = 0.0;
+		double sceneMs = 0.0;
+		for (uint32_t frame = 0; frame < warmupFrames + frameCount && glfwWindowShouldClose(m_Window) == false; frame++)
+		{
+			runFrame();
+			if (frame >= warmupFrames)
+			{
+				cullMs += m_LightCullMs / frameCount;
+				sceneMs += m_ScenePassMs / frameCount;
+			}
+		}
+		if (glfwWindowShouldClose(m_Window))
+		{
+			printf("  interrupted\n");
+			break;
+		}
+
+		// Ō̃t[̃CgCPUŐU蕪āANX^[̐L߂܂  occupancy of the last frame's clusters
+		ClusterData clusters;
+		CClusteredLights::cull(m_LightHeader, m_Lights.data(), clusters, *m_JobSystem);
+		ClusterStats stats = CClusteredLights::getStats(clusters);
+
+		printf("  %6u   %9.3f   %10.3f   %13.1f / %-5u   %8u   %11u\n", lightCount, cullMs, sceneMs,
+			stats.averageLights, stats.maxLights, stats.overflowClusters, lightCount);
+	}
+	vkDeviceWaitIdle(m_LogicalDevice);
+
+	setShaderFeatures(originalConfig.shaderFeatures);
+	setPresentPolicy(originalConfig.presentPolicy);
+	m_Config = originalConfig;
+}
+
+// fvXvpX̃x`}[NFCgƂɃvpXȂEGPU
+// Depth prepass benchmark: scene GPU time without and with the prepass for several light counts. The prepass
+// costs a second geometry pass, so it only pays off once shading a fragment is expensive enough (many lights).
+void CVulkanFramework::benchmarkDepthPrepass()
+{
+	if (m_FrameTimers.empty())
+	{
+		std::cout << "Timestamps not supported on the graphics queue, cannot run depth prepass benchmark" << std::endl;
+		return;
+	}
+
+	const uint32_t warmupFrames = 30;
+	const uint32_t frameCount = 200;
+	const uint32_t lightCounts[] = { 0, 64, 256, 1024, 4096 };
+	const AppConfig originalConfig = m_Config;
+
+	setPresentPolicy(PresentPolicy::Uncapped);    // ҂vȂ  do not measure vsync waits
+
+	printf("Depth prepass: %u frames per run, shader variant %s, %zu indices\n", frameCount,
+		describeShaderVariant(m_Config.shaderFeatures).c_str(), m_Indices.size());
+	printf("  lights   off: scene (ms)   on: prepass + shading = total (ms)   saved\n");
+
+	for (uint32_t lightCount : lightCounts)
+	{
+		m_Config.lightCount = lightCount;
+
+		double totalMs[2] = {};
+		double prepassMs = 0.0;
+		double shadingMs = 0.0;
+		for (uint32_t run = 0; run < 2 && glfwWindowShouldClose(m_Window) == false; run++)
+		{
+			setDepthPrepass(run == 1);
+			for (uint32_t frame = 0; frame < warmupFrames + frameCount && glfwWindowShouldClose(m_Window) == false; frame++)
+			{
+				runFrame();
+				if (frame >= warmupFrames)
+				{
+					totalMs[run] += (m_DepthPrepassMs + m_ScenePassMs) / frameCount;
+					if (run == 1)
+					{
+						prepassMs += m_DepthPrepassMs / frameCount;
+						shadingMs += m_ScenePassMs / frameCount;
+					}
+				}
+			}
+		}
+		if (glfwWindowShouldClose(m_Window))
+		{
+			printf("  interrupted\n");
+			break;
+		}
+
+		printf("  %6u   %15.3f   %10.3f + %7.3f = %7.3f        %+6.1f%%\n", lightCount, totalMs[0], prepassMs, shadingMs, totalMs[1],
+			100.0 * (totalMs[0] - totalMs[1]) / std::max(totalMs[0], 1e-6));
+	}
+	vkDeviceWaitIdle(m_LogicalDevice);
+
+	setDepthPrepass(originalConfig.depthPrepass);
+	setPresentPolicy(originalConfig.presentPolicy);
+	m_Config = originalConfig;
 }
 
-// C[WCAEg̃CAEgɑJڂ܂
-void CVulkanFramework::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels)
+// h[\[g̃x`}[NF\[gȂiSXe[g𖈉oChjƃ\[gς݁idoChȗj̔r
+// Draw sorting benchmark: the unsorted baseline (full state bound per draw) against sorted packets with redundant
+// binds skipped, without and with the depth prepass. Bind counts and CPU recording time (all images, including
+// building and sorting the draw list) next to the GPU time of the scene.
+void CVulkanFramework::benchmarkDrawSorting()
 {
-	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	const uint32_t recordCount = 50;
+	const uint32_t warmupFrames = 30;
+	const uint32_t frameCount = 200;
+	const AppConfig originalConfig = m_Config;
 
-	VkImageMemoryBarrier barrier{};
-	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	barrier.oldLayout = oldLayout;
-	barrier.newLayout = newLayout;
+	setPresentPolicy(PresentPolicy::Uncapped);    // ҂vȂ  do not measure vsync waits
 
-	// L[ςꍇAȉ̐ݒ肪Kvł
-	// ftHgł͂܂I@Kݒ肷邱
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	printf("Draw sorting: %zu chunks, %zu images, record averaged over %u runs, GPU over %u frames\n", m_ShadowCasters.size(),
+		m_CommandBuffers.size(), recordCount, frameCount);
+	printf("  prepass   order      draws   pipeline   descriptor   vertex   push   skipped   record (ms)   GPU (ms)\n");
 
-	barrier.image = image;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = mipLevels;
-	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = 1;
+	for (uint32_t run = 0; run < 4 && glfwWindowShouldClose(m_Window) == false; run++)
+	{
+		setDepthPrepass(run >= 2);
+		setDrawSorting(run % 2 == 1);
 
-	VkPipelineStageFlags sourceStage;
-	VkPipelineStageFlags destinationStage;
+		// L^ԁFGPUR}hobt@[gĂȂԂŋL^܂  re-record while the GPU is idle
+		vkDeviceWaitIdle(m_LogicalDevice);
+		double recordMs = 0.0;
+		for (uint32_t i = 0; i < recordCount; i++)
+		{
+			rerecordCommandBuffers();
+			recordMs += m_RecordMs / recordCount;
+		}
+		DrawRecordStats stats = m_DrawStats.empty() ? DrawRecordStats() : m_DrawStats[0];
 
-	if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-	{
-		barrier.srcAccessMask = 0;
-		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-		destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		double gpuMs = 0.0;
+		for (uint32_t frame = 0; frame < warmupFrames + frameCount && glfwWindowShouldClose(m_Window) == false; frame++)
+		{
+			runFrame();
+			if (frame >= warmupFrames)
+			{
+				gpuMs += (m_DepthPrepassMs + m_ScenePassMs) / frameCount;
+			}
+		}
+
+		printf("  %-7s   %-8s   %5u   %8u   %10u   %6u   %4u   %7u   %11.3f   %8.3f\n", m_Config.depthPrepass ? "on" : "off",
+			m_Config.sortDraws ? "sorted" : "unsorted", stats.draws, stats.pipelineBinds, stats.descriptorBinds, stats.vertexBinds,
+			stats.pushConstants, stats.skipped, recordMs, gpuMs);
 	}
-	else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+	vkDeviceWaitIdle(m_LogicalDevice);
+
+	setDepthPrepass(originalConfig.depthPrepass);
+	setDrawSorting(originalConfig.sortDraws);
+	setPresentPolicy(originalConfig.presentPolicy);
+	m_Config = originalConfig;
+}
+
+// C|X^[̃x`}[NFX̑S̖؂bVŕ`悵ꍇƁA𒴂؂C|X^[ɂꍇ̃t[
+// Impostor benchmark: frame time of the forest with every tree a mesh, then with the trees beyond several distances
+// drawn as impostors. Frame time is wall clock per runFrame() with presentation uncapped, next to the GPU time of
+// the scene (prepass, meshes and impostors).
+void CVulkanFramework::benchmarkImpostors()
+{
+	if (m_ForestTrees.empty())
 	{
-		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		std::cout << "No forest (--forest 0), cannot run impostor benchmark" << std::endl;
+		return;
 	}
-	else
+	if (m_ImpostorPass.isCreated() == false)
 	{
-		throw std::invalid_argument("Unsupported layout transition!");
+		std::cout << "Impostor shaders not found, cannot run impostor benchmark" << std::endl;
+		return;
 	}
 
-	vkCmdPipelineBarrier(
-		commandBuffer,
-		sourceStage, destinationStage,
-		0,              // VK_DEPENDENCY_BY_REGION_BIT
-		0, nullptr,     // [oA
-		0, nullptr,     // obt@[[oA
-		1, &barrier     // C[WoAiݎgpj
-	);
+	const uint32_t warmupFrames = 30;
+	const uint32_t frameCount = 200;
+	const float distances[] = { 0.0f, 15.0f, 30.0f, 60.0f, 120.0f };    // 0 = C|X^[Ȃ  impostors off
+	const AppConfig originalConfig = m_Config;
 
-	endSingleTimeCommands(commandBuffer);
-}
+	setPresentPolicy(PresentPolicy::Uncapped);    // ҂vȂ  do not measure vsync waits
 
-// 񂾂gp\̃R}hJn܂
-VkCommandBuffer CVulkanFramework::beginSingleTimeCommands()
-{
-	VkCommandBufferAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandPool = m_CommandPool;
-	allocInfo.commandBufferCount = 1;
+	const ImpostorSettings& settings = m_ImpostorAtlas.getSettings();
+	printf("Impostors: %zu trees, %zu indices per mesh, %u x %u frames of %u texels, %u frames per run\n", m_ForestTrees.size(),
+		m_Indices.size(), settings.frames, settings.frames, settings.frameSize, frameCount);
+	printf("  impostors   distance   meshes   quads    GPU scene (ms)   frame (ms)   speedup\n");
 
-	VkCommandBuffer commandBuffer;
-	vkAllocateCommandBuffers(m_LogicalDevice, &allocInfo, &commandBuffer);
+	double baselineMs = 0.0;
+	for (float distance : distances)
+	{
+		setImpostors(distance > 0.0f);
+		if (distance > 0.0f)
+		{
+			setImpostorDistance(distance);
+		}
 
-	VkCommandBufferBeginInfo beginInfo{};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		double gpuMs = 0.0;
+		double frameMs = 0.0;
+		for (uint32_t frame = 0; frame < warmupFrames + frameCount && glfwWindowShouldClose(m_Window) == false; frame++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			runFrame();
+			if (frame >= warmupFrames)
+			{
+				frameMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / frameCount;
+				gpuMs += (m_DepthPrepassMs + m_ScenePassMs) / frameCount;
+			}
+		}
+		if (glfwWindowShouldClose(m_Window))
+		{
+			printf("  interrupted\n");
+			break;
+		}
 
-	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		if (distance == 0.0f)
+		{
+			baselineMs = frameMs;
+		}
+		uint32_t quadCount = m_Config.impostors ? static_cast<uint32_t>(m_ForestTrees.size()) - m_NearTreeCount : 0;
+		printf("  %-9s   %8.0f   %6u   %5u   %14.3f   %10.3f   %6.2fx\n", m_Config.impostors ? "on" : "off", distance, m_NearTreeCount,
+			quadCount, gpuMs, frameMs, baselineMs / std::max(frameMs, 1e-6));
+	}
+	vkDeviceWaitIdle(m_LogicalDevice);
 
-	return commandBuffer;
+	setImpostors(originalConfig.impostors);
+	setImpostorDistance(originalConfig.impostorDistance);
+	setPresentPolicy(originalConfig.presentPolicy);
+	m_Config = originalConfig;
 }
 
-// 񂾂gp\̃R}hI܂
-void CVulkanFramework::endSingleTimeCommands(VkCommandBuffer commandBuffer)
+// ~bv}bvx`}[NF4KE8KeNX`[blitƃRs[griGPU^CX^vj
+// Mip generation benchmark: blit chain vs compute shader on 4K and 8K images, GPU time averaged over several runs
+void CVulkanFramework::benchmarkMipGeneration()
 {
-	vkEndCommandBuffer(commandBuffer);
+	const uint32_t iterations = 10;
+	const uint32_t sizes[] = { 4096, 8192 };
+	const VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
 
-	VkSubmitInfo submitInfo{};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffer;
+	if (CGpuTimer::isSupported(m_PhysicalDevice, findQueueFamilies(m_PhysicalDevice).graphicsFamily.value()) == false)
+	{
+		std::cout << "Timestamps not supported on the graphics queue, cannot run mip benchmark" << std::endl;
+		return;
+	}
 
-	vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(m_GraphicsQueue);
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(m_PhysicalDevice, format, &formatProperties);
+	bool blitSupported = (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0;
 
-	vkFreeCommandBuffers(m_LogicalDevice, m_CommandPool, 1, &commandBuffer);
-}
+	CGpuTimer timer;
+	timer.create(m_LogicalDevice, m_PhysicalDevice, 4 * iterations);
 
-// ~bv}bv֐
-void CVulkanFramework::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels)
-{
-	// nꂽtH[}bgLinear BlittingT|[g邩mF
-	VkFormatProperties formatProperties;
-	vkGetPhysicalDeviceFormatProperties(m_PhysicalDevice, imageFormat, &formatProperties);
+	printf("Mip generation benchmark (GPU time, average of %u runs)\n", iterations);
+	printf("%8s %8s %12s %14s %10s\n", "size", "levels", "blit (ms)", "compute (ms)", "speedup");
 
-	if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+	for (uint32_t size : sizes)
 	{
-		throw std::runtime_error("Texture image format does not support linear blitting!");
+		uint32_t mipLevels = CTextureLoader::calculateMipLevels(size, size);
+
+		VkImage image;
+		VkDeviceMemory imageMemory;
+		createImage(size, size, mipLevels, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (m_ComputeMipGen ? VK_IMAGE_USAGE_STORAGE_BIT : 0),
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory, m_ComputeMipGen ? CMipGenerator::getImageCreateFlags() : 0);
+
+		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+		timer.reset(commandBuffer);
+
+		// S~bvxTRANSFER_DSTցAx0hԂ
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 };
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkClearColorValue clearColor = { { 0.25f, 0.5f, 0.75f, 1.0f } };
+		VkImageSubresourceRange baseLevel = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &baseLevel);
+
+		for (int method = 0; method < 2; method++)
+		{
+			bool compute = (method == 1);
+			if ((compute && m_ComputeMipGen == false) || (compute == false && blitSupported == false))
+			{
+				continue;
+			}
+
+			for (uint32_t i = 0; i < iterations; i++)
+			{
+				timer.timestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, "start");
+				if (compute)
+				{
+					m_MipGenerator.record(commandBuffer, image, format, size, size, mipLevels);
+				}
+				else
+				{
+					recordMipmapBlits(commandBuffer, image, static_cast<int32_t>(size), static_cast<int32_t>(size), mipLevels);
+				}
+				timer.timestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, compute ? "compute" : "blit");
+
+				// ̌v̂߂ɖ߂ivOj  back to TRANSFER_DST for the next run (not timed)
+				barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+					0, 0, nullptr, 0, nullptr, 1, &barrier);
+			}
+		}
+
+		endSingleTimeCommands(commandBuffer);
+		m_MipGenerator.releaseTransient();
+
+		std::vector<std::pair<std::string, double>> sections;
+		timer.resolve(sections);
+
+		double blitMs = 0.0, computeMs = 0.0;
+		for (const std::pair<std::string, double>& section : sections)
+		{
+			if (section.first == "blit")    blitMs += section.second / iterations;
+			if (section.first == "compute") computeMs += section.second / iterations;
+		}
+		printf("%8u %8u %12.3f %14.3f %9.2fx\n", size, mipLevels, blitMs, computeMs, (computeMs > 0.0) ? blitMs / computeMs : 0.0);
+
+		vkDestroyImage(m_LogicalDevice, image, nullptr);
+		freeMemory(imageMemory);
 	}
 
-	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	timer.destroy();
+}
 
+// ~bv}bvR}hL^܂iSxTRANSFER_DST_OPTIMAL̏ԂASHADER_READ_ONLY_OPTIMALŏIj
+// records the blit chain; expects every level in TRANSFER_DST_OPTIMAL and leaves them in SHADER_READ_ONLY_OPTIMAL
+void CVulkanFramework::recordMipmapBlits(VkCommandBuffer commandBuffer, VkImage image, int32_t texWidth, int32_t texHeight, uint32_t mipLevels)
+{
 	VkImageMemoryBarrier barrier{};
 	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 	barrier.image = image;
@@ -2217,7 +4531,6 @@ void CVulkanFramework::generateMipmaps(VkImage image, VkFormat imageFormat, int3
 		0, nullptr,
 		1, &barrier);
 
-	endSingleTimeCommands(commandBuffer);
 }
 
 //====================================================================================
@@ -2259,38 +4572,55 @@ void CVulkanFramework::recreateSwapChain()
 	createDepthResources();     // fvXobt@[][VEChETCYɍ킹܂
 	createFramebuffers();       // SwapChain̉摜Ɉˑ
 	createUniformBuffers();     // SwapChain̉摜Ɉˑ
+	createLightBuffers();       // SwapChain̉摜Ɉˑ
 	createDescriptorPool();     // SwapChain̉摜Ɉˑ
 	createDescriptorSets();     // SwapChain̉摜Ɉˑ
+	m_ImpostorPass.createPipeline(m_RenderPass, m_MSAASamples, m_SwapChainExtent, m_PipelineCache.get());    // _[pXEr[|[gɈˑ
+	m_ImpostorPass.createDescriptorSets(m_UniformBuffers, sizeof(UniformBufferObject), m_ImpostorSampler);
 	createCommandBuffers();     // SwapChain̉摜Ɉˑ
+	m_ImageFrames.assign(m_SwapChainImages.size(), 0);    // GPUҋ@ς  device is idle
+	m_ShadowCascades.invalidate();    // AXyNg䂪ς΃JXP[hς  new aspect ratio, new cascades
 
 	createImGuiRenderPass();
 	createImGuiFramebuffers();
 	createCommandPool(m_ImGuiCommandPool, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
 	allocateImGuiCommandBuffers();
-	createImGuiCommandBuffers();         
 	ImGui_ImplVulkan_SetMinImageCount(m_MinImageCount);    // XVm_MinImageCountImGuiɓn
 }
 
 // jtH[obt@[XViUBOjF}gbNXgXtH[AJݒ
 void CVulkanFramework::updateUniformBuffer(uint32_t currentImage)
 {
+	PROFILE_FUNCTION();
+
 	//// startTimeAcurrentTime̎ۂ̃f[^^: static std::chrono::time_point<std::chrono::steady_clock> 
 	static auto startTime = std::chrono::high_resolution_clock::now();
 	auto currentTime = std::chrono::high_resolution_clock::now();
 	float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+	float deltaTime = static_cast<float>(time - m_LastUpdateTime);
+	m_LastUpdateTime = time;
 
 	UniformBufferObject ubo{};  // MVP (fEr[EvWFNV)gXtH[\
 
-	//// M(Model: t[AZX]
+	//// M(Model: t[AZ30/b]i]̂݁F~܂f̉e̓LbV܂j
+	//// rotates 30 degrees per second about Z while spinning; a still model's shadow cascades stay cached
 	// ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-	ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(30.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	if (m_Config.spinModel)
+	{
+		m_ModelAngle = std::fmod(m_ModelAngle + deltaTime * 30.0f, 360.0f);
+	}
+	m_SceneGraph.setLocal(m_ModelNode, glm::rotate(glm::mat4(1.0f), glm::radians(m_ModelAngle), glm::vec3(0.0f, 0.0f, 1.0f)));
+	m_SceneGraph.update(m_JobSystem.get());    // ύXꂽm[h̕؂̂  dirty subtrees only
+	ubo.model = m_SceneGraph.getWorld(m_ModelNode);
 	//
 	// V(View): @eyeʒu, centerʒu, up
-	ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	ubo.camPos = m_CameraPosition;    // IBLFxNgp  view vector for image based lighting
+	ubo.view = glm::lookAt(ubo.camPos, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 
 	// P(Projection): @45o[eBJFoV, AXyNgAjAAt@[r[v[
 	// arguments: field-of-view, aspect ratio, near and far view planes 
-	ubo.proj = glm::perspective(glm::radians(45.0f), m_SwapChainExtent.width / (float)m_SwapChainExtent.height, 0.1f, 10.0f);
+	// t@[͐Xꍇ̒[܂  the far plane reaches the edge of the forest, if any
+	ubo.proj = glm::perspective(glm::radians(45.0f), m_SwapChainExtent.width / (float)m_SwapChainExtent.height, 0.1f, m_FarPlane);
 
 	//// XGLMOpelGLɑΉ邽߂ɐ݌vĂ܂iỸNbvWtɂȂĂ܂jB
 	//// VulkanɑΉ邽߂ɃNbvWYuɖ߂vłBȂƕ`͂ЂԂԂɂȂĂ܂܂B
@@ -2300,21 +4630,147 @@ void CVulkanFramework::updateUniformBuffer(uint32_t currentImage)
 	//// Not doing this results in an upside-down render.
 	ubo.proj[1][1] *= -1;
 
+	m_SunAzimuth = std::fmod(m_SunAzimuth + deltaTime * m_SunSpeed + 360.0f, 360.0f);
+	updateShadows(ubo);    // JXP[h͂̃r[EvWFNV番
+
 	//// UBÕ݂jtH[obt@[ɂ܂
 	void* data;
 	vkMapMemory(m_LogicalDevice, m_UniformBuffersMemory[currentImage], 0, sizeof(ubo), 0, &data);
 	memcpy(data, &ubo, sizeof(ubo));
 	vkUnmapMemory(m_LogicalDevice, m_UniformBuffersMemory[currentImage]);
+
+	updateLights(currentImage, ubo, time);    // NX^[̃Obh͓r[EvWFNV
+}
+
+// z̕ƃVhEJXP[hFELbV̌AUBOɃJXP[h̍siLbVꂽ͕̂`掞̍sj݂܂
+// sun direction and shadow cascades: splits the camera frustum of ubo.view/proj, decides which cascades re-render,
+// and writes every cascade's matrix (for a cached cascade, the one its layer was rendered with) into the UBO
+void CVulkanFramework::updateShadows(UniformBufferObject& ubo)
+{
+	PROFILE_FUNCTION();
+
+	const float SUN_INTENSITY = 3.0f;
+	float azimuth = glm::radians(m_SunAzimuth);
+	float elevation = glm::radians(m_SunElevation);
+	glm::vec3 sunDirection(std::cos(elevation) * std::cos(azimuth), std::cos(elevation) * std::sin(azimuth), std::sin(elevation));
+	ubo.sun = glm::vec4(sunDirection, SUN_INTENSITY);
+
+	if (m_ShadowPass.isCreated() == false || (m_Config.shaderFeatures & SHADER_FEATURE_SHADOWS) == 0)
+	{
+		m_ShadowCascades.invalidate();    // ĂїLɂȂSJXP[h`  everything re-renders when enabled again
+		return;
+	}
+
+	// ]̃f͓ILX^[FJXP[h͖t[`  a spinning model is dynamic: its cascades render every frame
+	for (ShadowCaster& caster : m_ShadowCasters)
+	{
+		caster.dynamic = m_Config.spinModel;
+	}
+	m_ShadowCascades.update(ubo.view, ubo.proj, sunDirection, ubo.model, m_ShadowCasters);
+
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		const ShadowCascade& cascade = m_ShadowCascades.getCascade(i);
+		ubo.cascadeViewProj[i] = cascade.viewProj;
+		ubo.cascadeSplits[i] = cascade.splitFar;
+	}
+}
+
+// CgXVFAj[V̌Awb_[iubo.viewEproj狁߂NX^[̃ObhjƃCg݂܂
+// GPUU蕪Ȃꍇ͂ŃNX^[܂
+// animates the lights and writes them behind the grid header derived from ubo.view/proj;
+// without the compute pass the clusters are built here on the job system
+void CVulkanFramework::updateLights(uint32_t currentImage, const UniformBufferObject& ubo, float time)
+{
+	PROFILE_FUNCTION();
+
+	if ((m_Config.shaderFeatures & SHADER_FEATURE_CLUSTERED_LIGHTS) == 0)
+	{
+		return;
+	}
+
+	uint32_t lightCount = std::min(m_Config.lightCount, MAX_POINT_LIGHTS);
+	if (m_BaseLights.size() != lightCount)
+	{
+		m_BaseLights = CClusteredLights::createForestLights(lightCount);    // ImGuiŃCgς  count changed in ImGui
+	}
+	CClusteredLights::animate(m_BaseLights, m_Lights, time);
+
+	m_LightHeader = CClusteredLights::makeHeader(ubo.view, ubo.proj, m_SwapChainExtent.width, m_SwapChainExtent.height, lightCount);
+	uint8_t* lightData = static_cast<uint8_t*>(m_LightBuffersMapped[currentImage]);
+	memcpy(lightData, &m_LightHeader, sizeof(m_LightHeader));
+	memcpy(lightData + sizeof(m_LightHeader), m_Lights.data(), sizeof(PointLight) * m_Lights.size());
+
+	if (m_LightCuller.isCreated() == false)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		CClusteredLights::cull(m_LightHeader, m_Lights.data(), m_CpuClusters, *m_JobSystem);
+		CClusteredLights::writeClusterBuffer(m_CpuClusters, m_ClusterBuffersMapped[currentImage]);
+		m_LightCullMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
 }
 
 // t[`
+// 1t[̏
+// Low latency mode waits for the GPU *before* reading input, so the input is at most m_FramesInFlight - 1
+// frames old when the GPU starts on it, instead of blocking after input was already sampled.
+void CVulkanFramework::runFrame()
+{
+	PROFILE_SCOPE("Frame");
+
+	if (m_Config.lowLatency && m_FrameNumber + 1 > m_FramesInFlight)
+	{
+		waitForFrame(m_FrameNumber + 1 - m_FramesInFlight);
+	}
+
+	// t[~b^[F͂̑Oɑ҂̂ŁAҋ@ɓ͂ÂȂȂ
+	// frame limiter: sleeps before input is sampled, so the wait does not add input latency
+	m_FrameLimiter.setTargetFps(selectFrameLimit(m_Config.presentPolicy, m_Config.fpsLimit));
+	{
+		PROFILE_SCOPE("FrameLimiter");
+		m_FrameLimiter.wait();
+	}
+
+	{
+		PROFILE_SCOPE("glfwPollEvents");
+		glfwPollEvents();    // Cxgҋ@  Update/event checkeri̓TvOj
+	}
+	m_InputSampleTime = glfwGetTime();
+
+	// UIɑgݗāAdrawFrame()Ŏ擾摜pɋL^܂
+	// build the UI first; drawFrame() records it into the acquired image's ImGui command buffer
+	drawImGuiFrame();
+
+	// OL^̃R}hobt@[͎gp̉\̂ŁAGPŮ҂ĂL^܂
+	// the prerecorded command buffers may be in flight: wait for the GPU, then reset and record them again
+	if (m_CommandBuffersDirty)
+	{
+		PROFILE_SCOPE("rerecordCommandBuffers");
+		vkDeviceWaitIdle(m_LogicalDevice);
+		rerecordCommandBuffers();
+	}
+	drawFrame();         // t[`
+}
+
 void CVulkanFramework::drawFrame()
 {
-	// tFX҂܂
-	vkWaitForFences(m_LogicalDevice, 1, &m_InFlightFences[m_CurrentFrame], VK_TRUE, UINT64_MAX);
+	PROFILE_FUNCTION();
+
+	// XbggĂt[im_FramesInFlightOj̊҂܂
+	// wait for the frame that last used this slot, m_FramesInFlight frames ago
+	uint64_t frame = m_FrameNumber + 1;
+	uint32_t slot = static_cast<uint32_t>(frame % m_FramesInFlight);
+	if (frame > m_FramesInFlight)
+	{
+		waitForFrame(frame - m_FramesInFlight);
+	}
 
 	uint32_t imageIndex;
-	VkResult result = vkAcquireNextImageKHR(m_LogicalDevice, m_SwapChain, UINT64_MAX, m_ImageAvailableSemaphores[m_CurrentFrame], VK_NULL_HANDLE, &imageIndex);
+	VkResult result;
+	{
+		PROFILE_SCOPE("vkAcquireNextImageKHR");
+		result = vkAcquireNextImageKHR(m_LogicalDevice, m_SwapChain, UINT64_MAX, m_ImageAvailableSemaphores[slot], VK_NULL_HANDLE, &imageIndex);
+	}
 
 	// SwapChainꂽꍇ  iꂽj
 	// check if swap chain is out of date
@@ -2328,29 +4784,47 @@ void CVulkanFramework::drawFrame()
 		throw std::runtime_error("Failed to acquire swap chain image!");
 	}
 
-	// jtH[obt@[XV
-	updateUniformBuffer(imageIndex);
+	// ݂̉摜ȑÕt[ŎgĂ邩F̃t[̊҂ijtH[obt@[XV̑Oj
+	// wait for the frame that last rendered to this image before touching its uniform buffer
+	waitForFrame(m_ImageFrames[imageIndex]);
 
-	// ݂̉摜ȑÕt[ŎgĂ邩itFX҂Ă邩j
-	// check if a previous frame is using this image (i.e. there is its fence to wait on)
-	if (m_ImagesInFlight[imageIndex] != VK_NULL_HANDLE)
+	// O񂱂̉摜Ŏst[͊ς݁F̃^CX^vǂݎ܂
+	// the last frame on this image has completed, so its timestamps can be read without waiting
+	if (m_FrameTimers.empty() == false && m_ImageFrames[imageIndex] != 0)
 	{
-		vkWaitForFences(m_LogicalDevice, 1, &m_ImagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+		std::vector<std::pair<std::string, double>> sections;
+		if (m_FrameTimers[imageIndex].resolve(sections, false))
+		{
+			m_DepthPrepassMs = 0.0;    // vpXȂF^CX^vȂ  no prepass, no timestamp
+			for (const std::pair<std::string, double>& section : sections)
+			{
+				if (section.first == "cull" && m_LightCuller.isCreated()) m_LightCullMs = section.second;
+				if (section.first == "prepass")                           m_DepthPrepassMs = section.second;
+				if (section.first == "scene")                             m_ScenePassMs = section.second;
+			}
+		}
+		sections.clear();
+		if (m_ShadowTimers[imageIndex].resolve(sections, false) && sections.empty() == false)
+		{
+			m_ShadowPassMs = sections.back().second;    // "shadow"
+		}
 	}
+	m_ImageFrames[imageIndex] = frame;
 
-	// ݂̉摜݂̃t[ŎgĂ悤ɎB
-	// mark the image as now being in use by this frame
-	m_ImagesInFlight[imageIndex] = m_InFlightFences[m_CurrentFrame];
+	// jtH[obt@[XViVhEJXP[h̔܂ށj
+	updateUniformBuffer(imageIndex);
+	recordShadowPass(imageIndex);
+	recordImGuiCommandBuffer(imageIndex);
 
-	// V[`ImGuiꂼ̃R}hobt@[z
-	// combining both render and ImGui command buffers into one submit array
-	std::array<VkCommandBuffer, 2> submitCommandBuffers =
-	{ m_CommandBuffers[imageIndex], m_ImGuiCommandBuffers[imageIndex] };
+	// VhEEV[`EImGuiꂼ̃R}hobt@[z
+	// combining the shadow, render and ImGui command buffers into one submit array
+	std::array<VkCommandBuffer, 3> submitCommandBuffers =
+	{ m_ShadowCommandBuffers[imageIndex], m_CommandBuffers[imageIndex], m_ImGuiCommandBuffers[imageIndex] };
 
 	VkSubmitInfo submitInfo{};    // L[Eo\
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-	VkSemaphore waitSemaphores[] = { m_ImageAvailableSemaphores[m_CurrentFrame] };
+	VkSemaphore waitSemaphores[] = { m_ImageAvailableSemaphores[slot] };
 	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 	submitInfo.waitSemaphoreCount = 1;
 	submitInfo.pWaitSemaphores = waitSemaphores;    // sOɑ҂Z}tH@semaphore to wait on before execution
@@ -2361,22 +4835,43 @@ void CVulkanFramework::drawFrame()
 	submitInfo.commandBufferCount = static_cast<uint32_t>(submitCommandBuffers.size());
 	submitInfo.pCommandBuffers = submitCommandBuffers.data();
 
-	VkSemaphore signalSemaphores[] = { m_RenderFinishedSemaphores[m_CurrentFrame] };
-	submitInfo.signalSemaphoreCount = 1;
+	// ^CCZ}tHɃt[ԍVOiioCiZ}tH̒l͖܂j
+	// signal the frame number on the timeline; the value given for the binary semaphore is ignored
+	VkSemaphore signalSemaphores[] = { m_RenderFinishedSemaphores[slot], m_FrameTimeline };
+	uint64_t signalValues[] = { 0, frame };
+	submitInfo.signalSemaphoreCount = m_TimelineSupported ? 2 : 1;
 	submitInfo.pSignalSemaphores = signalSemaphores;    // ÎƂɋNZ}tH  semaphores to signal once command buffer(s) have finished execution
 
-	vkResetFences(m_LogicalDevice, 1, &m_InFlightFences[m_CurrentFrame]);
+	VkTimelineSemaphoreSubmitInfo timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineInfo.signalSemaphoreValueCount = 2;
+	timelineInfo.pSignalSemaphoreValues = signalValues;
 
-	if (vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, m_InFlightFences[m_CurrentFrame]) != VK_SUCCESS)
+	VkFence fence = VK_NULL_HANDLE;
+	if (m_TimelineSupported)
 	{
-		throw std::runtime_error("Failed to submit draw command buffer!");
+		submitInfo.pNext = &timelineInfo;
 	}
+	else
+	{
+		fence = m_InFlightFences[slot];
+		vkResetFences(m_LogicalDevice, 1, &fence);
+	}
+
+	{
+		PROFILE_SCOPE("vkQueueSubmit");
+		if (vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit draw command buffer!");
+		}
+	}
+	m_FrameNumber = frame;
 
 	VkPresentInfoKHR presentInfo{};    // v[g\
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
 	presentInfo.waitSemaphoreCount = 1;
-	presentInfo.pWaitSemaphores = signalSemaphores;
+	presentInfo.pWaitSemaphores = &m_RenderFinishedSemaphores[slot];
 
 	VkSwapchainKHR swapChains[] = { m_SwapChain };      // SwapChain\
 	presentInfo.swapchainCount = 1;                     // SwapChaini݁FPj
@@ -2388,7 +4883,10 @@ void CVulkanFramework::drawFrame()
 	presentInfo.pResults = nullptr;
 
 	// UgSwapChainɓnĕ`悵܂  submit the result back to the swap chain to have it show on screen
-	result = vkQueuePresentKHR(m_PresentQueue, &presentInfo);
+	{
+		PROFILE_SCOPE("vkQueuePresentKHR");
+		result = vkQueuePresentKHR(m_PresentQueue, &presentInfo);
+	}
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR    // SwapChainpꂽ
 		|| result == VK_SUBOPTIMAL_KHR           // SwapChainœKĂȂ
@@ -2401,8 +4899,6 @@ void CVulkanFramework::drawFrame()
 	{
 		throw std::runtime_error("Failed to present swap chain image!");
 	}
-
-	m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;    // ̃t[Ɉړ@advance to next frame
 }
 
 //====================================================================================
@@ -2410,15 +4906,38 @@ void CVulkanFramework::drawFrame()
 // Device/Component Property, Query Functions
 //====================================================================================
 
+// IGPŨvpeB[El1񂾂擾܂iȍ~m_DevicePropertiesQƁj
+// query the selected GPU's properties and limits once; everything else reads m_DeviceProperties
+void CVulkanFramework::queryDeviceProperties()
+{
+	vkGetPhysicalDeviceProperties(m_PhysicalDevice, &m_DeviceProperties);
+	vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &m_MemoryProperties);
+	m_PhysicalDeviceName = "GPU: " + std::string(m_DeviceProperties.deviceName);
+
+	// BCnΉ̓eNX`[fR[hJniWJfoCX̑OjɕKvł
+	// BCn support is needed to start texture decoding, before the logical device exists
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+	m_TextureCompressionBC = (supportedFeatures.textureCompressionBC == VK_TRUE);
+
+	m_DeviceProperties12 = {};
+	m_DeviceProperties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+	if (m_DeviceProperties.apiVersion >= VK_API_VERSION_1_2)
+	{
+		VkPhysicalDeviceProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &m_DeviceProperties12;
+		vkGetPhysicalDeviceProperties2(m_PhysicalDevice, &properties2);
+		m_DeviceProperties12.pNext = nullptr;
+	}
+}
+
 // gpGPȖΉłTvrbgl֐
 VkSampleCountFlagBits CVulkanFramework::getMaxUseableSampleCount()
 {
-	VkPhysicalDeviceProperties physicalDeviceProperties;
-	vkGetPhysicalDeviceProperties(m_PhysicalDevice, &physicalDeviceProperties);
-
 	VkSampleCountFlags counts =
-		physicalDeviceProperties.limits.framebufferColorSampleCounts
-		& physicalDeviceProperties.limits.framebufferDepthSampleCounts;
+		m_DeviceProperties.limits.framebufferColorSampleCounts
+		& m_DeviceProperties.limits.framebufferDepthSampleCounts;
 
 
 	// ő吔D
@@ -2505,6 +5024,24 @@ bool CVulkanFramework::checkDeviceExtensionSupport(VkPhysicalDevice device)
 	return isEmpty;                               // if all the required extension were present (and thus erased), returns true
 }
 
+// Cӂ̃foCXGNXeVg邩  whether an optional device extension is available
+bool CVulkanFramework::isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extensionName)
+{
+	uint32_t extensionCount;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+	std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+	for (const VkExtensionProperties& extension : availableExtensions)
+	{
+		if (strcmp(extension.extensionName, extensionName) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 // L[ތEI
 QueueFamilyIndices CVulkanFramework::findQueueFamilies(VkPhysicalDevice device)
 {
@@ -2558,16 +5095,17 @@ VkSurfaceFormatKHR CVulkanFramework::chooseSwapSurfaceFormat(const std::vector<V
 }
 
 // Xbvv[g[hI
+// --present|V[̗D揇ʂőIт܂BFIFO͕KT|[gĂ̂ōŌ̎iłB
+// picked in the order of the present policy (default: MAILBOX = triple buffering, less latency).
+// FIFO is guaranteed to be available and is always the last resort.
 VkPresentModeKHR CVulkanFramework::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes)
 {
-	for (const VkPresentModeKHR& availablePresentMode : availablePresentModes)
+	VkPresentModeKHR presentMode = selectPresentMode(m_Config.presentPolicy, availablePresentModes);
+	if (presentMode != m_PresentMode)
 	{
-		if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)    // gvobt@O@triple buffering (less latency)
-		{
-			return availablePresentMode;
-		}
+		printf("Present mode: %s (%s)\n", toString(presentMode), toString(m_Config.presentPolicy));
 	}
-	return VK_PRESENT_MODE_FIFO_KHR;    // if VK_PRESENT_MODE_MAILBOX_KHR is not available, use a guaranteed available mode
+	return presentMode;
 }
 
 // ][Vݒ  extent = resolution of the swap chain images
@@ -2619,8 +5157,7 @@ VkFormat CVulkanFramework::findDepthFormat()
 // K؂ȃ[^Cv
 uint32_t CVulkanFramework::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
 {
-	VkPhysicalDeviceMemoryProperties memProperties;    // [^CvA[q[v
-	vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &memProperties);
+	const VkPhysicalDeviceMemoryProperties& memProperties = m_MemoryProperties;    // [^CvA[q[v
 
 	// K؂ȃ[^Cvl
 	for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
@@ -2634,6 +5171,19 @@ uint32_t CVulkanFramework::findMemoryType(uint32_t typeFilter, VkMemoryPropertyF
 	throw std::runtime_error("Failed to find suitable memory type!");    // K؂ȃ[^CvȂꍇ
 }
 
+// ɍ[^Cv邩iOȂj
+bool CVulkanFramework::isMemoryTypeAvailable(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+{
+	for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+	{
+		if ((typeFilter & (1 << i)) && (m_MemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 // nꂽfvXtH[}bgXeVR|[lgĂ邩
 bool CVulkanFramework::hasStencilComponent(VkFormat format)
 {
@@ -2662,24 +5212,27 @@ void CVulkanFramework::cleanupSwapChain()
 	// main program cleanup
 	vkDestroyImageView(m_LogicalDevice, m_ColorImageView, nullptr);
 	vkDestroyImage(m_LogicalDevice, m_ColorImage, nullptr);
-	vkFreeMemory(m_LogicalDevice, m_ColorImageMemory, nullptr);
+	freeMemory(m_ColorImageMemory);
 
 	vkDestroyImageView(m_LogicalDevice, m_DepthImageView, nullptr);
 	vkDestroyImage(m_LogicalDevice, m_DepthImage, nullptr);
-	vkFreeMemory(m_LogicalDevice, m_DepthImageMemory, nullptr);
+	freeMemory(m_DepthImageMemory);
 
 	for (VkFramebuffer framebuffer : m_SwapChainFramebuffers)
 	{
 		vkDestroyFramebuffer(m_LogicalDevice, framebuffer, nullptr);
 	}
 
-	// R}hv[폜R}hobt@[JB̃v[VR}hobt@[Ŏg܂B
-	// Frees up command buffers without destroying the command pool; reuse the existing pool to allocate new command buffers
-	vkFreeCommandBuffers(m_LogicalDevice, m_CommandPool, static_cast<uint32_t>(m_CommandBuffers.size()),
-		m_CommandBuffers.data());
+	// 摜Ƃ̃R}hv[폜iR}hobt@[ꏏɊJ܂jBm_CommandPool͂̂܂܎g܂B
+	// destroying the per-image pools frees their command buffers; m_CommandPool (one-time commands) is kept
+	for (VkCommandPool commandPool : m_FrameCommandPools)
+	{
+		vkDestroyCommandPool(m_LogicalDevice, commandPool, nullptr);
+	}
+	m_FrameCommandPools.clear();
 
-	vkDestroyPipeline(m_LogicalDevice, m_GraphicsPipeline, nullptr);
-	vkDestroyPipelineLayout(m_LogicalDevice, m_PipelineLayout, nullptr);
+	m_PipelineVariants.clear();    // _[pXEr[|[gɈˑiăRpCm_PipelineCachejBCAEgm_LayoutCacheL
+	m_ImpostorPass.destroyPipeline();    // AfXNv^[ZbgijtH[obt@[͉摜Ɓj  same, plus its per-image sets
 	vkDestroyRenderPass(m_LogicalDevice, m_RenderPass, nullptr);
 
 	for (VkImageView imageView : m_SwapChainImageViews)
@@ -2692,8 +5245,36 @@ void CVulkanFramework::cleanupSwapChain()
 	for (size_t i = 0; i < m_SwapChainImages.size(); i++)
 	{
 		vkDestroyBuffer(m_LogicalDevice, m_UniformBuffers[i], nullptr);
-		vkFreeMemory(m_LogicalDevice, m_UniformBuffersMemory[i], nullptr);
+		freeMemory(m_UniformBuffersMemory[i]);
+	}
+
+	for (size_t i = 0; i < m_LightBuffers.size(); i++)
+	{
+		vkUnmapMemory(m_LogicalDevice, m_LightBuffersMemory[i]);
+		vkDestroyBuffer(m_LogicalDevice, m_LightBuffers[i], nullptr);
+		freeMemory(m_LightBuffersMemory[i]);
+		if (m_ClusterBuffersMapped[i])
+		{
+			vkUnmapMemory(m_LogicalDevice, m_ClusterBuffersMemory[i]);
+		}
+		vkDestroyBuffer(m_LogicalDevice, m_ClusterBuffers[i], nullptr);
+		freeMemory(m_ClusterBuffersMemory[i]);
+	}
+	m_LightBuffers.clear();
+
+	for (CGpuTimer& timer : m_FrameTimers)
+	{
+		timer.destroy();
+	}
+	m_FrameTimers.clear();
+
+	vkDestroyCommandPool(m_LogicalDevice, m_ShadowCommandPool, nullptr);    // R}hobt@[ꏏɊJ  frees its command buffers
+	m_ShadowCommandBuffers.clear();
+	for (CGpuTimer& timer : m_ShadowTimers)
+	{
+		timer.destroy();
 	}
+	m_ShadowTimers.clear();
 
 	vkDestroyDescriptorPool(m_LogicalDevice, m_DescriptorPool, nullptr);
 }
@@ -2709,26 +5290,56 @@ void CVulkanFramework::cleanup()
 	ImGui::DestroyContext();
 	vkDestroyDescriptorPool(m_LogicalDevice, m_ImGuiDescriptorPool, nullptr);
 
-	vkDestroySampler(m_LogicalDevice, m_TextureSampler, nullptr);
-	vkDestroyImageView(m_LogicalDevice, m_TextureImageView, nullptr);
+	if (m_UseBindless)
+	{
+		vkDestroyDescriptorPool(m_LogicalDevice, m_BindlessPool, nullptr);
+		vkUnmapMemory(m_LogicalDevice, m_MaterialBufferMemory);
+		vkDestroyBuffer(m_LogicalDevice, m_MaterialBuffer, nullptr);
+		freeMemory(m_MaterialBufferMemory);
+	}
 
-	vkDestroyImage(m_LogicalDevice, m_TextureImage, nullptr);
-	vkFreeMemory(m_LogicalDevice, m_TextureImageMemory, nullptr);
+	m_SamplerCache.destroy();
+	m_MipGenerator.destroy();
+	m_IblBaker.destroy();
+	m_LightCuller.destroy();
+	m_ShadowPass.destroy();
+	vkDestroyImage(m_LogicalDevice, m_ShadowImage, nullptr);
+	freeMemory(m_ShadowImageMemory);
+	m_ImpostorPass.destroy();
+	vkDestroyImage(m_LogicalDevice, m_ImpostorAlbedoImage, nullptr);
+	freeMemory(m_ImpostorAlbedoMemory);
+	vkDestroyImage(m_LogicalDevice, m_ImpostorNormalDepthImage, nullptr);
+	freeMemory(m_ImpostorNormalDepthMemory);
+	for (Texture& texture : m_Textures)
+	{
+		vkDestroyImageView(m_LogicalDevice, texture.view, nullptr);
+		vkDestroyImage(m_LogicalDevice, texture.image, nullptr);
+		freeMemory(texture.memory);
+	}
+	m_Textures.clear();
+	for (Texture* texture : { &m_IblIrradiance, &m_IblPrefiltered, &m_IblBrdfLut })
+	{
+		vkDestroyImageView(m_LogicalDevice, texture->view, nullptr);
+		vkDestroyImage(m_LogicalDevice, texture->image, nullptr);
+		freeMemory(texture->memory);
+	}
 
-	vkDestroyDescriptorSetLayout(m_LogicalDevice, m_DescriptorSetLayout, nullptr);
+	vkDestroyShaderModule(m_LogicalDevice, m_FragShaderModule, nullptr);
+	vkDestroyShaderModule(m_LogicalDevice, m_VertShaderModule, nullptr);
+	m_LayoutCache.destroy();    // fXNv^[ZbgCAEgEpCvCCAEg
+	m_PipelineCache.save();     // ̋NEoAg̃RpC𑬂܂
+	m_PipelineCache.destroy();
 
 	vkDestroyBuffer(m_LogicalDevice, m_IndexBuffer, nullptr);
-	vkFreeMemory(m_LogicalDevice, m_IndexBufferMemory, nullptr);
+	freeMemory(m_IndexBufferMemory);
 
 	vkDestroyBuffer(m_LogicalDevice, m_VertexBuffer, nullptr);
-	vkFreeMemory(m_LogicalDevice, m_VertexBufferMemory, nullptr);
+	freeMemory(m_VertexBufferMemory);
 
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		vkDestroySemaphore(m_LogicalDevice, m_RenderFinishedSemaphores[i], nullptr);
-		vkDestroySemaphore(m_LogicalDevice, m_ImageAvailableSemaphores[i], nullptr);
-		vkDestroyFence(m_LogicalDevice, m_InFlightFences[i], nullptr);
-	}
+	vkDestroyBuffer(m_LogicalDevice, m_InstanceBuffer, nullptr);
+	freeMemory(m_InstanceBufferMemory);
+
+	destroySyncObjects();
 
 	vkDestroyCommandPool(m_LogicalDevice, m_CommandPool, nullptr);
 
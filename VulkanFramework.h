@@ -14,8 +14,42 @@ Last Modified:	2020.12.18
 
 #include <array>
 #include <optional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <mutex>
 #include <iostream>          // std::cerr, try to migrate out of debug callback
 
+#include "AppConfig.h"
+#include "Bvh.h"
+#include "ClusteredLights.h"
+#include "DrawList.h"
+#include "GpuTimer.h"
+#include "IblBaker.h"
+#include "IblCache.h"
+#include "IblPrecompute.h"
+#include "ImpostorPass.h"
+#include "JobSystem.h"
+#include "LightCuller.h"
+#include "MemoryTracker.h"
+#include "MipGenerator.h"
+#include "Profiler.h"
+#include "RenderGraph.h"
+#include "SamplerCache.h"
+#include "SceneGraph.h"
+#include "SimdMath.h"
+#include "PipelineCache.h"
+#include "ShaderReflection.h"
+#include "ShaderVariants.h"
+#include "ShadowCascades.h"
+#include "ShadowPass.h"
+#include "StartupTimeline.h"
+#include "TextureCompressor.h"
+#include "TextureLoader.h"
+#include "WorldStreaming.h"
+
 #define GLFW_INCLUDE_VULKAN    // VulkanSDKGLFWƈꏏɃCN[h܂B
 #include <GLFW/glfw3.h>        // replaces #include <vulkan/vulkan.h> and automatically bundles it with glfw include
 
@@ -98,6 +132,9 @@ struct UniformBufferObject
 	alignas(16) glm::mat4 view;
 	alignas(16) glm::mat4 proj;
 	alignas(16) glm::vec3 camPos;
+	alignas(16) glm::mat4 cascadeViewProj[SHADOW_CASCADE_COUNT];    // z̉eJXP[hF[hVhENbv  world -> shadow clip space
+	alignas(16) glm::vec4 cascadeSplits;    // eJXP[h̉r[[x  far view depth of every cascade
+	alignas(16) glm::vec4 sun;              // xyz = zւ̕Aw =   direction towards the sun, intensity
 };
 
 // Vulkan̂鏈̓L[ŏĂ܂BɂăL[̎ނقȂ܂B
@@ -125,6 +162,39 @@ struct SwapChainSupportDetails
 	std::vector<VkPresentModeKHR> presentModes;
 };
 
+// eNX`[iC[WA[AC[Wr[j
+// GPU texture: image, memory and view
+struct Texture
+{
+	VkImage         image = VK_NULL_HANDLE;
+	VkDeviceMemory  memory = VK_NULL_HANDLE;
+	VkImageView     view = VK_NULL_HANDLE;
+	VkFormat        format = VK_FORMAT_R8G8B8A8_SRGB;
+	uint32_t        width = 0;
+	uint32_t        height = 0;
+	uint32_t        mipLevels = 1;
+	VkSampler       sampler = VK_NULL_HANDLE;      // m_SamplerCacheL  owned by the sampler cache
+	uint32_t        bindlessIndex = UINT32_MAX;    // oChXz̃CfbNX  slot in the bindless texture array
+};
+
+// pXŊA^b`giMSAAJ[EfvXj̃[
+// memory of an attachment that only lives inside the render pass (MSAA color, depth)
+struct AttachmentMemoryInfo
+{
+	VkDeviceSize    size = 0;             // vkGetImageMemoryRequirements
+	VkDeviceSize    bytesPerSample = 0;
+	bool            lazy = false;         // LAZILY_ALLOCATED: ^CGPUł͎[قڊmۂȂ
+};
+
+// }eAiGPUAstd430Gshaders_bindless.fragƈv邱Ɓj
+// GPU material record, std430 layout: must match shaders_bindless.frag
+struct MaterialData
+{
+	glm::vec4       baseColorFactor = glm::vec4(1.0f);
+	uint32_t        albedoTexture = 0;       // oChXz̃CfbNX  index into the bindless texture array
+	uint32_t        padding[3] = {};
+};
+
 // }EX{^
 // mouse buttons
 struct MouseButtons
@@ -141,6 +211,12 @@ class CVulkanFramework
 {
 private:
 
+	AppConfig                       m_Config;                // R}hCݒ  command line settings
+	std::unique_ptr<CJobSystem>     m_JobSystem;             // [J[Xbh  CPU worker pool
+	CStartupTimeline                m_StartupTimeline;       // NXebv̊JnEI  --startup-timeline
+	std::mutex                      m_StartupErrorMutex;
+	std::exception_ptr              m_StartupError;          // [J[ŎsNXebv̗O  first failed startup job
+
 	GLFWwindow*                     m_Window;                // WINDOWSł͂ȂGLFW;@NXvbgtH[Ή
 	VkInstance                      m_Instance;              // CX^XFAvP[VSDK̂Ȃ
 
@@ -153,7 +229,16 @@ private:
 
 	std::string         m_PhysicalDeviceName;                // GPU
 
+	// foCX̃vpeB[ElipickPhysicalDevice()1񂾂擾j
+	// physical device properties and limits, queried once in pickPhysicalDevice()
+	VkPhysicalDeviceProperties          m_DeviceProperties{};
+	VkPhysicalDeviceVulkan12Properties  m_DeviceProperties12{};    // apiVersion < 1.2̏ꍇ̓[  zero if the device is older than 1.2
+	VkPhysicalDeviceMemoryProperties    m_MemoryProperties{};
+	CMemoryTracker                      m_MemoryTracker;                    // SfoCX[̊蓖āEL^  every device allocation goes through here
+	bool                                m_MemoryBudgetSupported = false;    // VK_EXT_memory_budget
+
 	VkQueue                         m_GraphicsQueue;         // OtBbNXpL[
+	uint32_t                        m_GraphicsQueueFamily = 0;
 	VkQueue                         m_PresentQueue;          // v[gi`jpL[
 
 	VkSwapchainKHR                  m_SwapChain;             // \\̉摜̃L[
@@ -165,18 +250,27 @@ private:
 	std::vector<VkFramebuffer> m_SwapChainFramebuffers;      // SwapChaiñt[obt@
 
 	VkRenderPass                    m_RenderPass;            // _[pX
-	VkDescriptorSetLayout           m_DescriptorSetLayout;   // ŃXNv^[ZbgCAEg
-	VkPipelineLayout                m_PipelineLayout;        // OtBbNXpCvCCAEg
-	VkPipeline                      m_GraphicsPipeline;      // OtBbNXpCvC
+	VkDescriptorSetLayout           m_DescriptorSetLayout;   // ŃXNv^[ZbgCAEgiZbg0Am_LayoutCacheLj
+	VkPipelineLayout                m_PipelineLayout;        // OtBbNXpCvCCAEgim_LayoutCacheLj
+	CShaderReflection               m_ShaderReflection;      // _EtOgVF[_[̃oCfBOAvbV萔  reflected from vert/frag SPIR-V
+	std::vector<VkDescriptorSetLayout>  m_SetLayouts;        // Zbgԍ  indexed by set number
+	CLayoutCache                    m_LayoutCache;           // ẽCAEgL  identical layouts are created once
+	CPipelineVariants               m_PipelineVariants;      // OtBbNXpCvCFVF[_[@\L[ƂɏgpɃRpC  compiled per feature key on first use
+	CPipelineCache                  m_PipelineCache;         // fBXNɕۑpCvCLbV  persisted across runs
+	VkShaderModule                  m_VertShaderModule = VK_NULL_HANDLE;    // oAgpɕێ
+	VkShaderModule                  m_FragShaderModule = VK_NULL_HANDLE;
 
 	VkCommandPool                   m_CommandPool;           // CommandPool : R}hobt@[AĂ̊蓖ĂǗA
 	std::vector<VkCommandBuffer>    m_CommandBuffers;
+	std::vector<VkCommandPool>      m_FrameCommandPools;     // Xbv`F[摜Ƃ̃v[iL^pj  per-image pools for parallel recording
 
 	VkDescriptorPool                m_DescriptorPool;        // DescriptorPool : fXNv^[ZbgAĂ̊蓖ĂǗ
 	std::vector<VkDescriptorSet>    m_DescriptorSets;
 
 	std::vector<Vertex>             m_Vertices;              // _f[^ifpj
 	std::vector<uint32_t>           m_Indices;               // CfbNXf[^ifpj
+	std::vector<ShadowCaster>       m_ShadowCasters;         // f̃`Nim_Indices͈̔́j  model chunks, ranges of m_Indices
+	float                           m_ModelAngle = 0.0f;     // f̉]ixA]̂ݐiށj  model rotation, advances only while spinning
 
 	VkBuffer                        m_VertexBuffer;          // _obt@[
 	VkDeviceMemory                  m_VertexBufferMemory;    // _obt@[[蓖
@@ -190,29 +284,130 @@ private:
 	VkDeviceMemory                  m_DepthImageMemory;
 	VkImageView                     m_DepthImageView;
 
-	uint32_t                        m_MipLevels;             // ~bv}bvp
-	VkImage                         m_TextureImage;          // eNX`[}bsOpiTexelAȂǁj
-	VkDeviceMemory                  m_TextureImageMemory;
-	VkImageView                     m_TextureImageView;
-	VkSampler                       m_TextureSampler;
+	std::vector<Texture>            m_Textures;              // eNX`[}bsOpiTexelA~bv}bvȂǁj
+	TextureFormat                   m_TextureFormat = TextureFormat::RGBA8;    // ۂɎgp̃tH[}bg  format actually in use
+	bool                            m_TextureCompressionBC = false;            // GPUBCnɑΉĂ邩
+	// oChXFSeNX`[1̔zɁA}eASSBOɊi[i`悲ƂɃvbV萔Ń}eAwj
+	// bindless: every texture in one update-after-bind array (set 1), materials in an SSBO, material index per draw
+	bool                            m_BindlessSupported = false;    // descriptor indexing (Vulkan 1.2)
+	bool                            m_UseBindless = false;          // ΉĂAfrag_bindless.spv݂ꍇ
+	uint32_t                        m_BindlessCapacity = 0;         // eNX`[z̍ő吔
+	VkDescriptorSetLayout           m_BindlessSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool                m_BindlessPool = VK_NULL_HANDLE;
+	VkDescriptorSet                 m_BindlessSet = VK_NULL_HANDLE;
+	uint32_t                        m_BindlessTextureCount = 0;
+	std::vector<MaterialData>       m_Materials;
+	VkBuffer                        m_MaterialBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory                  m_MaterialBufferMemory = VK_NULL_HANDLE;
+	void*                           m_MaterialBufferMapped = nullptr;    // host visible, persistently mapped
+	CMipGenerator                   m_MipGenerator;                            // Rs[gVF[_[Ń~bv}bv
+	bool                            m_ComputeMipGen = false;                   // falsȅꍇvkCmdBlitImage
+	CSamplerCache                   m_SamplerCache;               // ݒ̃Tv[L  identical samplers are created once
+	double                          m_TextureLoadTimeMs = 0.0;    // fR[h{Abv[h  decode + upload wall time
+	std::vector<TextureData>        m_DecodedTextures;            // decodeTextures()̌ʁAAbv[h҂  waiting for upload
+	// C[Wx[XhCeBOFˏƓxEvtB^[ς݃XyL[EBRDF LUTi}bṽnbVŃfBXNɃLbVj
+	// image based lighting: irradiance, prefiltered specular and BRDF LUT, cached on disk by environment hash
+	CIblBaker                       m_IblBaker;                   // LbVȂꍇɃRs[gVF[_[ŃxCN
+	uint64_t                        m_IblSourceKey = 0;
+	bool                            m_IblCached = false;          // loadEnvironmentLighting()ŃLbVǂݍ߂
+	IblData                         m_IblData;                    // LbV̓eA̓xCNʁiAbv[hɉj
+	EnvironmentMap                  m_EnvironmentMap;             // LbVȂꍇ̂ݓǂݍ
+	Texture                         m_IblIrradiance;
+	Texture                         m_IblPrefiltered;
+	Texture                         m_IblBrdfLut;
+	const char*                     m_IblSource = "none";         // "disk cache", "GPU bake", "CPU bake"
+	double                          m_IblTimeMs = 0.0;
+	// NX^[tH[hCeBOF|CgCgtX^̃NX^[itNZjɐU蕪AtOg͎̃NX^[̃Cĝ݌vZ
+	// clustered forward lighting: lights binned into froxel clusters, each fragment only loops over its own cluster's list
+	CLightCuller                    m_LightCuller;                // cluster_cull.spvȂꍇCPUŐU蕪  CPU culling without it
+	std::vector<VkBuffer>           m_LightBuffers;               // 摜ƁFwb_[{CgizXgA}bv܂܁j
+	std::vector<VkDeviceMemory>     m_LightBuffersMemory;
+	std::vector<void*>              m_LightBuffersMapped;
+	std::vector<VkBuffer>           m_ClusterBuffers;             // 摜ƁFNX^[̃CgXgiGPUU蕪̓foCX[Jj
+	std::vector<VkDeviceMemory>     m_ClusterBuffersMemory;
+	std::vector<void*>              m_ClusterBuffersMapped;       // CPUU蕪̏ꍇ̂  CPU culling only
+	std::vector<PointLight>         m_BaseLights;                 // createForestLights(m_Config.lightCount)
+	std::vector<PointLight>         m_Lights;                     // t[̃Aj[V  animated, this frame
+	LightBufferHeader               m_LightHeader{};              // Ōɏ񂾃wb_[  last header written
+	ClusterData                     m_CpuClusters;                // CPUU蕪̌  CPU culling result
+	std::vector<CGpuTimer>          m_FrameTimers;                // 摜ƁFU蕪EvpXEV[GPUԁi^CX^vΉ̏ꍇ͋j
+	double                          m_LightCullMs = 0.0;          // GPUiCPUU蕪̏ꍇCPUj
+	double                          m_DepthPrepassMs = 0.0;       // vpXȂ̏ꍇ0  0 without the depth prepass
+	double                          m_ScenePassMs = 0.0;          // vpX̌̃CpX  main pass, after the prepass if any
+	// h[pPbgFL^̂тɃf̃`N蒼A\[g܂  rebuilt from the model chunks and sorted on every record
+	CDrawList                       m_DrawList;
+	std::vector<DrawRecordStats>    m_DrawStats;                  // 摜ƁFŌ̋L^̃oCh  per image, binds of the last record
+	double                          m_RecordMs = 0.0;             // S摜̋L^ih[Xg쐬E\[g܂ށj  all images, with the draw list
+	// t[OtFVhEECgU蕪EV[EImGuĩoAcompile()܂iRenderGraph.hj
+	// frame graph: compile() generates the barriers of the shadow, light-cull, scene and ImGui passes;
+	// one per image (its swapchain image and cluster buffer), rebuilt on every record
+	std::vector<CRenderGraph>       m_FrameGraphs;
+	RGForestFrame                   m_FramePasses;                // S摜œ  the same for every image
+	glm::vec3                       m_CameraPosition = glm::vec3(2.0f, 2.0f, 2.0f);
+	CSceneGraph                     m_SceneGraph;                 // [hsFt[ύXꂽ؂̂ݍXV  dirty subtrees per frame
+	uint32_t                        m_RootNode = 0;
+	uint32_t                        m_ModelNode = 0;              // ubo.model
+	// XFf̃CX^XB𒴂؂̓C|X^[iNɔʑ̃AgXɃxCNAJ̎lp`1j
+	// forest: instances of the model; trees beyond the impostor distance are one camera-facing quad sampling an
+	// octahedral atlas baked from the model at startup
+	std::vector<glm::vec4>          m_ForestTrees;                // xyzʒuEwXP[AJ߂  xyz position, w scale, nearest first
+	VkBuffer                        m_InstanceBuffer = VK_NULL_HANDLE;    // _oCfBO1F[0]̓f́Aȍ~m_ForestTrees  vertex binding 1
+	VkDeviceMemory                  m_InstanceBufferMemory = VK_NULL_HANDLE;
+	CImpostorAtlas                  m_ImpostorAtlas;
+	CImpostorPass                   m_ImpostorPass;               // impostor_*.spvȂꍇ͑SbV  every tree is a mesh without them
+	VkImage                         m_ImpostorAlbedoImage = VK_NULL_HANDLE;
+	VkDeviceMemory                  m_ImpostorAlbedoMemory = VK_NULL_HANDLE;
+	VkImage                         m_ImpostorNormalDepthImage = VK_NULL_HANDLE;
+	VkDeviceMemory                  m_ImpostorNormalDepthMemory = VK_NULL_HANDLE;
+	VkSampler                       m_ImpostorSampler = VK_NULL_HANDLE;    // m_SamplerCacheL  owned by m_SamplerCache
+	uint32_t                        m_NearTreeCount = 0;          // Ō̋L^ŃbVX̖  forest trees drawn as meshes in the last record
+	double                          m_ImpostorBakeMs = 0.0;
+	float                           m_FarPlane = 10.0f;           // Xꍇ͐X̒[܂  out to the edge of the forest, if any
+	// z̃JXP[hVhE}bvFÓIȃLX^[̃JXP[h̓LbVAzE͈͂ꍇ̂ݍĕ`
+	// cascaded sun shadows: cascades with only static casters are cached, re-rendered when the sun or their bounds move
+	CShadowPass                     m_ShadowPass;                 // shadow.spvȂꍇ̓NÂ݁ieȂj  cleared once without it
+	CShadowCascades                 m_ShadowCascades;
+	VkImage                         m_ShadowImage = VK_NULL_HANDLE;    // SHADOW_CASCADE_COUNTC[̃fvXz  one layer per cascade
+	VkDeviceMemory                  m_ShadowImageMemory = VK_NULL_HANDLE;
+	VkSampler                       m_ShadowSampler = VK_NULL_HANDLE;  // rTv[im_SamplerCacheLj  comparison sampler
+	VkCommandPool                   m_ShadowCommandPool = VK_NULL_HANDLE;    // t[L^  re-recorded every frame
+	std::vector<VkCommandBuffer>    m_ShadowCommandBuffers;       // 摜  per swapchain image
+	std::vector<CGpuTimer>          m_ShadowTimers;               // 摜ƁFVhEpXGPU
+	double                          m_ShadowPassMs = 0.0;
+	float                           m_SunAzimuth = 45.0f;         // xAZ܂  degrees around Z
+	float                           m_SunElevation = 35.0f;       // xAn  degrees above the horizon
+	float                           m_SunSpeed = 0.0f;            // ʊp̕ωix/bj  azimuth change, degrees per second
+	double                          m_LastUpdateTime = 0.0;       // updateUniformBuffer()̑O̎ibj
 
 	VkSampleCountFlagBits           m_MSAASamples = VK_SAMPLE_COUNT_1_BIT;    // }`TvOrbg  Multisampling bit count 
 	VkImage                         m_ColorImage;                             // }`TvOobt@[p
 	VkDeviceMemory                  m_ColorImageMemory;                       // }`TvOobt@[p
 	VkImageView                     m_ColorImageView;                         // }`TvOobt@[p
+	AttachmentMemoryInfo            m_ColorImageInfo;                         // MSAA[  MSAA memory report
+	AttachmentMemoryInfo            m_DepthImageInfo;
 
 	uint32_t                        m_ImageCount;
 	uint32_t                        m_MinImageCount;
+	VkPresentModeKHR                m_PresentMode = VK_PRESENT_MODE_FIFO_KHR;    // --present|V[őI΂ꂽ[h  mode picked by the present policy
+	CFrameLimiter                   m_FrameLimiter;                // CPUt[~b^[i--fps-limitApower-saverj
 
 	// SemaphoreFȒPɁuVOivB𓯊邽߂ɗp܂B
 	// Fence: GPU-CPŮԂ̓@\GQ[gȃXgbp[łB
 	std::vector<VkSemaphore>        m_ImageAvailableSemaphores;    // C[W`揀Z}tH
 	std::vector<VkSemaphore>        m_RenderFinishedSemaphores;    // _OZ}tH
-	std::vector<VkFence>            m_InFlightFences;              // ÑtFX
-	std::vector<VkFence>            m_ImagesInFlight;              // ̉摜
-	size_t                          m_CurrentFrame = 0;            // ݂t[JE^[
+	std::vector<VkFence>            m_InFlightFences;              // ÑtFXi^CCZ}tHΉ̏ꍇ̂݁j
+
+	// t[y[VOF^CCZ}tH̒lt[ԍiVulkan 1.2j
+	// frame pacing: the timeline semaphore counts completed frames, frame N signals value N
+	uint32_t                        m_FramesInFlight = 2;          // --frames-in-flight (1..MAX_FRAMES_IN_FLIGHT)
+	bool                            m_TimelineSupported = false;
+	VkSemaphore                     m_FrameTimeline = VK_NULL_HANDLE;
+	uint64_t                        m_FrameNumber = 0;             // Ōɒot[  last submitted frame
+	std::vector<uint64_t>           m_ImageFrames;                 // eXbv`F[摜ŌɎgt[  last frame per swapchain image
+	double                          m_InputSampleTime = 0.0;       // Ō̓̓TvOiglfwGetTimej
 
 	bool                            m_FramebufferResized = false;  // EEBhETCYύX
+	bool                            m_CommandBuffersDirty = false; // VF[_[@\ςAL^Kv邩
 
 	bool                            m_ImGuiDisplayed;              // ImGui\tbO
 	VkRenderPass                    m_ImGuiRenderPass;             // ImGuip_[pX
@@ -236,12 +431,17 @@ public:
 	bool checkValidationLayerSupport();                      // 003 of[VC[ΉmF
 	std::vector<const char*> getRequiredExtensions();    	 // 004 of[VC[GNXeVl
 
+	void setConfig(const AppConfig& config) { m_Config = config; }
+
 	void run();         
 	void mainLoop();   
 
 	                                     // 
 	void initWindow();                   // 101 EChE
 	void initVulkan();                   // 102 Vulkan
+	void startupStep(const char* name, const std::function<void()>& step);    // CXbhŎsE^CCɋL^
+	JobHandle submitStartupJob(const char* name, std::function<void()> step, const std::vector<JobHandle>& dependencies = {});
+	void waitStartupJob(const JobHandle& job);    // ҋ@A[J[ŎsXebv̗OăX[
 	void createInstance();               // 103 VulkanCX^X
 	void createSurface();                // 104 GLFWT[tFX
 	void pickPhysicalDevice();           // 105 VulkanΉGPUI
@@ -251,36 +451,80 @@ public:
 	void createRenderPass();             // _[pX
 	void createDescriptorSetLayout();    // \[XŃXNv^[CAEg 
 	void createGraphicsPipeline();       // OtBbNXpCvC
+	VkPipeline createPipelineVariant(uint32_t featureKey);    // m_PipelineVariantsĂ΂܂
 	void createColorResources();         // J[\[XiMSAA)
 	void createDepthResources();         // fvX\[X
+	void createTransientAttachment(VkFormat format, VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& imageMemory, AttachmentMemoryInfo& info);
+	void reportAttachmentMemory();       // MSAAA^b`g̃[Eшo
 	void createFramebuffers();           // t[obt@ifvX\[X̌j
-	void createTextureImage();           // eNX`[}bsOp摜
+	void createMipGenerator();           // ~bv}bvpRs[gpCvCiΉĂꍇj
+	void decodeTextures();               // eNX`[fR[hi[J[Xbhj
+	void createTextureImage();           // eNX`[}bsOp摜iAbv[hj
 	void createTextureImageView();       // eNX`[ANZX邽߂̃C[Wr[
 	void createTextureSampler();         // eNX`[Tv[
+	void loadEnvironmentLighting();      // IBLLbV͊}bv̓ǂݍ݁i[J[Xbhj
+	void createIblBaker();               // IBLxCNpRs[gpCvCiΉĂꍇj
+	void createEnvironmentLighting();    // IBLeNX`[FLbVAbv[hAGPU/CPUŃxCN
+	void createIblTextures(VkImageUsageFlags usage);
+	void bakeEnvironmentLighting();      // GPUxCNALbVpm_IblData֓ǂݖ߂
+	void uploadEnvironmentLighting();    // m_IblDataIBLeNX`[ɃAbv[h
+	void copyEnvironmentLighting(VkCommandBuffer commandBuffer, VkBuffer buffer, bool toImages);
+	void recordLayoutBarrier(VkCommandBuffer commandBuffer, VkImage image, uint32_t mipLevels, const RGAccess& source, const RGAccess& destination);
+	void createLightCuller();            // CgU蕪pRs[gpCvCicluster_cull.spvꍇj
+	void createLightBuffers();           // 摜Ƃ̃CgENX^[obt@[iXbv`F[Ɉˑj
+	void updateLights(uint32_t currentImage, const UniformBufferObject& ubo, float time);    // Cg̃Aj[VEAbv[hiCPUU蕪܂ށj
+	void createShadowPass();             // epfvX_[pXEpCvCishadow.spvꍇj
+	void createShadowMap();              // JXP[h̃fvXziNAς݁ATvO\j
+	void updateShadows(UniformBufferObject& ubo);    // JXP[h̕ELbVAUBOɍs
+	void recordShadowPass(uint32_t imageIndex);      // ĕ`悷JXP[ĥ݋L^it[j
 	void loadModel();                    // ff[^ǂݍ
+	void createShadowCasters();          // ep`NiCfbNXobt@[̑Oj
+	void createSceneGraph();             // gXtH[Kw
+	void createForest();                 // X̖؂̔zuEJim_Config.forestTreesj
+	void createInstanceBuffer();         // CX^Xobt@[if́{X̖؁j
+	void createImpostors();              // C|X^[AgX̃xCNE`pCvCiimpostor_*.spvꍇj
 	void createVertexBuffer();           // _obt@[
 	void createIndexBuffer();		     // CfbNXobt@[
 	void createUniformBuffers();         // jtH[obt@[
 	void createDescriptorPool();         // fXNv^[Zbgi[v[𐶐
 	void createDescriptorSets();         // fXNv^[Zbg𐶐
+	void createBindlessDescriptors();    // oChXeNX`[zƃ}eASSBO
 
 	// R}hobt@[
 
 	void createCommandBuffers();   
+	void recordCommandBuffers();
+	void rerecordCommandBuffers();                    // v[ZbgĂL^  GPU idle, resets the pools first
+	void recordCommandBuffer(uint32_t imageIndex);    // [J[XbhŕɌĂ΂܂
+	void buildDrawList();                             // recordCommandBuffers()̍ŏ  before the images are recorded
+	void buildFrameGraphs();                          // iLȋ@\ŃpXς܂j  same, the passes depend on the features
 
 	void createSyncObjects();            // IuWFNg
+	void destroySyncObjects();
+	void setFramesInFlight(uint32_t framesInFlight);    // GPUҋ@ɓIuWFNgĐ
+	void setPresentPolicy(PresentPolicy policy);        // ̃t[ŃXbv`F[Đ
+	void setShaderFeatures(uint32_t features);          // ̃t[̑OɃR}hobt@[L^܂
+	void setDepthPrepass(bool enabled);                 //   same
+	void setDrawSorting(bool enabled);                  //   same
+	void setImpostors(bool enabled);                    //   same
+	void setImpostorDistance(float distance);           //   same
+	void waitForFrame(uint64_t frame);                  // t[frameGPU҂i0 = Ȃj
 
 	void initImGui();                    
 	void createImGuiRenderPass();        
 	void createImGuiDescriptorPool();    
 	void createImGuiFramebuffers();
 	void allocateImGuiCommandBuffers();
-	void createImGuiCommandBuffers();
+	void recordImGuiCommandBuffer(uint32_t imageIndex);
+	void drawShaderVariants();           // ImGuiFVF[_[@\
+	void drawMemoryReport();             // ImGuiFfoCX[gp
+	void drawShadowStats();              // ImGuiFzEVhEJXP[h
+	void drawForestStats();              // ImGuiFXEC|X^[
 	void drawImGuiFrame();
 
 
-	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
-	void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, VkImageUsageFlags viewUsage = 0);
+	void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, VkImageCreateFlags flags = 0, uint32_t arrayLayers = 1);
 	VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 	VkShaderModule createShaderModule(const std::vector<char>& code);
 	
@@ -289,32 +533,46 @@ public:
 	void createCommandPool(VkCommandPool &commandPool, VkCommandPoolCreateFlags flags);
 	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
 		VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+	void freeMemory(VkDeviceMemory memory);        // vkFreeMemory + m_MemoryTracker
 	void allocateCommandBuffers(VkCommandBuffer* commandBuffer, uint32_t commandBufferCount, VkCommandPool &commandPool);
 	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 	void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
 	void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels);
 	VkCommandBuffer beginSingleTimeCommands();
 	void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-	void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
+	void recordMipmapBlits(VkCommandBuffer commandBuffer, VkImage image, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
+	void uploadTextures(const std::vector<TextureData>& textureData);
+	uint32_t registerBindlessTexture(VkImageView view, VkSampler sampler);        // returns the array index
+	uint32_t addMaterial(const MaterialData& material);        // returns the material index
+	void benchmarkMipGeneration();
+	void benchmarkFramePacing();
+	void benchmarkLights();
+	void benchmarkDepthPrepass();
+	void benchmarkDrawSorting();
+	void benchmarkImpostors();
 
 	//----------------
 
 	bool isDeviceSuitable(VkPhysicalDevice device);
 	bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+	bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extensionName);
 	QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
 	SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
+	void queryDeviceProperties();    // m_DeviceProperties, m_DeviceProperties12, m_MemoryProperties擾
 	VkSampleCountFlagBits getMaxUseableSampleCount();
 	VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 	VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
 	VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilites);
 	VkFormat findDepthFormat();
 	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+	bool isMemoryTypeAvailable(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 	bool hasStencilComponent(VkFormat format);
 
 	static void framebufferResizeCallback
 	    (GLFWwindow* window, int width, int height);
 	void recreateSwapChain();
 	void updateUniformBuffer(uint32_t currentImage);
+	void runFrame();                     //   `  ImGuiix[hł͓͑Oɑҋ@j
 	void drawFrame();
 
 	void cleanup();
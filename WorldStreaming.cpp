@@ -0,0 +1,535 @@
+/*======================================================================
+VulkanPBR_AcornForest : WorldStreaming.cpp
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+=======================================================================*/
+#include "WorldStreaming.h"
+#include "BenchUtil.h"
+#include "CacheFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace
+{
+	const uint32_t CELL_VERSION = 1;
+	const CCacheFile::Identifier CELL_IDENTIFIER = CCacheFile::makeIdentifier("AFCL 1");
+
+	struct CellHeader
+	{
+		uint8_t  identifier[CACHE_IDENTIFIER_SIZE];
+		uint32_t version;
+		int32_t  cellX;
+		int32_t  cellY;
+		uint32_t instanceCount;
+		uint32_t reserved;
+		uint64_t meshBytes;
+		uint64_t textureBytes;
+	};
+
+	const double STREAMING_FRAME_BUDGET_MS = 2.0;    // share of a 60 Hz frame the streaming may take before it counts as a hitch
+}
+
+size_t WorldCellData::getByteSize() const
+{
+	return instances.size() * sizeof(glm::vec4)
+		+ instanceBounds.size() * 6 * sizeof(float)
+		+ bvh.getNodeCount() * sizeof(BvhNode)
+		+ bvh.getInstanceCount() * (sizeof(uint32_t) + sizeof(BvhBox))
+		+ meshData.size()
+		+ textureData.size();
+}
+
+CWorldStreamer::CWorldStreamer(const WorldStreamingSettings& settings)
+	: m_Settings(settings)
+{
+	m_Cells.resize(static_cast<size_t>(settings.gridSize) * settings.gridSize);
+	for (uint32_t i = 0; i < settings.ioThreads; i++)
+	{
+		m_IoThreads.emplace_back(&CWorldStreamer::ioLoop, this);
+	}
+}
+
+CWorldStreamer::~CWorldStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Quit = true;
+	}
+	m_WakeCondition.notify_all();
+	for (std::thread& thread : m_IoThreads)
+	{
+		thread.join();
+	}
+}
+
+void CWorldStreamer::setCallbacks(std::function<void(const WorldCellData&)> onResident, std::function<void(const WorldCellData&)> onEvict)
+{
+	m_OnResident = std::move(onResident);
+	m_OnEvict = std::move(onEvict);
+}
+
+void CWorldStreamer::ioLoop()
+{
+	while (true)
+	{
+		uint32_t cellIndex;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WakeCondition.wait(lock, [this]() { return m_Quit || !m_Requests.empty(); });
+			if (m_Quit)
+			{
+				return;
+			}
+			cellIndex = m_Requests.front();
+			m_Requests.pop_front();
+			m_Cells[cellIndex].state = CellState::Loading;
+		}
+
+		std::unique_ptr<WorldCellData> data = tryLoadCell(cellIndex);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Cells[cellIndex].state = CellState::Loaded;
+		m_Completed.push_back({ cellIndex, std::move(data) });
+	}
+}
+
+std::unique_ptr<WorldCellData> CWorldStreamer::loadCell(uint32_t cellIndex) const
+{
+	int32_t cellX = static_cast<int32_t>(cellIndex % m_Settings.gridSize);
+	int32_t cellY = static_cast<int32_t>(cellIndex / m_Settings.gridSize);
+	std::unique_ptr<WorldCellData> cell = std::make_unique<WorldCellData>();
+	if (readCellFile(getCellPath(m_Settings.directory, cellX, cellY), cellX, cellY, *cell) == false)
+	{
+		return nullptr;
+	}
+
+	// trunk radius and crown height follow the instance scale
+	size_t count = cell->instances.size();
+	cell->instanceBounds.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		const glm::vec4& instance = cell->instances[i];
+		float radius = instance.w * 1.5f;
+		cell->instanceBounds.minX[i] = instance.x - radius; cell->instanceBounds.maxX[i] = instance.x + radius;
+		cell->instanceBounds.minY[i] = instance.y - radius; cell->instanceBounds.maxY[i] = instance.y + radius;
+		cell->instanceBounds.minZ[i] = instance.z;          cell->instanceBounds.maxZ[i] = instance.z + instance.w * 8.0f;
+	}
+	cell->bvh.build(cell->instanceBounds, nullptr);
+	return cell;
+}
+
+std::unique_ptr<WorldCellData> CWorldStreamer::tryLoadCell(uint32_t cellIndex) const
+{
+	// a cell that cannot be loaded becomes Failed; the I/O thread keeps serving the others
+	try
+	{
+		return loadCell(cellIndex);
+	}
+	catch (const std::exception& e)
+	{
+		printf("World streaming: cell %u failed to load (%s)\n", cellIndex, e.what());
+		return nullptr;
+	}
+}
+
+void CWorldStreamer::makeResident(Completed& completed)
+{
+	Cell& cell = m_Cells[completed.cellIndex];
+	if (completed.data == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		cell.state = CellState::Failed;
+		m_Stats.failedCells++;
+		return;
+	}
+
+	cell.data = std::move(completed.data);
+	if (m_OnResident)
+	{
+		m_OnResident(*cell.data);
+	}
+	m_Lru.push_front(completed.cellIndex);
+	cell.lruPosition = m_Lru.begin();
+	m_Stats.residentBytes += cell.data->getByteSize();
+	m_Stats.peakResidentBytes = std::max(m_Stats.peakResidentBytes, m_Stats.residentBytes);
+	m_Stats.loadedCells++;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	cell.state = CellState::Resident;
+}
+
+void CWorldStreamer::evict(uint32_t cellIndex)
+{
+	Cell& cell = m_Cells[cellIndex];
+	if (m_OnEvict)
+	{
+		m_OnEvict(*cell.data);
+	}
+	m_Stats.residentBytes -= cell.data->getByteSize();
+	m_Stats.evictedCells++;
+	m_Lru.erase(cell.lruPosition);
+	cell.data.reset();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	cell.state = CellState::Unloaded;
+}
+
+void CWorldStreamer::update(const glm::vec3& cameraPosition)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	m_Frame++;
+
+	// cells whose square comes within loadRadius of the camera, nearest first
+	struct Wanted
+	{
+		float    distance;
+		uint32_t cellIndex;
+	};
+	std::vector<Wanted> wanted;
+	float origin = -0.5f * m_Settings.gridSize * m_Settings.cellSize;
+	int32_t firstX = std::max(0, static_cast<int32_t>(std::floor((cameraPosition.x - m_Settings.loadRadius - origin) / m_Settings.cellSize)));
+	int32_t lastX = std::min(m_Settings.gridSize - 1, static_cast<int32_t>(std::floor((cameraPosition.x + m_Settings.loadRadius - origin) / m_Settings.cellSize)));
+	int32_t firstY = std::max(0, static_cast<int32_t>(std::floor((cameraPosition.y - m_Settings.loadRadius - origin) / m_Settings.cellSize)));
+	int32_t lastY = std::min(m_Settings.gridSize - 1, static_cast<int32_t>(std::floor((cameraPosition.y + m_Settings.loadRadius - origin) / m_Settings.cellSize)));
+	for (int32_t y = firstY; y <= lastY; y++)
+	{
+		for (int32_t x = firstX; x <= lastX; x++)
+		{
+			float minX = origin + x * m_Settings.cellSize;
+			float minY = origin + y * m_Settings.cellSize;
+			float dx = std::max(std::max(minX - cameraPosition.x, cameraPosition.x - (minX + m_Settings.cellSize)), 0.0f);
+			float dy = std::max(std::max(minY - cameraPosition.y, cameraPosition.y - (minY + m_Settings.cellSize)), 0.0f);
+			float distance = std::sqrt(dx * dx + dy * dy);
+			if (distance < m_Settings.loadRadius)
+			{
+				uint32_t cellIndex = static_cast<uint32_t>(y * m_Settings.gridSize + x);
+				wanted.push_back({ distance, cellIndex });
+				m_Cells[cellIndex].lastWantedFrame = m_Frame;
+			}
+		}
+	}
+	std::sort(wanted.begin(), wanted.end(), [](const Wanted& a, const Wanted& b) { return a.distance < b.distance; });
+
+	// wanted resident cells move to the front of the LRU list
+	for (const Wanted& cell : wanted)
+	{
+		if (m_Cells[cell.cellIndex].data != nullptr)
+		{
+			m_Lru.splice(m_Lru.begin(), m_Lru, m_Cells[cell.cellIndex].lruPosition);
+		}
+	}
+
+	std::vector<uint32_t> synchronousLoads;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (uint32_t cellIndex : m_Requests)
+		{
+			if (m_Cells[cellIndex].lastWantedFrame != m_Frame)
+			{
+				m_Cells[cellIndex].state = CellState::Unloaded;    // the camera moved away before an I/O thread got to it
+			}
+		}
+		m_Requests.clear();
+		for (const Wanted& cell : wanted)
+		{
+			CellState& state = m_Cells[cell.cellIndex].state;
+			if (state == CellState::Unloaded)
+			{
+				state = CellState::Queued;
+			}
+			if (state == CellState::Queued)
+			{
+				m_Requests.push_back(cell.cellIndex);
+			}
+		}
+		if (m_IoThreads.empty())
+		{
+			synchronousLoads.assign(m_Requests.begin(), m_Requests.end());
+			m_Requests.clear();
+		}
+	}
+	if (m_IoThreads.empty())
+	{
+		for (uint32_t cellIndex : synchronousLoads)
+		{
+			Completed completed = { cellIndex, tryLoadCell(cellIndex) };
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Cells[cellIndex].state = CellState::Loaded;
+			m_Completed.push_back(std::move(completed));
+		}
+	}
+	else
+	{
+		m_WakeCondition.notify_all();
+	}
+
+	// loaded cells become resident up to the per-frame upload limit
+	size_t uploaded = 0;
+	while (true)
+	{
+		Completed completed;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Completed.empty() || (uploaded > 0 && uploaded >= m_Settings.uploadBytesPerFrame))
+			{
+				break;
+			}
+			completed = std::move(m_Completed.front());
+			m_Completed.pop_front();
+		}
+		uploaded += (completed.data != nullptr) ? completed.data->meshData.size() + completed.data->textureData.size() : 0;
+		makeResident(completed);
+	}
+
+	// least recently wanted first; a cell the camera still wants stays even over budget
+	while (m_Stats.residentBytes > m_Settings.memoryBudget && m_Lru.empty() == false && m_Cells[m_Lru.back()].lastWantedFrame != m_Frame)
+	{
+		evict(m_Lru.back());
+	}
+
+	m_Stats.residentCells = static_cast<uint32_t>(m_Lru.size());
+	m_Stats.pendingCells = 0;
+	m_Stats.missingCells = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (const Wanted& cell : wanted)
+		{
+			CellState state = m_Cells[cell.cellIndex].state;
+			if (state != CellState::Resident && state != CellState::Failed)
+			{
+				m_Stats.pendingCells++;
+				m_Stats.missingCells += (cell.distance < m_Settings.requiredRadius) ? 1 : 0;
+			}
+		}
+	}
+	m_Stats.lastUpdateMs = elapsedMs(start);
+}
+
+void CWorldStreamer::clear()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (uint32_t cellIndex : m_Requests)
+		{
+			m_Cells[cellIndex].state = CellState::Unloaded;
+		}
+		m_Requests.clear();
+		for (const Completed& completed : m_Completed)
+		{
+			m_Cells[completed.cellIndex].state = CellState::Unloaded;
+		}
+		m_Completed.clear();
+	}
+	while (m_Lru.empty() == false)
+	{
+		evict(m_Lru.back());
+	}
+	m_Stats.residentCells = 0;
+}
+
+const WorldCellData* CWorldStreamer::getCell(int32_t cellX, int32_t cellY) const
+{
+	if (cellX < 0 || cellY < 0 || cellX >= m_Settings.gridSize || cellY >= m_Settings.gridSize)
+	{
+		return nullptr;
+	}
+	return m_Cells[static_cast<size_t>(cellY) * m_Settings.gridSize + cellX].data.get();
+}
+
+std::string CWorldStreamer::getCellPath(const std::string& directory, int32_t cellX, int32_t cellY)
+{
+	return directory + "/cell_" + std::to_string(cellX) + "_" + std::to_string(cellY) + ".afcell";
+}
+
+bool CWorldStreamer::readCellFile(const std::string& path, int32_t cellX, int32_t cellY, WorldCellData& cell)
+{
+	std::ifstream file;
+	CellHeader header{};
+	uint64_t fileSize = 0;
+	if (CCacheFile::readHeader(path, CELL_IDENTIFIER, CELL_VERSION, file, header, fileSize) == false ||
+		header.cellX != cellX || header.cellY != cellY)
+	{
+		return false;
+	}
+
+	// the sizes must add up to the file exactly before anything is allocated
+	uint64_t instanceBytes = static_cast<uint64_t>(header.instanceCount) * sizeof(glm::vec4);
+	if (header.meshBytes > fileSize || header.textureBytes > fileSize ||
+		sizeof(header) + instanceBytes + header.meshBytes + header.textureBytes != fileSize)
+	{
+		return false;
+	}
+
+	cell.cellX = header.cellX;
+	cell.cellY = header.cellY;
+	cell.instances.resize(header.instanceCount);
+	cell.meshData.resize(static_cast<size_t>(header.meshBytes));
+	cell.textureData.resize(static_cast<size_t>(header.textureBytes));
+	file.read(reinterpret_cast<char*>(cell.instances.data()), static_cast<std::streamsize>(instanceBytes));
+	file.read(reinterpret_cast<char*>(cell.meshData.data()), static_cast<std::streamsize>(cell.meshData.size()));
+	file.read(reinterpret_cast<char*>(cell.textureData.data()), static_cast<std::streamsize>(cell.textureData.size()));
+	return file.good();
+}
+
+bool CWorldStreamer::writeCellFile(const std::string& path, const WorldCellData& cell)
+{
+	CellHeader header{};
+	CCacheFile::initHeader(header, CELL_IDENTIFIER, CELL_VERSION);
+	header.cellX = cell.cellX;
+	header.cellY = cell.cellY;
+	header.instanceCount = static_cast<uint32_t>(cell.instances.size());
+	header.meshBytes = cell.meshData.size();
+	header.textureBytes = cell.textureData.size();
+
+	return CCacheFile::write(path, header, [&](std::ofstream& file)
+	{
+		file.write(reinterpret_cast<const char*>(cell.instances.data()), static_cast<std::streamsize>(cell.instances.size() * sizeof(glm::vec4)));
+		file.write(reinterpret_cast<const char*>(cell.meshData.data()), static_cast<std::streamsize>(cell.meshData.size()));
+		file.write(reinterpret_cast<const char*>(cell.textureData.data()), static_cast<std::streamsize>(cell.textureData.size()));
+	}, nullptr);
+}
+
+void CWorldStreamer::generateWorld(const WorldStreamingSettings& settings, uint32_t instancesPerCell, size_t meshBytes, size_t textureBytes)
+{
+	std::error_code error;
+	std::filesystem::create_directories(settings.directory, error);
+
+	float origin = -0.5f * settings.gridSize * settings.cellSize;
+	for (int32_t y = 0; y < settings.gridSize; y++)
+	{
+		for (int32_t x = 0; x < settings.gridSize; x++)
+		{
+			uint64_t state = 0x9E3779B97F4A7C15ull ^ (static_cast<uint64_t>(y * settings.gridSize + x + 1) * 0xBF58476D1CE4E5B9ull);
+			WorldCellData cell;
+			cell.cellX = x;
+			cell.cellY = y;
+			float minX = origin + x * settings.cellSize;
+			float minY = origin + y * settings.cellSize;
+			cell.instances.resize(instancesPerCell);
+			for (glm::vec4& instance : cell.instances)
+			{
+				instance = glm::vec4(randomRange(state, minX, minX + settings.cellSize), randomRange(state, minY, minY + settings.cellSize), 0.0f,
+					randomRange(state, 0.5f, 1.5f));
+			}
+
+			// payloads stand in for vertex/index and BCn data: only their size matters to the streaming
+			cell.meshData.resize(meshBytes);
+			cell.textureData.resize(textureBytes);
+			for (std::vector<uint8_t>* blob : { &cell.meshData, &cell.textureData })
+			{
+				for (size_t offset = 0; offset < blob->size(); offset += sizeof(uint64_t))
+				{
+					uint64_t random = nextRandom(state);
+					memcpy(blob->data() + offset, &random, std::min(sizeof(uint64_t), blob->size() - offset));
+				}
+			}
+
+			std::string path = getCellPath(settings.directory, x, y);
+			if (writeCellFile(path, cell) == false)
+			{
+				throw std::runtime_error("Failed to write world cell " + path + "!");
+			}
+		}
+	}
+}
+
+void CWorldStreamer::benchmark()
+{
+	const uint32_t frames = 600;
+	const double frameMs = 1000.0 / 60.0;
+	const float pathRadius = 320.0f;
+	const float speed = 60.0f;    // m/s, a fast fly-over
+
+	WorldStreamingSettings settings;
+	settings.directory = "Asset/Cache/WorldBench";
+	settings.memoryBudget = 24ull * 1024 * 1024;
+	settings.uploadBytesPerFrame = 4ull * 1024 * 1024;
+
+	const uint32_t instancesPerCell = 2000;
+	const size_t meshBytes = 128 * 1024;
+	const size_t textureBytes = 256 * 1024;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	generateWorld(settings, instancesPerCell, meshBytes, textureBytes);
+	printf("World streaming: %dx%d cells of %.0f m, %u trees + %zu KB per cell, budget %zu MB, generated in %.0f ms\n", settings.gridSize,
+		settings.gridSize, settings.cellSize, instancesPerCell, (meshBytes + textureBytes) / 1024, settings.memoryBudget >> 20, elapsedMs(start));
+	printf("  %u frames at 60 Hz on a %.0f m circle at %.0f m/s; hitch = streaming over %.1f ms of the frame\n", frames, pathRadius, speed,
+		STREAMING_FRAME_BUDGET_MS);
+	printf("  (the cell files were just written, so reads mostly hit the OS file cache)\n");
+	printf("  mode         avg (ms)   p99 (ms)   max (ms)   hitches   pop-in frames   loads   evictions   peak (MB)\n");
+
+	auto cameraAt = [&](uint32_t frame)
+	{
+		float angle = speed * frame / 60.0f / pathRadius;
+		return glm::vec3(pathRadius * std::cos(angle), pathRadius * std::sin(angle), 30.0f);
+	};
+
+	const uint32_t ioThreadCounts[] = { 0, 2 };
+	for (uint32_t ioThreads : ioThreadCounts)
+	{
+		settings.ioThreads = ioThreads;
+		CWorldStreamer streamer(settings);
+
+		// stand-in for the GPU upload: copy the payload into a staging buffer
+		std::vector<uint8_t> staging(meshBytes + textureBytes);
+		streamer.setCallbacks([&](const WorldCellData& cell)
+		{
+			memcpy(staging.data(), cell.meshData.data(), std::min(staging.size(), cell.meshData.size()));
+			memcpy(staging.data() + meshBytes, cell.textureData.data(), std::min(staging.size() - meshBytes, cell.textureData.size()));
+		}, nullptr);
+
+		// the start of the path is loaded before timing, like a loading screen
+		for (uint32_t warmup = 0; warmup < 600; warmup++)
+		{
+			streamer.update(cameraAt(0));
+			if (streamer.getStats().pendingCells == 0)
+			{
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		uint64_t loadsBefore = streamer.getStats().loadedCells;
+		uint64_t evictionsBefore = streamer.getStats().evictedCells;
+
+		std::vector<double> updateMs(frames);
+		uint32_t hitches = 0;
+		uint32_t popInFrames = 0;
+		std::chrono::high_resolution_clock::time_point frameStart = std::chrono::high_resolution_clock::now();
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			streamer.update(cameraAt(frame));
+			updateMs[frame] = streamer.getStats().lastUpdateMs;
+			hitches += (updateMs[frame] > STREAMING_FRAME_BUDGET_MS) ? 1 : 0;
+			popInFrames += (streamer.getStats().missingCells > 0) ? 1 : 0;
+
+			frameStart += std::chrono::microseconds(static_cast<int64_t>(frameMs * 1000.0));
+			std::this_thread::sleep_until(frameStart);
+		}
+
+		double average = 0.0;
+		for (double ms : updateMs)
+		{
+			average += ms / frames;
+		}
+		std::sort(updateMs.begin(), updateMs.end());
+		const WorldStreamingStats& stats = streamer.getStats();
+		char mode[32] = "synchronous";
+		if (ioThreads > 0)
+		{
+			snprintf(mode, sizeof(mode), "%u I/O thr", ioThreads);
+		}
+		printf("  %-11s  %8.3f   %8.3f   %8.3f   %7u   %13u   %5llu   %9llu   %9.1f\n", mode, average, updateMs[frames * 99 / 100], updateMs.back(), hitches,
+			popInFrames, static_cast<unsigned long long>(stats.loadedCells - loadsBefore),
+			static_cast<unsigned long long>(stats.evictedCells - evictionsBefore), stats.peakResidentBytes / (1024.0 * 1024.0));
+	}
+
+	std::error_code error;
+	std::filesystem::remove_all(settings.directory, error);
+}
@@ -0,0 +1,156 @@
+/*======================================================================
+VulkanPBR_AcornForest : WorldStreaming.h
+Author:			Sim Luigi
+Last Modified:	2026.10.19
+
+Streaming of a forest larger than memory, one grid cell at a time.
+The world (xy plane, z up, centered on the origin) is a grid of square
+cells. Every cell is one file in the world directory (.afcell): the
+tree instances, a mesh blob and a texture blob, laid out so the blobs
+can be copied into staging buffers as they are.
+
+update() runs once per frame on the main thread:
+  - cells within loadRadius of the camera are requested, nearest first;
+    requests for cells the camera has left are dropped again
+  - I/O threads read the files and build the cell's instance BVH
+  - loaded cells become resident, at most uploadBytesPerFrame per call
+    (onResident is the place for the GPU upload)
+  - resident cells are kept in least-recently-wanted order and evicted
+    from the back while memoryBudget is exceeded; cells the camera
+    still wants are never evicted
+With ioThreads = 0, update() reads every request itself (the baseline
+that stalls the frame). A missing cell file is a hole in the world.
+=======================================================================*/
+#pragma once
+
+#include "Bvh.h"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct WorldStreamingSettings
+{
+	std::string directory = "Asset/World";
+	float       cellSize = 64.0f;                         // meters
+	int32_t     gridSize = 16;                            // cells per side
+	float       loadRadius = 160.0f;                      // cells closer than this to the camera are requested
+	float       requiredRadius = 64.0f;                   // a cell closer than this that is not resident is counted as missing (pop-in)
+	size_t      memoryBudget = 64ull * 1024 * 1024;       // resident cell bytes
+	size_t      uploadBytesPerFrame = 8ull * 1024 * 1024; // cells made resident per update(), at least one
+	uint32_t    ioThreads = 2;                            // 0 = load on the calling thread
+};
+
+struct WorldCellData
+{
+	int32_t                 cellX = 0;
+	int32_t                 cellY = 0;
+	std::vector<glm::vec4>  instances;       // tree position (xyz) and scale (w)
+	AabbArrays              instanceBounds;
+	CBvh                    bvh;             // over instanceBounds, built on the I/O thread
+	std::vector<uint8_t>    meshData;        // vertices + indices
+	std::vector<uint8_t>    textureData;     // block-compressed mip chain
+
+	size_t getByteSize() const;
+};
+
+struct WorldStreamingStats
+{
+	uint32_t    residentCells = 0;
+	uint32_t    pendingCells = 0;        // requested, not resident yet
+	uint32_t    missingCells = 0;        // within requiredRadius, not resident (last update)
+	uint32_t    failedCells = 0;         // no readable file or the load threw
+	uint64_t    loadedCells = 0;         // since the start
+	uint64_t    evictedCells = 0;
+	size_t      residentBytes = 0;
+	size_t      peakResidentBytes = 0;
+	double      lastUpdateMs = 0.0;      // main thread time of the last update()
+};
+
+class CWorldStreamer
+{
+private:
+
+	enum class CellState : uint8_t
+	{
+		Unloaded,
+		Queued,      // in m_Requests
+		Loading,     // an I/O thread has it
+		Loaded,      // in m_Completed, waiting for update()
+		Resident,
+		Failed,
+	};
+
+	struct Cell
+	{
+		CellState                       state = CellState::Unloaded;
+		std::unique_ptr<WorldCellData>  data;
+		std::list<uint32_t>::iterator   lruPosition;
+		uint64_t                        lastWantedFrame = 0;
+	};
+
+	struct Completed
+	{
+		uint32_t                        cellIndex;
+		std::unique_ptr<WorldCellData>  data;    // null when the file could not be read
+	};
+
+	WorldStreamingSettings      m_Settings;
+	std::vector<Cell>           m_Cells;
+	std::list<uint32_t>         m_Lru;           // resident cells, most recently wanted first
+	uint64_t                    m_Frame = 0;
+	WorldStreamingStats         m_Stats;
+	std::function<void(const WorldCellData&)>   m_OnResident;
+	std::function<void(const WorldCellData&)>   m_OnEvict;
+
+	// shared with the I/O threads
+	std::mutex                  m_Mutex;
+	std::condition_variable     m_WakeCondition;
+	std::deque<uint32_t>        m_Requests;      // nearest first, rebuilt by every update()
+	std::deque<Completed>       m_Completed;
+	std::vector<std::thread>    m_IoThreads;
+	bool                        m_Quit = false;
+
+	void ioLoop();
+	std::unique_ptr<WorldCellData> loadCell(uint32_t cellIndex) const;    // touches no shared state
+	std::unique_ptr<WorldCellData> tryLoadCell(uint32_t cellIndex) const; // loadCell(), null instead of an exception
+	void makeResident(Completed& completed);
+	void evict(uint32_t cellIndex);
+
+public:
+
+	explicit CWorldStreamer(const WorldStreamingSettings& settings);
+	~CWorldStreamer();    // stops the I/O threads; resident cells are freed without onEvict
+
+	CWorldStreamer(const CWorldStreamer&) = delete;
+	CWorldStreamer& operator=(const CWorldStreamer&) = delete;
+
+	// called from update() on the calling thread
+	void setCallbacks(std::function<void(const WorldCellData&)> onResident, std::function<void(const WorldCellData&)> onEvict);
+
+	void update(const glm::vec3& cameraPosition);
+	void clear();    // evicts every resident cell (with onEvict) and drops the requests
+
+	const WorldCellData* getCell(int32_t cellX, int32_t cellY) const;    // null unless resident
+	const WorldStreamingStats& getStats() const { return m_Stats; }
+
+	static std::string getCellPath(const std::string& directory, int32_t cellX, int32_t cellY);
+	// instances and blobs only, the bounds and BVH are derived when loading;
+	// fails unless the file is complete and holds the cell at cellX, cellY
+	static bool readCellFile(const std::string& path, int32_t cellX, int32_t cellY, WorldCellData& cell);
+	static bool writeCellFile(const std::string& path, const WorldCellData& cell);
+	// procedural test world: instancesPerCell trees with random mesh/texture payloads
+	static void generateWorld(const WorldStreamingSettings& settings, uint32_t instancesPerCell, size_t meshBytes, size_t textureBytes);
+
+	// CPU-only: flies a camera path over a generated world, synchronous vs I/O threads, prints hitches
+	static void benchmark();
+};
@@ -8,12 +8,100 @@ Last Modified:	2020.12.13
 #include "VulkanFramework.h"
 
 // C֐
-int main(void)
+int main(int argc, char** argv)
 {
+	AppConfig config;
+	int exitCode = EXIT_SUCCESS;
+	if (parseCommandLine(argc, argv, config, exitCode) == false)
+	{
+		return exitCode;
+	}
+
 	CVulkanFramework mainProgram;
 
 	try
 	{
+		// x`}[N[hFEBhEJɌʂo͂ďI
+		if (config.benchTextures)
+		{
+			CTextureLoader::benchmark({ "Asset/Texture/viking_room.png", "Asset/Texture/texture.jpg" }, 64, 0, config.mipFilter);
+			return EXIT_SUCCESS;
+		}
+		if (config.benchCompression)
+		{
+			CTextureCompressor::benchmark({ "Asset/Texture/viking_room.png", "Asset/Texture/texture.jpg" });
+			return EXIT_SUCCESS;
+		}
+		if (config.validateRenderGraph)
+		{
+			return CRenderGraph::selfTest(10000) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		if (config.validateReflection)
+		{
+			return CShaderReflection::selfTest() ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		if (config.validateIbl)
+		{
+			return CIblPrecompute::selfTest(config.environmentMapPath) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		if (config.validateLights)
+		{
+			return CClusteredLights::selfTest() ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		if (config.validateShadows)
+		{
+			return CShadowCascades::selfTest() ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		if (config.validateSimd)
+		{
+			return CSimdMath::selfTest() ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		if (config.validateImpostors)
+		{
+			return CImpostorAtlas::selfTest() ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		if (config.benchJobs)
+		{
+			CJobSystem::benchmark(64);
+			return EXIT_SUCCESS;
+		}
+		if (config.benchProfiler)
+		{
+			CProfiler::benchmark(10000000);
+			return EXIT_SUCCESS;
+		}
+		if (config.benchLimiter)
+		{
+			CFrameLimiter::benchmark(600);
+			return EXIT_SUCCESS;
+		}
+		if (config.benchScene)
+		{
+			CSceneGraph::benchmark(1000000, 0.01f);
+			return EXIT_SUCCESS;
+		}
+		if (config.benchSimd)
+		{
+			CSimdMath::benchmark();
+			return EXIT_SUCCESS;
+		}
+		if (config.benchBvh)
+		{
+			CBvh::benchmark();
+			return EXIT_SUCCESS;
+		}
+		if (config.benchStreaming)
+		{
+			CWorldStreamer::benchmark();
+			return EXIT_SUCCESS;
+		}
+		if (config.benchSort)
+		{
+			CDrawList::benchmark();
+			return EXIT_SUCCESS;
+		}
+
+		mainProgram.setConfig(config);
 		mainProgram.run();
 
 	}